@@ -0,0 +1,632 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Allocation budget regression check.
+ *
+ * It counts the iowa_system_malloc() calls, the
+ * allocated bytes and the peak of outstanding memory
+ * of scripted LwM2M operations on the Device Object:
+ *  - register: the registration to a LwM2M Server,
+ *  - read_resource: a Read on /3/0/0,
+ *  - read_object: a Read on /3,
+ *  - write_tlv: a TLV Write on /3/0/14,
+ *  - observe_notify: a notification of /3/0/9 after
+ *    a battery level change.
+ *
+ * The measures are compared to the budgets of
+ * allocation_budgets.h. The program exits with 1
+ * when a budget is exceeded.
+ *
+ * The connection and the clock are simulated so that
+ * the measures are deterministic: the datagrams sent
+ * by the Client are captured in memory and the
+ * replies of the LwM2M Server are injected in the
+ * next iowa_step().
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+
+// Budgets to check against
+#include "allocation_budgets.h"
+
+// Allocation counters and CoAP encoding
+#include "benchmark_helpers.h"
+
+// Platform specific headers
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK_SERVER_SHORT_ID 1
+#define CHECK_SERVER_URI      "coap://127.0.0.1:5683"
+#define CHECK_LIFETIME        3600
+#define CHECK_DATAGRAM_SIZE   1024
+#define CHECK_QUEUE_SIZE      8
+#define CHECK_MAX_STEP        10
+#define CHECK_ITERATION_COUNT 8
+
+// A budget or a measure.
+// - name: the operation.
+// - allocationCount: the number of iowa_system_malloc() calls.
+// - allocatedBytes: the sum of the sizes passed to iowa_system_malloc().
+// - peakBytes: the peak of outstanding memory above the level at the start of the operation.
+typedef struct
+{
+    const char *name;
+    size_t      allocationCount;
+    size_t      allocatedBytes;
+    size_t      peakBytes;
+} check_budget_t;
+
+// A datagram queue.
+typedef struct
+{
+    uint8_t bufferArray[CHECK_QUEUE_SIZE][CHECK_DATAGRAM_SIZE];
+    size_t  lengthArray[CHECK_QUEUE_SIZE];
+    size_t  count;
+} check_queue_t;
+
+static check_queue_t prv_clientQueue; // Datagrams sent by the Client
+static check_queue_t prv_serverQueue; // Datagrams to deliver to the Client
+static int prv_connection;
+static int32_t prv_currentTime;
+static bool prv_isRegistered;
+static uint16_t prv_nextMid;
+
+/**************************************************
+ * System abstraction functions
+ *
+ * iowa_system_malloc() and iowa_system_free() are
+ * provided by benchmark_helpers.c.
+ */
+
+// The clock only moves when the script advances it.
+int32_t iowa_system_gettime(void)
+{
+    return prv_currentTime;
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+
+    fprintf(stderr, "Unexpected reboot request.\r\n");
+    exit(1);
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+/**************************************************
+ * Simulated connection
+ */
+
+void * iowa_system_connection_open(iowa_connection_type_t type,
+                                   char *hostname,
+                                   char *port,
+                                   void *userData)
+{
+    (void)type;
+    (void)hostname;
+    (void)port;
+    (void)userData;
+
+    return &prv_connection;
+}
+
+int iowa_system_connection_send(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    (void)connP;
+    (void)userData;
+
+    if (prv_clientQueue.count == CHECK_QUEUE_SIZE
+        || length > CHECK_DATAGRAM_SIZE)
+    {
+        return -1;
+    }
+
+    memcpy(prv_clientQueue.bufferArray[prv_clientQueue.count], buffer, length);
+    prv_clientQueue.lengthArray[prv_clientQueue.count] = length;
+    prv_clientQueue.count++;
+
+    return (int)length;
+}
+
+int iowa_system_connection_recv(void *connP,
+                                uint8_t *buffer,
+                                size_t length,
+                                void *userData)
+{
+    size_t datagramLength;
+
+    (void)connP;
+    (void)userData;
+
+    if (prv_serverQueue.count == 0)
+    {
+        return 0;
+    }
+
+    datagramLength = prv_serverQueue.lengthArray[0];
+    if (datagramLength > length)
+    {
+        datagramLength = length;
+    }
+    memcpy(buffer, prv_serverQueue.bufferArray[0], datagramLength);
+
+    prv_serverQueue.count--;
+    memmove(prv_serverQueue.bufferArray[0], prv_serverQueue.bufferArray[1], prv_serverQueue.count * CHECK_DATAGRAM_SIZE);
+    memmove(prv_serverQueue.lengthArray, prv_serverQueue.lengthArray + 1, prv_serverQueue.count * sizeof(size_t));
+
+    return (int)datagramLength;
+}
+
+// Returns immediately: the script calls iowa_step() after each injection.
+int iowa_system_connection_select(void **connArray,
+                                  size_t connCount,
+                                  int32_t timeout,
+                                  void *userData)
+{
+    (void)connArray;
+    (void)connCount;
+    (void)timeout;
+    (void)userData;
+
+    return prv_serverQueue.count != 0 ? 1 : 0;
+}
+
+void iowa_system_connection_close(void *connP,
+                                  void *userData)
+{
+    (void)connP;
+    (void)userData;
+}
+
+/**************************************************
+ * Simulated LwM2M Server
+ */
+
+static void prv_inject(const uint8_t *buffer,
+                       size_t length)
+{
+    memcpy(prv_serverQueue.bufferArray[prv_serverQueue.count], buffer, length);
+    prv_serverQueue.lengthArray[prv_serverQueue.count] = length;
+    prv_serverQueue.count++;
+}
+
+// Acknowledge the confirmable messages sent by the Client and answer its Register request.
+static void prv_serverReply(void)
+{
+    size_t i;
+
+    for (i = 0; i < prv_clientQueue.count; i++)
+    {
+        uint8_t *datagramP;
+        uint8_t buffer[64];
+        size_t length;
+        uint8_t tokenLength;
+        uint16_t lastNumber;
+
+        datagramP = prv_clientQueue.bufferArray[i];
+        if (((datagramP[0] >> 4) & 0x03) != COAP_TYPE_CON)
+        {
+            continue;
+        }
+        tokenLength = (uint8_t)(datagramP[0] & 0x0F);
+
+        lastNumber = 0;
+        if (datagramP[1] != 0
+            && datagramP[1] < 32)
+        {
+            // The only request of the Client in this script is the Register
+            length = benchCoapEncodeHeader(buffer, COAP_TYPE_ACK, COAP_201_CREATED, (uint16_t)((datagramP[2] << 8) | datagramP[3]), datagramP + 4, tokenLength);
+            length += benchCoapAddOption(buffer + length, &lastNumber, COAP_OPTION_LOCATION_PATH, (const uint8_t *)"rd", 2);
+            length += benchCoapAddOption(buffer + length, &lastNumber, COAP_OPTION_LOCATION_PATH, (const uint8_t *)"0", 1);
+        }
+        else
+        {
+            // Empty acknowledgement of a confirmable notification
+            length = benchCoapEncodeHeader(buffer, COAP_TYPE_ACK, 0, (uint16_t)((datagramP[2] << 8) | datagramP[3]), NULL, 0);
+        }
+        prv_inject(buffer, length);
+    }
+}
+
+// Returns the code of the first datagram sent by the Client or 0 if none.
+static uint8_t prv_clientCode(void)
+{
+    if (prv_clientQueue.count == 0)
+    {
+        return 0;
+    }
+
+    return prv_clientQueue.bufferArray[0][1];
+}
+
+// Send a request to the Client.
+static void prv_serverRequest(uint8_t code,
+                              const char *uri,
+                              bool observe,
+                              const uint8_t *tlvP,
+                              size_t tlvLength)
+{
+    uint8_t buffer[CHECK_DATAGRAM_SIZE];
+    uint8_t token[2];
+    size_t length;
+    uint16_t lastNumber;
+
+    token[0] = observe == true ? 'O' : 'R';
+    token[1] = (uint8_t)prv_nextMid;
+
+    lastNumber = 0;
+    length = benchCoapEncodeHeader(buffer, COAP_TYPE_CON, code, prv_nextMid, token, 2);
+    if (observe == true)
+    {
+        // Observe option with the value 0
+        length += benchCoapAddOption(buffer + length, &lastNumber, COAP_OPTION_OBSERVE, NULL, 0);
+    }
+    length += benchCoapAddUriPath(buffer + length, &lastNumber, uri);
+    if (tlvP != NULL)
+    {
+        uint8_t format[2];
+
+        format[0] = (uint8_t)(COAP_FORMAT_TLV >> 8);
+        format[1] = (uint8_t)COAP_FORMAT_TLV;
+        length += benchCoapAddOption(buffer + length, &lastNumber, COAP_OPTION_CONTENT_FORMAT, format, 2);
+        buffer[length++] = 0xFF;
+        memcpy(buffer + length, tlvP, tlvLength);
+        length += tlvLength;
+    }
+    prv_nextMid++;
+
+    prv_inject(buffer, length);
+}
+
+/**************************************************
+ * Script
+ */
+
+static void prv_eventCallback(iowa_event_t *eventP,
+                              void *userData,
+                              iowa_context_t contextP)
+{
+    (void)userData;
+    (void)contextP;
+
+    switch (eventP->eventType)
+    {
+    case IOWA_EVENT_REG_REGISTERED:
+        prv_isRegistered = true;
+        break;
+
+    case IOWA_EVENT_REG_UNREGISTERED:
+    case IOWA_EVENT_REG_FAILED:
+        prv_isRegistered = false;
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Run one iowa_step() and return the code of the first datagram sent by the Client.
+static uint8_t prv_step(iowa_context_t iowaH)
+{
+    prv_clientQueue.count = 0;
+    if (iowa_step(iowaH, 0) != IOWA_COAP_NO_ERROR)
+    {
+        return 0xFF;
+    }
+
+    return prv_clientCode();
+}
+
+// Start the measure of an operation.
+static void prv_measureStart(bench_allocation_t *startP)
+{
+    benchAllocation.peakBytes = benchAllocation.outstandingBytes;
+    *startP = benchAllocation;
+}
+
+// Stop the measure of an operation and keep the maximum of each value in resultP.
+static void prv_measureStop(bench_allocation_t *startP,
+                            check_budget_t *resultP)
+{
+    size_t value;
+
+    value = (size_t)(benchAllocation.allocationCount - startP->allocationCount);
+    if (value > resultP->allocationCount)
+    {
+        resultP->allocationCount = value;
+    }
+    value = (size_t)(benchAllocation.allocatedBytes - startP->allocatedBytes);
+    if (value > resultP->allocatedBytes)
+    {
+        resultP->allocatedBytes = value;
+    }
+    value = benchAllocation.peakBytes - startP->outstandingBytes;
+    if (value > resultP->peakBytes)
+    {
+        resultP->peakBytes = value;
+    }
+}
+
+static bool prv_register(iowa_context_t iowaH,
+                         check_budget_t *resultP)
+{
+    bench_allocation_t start;
+    size_t i;
+
+    prv_measureStart(&start);
+
+    if (iowa_client_add_server(iowaH, CHECK_SERVER_SHORT_ID, CHECK_SERVER_URI, CHECK_LIFETIME, 0, IOWA_SEC_NONE) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+    for (i = 0; i < CHECK_MAX_STEP && prv_isRegistered == false; i++)
+    {
+        (void)prv_step(iowaH);
+        prv_serverReply();
+    }
+
+    prv_measureStop(&start, resultP);
+
+    return prv_isRegistered;
+}
+
+// Inject a request and return the code of the response.
+static uint8_t prv_request(iowa_context_t iowaH,
+                           uint8_t code,
+                           const char *uri,
+                           bool observe,
+                           const uint8_t *tlvP,
+                           size_t tlvLength)
+{
+    prv_serverRequest(code, uri, observe, tlvP, tlvLength);
+
+    return prv_step(iowaH);
+}
+
+// Run a request as warm-up, then CHECK_ITERATION_COUNT times under measure.
+static bool prv_measureRequest(iowa_context_t iowaH,
+                               uint8_t code,
+                               const char *uri,
+                               const uint8_t *tlvP,
+                               size_t tlvLength,
+                               uint8_t expectedCode,
+                               check_budget_t *resultP)
+{
+    size_t i;
+
+    for (i = 0; i <= CHECK_ITERATION_COUNT; i++)
+    {
+        bench_allocation_t start;
+        uint8_t responseCode;
+
+        prv_measureStart(&start);
+        responseCode = prv_request(iowaH, code, uri, false, tlvP, tlvLength);
+        if (i != 0)
+        {
+            prv_measureStop(&start, resultP);
+        }
+
+        if (responseCode != expectedCode)
+        {
+            fprintf(stderr, "%s: unexpected response %u.%02u.\r\n", resultP->name, (unsigned int)(responseCode >> 5), (unsigned int)(responseCode & 0x1F));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Change the battery level, then run iowa_step() until the notification is sent.
+static bool prv_measureNotify(iowa_context_t iowaH,
+                              check_budget_t *resultP)
+{
+    size_t i;
+
+    if (prv_request(iowaH, COAP_GET, "/3/0/9", true, NULL, 0) != COAP_205_CONTENT)
+    {
+        fprintf(stderr, "%s: the observation failed.\r\n", resultP->name);
+        return false;
+    }
+
+    for (i = 0; i <= CHECK_ITERATION_COUNT; i++)
+    {
+        bench_allocation_t start;
+        uint8_t responseCode;
+        size_t stepCount;
+
+        // Move the clock to avoid any minimum period
+        prv_currentTime++;
+
+        prv_measureStart(&start);
+        if (iowa_client_device_update_battery(iowaH, (uint8_t)(50 + i), IOWA_DEVICE_BATTERY_STATUS_NORMAL) != IOWA_COAP_NO_ERROR)
+        {
+            return false;
+        }
+        responseCode = 0;
+        for (stepCount = 0; stepCount < CHECK_MAX_STEP && responseCode == 0; stepCount++)
+        {
+            responseCode = prv_step(iowaH);
+        }
+        // Acknowledge the notification if needed
+        prv_serverReply();
+        (void)prv_step(iowaH);
+        if (i != 0)
+        {
+            prv_measureStop(&start, resultP);
+        }
+
+        if (responseCode != COAP_205_CONTENT)
+        {
+            fprintf(stderr, "%s: no notification was sent.\r\n", resultP->name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool prv_runScript(check_budget_t *resultArray)
+{
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    bool success;
+    // TLV Resource 14 with the string "+02:00"
+    const uint8_t utcOffsetTlv[] = { 0xC6, 14, '+', '0', '2', ':', '0', '0' };
+
+    success = false;
+    prv_currentTime = 1000;
+    prv_nextMid = 1;
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        return false;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = "IOWA";
+    devInfo.deviceType = "Allocation check";
+    devInfo.modelNumber = "1";
+    devInfo.serialNumber = "0123456789";
+    devInfo.firmwareVersion = "1.0";
+    devInfo.optFlags = IOWA_DEVICE_RSC_BATTERY | IOWA_DEVICE_RSC_UTC_OFFSET;
+    devInfo.utcOffsetP = "+01:00";
+
+    if (iowa_client_configure(iowaH, "IOWA_allocation_check", &devInfo, prv_eventCallback) != IOWA_COAP_NO_ERROR)
+    {
+        goto cleanup;
+    }
+
+    if (prv_register(iowaH, resultArray + 0) == false)
+    {
+        fprintf(stderr, "%s: the registration failed.\r\n", resultArray[0].name);
+        goto cleanup;
+    }
+
+    if (prv_measureRequest(iowaH, COAP_GET, "/3/0/0", NULL, 0, COAP_205_CONTENT, resultArray + 1) == false
+        || prv_measureRequest(iowaH, COAP_GET, "/3", NULL, 0, COAP_205_CONTENT, resultArray + 2) == false
+        || prv_measureRequest(iowaH, COAP_PUT, "/3/0/14", utcOffsetTlv, sizeof(utcOffsetTlv), COAP_204_CHANGED, resultArray + 3) == false
+        || prv_measureNotify(iowaH, resultArray + 4) == false)
+    {
+        goto cleanup;
+    }
+
+    success = true;
+
+cleanup:
+    iowa_close(iowaH);
+
+    return success;
+}
+
+int main(int argc,
+         char *argv[])
+{
+    check_budget_t budgetArray[] = ALLOCATION_BUDGET_TABLE;
+    check_budget_t resultArray[sizeof(budgetArray) / sizeof(budgetArray[0])];
+    size_t count;
+    size_t i;
+    bool printBudgets;
+    bool success;
+
+    printBudgets = false;
+    if (argc == 2
+        && strcmp(argv[1], "-p") == 0)
+    {
+        printBudgets = true;
+    }
+    else if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [-p]\r\n", argv[0]);
+        fprintf(stderr, "  -p   print the measures in the format of allocation_budgets.h\r\n");
+        return 1;
+    }
+
+    count = sizeof(budgetArray) / sizeof(budgetArray[0]);
+    memset(resultArray, 0, sizeof(resultArray));
+    for (i = 0; i < count; i++)
+    {
+        resultArray[i].name = budgetArray[i].name;
+    }
+
+    if (prv_runScript(resultArray) == false)
+    {
+        return 1;
+    }
+    if (benchAllocation.outstandingBytes != 0)
+    {
+        fprintf(stderr, "%lu bytes are still allocated after iowa_close().\r\n", (unsigned long)benchAllocation.outstandingBytes);
+    }
+
+    if (printBudgets == true)
+    {
+        fprintf(stdout, "#define ALLOCATION_BUDGET_TABLE {                 \\\n");
+        for (i = 0; i < count; i++)
+        {
+            fprintf(stdout, "    { \"%s\",%*s%4lu, %6lu, %6lu }%s \\\n",
+                    resultArray[i].name,
+                    (int)(15 - strlen(resultArray[i].name)), "",
+                    (unsigned long)resultArray[i].allocationCount,
+                    (unsigned long)resultArray[i].allocatedBytes,
+                    (unsigned long)resultArray[i].peakBytes,
+                    i + 1 < count ? "," : " ");
+        }
+        fprintf(stdout, "}\n");
+        return 0;
+    }
+
+    success = true;
+    fprintf(stdout, "%-16s %18s %18s %18s\r\n", "operation", "allocations", "bytes", "peak bytes");
+    for (i = 0; i < count; i++)
+    {
+        bool exceeded;
+
+        exceeded = resultArray[i].allocationCount > budgetArray[i].allocationCount
+                   || resultArray[i].allocatedBytes > budgetArray[i].allocatedBytes
+                   || resultArray[i].peakBytes > budgetArray[i].peakBytes;
+
+        fprintf(stdout, "%-16s %8lu / %-7lu %8lu / %-7lu %8lu / %-7lu %s\r\n",
+                resultArray[i].name,
+                (unsigned long)resultArray[i].allocationCount, (unsigned long)budgetArray[i].allocationCount,
+                (unsigned long)resultArray[i].allocatedBytes, (unsigned long)budgetArray[i].allocatedBytes,
+                (unsigned long)resultArray[i].peakBytes, (unsigned long)budgetArray[i].peakBytes,
+                exceeded ? "EXCEEDED" : "ok");
+
+        if (exceeded)
+        {
+            success = false;
+        }
+    }
+
+    if (success == false)
+    {
+        fprintf(stdout, "\r\nAllocation budget exceeded. If the increase is intended, update allocation_budgets.h with the -p option.\r\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Allocation budgets checked by allocation_budget_check.
+ *
+ * For each scripted LwM2M operation: the maximum
+ * number of iowa_system_malloc() calls, the maximum
+ * number of allocated bytes and the maximum peak of
+ * outstanding memory above the level at the start
+ * of the operation.
+ *
+ * The values depend on the configuration in
+ * iowa_config.h. When an increase is intended,
+ * replace the matching table below with the
+ * output of:
+ *   allocation_budget_check -p
+ *   allocation_budget_check_option_view -p
+ *
+ **************************************************/
+
+#ifndef _ALLOCATION_BUDGETS_INCLUDE_
+#define _ALLOCATION_BUDGETS_INCLUDE_
+
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+
+#define ALLOCATION_BUDGET_TABLE {                 \
+    { "register",         36,   2127,   1742 }, \
+    { "read_resource",     8,    586,    538 }, \
+    { "read_object",       9,   1486,    956 }, \
+    { "write_tlv",         7,   1332,   1278 }, \
+    { "observe_notify",    2,     80,     80 }  \
+}
+
+#else
+
+#define ALLOCATION_BUDGET_TABLE {                 \
+    { "register",         38,   2127,   1742 }, \
+    { "read_resource",    11,    586,    538 }, \
+    { "read_object",      10,   1486,    956 }, \
+    { "write_tlv",        11,   1332,   1278 }, \
+    { "observe_notify",    2,     80,     80 }  \
+}
+
+#endif
+
+#endif
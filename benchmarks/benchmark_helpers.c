@@ -0,0 +1,192 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+#include "benchmark_helpers.h"
+
+// IOWA headers
+#include "iowa_platform.h"
+
+// Platform specific headers
+#include <stdlib.h>
+#include <string.h>
+
+bench_allocation_t benchAllocation;
+
+/**************************************************
+ * System abstraction functions
+ *
+ * iowa_system_malloc() and iowa_system_free() count
+ * the allocations. The size of each block is stored
+ * in front of it to track the outstanding memory.
+ */
+
+#define BENCH_ALLOC_HEADER 16
+
+void * iowa_system_malloc(size_t size)
+{
+    uint8_t *blockP;
+
+    blockP = (uint8_t *)malloc(size + BENCH_ALLOC_HEADER);
+    if (blockP == NULL)
+    {
+        return NULL;
+    }
+    memcpy(blockP, &size, sizeof(size_t));
+
+    benchAllocation.allocationCount++;
+    benchAllocation.allocatedBytes += size;
+    benchAllocation.outstandingBytes += size;
+    if (benchAllocation.outstandingBytes > benchAllocation.peakBytes)
+    {
+        benchAllocation.peakBytes = benchAllocation.outstandingBytes;
+    }
+
+    return blockP + BENCH_ALLOC_HEADER;
+}
+
+void iowa_system_free(void *pointer)
+{
+    uint8_t *blockP;
+    size_t size;
+
+    if (pointer == NULL)
+    {
+        return;
+    }
+
+    blockP = (uint8_t *)pointer - BENCH_ALLOC_HEADER;
+    memcpy(&size, blockP, sizeof(size_t));
+    benchAllocation.outstandingBytes -= size;
+
+    free(blockP);
+}
+
+/**************************************************
+ * CoAP encoding
+ */
+
+static size_t prv_encodeOptionField(uint8_t *buffer,
+                                    size_t *indexP,
+                                    size_t value)
+{
+    if (value < 13)
+    {
+        return value;
+    }
+    if (value < 269)
+    {
+        buffer[(*indexP)++] = (uint8_t)(value - 13);
+        return 13;
+    }
+    buffer[(*indexP)++] = (uint8_t)((value - 269) >> 8);
+    buffer[(*indexP)++] = (uint8_t)(value - 269);
+    return 14;
+}
+
+size_t benchCoapEncodeHeader(uint8_t *buffer,
+                             uint8_t type,
+                             uint8_t code,
+                             uint16_t mid,
+                             const uint8_t *token,
+                             uint8_t tokenLength)
+{
+    buffer[0] = (uint8_t)(0x40 | (type << 4) | tokenLength);
+    buffer[1] = code;
+    buffer[2] = (uint8_t)(mid >> 8);
+    buffer[3] = (uint8_t)mid;
+    if (tokenLength != 0)
+    {
+        memcpy(buffer + 4, token, tokenLength);
+    }
+
+    return 4 + (size_t)tokenLength;
+}
+
+size_t benchCoapAddOption(uint8_t *buffer,
+                          uint16_t *lastNumberP,
+                          uint16_t number,
+                          const uint8_t *value,
+                          size_t length)
+{
+    size_t index;
+    size_t deltaNibble;
+    size_t lengthNibble;
+
+    index = 1;
+    deltaNibble = prv_encodeOptionField(buffer, &index, (size_t)(number - *lastNumberP));
+    lengthNibble = prv_encodeOptionField(buffer, &index, length);
+    buffer[0] = (uint8_t)((deltaNibble << 4) | lengthNibble);
+    if (length != 0)
+    {
+        memcpy(buffer + index, value, length);
+    }
+    *lastNumberP = number;
+
+    return index + length;
+}
+
+size_t benchCoapAddIntegerOption(uint8_t *buffer,
+                                 uint16_t *lastNumberP,
+                                 uint16_t number,
+                                 uint32_t value)
+{
+    uint8_t valueBuffer[4];
+    size_t length;
+
+    length = 0;
+    if (value > 0xFFFFFF)
+    {
+        valueBuffer[length++] = (uint8_t)(value >> 24);
+    }
+    if (value > 0xFFFF)
+    {
+        valueBuffer[length++] = (uint8_t)(value >> 16);
+    }
+    if (value > 0xFF)
+    {
+        valueBuffer[length++] = (uint8_t)(value >> 8);
+    }
+    if (value > 0)
+    {
+        valueBuffer[length++] = (uint8_t)value;
+    }
+
+    return benchCoapAddOption(buffer, lastNumberP, number, valueBuffer, length);
+}
+
+size_t benchCoapAddUriPath(uint8_t *buffer,
+                           uint16_t *lastNumberP,
+                           const char *uri)
+{
+    size_t length;
+
+    length = 0;
+    while (*uri != 0)
+    {
+        const char *endP;
+
+        if (*uri == '/')
+        {
+            uri++;
+            continue;
+        }
+        endP = strchr(uri, '/');
+        if (endP == NULL)
+        {
+            endP = uri + strlen(uri);
+        }
+        length += benchCoapAddOption(buffer + length, lastNumberP, COAP_OPTION_URI_PATH, (const uint8_t *)uri, (size_t)(endP - uri));
+        uri = endP;
+    }
+
+    return length;
+}
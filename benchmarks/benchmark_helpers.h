@@ -0,0 +1,114 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Helpers shared by the benchmarks simulating a
+ * LwM2M Server:
+ *  - iowa_system_malloc() and iowa_system_free()
+ *    counting the allocations,
+ *  - the encoding of the CoAP messages sent to the
+ *    Client.
+ *
+ **************************************************/
+
+#ifndef _BENCHMARK_HELPERS_INCLUDE_
+#define _BENCHMARK_HELPERS_INCLUDE_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CoAP constants used by the simulated LwM2M Servers
+#define COAP_TYPE_CON 0
+#define COAP_TYPE_NON 1
+#define COAP_TYPE_ACK 2
+
+#define COAP_GET    0x01
+#define COAP_POST   0x02
+#define COAP_PUT    0x03
+#define COAP_DELETE 0x04
+
+#define COAP_201_CREATED   0x41
+#define COAP_202_DELETED   0x42
+#define COAP_204_CHANGED   0x44
+#define COAP_205_CONTENT   0x45
+#define COAP_404_NOT_FOUND 0x84
+
+#define COAP_OPTION_OBSERVE        6
+#define COAP_OPTION_LOCATION_PATH  8
+#define COAP_OPTION_URI_PATH       11
+#define COAP_OPTION_CONTENT_FORMAT 12
+#define COAP_OPTION_ACCEPT         17
+
+#define COAP_FORMAT_LINK 40
+#define COAP_FORMAT_TLV  11542
+
+// Counters of the iowa_system_malloc() shim.
+// - allocationCount: the number of iowa_system_malloc() calls.
+// - allocatedBytes: the sum of the sizes passed to iowa_system_malloc().
+// - outstandingBytes: the memory allocated and not freed yet.
+// - peakBytes: the maximum of outstandingBytes. It can be lowered to measure a peak from a given point.
+typedef struct
+{
+    uint64_t allocationCount;
+    uint64_t allocatedBytes;
+    size_t   outstandingBytes;
+    size_t   peakBytes;
+} bench_allocation_t;
+
+// Updated by the iowa_system_malloc() and iowa_system_free() of benchmark_helpers.c.
+extern bench_allocation_t benchAllocation;
+
+// Encode the header of a CoAP message over UDP.
+// Returned value: the number of bytes written in buffer.
+// Parameters:
+// - buffer: the message to build.
+// - type, code, mid: the header fields.
+// - token, tokenLength: the token. token can be nil if tokenLength is 0.
+size_t benchCoapEncodeHeader(uint8_t *buffer,
+                             uint8_t type,
+                             uint8_t code,
+                             uint16_t mid,
+                             const uint8_t *token,
+                             uint8_t tokenLength);
+
+// Append an option to a CoAP message. The options must be appended by increasing number.
+// Returned value: the number of bytes written in buffer.
+// Parameters:
+// - buffer: where to write the option.
+// - lastNumberP: IN/OUT. The number of the previous option, 0 for the first one.
+// - number: the option number.
+// - value, length: the option value. value can be nil if length is 0.
+size_t benchCoapAddOption(uint8_t *buffer,
+                          uint16_t *lastNumberP,
+                          uint16_t number,
+                          const uint8_t *value,
+                          size_t length);
+
+// Append an option with an integer value, in the shortest encoding.
+// Returned value: the number of bytes written in buffer.
+// Parameters: as benchCoapAddOption().
+size_t benchCoapAddIntegerOption(uint8_t *buffer,
+                                 uint16_t *lastNumberP,
+                                 uint16_t number,
+                                 uint32_t value);
+
+// Append one Uri-Path option per segment of uri.
+// Returned value: the number of bytes written in buffer.
+// Parameters:
+// - buffer, lastNumberP: as benchCoapAddOption().
+// - uri: the path, like "/3/0/9".
+size_t benchCoapAddUriPath(uint8_t *buffer,
+                           uint16_t *lastNumberP,
+                           const char *uri);
+
+#endif
@@ -0,0 +1,437 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Benchmark of the updates made by several
+ * application threads while a dedicated I/O thread
+ * runs iowa_step().
+ *
+ * Each producer thread owns a Temperature sensor
+ * and updates its value as fast as possible. Two
+ * modes are measured:
+ *  - mutex: the application serializes its calls
+ *    with a mutex also held by the I/O thread
+ *    around iowa_step(), and the producers call
+ *    iowa_client_IPSO_update_value(),
+ *  - queue: the producers call
+ *    iowa_client_IPSO_post_value() without locking
+ *    and the I/O thread applies the queued updates
+ *    at each iteration of iowa_step().
+ *
+ * For each mode, it reports the updates per second,
+ * the p50, p99 and maximum durations of the calls
+ * made by the producers and, for the queue mode,
+ * the statistics of the command queue.
+ *
+ * No LwM2M Server is configured: the measure
+ * covers the application calls and the update of
+ * the sensor values, not the notifications.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+#include "iowa_platform.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define BENCH_MAX_PRODUCERS     64
+#define BENCH_SAMPLE_INTERVAL   16       // one call out of BENCH_SAMPLE_INTERVAL is timed
+#define BENCH_MAX_SAMPLES       (1 << 20)
+
+typedef enum
+{
+    BENCH_MODE_MUTEX = 0,
+    BENCH_MODE_QUEUE
+} bench_mode_t;
+
+typedef struct
+{
+    pthread_t     thread;
+    iowa_sensor_t sensorId;
+    uint64_t      updateCount;
+    uint64_t      rejectCount;
+    uint32_t     *sampleArray;
+    size_t        sampleCount;
+} bench_producer_t;
+
+typedef struct
+{
+    iowa_context_t   iowaH;
+    bench_mode_t     mode;
+    pthread_mutex_t  mutex;
+    int              isStarted;
+    int              isStopped;
+    int              isIoStopped;
+    size_t           producerCount;
+    bench_producer_t producerArray[BENCH_MAX_PRODUCERS];
+} bench_t;
+
+static bench_t prv_bench;
+
+/**************************************************
+ * Helpers
+ */
+
+static long long prv_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// The flags are set by the main thread and polled by the others
+static int prv_flagGet(int *flagP)
+{
+    return __atomic_load_n(flagP, __ATOMIC_ACQUIRE);
+}
+
+static void prv_flagSet(int *flagP)
+{
+    __atomic_store_n(flagP, 1, __ATOMIC_RELEASE);
+}
+
+static int prv_compareSample(const void *aP,
+                             const void *bP)
+{
+    uint32_t a;
+    uint32_t b;
+
+    a = *(const uint32_t *)aP;
+    b = *(const uint32_t *)bP;
+
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+// Returns the percentile in microseconds. The samples are sorted.
+static double prv_percentile(uint32_t *sampleArray,
+                             size_t sampleCount,
+                             double percentile)
+{
+    size_t index;
+
+    if (sampleCount == 0)
+    {
+        return 0.0;
+    }
+
+    index = (size_t)(percentile / 100.0 * (double)(sampleCount - 1) + 0.5);
+
+    return sampleArray[index] / 1000.0;
+}
+
+/**************************************************
+ * Threads
+ */
+
+static void * prv_ioThread(void *arg)
+{
+    bench_t *benchP;
+
+    benchP = (bench_t *)arg;
+
+    while (prv_flagGet(&(benchP->isIoStopped)) == 0)
+    {
+        if (benchP->mode == BENCH_MODE_MUTEX)
+        {
+            // iowa_step() must not wait for incoming data while holding the mutex of the application
+            pthread_mutex_lock(&(benchP->mutex));
+            (void)iowa_step(benchP->iowaH, 0);
+            pthread_mutex_unlock(&(benchP->mutex));
+        }
+        else
+        {
+            // The producers interrupt the select when they post an update
+            (void)iowa_step(benchP->iowaH, 1);
+        }
+    }
+
+    return NULL;
+}
+
+static void * prv_producerThread(void *arg)
+{
+    bench_producer_t *producerP;
+    uint32_t counter;
+
+    producerP = (bench_producer_t *)arg;
+    counter = 0;
+
+    while (prv_flagGet(&(prv_bench.isStarted)) == 0)
+    {
+        sched_yield();
+    }
+
+    while (prv_flagGet(&(prv_bench.isStopped)) == 0)
+    {
+        long long start;
+        iowa_status_t result;
+        float value;
+
+        value = (float)(20 + counter % 16);
+        start = (counter % BENCH_SAMPLE_INTERVAL == 0) ? prv_now() : 0;
+
+        if (prv_bench.mode == BENCH_MODE_MUTEX)
+        {
+            pthread_mutex_lock(&(prv_bench.mutex));
+            result = iowa_client_IPSO_update_value(prv_bench.iowaH, producerP->sensorId, value);
+            pthread_mutex_unlock(&(prv_bench.mutex));
+        }
+        else
+        {
+            result = iowa_client_IPSO_post_value(prv_bench.iowaH, producerP->sensorId, value);
+        }
+
+        if (start != 0
+            && producerP->sampleCount < BENCH_MAX_SAMPLES)
+        {
+            long long duration;
+
+            duration = prv_now() - start;
+            producerP->sampleArray[producerP->sampleCount] = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
+            producerP->sampleCount++;
+        }
+
+        if (result == IOWA_COAP_NO_ERROR)
+        {
+            producerP->updateCount++;
+        }
+        else
+        {
+            // The queue is full: let the I/O thread run
+            producerP->rejectCount++;
+            sched_yield();
+        }
+        counter++;
+    }
+
+    return NULL;
+}
+
+/**************************************************
+ * Measure
+ */
+
+static bool prv_runMode(bench_mode_t mode,
+                        size_t producerCount,
+                        double duration)
+{
+    pthread_t ioThread;
+    iowa_command_queue_stats_t stats;
+    uint32_t *allSampleArray;
+    size_t allSampleCount;
+    uint64_t updateCount;
+    uint64_t rejectCount;
+    long long start;
+    long long elapsed;
+    size_t i;
+
+    memset(&prv_bench, 0, sizeof(prv_bench));
+    prv_bench.mode = mode;
+    prv_bench.producerCount = producerCount;
+    pthread_mutex_init(&(prv_bench.mutex), NULL);
+
+    prv_bench.iowaH = iowa_init(NULL);
+    if (prv_bench.iowaH == NULL
+        || iowa_client_configure(prv_bench.iowaH, "command_queue_benchmark", NULL, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stderr, "IOWA initialization failed.\r\n");
+        return false;
+    }
+
+    for (i = 0; i < producerCount; i++)
+    {
+        if (iowa_client_IPSO_add_sensor(prv_bench.iowaH, IOWA_IPSO_TEMPERATURE, 20, "Cel", NULL, -20.0, 50.0, &(prv_bench.producerArray[i].sensorId)) != IOWA_COAP_NO_ERROR)
+        {
+            fprintf(stderr, "Adding the sensor %u failed.\r\n", (unsigned int)i);
+            return false;
+        }
+        prv_bench.producerArray[i].sampleArray = (uint32_t *)malloc(BENCH_MAX_SAMPLES * sizeof(uint32_t));
+        if (prv_bench.producerArray[i].sampleArray == NULL)
+        {
+            fprintf(stderr, "Memory allocation failed.\r\n");
+            return false;
+        }
+    }
+
+    pthread_create(&ioThread, NULL, prv_ioThread, &prv_bench);
+    for (i = 0; i < producerCount; i++)
+    {
+        pthread_create(&(prv_bench.producerArray[i].thread), NULL, prv_producerThread, prv_bench.producerArray + i);
+    }
+
+    start = prv_now();
+    prv_flagSet(&(prv_bench.isStarted));
+    while (prv_now() - start < (long long)(duration * 1e9))
+    {
+        struct timespec delay;
+
+        delay.tv_sec = 0;
+        delay.tv_nsec = 10000000;
+        nanosleep(&delay, NULL);
+    }
+    prv_flagSet(&(prv_bench.isStopped));
+
+    for (i = 0; i < producerCount; i++)
+    {
+        pthread_join(prv_bench.producerArray[i].thread, NULL);
+    }
+
+    if (mode == BENCH_MODE_QUEUE)
+    {
+        // Wait for the I/O thread to apply the last posted updates
+        do
+        {
+            sched_yield();
+            (void)iowa_command_queue_get_stats(prv_bench.iowaH, &stats);
+        } while (stats.appliedCount != stats.postCount);
+    }
+    elapsed = prv_now() - start;
+
+    prv_flagSet(&(prv_bench.isIoStopped));
+    iowa_system_connection_interrupt_select(NULL);
+    pthread_join(ioThread, NULL);
+
+    updateCount = 0;
+    rejectCount = 0;
+    allSampleCount = 0;
+    for (i = 0; i < producerCount; i++)
+    {
+        updateCount += prv_bench.producerArray[i].updateCount;
+        rejectCount += prv_bench.producerArray[i].rejectCount;
+        allSampleCount += prv_bench.producerArray[i].sampleCount;
+    }
+
+    allSampleArray = (uint32_t *)malloc((allSampleCount + 1) * sizeof(uint32_t));
+    if (allSampleArray == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed.\r\n");
+        return false;
+    }
+    allSampleCount = 0;
+    for (i = 0; i < producerCount; i++)
+    {
+        memcpy(allSampleArray + allSampleCount, prv_bench.producerArray[i].sampleArray, prv_bench.producerArray[i].sampleCount * sizeof(uint32_t));
+        allSampleCount += prv_bench.producerArray[i].sampleCount;
+        free(prv_bench.producerArray[i].sampleArray);
+    }
+    qsort(allSampleArray, allSampleCount, sizeof(uint32_t), prv_compareSample);
+
+    fprintf(stdout, "%-6s %9u %14.0f %10.3f %10.3f %10.3f\r\n",
+            mode == BENCH_MODE_MUTEX ? "mutex" : "queue",
+            (unsigned int)producerCount,
+            (double)updateCount * 1e9 / (double)elapsed,
+            prv_percentile(allSampleArray, allSampleCount, 50.0),
+            prv_percentile(allSampleArray, allSampleCount, 99.0),
+            allSampleCount == 0 ? 0.0 : allSampleArray[allSampleCount - 1] / 1000.0);
+
+    if (mode == BENCH_MODE_QUEUE)
+    {
+        (void)iowa_command_queue_get_stats(prv_bench.iowaH, &stats);
+
+        fprintf(stdout, "       posted: %u, retries: %u (%.2f per 1000 posts), rejected as full: %u (%llu calls)\r\n",
+                stats.postCount,
+                stats.retryCount,
+                stats.postCount == 0 ? 0.0 : (double)stats.retryCount * 1000.0 / (double)stats.postCount,
+                stats.fullCount,
+                (unsigned long long)rejectCount);
+        fprintf(stdout, "       applied: %u, failed: %u, batches: %u, average batch: %.1f, largest batch: %u\r\n",
+                stats.appliedCount,
+                stats.failedCount,
+                stats.batchCount,
+                stats.batchCount == 0 ? 0.0 : (double)stats.appliedCount / (double)stats.batchCount,
+                stats.maxBatchSize);
+    }
+
+    free(allSampleArray);
+
+    for (i = 0; i < producerCount; i++)
+    {
+        (void)iowa_client_IPSO_remove_sensor(prv_bench.iowaH, prv_bench.producerArray[i].sensorId);
+    }
+    iowa_close(prv_bench.iowaH);
+    pthread_mutex_destroy(&(prv_bench.mutex));
+
+    return true;
+}
+
+static void prv_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [options]\r\n", name);
+    fprintf(stderr, "  -t SECONDS   measured duration of each mode (default: 2)\r\n");
+    fprintf(stderr, "  -p COUNT     number of producer threads, up to %d (default: 8)\r\n", BENCH_MAX_PRODUCERS);
+}
+
+int main(int argc,
+         char *argv[])
+{
+    double duration;
+    size_t producerCount;
+    int argIndex;
+
+    duration = 2.0;
+    producerCount = 8;
+
+    for (argIndex = 1; argIndex < argc; argIndex++)
+    {
+        if (argv[argIndex][0] != '-'
+            || argv[argIndex][1] == 0
+            || argv[argIndex][2] != 0
+            || argIndex + 1 >= argc)
+        {
+            prv_usage(argv[0]);
+            return 1;
+        }
+
+        switch (argv[argIndex][1])
+        {
+        case 't':
+            duration = atof(argv[argIndex + 1]);
+            break;
+        case 'p':
+            producerCount = (size_t)atoi(argv[argIndex + 1]);
+            break;
+        default:
+            prv_usage(argv[0]);
+            return 1;
+        }
+        argIndex++;
+    }
+    if (duration <= 0
+        || producerCount == 0
+        || producerCount > BENCH_MAX_PRODUCERS)
+    {
+        prv_usage(argv[0]);
+        return 1;
+    }
+
+    fprintf(stdout, "Command queue size: %d. Calls timed: one out of %d.\r\n\r\n", IOWA_COMMAND_QUEUE_SIZE, BENCH_SAMPLE_INTERVAL);
+    fprintf(stdout, "%-6s %9s %14s %10s %10s %10s\r\n", "mode", "producers", "updates/s", "p50 (us)", "p99 (us)", "max (us)");
+
+    if (prv_runMode(BENCH_MODE_MUTEX, producerCount, duration) == false
+        || prv_runMode(BENCH_MODE_QUEUE, producerCount, duration) == false)
+    {
+        return 1;
+    }
+
+    return 0;
+}
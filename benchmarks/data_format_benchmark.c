@@ -0,0 +1,309 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Micro-benchmark of the LwM2M data formats.
+ *
+ * It compares the payload size and the encoding and
+ * decoding durations of TLV, SenML CBOR and LwM2M
+ * CBOR on a Device Object instance and on a dump of
+ * twenty Temperature Object instances.
+ *
+ * Each payload is decoded back and compared to the
+ * original data before being measured.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_prv_data_internals.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATION_COUNT 20000
+#define BENCH_SENSOR_COUNT    20
+
+#define BENCH_DEVICE_OBJECT_ID      3
+#define BENCH_TEMPERATURE_OBJECT_ID 3303
+
+/**************************************************
+ * Helpers
+ */
+
+typedef struct
+{
+    const char           *name;
+    iowa_content_format_t format;
+} bench_format_t;
+
+static double prv_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void prv_setData(iowa_lwm2m_data_t *dataP,
+                        uint16_t objectID,
+                        uint16_t instanceID,
+                        uint16_t resourceID,
+                        uint16_t resInstanceID,
+                        iowa_lwm2m_data_type_t type)
+{
+    memset(dataP, 0, sizeof(iowa_lwm2m_data_t));
+    dataP->objectID = objectID;
+    dataP->instanceID = instanceID;
+    dataP->resourceID = resourceID;
+    dataP->resInstanceID = resInstanceID;
+    dataP->type = type;
+}
+
+static void prv_setString(iowa_lwm2m_data_t *dataP,
+                          uint16_t resourceID,
+                          const char *valueP)
+{
+    prv_setData(dataP, BENCH_DEVICE_OBJECT_ID, 0, resourceID, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING);
+    dataP->value.asBuffer.buffer = (uint8_t *)valueP;
+    dataP->value.asBuffer.length = strlen(valueP);
+}
+
+static void prv_setInteger(iowa_lwm2m_data_t *dataP,
+                           uint16_t resourceID,
+                           uint16_t resInstanceID,
+                           iowa_lwm2m_data_type_t type,
+                           int64_t value)
+{
+    prv_setData(dataP, BENCH_DEVICE_OBJECT_ID, 0, resourceID, resInstanceID, type);
+    dataP->value.asInteger = value;
+}
+
+static size_t prv_buildDevice(iowa_lwm2m_data_t *dataP)
+{
+    size_t count;
+
+    count = 0;
+    prv_setString(dataP + count++, 0, "IoTerop");
+    prv_setString(dataP + count++, 1, "IOWA benchmark");
+    prv_setString(dataP + count++, 2, "0123456789");
+    prv_setString(dataP + count++, 3, "1.0.4");
+    prv_setInteger(dataP + count++, 9, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, 87);
+    prv_setInteger(dataP + count++, 10, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_INTEGER, 15432);
+    prv_setInteger(dataP + count++, 11, 0, IOWA_LWM2M_TYPE_INTEGER, 0);
+    prv_setInteger(dataP + count++, 13, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_TIME, 1700000000);
+    prv_setString(dataP + count++, 14, "+02:00");
+    prv_setString(dataP + count++, 15, "Europe/Paris");
+    prv_setString(dataP + count++, 16, "U");
+    prv_setString(dataP + count++, 17, "Sensor hub");
+    prv_setString(dataP + count++, 18, "rev. B");
+    prv_setString(dataP + count++, 19, "2.1.0");
+
+    return count;
+}
+
+static size_t prv_buildSensors(iowa_lwm2m_data_t *dataP)
+{
+    size_t count;
+    uint16_t i;
+
+    count = 0;
+    for (i = 0; i < BENCH_SENSOR_COUNT; i++)
+    {
+        prv_setData(dataP + count, BENCH_TEMPERATURE_OBJECT_ID, i, 5601, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT);
+        dataP[count].value.asFloat = 12.5 + i;
+        count++;
+        prv_setData(dataP + count, BENCH_TEMPERATURE_OBJECT_ID, i, 5602, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT);
+        dataP[count].value.asFloat = 31.25 + i;
+        count++;
+        prv_setData(dataP + count, BENCH_TEMPERATURE_OBJECT_ID, i, 5700, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_FLOAT);
+        dataP[count].value.asFloat = 21.3 + i / 10.0;
+        count++;
+        prv_setData(dataP + count, BENCH_TEMPERATURE_OBJECT_ID, i, 5701, IOWA_LWM2M_ID_ALL, IOWA_LWM2M_TYPE_STRING);
+        dataP[count].value.asBuffer.buffer = (uint8_t *)"Cel";
+        dataP[count].value.asBuffer.length = 3;
+        count++;
+    }
+
+    return count;
+}
+
+static iowa_lwm2m_data_type_t prv_resourceType(uint16_t objectID,
+                                               uint16_t resourceID,
+                                               void *userDataP)
+{
+    (void)userDataP;
+
+    if (objectID == BENCH_TEMPERATURE_OBJECT_ID)
+    {
+        return resourceID == 5701 ? IOWA_LWM2M_TYPE_STRING : IOWA_LWM2M_TYPE_FLOAT;
+    }
+
+    switch (resourceID)
+    {
+    case 9:
+    case 10:
+    case 11:
+        return IOWA_LWM2M_TYPE_INTEGER;
+
+    case 13:
+        return IOWA_LWM2M_TYPE_TIME;
+
+    default:
+        return IOWA_LWM2M_TYPE_STRING;
+    }
+}
+
+static bool prv_isSameData(iowa_lwm2m_data_t *dataP,
+                           iowa_lwm2m_data_t *otherP)
+{
+    if (dataP->objectID != otherP->objectID
+        || dataP->instanceID != otherP->instanceID
+        || dataP->resourceID != otherP->resourceID
+        || dataP->resInstanceID != otherP->resInstanceID
+        || dataP->type != otherP->type)
+    {
+        return false;
+    }
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+        return dataP->value.asBuffer.length == otherP->value.asBuffer.length
+               && memcmp(dataP->value.asBuffer.buffer, otherP->value.asBuffer.buffer, dataP->value.asBuffer.length) == 0;
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        // TLV encodes the floating point values on 32 bits
+        return (float)dataP->value.asFloat == (float)otherP->value.asFloat;
+
+    default:
+        return dataP->value.asInteger == otherP->value.asInteger;
+    }
+}
+
+/**************************************************
+ * Benchmark
+ */
+
+static void prv_bench(const char *payloadName,
+                      iowa_lwm2m_uri_t *baseUriP,
+                      iowa_lwm2m_data_t *dataP,
+                      size_t dataCount,
+                      bench_format_t *formatP)
+{
+    iowa_content_format_t format;
+    uint8_t *bufferP;
+    size_t bufferLength;
+    iowa_lwm2m_data_t *decodedP;
+    size_t decodedCount;
+    size_t i;
+    double start;
+    double encodeNs;
+    double decodeNs;
+
+    // Check the round trip
+    format = formatP->format;
+    if (dataLwm2mSerialize(baseUriP, dataP, dataCount, &format, 0, &bufferP, &bufferLength) != IOWA_COAP_NO_ERROR
+        || format != formatP->format)
+    {
+        fprintf(stdout, "%-10s %-12s encoding failed\r\n", payloadName, formatP->name);
+        return;
+    }
+    if (dataLwm2mDeserialize(baseUriP, bufferP, bufferLength, format, &decodedP, &decodedCount, prv_resourceType, NULL) != IOWA_COAP_NO_ERROR)
+    {
+        fprintf(stdout, "%-10s %-12s decoding failed\r\n", payloadName, formatP->name);
+        free(bufferP);
+        return;
+    }
+    for (i = 0; i < dataCount; i++)
+    {
+        if (decodedCount != dataCount
+            || prv_isSameData(dataP + i, decodedP + i) == false)
+        {
+            fprintf(stdout, "%-10s %-12s round trip mismatch\r\n", payloadName, formatP->name);
+            dataLwm2mFree(decodedCount, decodedP);
+            free(bufferP);
+            return;
+        }
+    }
+    dataLwm2mFree(decodedCount, decodedP);
+
+    start = prv_now();
+    for (i = 0; i < BENCH_ITERATION_COUNT; i++)
+    {
+        uint8_t *tmpP;
+        size_t tmpLength;
+
+        (void)dataLwm2mSerialize(baseUriP, dataP, dataCount, &format, 0, &tmpP, &tmpLength);
+        free(tmpP);
+    }
+    encodeNs = (prv_now() - start) / BENCH_ITERATION_COUNT;
+
+    start = prv_now();
+    for (i = 0; i < BENCH_ITERATION_COUNT; i++)
+    {
+        (void)dataLwm2mDeserialize(baseUriP, bufferP, bufferLength, format, &decodedP, &decodedCount, prv_resourceType, NULL);
+        dataLwm2mFree(decodedCount, decodedP);
+    }
+    decodeNs = (prv_now() - start) / BENCH_ITERATION_COUNT;
+
+    fprintf(stdout, "%-10s %-12s %8u %12.1f %12.1f\r\n", payloadName, formatP->name, (unsigned int)bufferLength, encodeNs, decodeNs);
+
+    free(bufferP);
+}
+
+int main(int argc,
+         char *argv[])
+{
+    bench_format_t formatArray[] = {
+        { "TLV",        IOWA_CONTENT_FORMAT_TLV },
+        { "SenML-CBOR", IOWA_CONTENT_FORMAT_SENML_CBOR },
+        { "LwM2M-CBOR", IOWA_CONTENT_FORMAT_LWM2M_CBOR }
+    };
+    iowa_lwm2m_data_t deviceArray[16];
+    iowa_lwm2m_data_t sensorArray[4 * BENCH_SENSOR_COUNT];
+    size_t deviceCount;
+    size_t sensorCount;
+    iowa_lwm2m_uri_t deviceUri;
+    iowa_lwm2m_uri_t sensorUri;
+    size_t i;
+
+    (void)argc;
+    (void)argv;
+
+    deviceCount = prv_buildDevice(deviceArray);
+    sensorCount = prv_buildSensors(sensorArray);
+
+    LWM2M_URI_RESET(&deviceUri);
+    deviceUri.objectId = BENCH_DEVICE_OBJECT_ID;
+    deviceUri.instanceId = 0;
+    LWM2M_URI_RESET(&sensorUri);
+    sensorUri.objectId = BENCH_TEMPERATURE_OBJECT_ID;
+
+    fprintf(stdout, "Sizes are in bytes, durations in nanoseconds per payload.\r\n\n");
+    fprintf(stdout, "%-10s %-12s %8s %12s %12s\r\n", "payload", "format", "size", "encode", "decode");
+
+    for (i = 0; i < sizeof(formatArray) / sizeof(formatArray[0]); i++)
+    {
+        prv_bench("device", &deviceUri, deviceArray, deviceCount, formatArray + i);
+    }
+    for (i = 0; i < sizeof(formatArray) / sizeof(formatArray[0]); i++)
+    {
+        prv_bench("sensors", &sensorUri, sensorArray, sensorCount, formatArray + i);
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/*********************************************
+*
+* IOWA configuration used by the benchmarks.
+* Logs are disabled to measure only the stack.
+*
+**********************************************/
+
+#ifndef _IOWA_CONFIG_INCLUDE_
+#define _IOWA_CONFIG_INCLUDE_
+
+/**********************************************
+*
+* Platform configuration.
+*
+**********************************************/
+
+#define LWM2M_LITTLE_ENDIAN
+
+#define IOWA_BUFFER_SIZE 512
+
+/**********************************************
+*
+* IOWA configuration.
+*
+**********************************************/
+
+#define IOWA_UDP_SUPPORT
+
+#define IOWA_LOG_LEVEL IOWA_LOG_LEVEL_NONE
+
+/**********************************************
+* To enable LWM2M features.
+**********************************************/
+
+#define LWM2M_CLIENT_MODE
+
+/**********************************************
+* To enable the data formats compared by data_format_benchmark.
+**********************************************/
+
+#define LWM2M_SUPPORT_TLV
+#define LWM2M_SUPPORT_SENML_CBOR
+#define LWM2M_SUPPORT_LWM2M_CBOR
+
+#endif
@@ -0,0 +1,1357 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * End-to-end load benchmark of the LwM2M Client.
+ *
+ * A minimal LwM2M Server stand-in runs in the same
+ * process on a loopback UDP socket. It answers the
+ * Register, Update and De-register requests and
+ * issues Read, Write, Observe and Discover requests
+ * at configurable rates while the application
+ * updates the observed values.
+ *
+ * The client and the server stand-in share one
+ * thread: each loop iteration runs iowa_step() with
+ * a null timeout, then handles the datagrams
+ * received by the server stand-in and sends the
+ * requests which are due.
+ *
+ * Three object setups taken from the samples are
+ * measured:
+ *  - device: the Device Object of 01-baseline_client,
+ *  - ipso: the sensors of 02-IPSO_client,
+ *  - multi_instance: the custom Object with several
+ *    instances of 05-custom_object_multiple_instances.
+ *
+ * For each setup, it reports the requests per second,
+ * the p50 and p99 response latencies, the
+ * notifications per second and the
+ * iowa_system_malloc() calls per operation. The peak
+ * RSS is reported once for the whole run as the
+ * system only keeps the high-water mark of the
+ * process. The results are printed and written as
+ * JSON.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_client.h"
+#include "iowa_ipso.h"
+
+// Header file containing the definition of the custom Object of the 05 sample
+#include "sample_object.h"
+
+// Allocation counters and CoAP encoding
+#include "benchmark_helpers.h"
+
+// Platform specific headers
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#define BENCH_SERVER_SHORT_ID    1
+#define BENCH_ENDPOINT_NAME      "IOWA_load_benchmark"
+#define BENCH_MAX_OUTSTANDING    64
+#define BENCH_MAX_OBSERVATION    8
+#define BENCH_MAX_OPTION         16
+#define BENCH_DATAGRAM_SIZE      2048
+#define BENCH_REQUEST_TIMEOUT_NS 2000000000LL
+#define BENCH_SETUP_TIMEOUT_NS   3000000000LL
+#define BENCH_DRAIN_NS           100000000LL
+
+typedef enum
+{
+    BENCH_OP_READ = 0,
+    BENCH_OP_WRITE,
+    BENCH_OP_OBSERVE,
+    BENCH_OP_DISCOVER,
+    BENCH_OP_COUNT
+} bench_op_t;
+
+static const char *prv_opNameArray[BENCH_OP_COUNT] = { "read", "write", "observe", "discover" };
+
+// An object setup of the samples.
+// - name: the setup name in the reports.
+// - setupCb: adds the Objects to the client.
+// - updateCb: changes an observed value.
+// - cleanupCb: removes the Objects from the client.
+// - writeCb: builds the TLV payload of a Write request. Nil if the setup has no writable resource.
+// - readUri, writeUri, discoverUri: the targets of the requests.
+// - observeUriArray, observeCount: the observed URIs.
+typedef struct
+{
+    const char  *name;
+    bool       (*setupCb)(iowa_context_t iowaH);
+    void       (*updateCb)(iowa_context_t iowaH, uint32_t counter);
+    void       (*cleanupCb)(iowa_context_t iowaH);
+    size_t     (*writeCb)(uint8_t *buffer, uint32_t counter);
+    const char  *readUri;
+    const char  *writeUri;
+    const char  *discoverUri;
+    const char  *observeUriArray[BENCH_MAX_OBSERVATION];
+    size_t       observeCount;
+} bench_scenario_t;
+
+// The benchmark settings.
+// - duration: the measured duration of each setup in seconds.
+// - rateArray: the requests per second of each kind. 0 disables the requests of this kind.
+// - updateRate: the observed value changes per second.
+// - maxOutstanding: the maximum number of requests waiting for a response.
+// - lifetime: the registration lifetime in seconds.
+// - jsonPath: the file to write the results to.
+typedef struct
+{
+    double      duration;
+    double      rateArray[BENCH_OP_COUNT];
+    double      updateRate;
+    size_t      maxOutstanding;
+    int32_t     lifetime;
+    const char *jsonPath;
+} bench_settings_t;
+
+// A decoded CoAP message.
+typedef struct
+{
+    uint8_t        type;
+    uint8_t        code;
+    uint16_t       mid;
+    uint8_t        token[8];
+    uint8_t        tokenLength;
+    size_t         optionCount;
+    uint16_t       optionNumberArray[BENCH_MAX_OPTION];
+    const uint8_t *optionValueArray[BENCH_MAX_OPTION];
+    size_t         optionLengthArray[BENCH_MAX_OPTION];
+    bool           hasObserve;
+} bench_message_t;
+
+// A request waiting for its response.
+typedef struct
+{
+    bool       used;
+    bench_op_t op;
+    uint16_t   mid;
+    uint8_t    token[4];
+    long long  sendTime;
+} bench_pending_t;
+
+// Growable array of latencies in nanoseconds.
+typedef struct
+{
+    uint32_t *valueArray;
+    size_t    count;
+    size_t    size;
+} bench_latency_t;
+
+// The state of the LwM2M Server stand-in.
+typedef struct
+{
+    int                sock;
+    struct sockaddr_in clientAddr;
+    bool               registered;
+    uint16_t           nextMid;
+    uint32_t           nextToken;
+    bench_pending_t    pendingArray[BENCH_MAX_OUTSTANDING];
+    size_t             pendingCount;
+    bool               observeReplied[BENCH_MAX_OBSERVATION];
+    size_t             observeIndex;
+    // Counters
+    uint32_t           registrationCount;
+    uint32_t           updateCount;
+    uint32_t           responseCount[BENCH_OP_COUNT];
+    uint32_t           errorCount;
+    uint32_t           timeoutCount;
+    uint32_t           notificationCount;
+    bench_latency_t    latencyArray[BENCH_OP_COUNT];
+} bench_server_t;
+
+static bench_server_t prv_server;
+
+/**************************************************
+ * System abstraction functions
+ *
+ * iowa_system_malloc() and iowa_system_free() are
+ * provided by benchmark_helpers.c.
+ */
+
+int32_t iowa_system_gettime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int32_t)ts.tv_sec;
+}
+
+void iowa_system_reboot(void *userData)
+{
+    (void)userData;
+
+    fprintf(stderr, "Unexpected reboot request.\r\n");
+    exit(1);
+}
+
+void iowa_system_trace(const char *format,
+                       va_list varArgs)
+{
+    vfprintf(stderr, format, varArgs);
+}
+
+/**************************************************
+ * Helpers
+ */
+
+static long long prv_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void prv_latencyAdd(bench_latency_t *latencyP,
+                           long long duration)
+{
+    if (latencyP->count == latencyP->size)
+    {
+        size_t newSize;
+        uint32_t *newArray;
+
+        newSize = latencyP->size == 0 ? 1024 : 2 * latencyP->size;
+        newArray = (uint32_t *)realloc(latencyP->valueArray, newSize * sizeof(uint32_t));
+        if (newArray == NULL)
+        {
+            return;
+        }
+        latencyP->valueArray = newArray;
+        latencyP->size = newSize;
+    }
+
+    latencyP->valueArray[latencyP->count] = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
+    latencyP->count++;
+}
+
+static int prv_compareLatency(const void *aP,
+                              const void *bP)
+{
+    uint32_t a;
+    uint32_t b;
+
+    a = *(const uint32_t *)aP;
+    b = *(const uint32_t *)bP;
+
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+// Returns the percentile in microseconds. The latencies are sorted.
+static double prv_percentile(bench_latency_t *latencyP,
+                             double percentile)
+{
+    size_t index;
+
+    if (latencyP->count == 0)
+    {
+        return 0.0;
+    }
+
+    index = (size_t)(percentile / 100.0 * (double)(latencyP->count - 1) + 0.5);
+
+    return latencyP->valueArray[index] / 1000.0;
+}
+
+/**************************************************
+ * CoAP decoding
+ */
+
+static bool prv_decodeOptionField(const uint8_t *buffer,
+                                  size_t length,
+                                  size_t *indexP,
+                                  size_t *valueP)
+{
+    switch (*valueP)
+    {
+    case 13:
+        if (*indexP + 1 > length)
+        {
+            return false;
+        }
+        *valueP = (size_t)buffer[*indexP] + 13;
+        *indexP += 1;
+        break;
+
+    case 14:
+        if (*indexP + 2 > length)
+        {
+            return false;
+        }
+        *valueP = (((size_t)buffer[*indexP] << 8) | buffer[*indexP + 1]) + 269;
+        *indexP += 2;
+        break;
+
+    case 15:
+        return false;
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
+static bool prv_decode(const uint8_t *buffer,
+                       size_t length,
+                       bench_message_t *messageP)
+{
+    size_t index;
+    uint16_t number;
+
+    if (length < 4
+        || (buffer[0] >> 6) != 1)
+    {
+        return false;
+    }
+
+    memset(messageP, 0, sizeof(bench_message_t));
+    messageP->type = (uint8_t)((buffer[0] >> 4) & 0x03);
+    messageP->tokenLength = (uint8_t)(buffer[0] & 0x0F);
+    messageP->code = buffer[1];
+    messageP->mid = (uint16_t)((buffer[2] << 8) | buffer[3]);
+    if (messageP->tokenLength > 8
+        || 4 + (size_t)messageP->tokenLength > length)
+    {
+        return false;
+    }
+    memcpy(messageP->token, buffer + 4, messageP->tokenLength);
+
+    index = 4 + (size_t)messageP->tokenLength;
+    number = 0;
+    while (index < length
+           && buffer[index] != 0xFF)
+    {
+        size_t delta;
+        size_t optionLength;
+
+        delta = buffer[index] >> 4;
+        optionLength = buffer[index] & 0x0F;
+        index++;
+        if (prv_decodeOptionField(buffer, length, &index, &delta) == false
+            || prv_decodeOptionField(buffer, length, &index, &optionLength) == false
+            || index + optionLength > length)
+        {
+            return false;
+        }
+        number = (uint16_t)(number + delta);
+
+        if (number == COAP_OPTION_OBSERVE)
+        {
+            messageP->hasObserve = true;
+        }
+        if (messageP->optionCount < BENCH_MAX_OPTION)
+        {
+            messageP->optionNumberArray[messageP->optionCount] = number;
+            messageP->optionValueArray[messageP->optionCount] = buffer + index;
+            messageP->optionLengthArray[messageP->optionCount] = optionLength;
+            messageP->optionCount++;
+        }
+        index += optionLength;
+    }
+
+    return true;
+}
+
+// Returns the number of Uri-Path options and checks the first two segments.
+static size_t prv_getUriPath(bench_message_t *messageP,
+                             const char *firstSegment,
+                             const char *secondSegment,
+                             bool *matchP)
+{
+    size_t count;
+    size_t i;
+
+    count = 0;
+    *matchP = true;
+    for (i = 0; i < messageP->optionCount; i++)
+    {
+        const char *expectedP;
+
+        if (messageP->optionNumberArray[i] != COAP_OPTION_URI_PATH)
+        {
+            continue;
+        }
+
+        expectedP = count == 0 ? firstSegment : (count == 1 ? secondSegment : NULL);
+        if (expectedP == NULL
+            || strlen(expectedP) != messageP->optionLengthArray[i]
+            || memcmp(expectedP, messageP->optionValueArray[i], messageP->optionLengthArray[i]) != 0)
+        {
+            *matchP = false;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/**************************************************
+ * LwM2M Server stand-in
+ */
+
+static bool prv_serverOpen(char *uri,
+                           size_t uriSize)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLength;
+
+    memset(&prv_server, 0, sizeof(bench_server_t));
+
+    prv_server.sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (prv_server.sock < 0)
+    {
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    addrLength = sizeof(addr);
+    if (bind(prv_server.sock, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || getsockname(prv_server.sock, (struct sockaddr *)&addr, &addrLength) != 0)
+    {
+        close(prv_server.sock);
+        return false;
+    }
+
+    snprintf(uri, uriSize, "coap://127.0.0.1:%u", (unsigned int)ntohs(addr.sin_port));
+    prv_server.nextMid = 1;
+
+    return true;
+}
+
+static void prv_serverClose(void)
+{
+    size_t i;
+
+    close(prv_server.sock);
+    for (i = 0; i < BENCH_OP_COUNT; i++)
+    {
+        free(prv_server.latencyArray[i].valueArray);
+    }
+}
+
+// Reset the counters at the start of the measured period. The registrations are counted from the start.
+static void prv_serverResetCounters(void)
+{
+    size_t i;
+
+    prv_server.updateCount = 0;
+    prv_server.errorCount = 0;
+    prv_server.timeoutCount = 0;
+    prv_server.notificationCount = 0;
+    for (i = 0; i < BENCH_OP_COUNT; i++)
+    {
+        prv_server.responseCount[i] = 0;
+        prv_server.latencyArray[i].count = 0;
+    }
+}
+
+static void prv_serverSend(const uint8_t *buffer,
+                           size_t length)
+{
+    (void)sendto(prv_server.sock, buffer, length, 0, (struct sockaddr *)&prv_server.clientAddr, sizeof(prv_server.clientAddr));
+}
+
+// Answer the Register, Update and De-register requests.
+static void prv_serverHandleRequest(bench_message_t *messageP)
+{
+    uint8_t buffer[64];
+    size_t length;
+    uint16_t lastNumber;
+    uint8_t code;
+    size_t segmentCount;
+    bool match;
+
+    lastNumber = 0;
+    length = 0;
+    segmentCount = prv_getUriPath(messageP, "rd", "0", &match);
+
+    if (messageP->code == COAP_POST
+        && segmentCount == 1
+        && match == true)
+    {
+        code = COAP_201_CREATED;
+        prv_server.registered = true;
+        prv_server.registrationCount++;
+    }
+    else if (messageP->code == COAP_POST
+             && segmentCount == 2
+             && match == true)
+    {
+        code = COAP_204_CHANGED;
+        prv_server.updateCount++;
+    }
+    else if (messageP->code == COAP_DELETE
+             && segmentCount == 2
+             && match == true)
+    {
+        code = COAP_202_DELETED;
+        prv_server.registered = false;
+    }
+    else
+    {
+        code = COAP_404_NOT_FOUND;
+    }
+
+    length = benchCoapEncodeHeader(buffer, messageP->type == COAP_TYPE_CON ? COAP_TYPE_ACK : COAP_TYPE_NON, code, messageP->mid, messageP->token, messageP->tokenLength);
+    if (code == COAP_201_CREATED)
+    {
+        length += benchCoapAddOption(buffer + length, &lastNumber, COAP_OPTION_LOCATION_PATH, (const uint8_t *)"rd", 2);
+        length += benchCoapAddOption(buffer + length, &lastNumber, COAP_OPTION_LOCATION_PATH, (const uint8_t *)"0", 1);
+    }
+    prv_serverSend(buffer, length);
+}
+
+static bench_pending_t * prv_serverFindPending(bench_message_t *messageP)
+{
+    size_t i;
+
+    for (i = 0; i < BENCH_MAX_OUTSTANDING; i++)
+    {
+        bench_pending_t *pendingP;
+
+        pendingP = prv_server.pendingArray + i;
+        if (pendingP->used == true)
+        {
+            // Piggybacked responses match by message ID, separate ones by token
+            if ((messageP->type == COAP_TYPE_ACK && pendingP->mid == messageP->mid)
+                || (messageP->type != COAP_TYPE_ACK && messageP->tokenLength == 4 && memcmp(pendingP->token, messageP->token, 4) == 0))
+            {
+                return pendingP;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void prv_serverHandleResponse(bench_message_t *messageP,
+                                     long long now)
+{
+    bench_pending_t *pendingP;
+
+    if (messageP->code == 0)
+    {
+        // Empty acknowledgement of a separate response or reset
+        return;
+    }
+
+    if (messageP->type == COAP_TYPE_CON)
+    {
+        uint8_t buffer[4];
+
+        (void)benchCoapEncodeHeader(buffer, COAP_TYPE_ACK, 0, messageP->mid, NULL, 0);
+        prv_serverSend(buffer, 4);
+    }
+
+    pendingP = prv_serverFindPending(messageP);
+    if (pendingP != NULL)
+    {
+        if ((messageP->code >> 5) != 2)
+        {
+            prv_server.errorCount++;
+        }
+        prv_server.responseCount[pendingP->op]++;
+        prv_latencyAdd(prv_server.latencyArray + pendingP->op, now - pendingP->sendTime);
+        if (pendingP->op == BENCH_OP_OBSERVE
+            && pendingP->token[0] == 'O')
+        {
+            prv_server.observeReplied[pendingP->token[1]] = true;
+        }
+        pendingP->used = false;
+        prv_server.pendingCount--;
+    }
+    else if (messageP->hasObserve == true
+             && messageP->tokenLength == 4
+             && messageP->token[0] == 'O')
+    {
+        prv_server.notificationCount++;
+    }
+}
+
+// Handle all the datagrams received by the server stand-in.
+static void prv_serverPoll(void)
+{
+    uint8_t buffer[BENCH_DATAGRAM_SIZE];
+    long long now;
+
+    now = 0;
+    while (true)
+    {
+        struct sockaddr_in addr;
+        socklen_t addrLength;
+        ssize_t length;
+        bench_message_t message;
+
+        addrLength = sizeof(addr);
+        length = recvfrom(prv_server.sock, buffer, sizeof(buffer), MSG_DONTWAIT, (struct sockaddr *)&addr, &addrLength);
+        if (length <= 0)
+        {
+            break;
+        }
+        if (now == 0)
+        {
+            now = prv_now();
+        }
+        if (prv_decode(buffer, (size_t)length, &message) == false)
+        {
+            continue;
+        }
+
+        if (message.code != 0
+            && message.code < 32)
+        {
+            prv_server.clientAddr = addr;
+            prv_serverHandleRequest(&message);
+        }
+        else
+        {
+            prv_serverHandleResponse(&message, now);
+        }
+    }
+}
+
+// Send a request. The tokens of the observations are 'O' followed by the observation index, the other ones 'R' and a counter.
+static bool prv_serverSendRequest(bench_scenario_t *scenarioP,
+                                  bench_op_t op,
+                                  uint32_t counter)
+{
+    uint8_t buffer[BENCH_DATAGRAM_SIZE];
+    size_t length;
+    uint16_t lastNumber;
+    bench_pending_t *pendingP;
+    size_t i;
+    const char *uri;
+    uint8_t code;
+
+    pendingP = NULL;
+    for (i = 0; i < BENCH_MAX_OUTSTANDING; i++)
+    {
+        if (prv_server.pendingArray[i].used == false)
+        {
+            pendingP = prv_server.pendingArray + i;
+            break;
+        }
+    }
+    if (pendingP == NULL)
+    {
+        return false;
+    }
+
+    switch (op)
+    {
+    case BENCH_OP_WRITE:
+        code = COAP_PUT;
+        uri = scenarioP->writeUri;
+        break;
+
+    case BENCH_OP_OBSERVE:
+        // Observing again with the token of an observation refreshes it
+        code = COAP_GET;
+        uri = scenarioP->observeUriArray[prv_server.observeIndex];
+        break;
+
+    case BENCH_OP_DISCOVER:
+        code = COAP_GET;
+        uri = scenarioP->discoverUri;
+        break;
+
+    default:
+        code = COAP_GET;
+        uri = scenarioP->readUri;
+        break;
+    }
+
+    if (op == BENCH_OP_OBSERVE)
+    {
+        pendingP->token[0] = 'O';
+        pendingP->token[1] = (uint8_t)prv_server.observeIndex;
+        pendingP->token[2] = 0;
+        pendingP->token[3] = 0;
+        prv_server.observeIndex = (prv_server.observeIndex + 1) % scenarioP->observeCount;
+    }
+    else
+    {
+        pendingP->token[0] = 'R';
+        pendingP->token[1] = (uint8_t)(prv_server.nextToken >> 16);
+        pendingP->token[2] = (uint8_t)(prv_server.nextToken >> 8);
+        pendingP->token[3] = (uint8_t)prv_server.nextToken;
+        prv_server.nextToken++;
+    }
+
+    lastNumber = 0;
+    length = benchCoapEncodeHeader(buffer, COAP_TYPE_CON, code, prv_server.nextMid, pendingP->token, 4);
+    if (op == BENCH_OP_OBSERVE)
+    {
+        length += benchCoapAddIntegerOption(buffer + length, &lastNumber, COAP_OPTION_OBSERVE, 0);
+    }
+    length += benchCoapAddUriPath(buffer + length, &lastNumber, uri);
+    if (op == BENCH_OP_WRITE)
+    {
+        length += benchCoapAddIntegerOption(buffer + length, &lastNumber, COAP_OPTION_CONTENT_FORMAT, COAP_FORMAT_TLV);
+        buffer[length++] = 0xFF;
+        length += scenarioP->writeCb(buffer + length, counter);
+    }
+    else if (op == BENCH_OP_DISCOVER)
+    {
+        length += benchCoapAddIntegerOption(buffer + length, &lastNumber, COAP_OPTION_ACCEPT, COAP_FORMAT_LINK);
+    }
+
+    pendingP->used = true;
+    pendingP->op = op;
+    pendingP->mid = prv_server.nextMid;
+    pendingP->sendTime = prv_now();
+    prv_server.nextMid++;
+    prv_server.pendingCount++;
+
+    prv_serverSend(buffer, length);
+
+    return true;
+}
+
+// Forget the requests which did not get a response.
+static void prv_serverExpire(long long now)
+{
+    size_t i;
+
+    for (i = 0; i < BENCH_MAX_OUTSTANDING; i++)
+    {
+        if (prv_server.pendingArray[i].used == true
+            && now - prv_server.pendingArray[i].sendTime > BENCH_REQUEST_TIMEOUT_NS)
+        {
+            prv_server.pendingArray[i].used = false;
+            prv_server.pendingCount--;
+            prv_server.timeoutCount++;
+        }
+    }
+}
+
+/**************************************************
+ * Object setups
+ */
+
+// 01-baseline_client: the Device Object. The battery level is observed and the UTC offset is written.
+static bool prv_deviceSetup(iowa_context_t iowaH)
+{
+    (void)iowaH;
+    return true;
+}
+
+static void prv_deviceUpdate(iowa_context_t iowaH,
+                             uint32_t counter)
+{
+    (void)iowa_client_device_update_battery(iowaH, (uint8_t)(counter % 100), IOWA_DEVICE_BATTERY_STATUS_NORMAL);
+}
+
+static void prv_deviceCleanup(iowa_context_t iowaH)
+{
+    (void)iowaH;
+}
+
+static size_t prv_deviceWrite(uint8_t *buffer,
+                              uint32_t counter)
+{
+    // TLV Resource 14 with a six-byte string value
+    buffer[0] = 0xC6;
+    buffer[1] = 14;
+    memcpy(buffer + 2, (counter % 2) == 0 ? "+01:00" : "+02:00", 6);
+
+    return 8;
+}
+
+// 02-IPSO_client: IPSO sensors. Their Sensor Value is observed.
+static iowa_sensor_t prv_sensorArray[4];
+
+static bool prv_ipsoSetup(iowa_context_t iowaH)
+{
+    if (iowa_client_IPSO_add_sensor(iowaH, IOWA_IPSO_TEMPERATURE, 20, "Cel", "Test Temperature", -20.0, 50.0, prv_sensorArray) != IOWA_COAP_NO_ERROR
+        || iowa_client_IPSO_add_sensor(iowaH, IOWA_IPSO_HUMIDITY, 40, "%RH", NULL, 0.0, 100.0, prv_sensorArray + 1) != IOWA_COAP_NO_ERROR
+        || iowa_client_IPSO_add_sensor(iowaH, IOWA_IPSO_BAROMETER, 1013, "hPa", NULL, 900.0, 1100.0, prv_sensorArray + 2) != IOWA_COAP_NO_ERROR
+        || iowa_client_IPSO_add_sensor(iowaH, IOWA_IPSO_ILLUMINANCE, 300, "lx", NULL, 0.0, 10000.0, prv_sensorArray + 3) != IOWA_COAP_NO_ERROR)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static void prv_ipsoUpdate(iowa_context_t iowaH,
+                           uint32_t counter)
+{
+    (void)iowa_client_IPSO_update_value(iowaH, prv_sensorArray[counter % 4], (float)(20 + counter % 16));
+}
+
+static void prv_ipsoCleanup(iowa_context_t iowaH)
+{
+    size_t i;
+
+    for (i = 0; i < 4; i++)
+    {
+        (void)iowa_client_IPSO_remove_sensor(iowaH, prv_sensorArray[i]);
+    }
+}
+
+// 05-custom_object_multiple_instances: the sample Object with three instances. Their integer value is observed and written.
+static sample_instance_values_t prv_instanceValues[3];
+
+static bool prv_multiInstanceSetup(iowa_context_t iowaH)
+{
+    iowa_lwm2m_resource_desc_t resources[SAMPLE_RES_COUNT] = SAMPLE_RES_DESCRIPTION;
+    uint16_t instanceIds[3];
+    size_t i;
+
+    for (i = 0; i < 3; i++)
+    {
+        prv_instanceValues[i].id = (uint16_t)(2 * i + 1);
+        prv_instanceValues[i].booleanValue = (i % 2) == 0;
+        prv_instanceValues[i].integerValue = (int)(10 * i);
+        prv_instanceValues[i].stringValue = strdup("Sample instance");
+        instanceIds[i] = prv_instanceValues[i].id;
+    }
+
+    return iowa_client_add_custom_object(iowaH, SAMPLE_OBJECT_ID, 3, instanceIds, SAMPLE_RES_COUNT, resources, sample_object_dataCallback, NULL, NULL, prv_instanceValues) == IOWA_COAP_NO_ERROR;
+}
+
+static void prv_multiInstanceUpdate(iowa_context_t iowaH,
+                                    uint32_t counter)
+{
+    sample_instance_values_t *valuesP;
+
+    valuesP = prv_instanceValues + counter % 3;
+    valuesP->integerValue++;
+    (void)iowa_client_object_resource_changed(iowaH, SAMPLE_OBJECT_ID, valuesP->id, 5503);
+}
+
+static void prv_multiInstanceCleanup(iowa_context_t iowaH)
+{
+    size_t i;
+
+    (void)iowa_client_remove_custom_object(iowaH, SAMPLE_OBJECT_ID);
+    for (i = 0; i < 3; i++)
+    {
+        free(prv_instanceValues[i].stringValue);
+    }
+}
+
+static size_t prv_multiInstanceWrite(uint8_t *buffer,
+                                     uint32_t counter)
+{
+    // TLV Resource 5503 with a one-byte integer value
+    buffer[0] = 0xE1;
+    buffer[1] = (uint8_t)(5503 >> 8);
+    buffer[2] = (uint8_t)(5503 & 0xFF);
+    buffer[3] = (uint8_t)(counter & 0x7F);
+
+    return 4;
+}
+
+static bench_scenario_t prv_scenarioArray[] =
+{
+    {
+        "device", prv_deviceSetup, prv_deviceUpdate, prv_deviceCleanup, prv_deviceWrite,
+        "/3/0", "/3/0/14", "/3/0",
+        { "/3/0/9" }, 1
+    },
+    {
+        "ipso", prv_ipsoSetup, prv_ipsoUpdate, prv_ipsoCleanup, NULL,
+        "/3303/0/5700", NULL, "/3303/0",
+        { "/3303/0/5700", "/3304/0/5700", "/3315/0/5700", "/3301/0/5700" }, 4
+    },
+    {
+        "multi_instance", prv_multiInstanceSetup, prv_multiInstanceUpdate, prv_multiInstanceCleanup, prv_multiInstanceWrite,
+        "/3200", "/3200/3/5503", "/3200",
+        { "/3200/1/5503", "/3200/3/5503", "/3200/5/5503" }, 3
+    }
+};
+
+/**************************************************
+ * Benchmark
+ */
+
+// The measures of an object setup.
+typedef struct
+{
+    double   duration;
+    uint32_t requestCount;
+    uint32_t notificationCount;
+    uint64_t allocationCount;
+    uint64_t allocatedBytes;
+    size_t   peakBytes;
+} bench_result_t;
+
+// Run iowa_step() and the server stand-in until condition becomes true or the timeout elapses.
+static bool prv_runUntil(iowa_context_t iowaH,
+                         bool *conditionP,
+                         long long timeout)
+{
+    long long endTime;
+
+    endTime = prv_now() + timeout;
+    while (*conditionP == false)
+    {
+        if (iowa_step(iowaH, 0) != IOWA_COAP_NO_ERROR
+            || prv_now() > endTime)
+        {
+            return false;
+        }
+        prv_serverPoll();
+    }
+
+    return true;
+}
+
+static bool prv_allObserved(bench_scenario_t *scenarioP)
+{
+    size_t i;
+
+    for (i = 0; i < scenarioP->observeCount; i++)
+    {
+        if (prv_server.observeReplied[i] == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool prv_runScenario(bench_scenario_t *scenarioP,
+                            bench_settings_t *settingsP,
+                            bench_result_t *resultP)
+{
+    iowa_context_t iowaH;
+    iowa_device_info_t devInfo;
+    char serverUri[64];
+    bool success;
+    long long startTime;
+    long long endTime;
+    long long now;
+    long long nextTimeArray[BENCH_OP_COUNT];
+    long long intervalArray[BENCH_OP_COUNT];
+    long long nextUpdateTime;
+    long long updateInterval;
+    uint32_t counter;
+    size_t i;
+    bench_allocation_t allocationStart;
+
+    memset(resultP, 0, sizeof(bench_result_t));
+
+    if (prv_serverOpen(serverUri, sizeof(serverUri)) == false)
+    {
+        fprintf(stderr, "Opening the server socket failed: %s.\r\n", strerror(errno));
+        return false;
+    }
+
+    success = false;
+
+    iowaH = iowa_init(NULL);
+    if (iowaH == NULL)
+    {
+        prv_serverClose();
+        return false;
+    }
+
+    memset(&devInfo, 0, sizeof(iowa_device_info_t));
+    devInfo.manufacturer = "IOWA";
+    devInfo.deviceType = "Benchmark";
+    devInfo.modelNumber = scenarioP->name;
+    devInfo.serialNumber = "0123456789";
+    devInfo.firmwareVersion = "1.0";
+    devInfo.optFlags = IOWA_DEVICE_RSC_BATTERY | IOWA_DEVICE_RSC_UTC_OFFSET;
+    devInfo.utcOffsetP = "+01:00";
+
+    if (iowa_client_configure(iowaH, BENCH_ENDPOINT_NAME, &devInfo, NULL) != IOWA_COAP_NO_ERROR
+        || scenarioP->setupCb(iowaH) == false)
+    {
+        fprintf(stderr, "%s: setting up the client failed.\r\n", scenarioP->name);
+        goto cleanup;
+    }
+
+    if (iowa_client_add_server(iowaH, BENCH_SERVER_SHORT_ID, serverUri, settingsP->lifetime, 0, IOWA_SEC_NONE) != IOWA_COAP_NO_ERROR
+        || prv_runUntil(iowaH, &prv_server.registered, BENCH_SETUP_TIMEOUT_NS) == false)
+    {
+        fprintf(stderr, "%s: the registration failed.\r\n", scenarioP->name);
+        goto remove_objects;
+    }
+
+    // Start the observations
+    for (i = 0; i < scenarioP->observeCount; i++)
+    {
+        (void)prv_serverSendRequest(scenarioP, BENCH_OP_OBSERVE, 0);
+    }
+    endTime = prv_now() + BENCH_SETUP_TIMEOUT_NS;
+    while (prv_allObserved(scenarioP) == false)
+    {
+        if (iowa_step(iowaH, 0) != IOWA_COAP_NO_ERROR
+            || prv_now() > endTime)
+        {
+            fprintf(stderr, "%s: the observations failed.\r\n", scenarioP->name);
+            goto remove_server;
+        }
+        prv_serverPoll();
+    }
+
+    // Measured period
+    prv_serverResetCounters();
+    allocationStart = benchAllocation;
+    benchAllocation.peakBytes = benchAllocation.outstandingBytes;
+
+    startTime = prv_now();
+    endTime = startTime + (long long)(settingsP->duration * 1e9);
+    for (i = 0; i < BENCH_OP_COUNT; i++)
+    {
+        if (settingsP->rateArray[i] > 0
+            && (i != BENCH_OP_WRITE || scenarioP->writeCb != NULL))
+        {
+            intervalArray[i] = (long long)(1e9 / settingsP->rateArray[i]);
+            nextTimeArray[i] = startTime;
+        }
+        else
+        {
+            intervalArray[i] = 0;
+            nextTimeArray[i] = endTime;
+        }
+    }
+    updateInterval = settingsP->updateRate > 0 ? (long long)(1e9 / settingsP->updateRate) : 0;
+    nextUpdateTime = updateInterval > 0 ? startTime : endTime;
+    counter = 0;
+
+    now = startTime;
+    while (now < endTime)
+    {
+        if (iowa_step(iowaH, 0) != IOWA_COAP_NO_ERROR)
+        {
+            fprintf(stderr, "%s: iowa_step() failed.\r\n", scenarioP->name);
+            goto remove_server;
+        }
+        prv_serverPoll();
+
+        now = prv_now();
+        for (i = 0; i < BENCH_OP_COUNT; i++)
+        {
+            if (intervalArray[i] != 0
+                && now >= nextTimeArray[i]
+                && prv_server.pendingCount < settingsP->maxOutstanding)
+            {
+                if (prv_serverSendRequest(scenarioP, (bench_op_t)i, counter) == true)
+                {
+                    counter++;
+                }
+                nextTimeArray[i] += intervalArray[i];
+                // Do not try to catch up after a stall
+                if (nextTimeArray[i] < now - 1000000000LL)
+                {
+                    nextTimeArray[i] = now;
+                }
+            }
+        }
+        if (updateInterval != 0
+            && now >= nextUpdateTime)
+        {
+            scenarioP->updateCb(iowaH, counter);
+            counter++;
+            nextUpdateTime += updateInterval;
+            if (nextUpdateTime < now - 1000000000LL)
+            {
+                nextUpdateTime = now;
+            }
+        }
+        prv_serverExpire(now);
+    }
+
+    // Collect the last responses
+    endTime = prv_now() + BENCH_DRAIN_NS;
+    while (prv_server.pendingCount > 0
+           && prv_now() < endTime)
+    {
+        (void)iowa_step(iowaH, 0);
+        prv_serverPoll();
+    }
+    now = prv_now();
+
+    resultP->duration = (double)(now - startTime) / 1e9;
+    for (i = 0; i < BENCH_OP_COUNT; i++)
+    {
+        resultP->requestCount += prv_server.responseCount[i];
+        if (prv_server.latencyArray[i].count > 0)
+        {
+            qsort(prv_server.latencyArray[i].valueArray, prv_server.latencyArray[i].count, sizeof(uint32_t), prv_compareLatency);
+        }
+    }
+    resultP->notificationCount = prv_server.notificationCount;
+    resultP->allocationCount = benchAllocation.allocationCount - allocationStart.allocationCount;
+    resultP->allocatedBytes = benchAllocation.allocatedBytes - allocationStart.allocatedBytes;
+    resultP->peakBytes = benchAllocation.peakBytes;
+
+    success = true;
+
+remove_server:
+    (void)iowa_client_remove_server(iowaH, BENCH_SERVER_SHORT_ID);
+    prv_serverPoll();
+remove_objects:
+    scenarioP->cleanupCb(iowaH);
+cleanup:
+    iowa_close(iowaH);
+    if (success == false)
+    {
+        prv_serverClose();
+    }
+
+    return success;
+}
+
+static void prv_printResult(bench_scenario_t *scenarioP,
+                            bench_result_t *resultP)
+{
+    size_t i;
+    double operationCount;
+
+    operationCount = (double)resultP->requestCount + resultP->notificationCount;
+
+    fprintf(stdout, "%s: %.0f requests/s, %.0f notifications/s, %.2f allocations per operation\r\n",
+            scenarioP->name,
+            resultP->requestCount / resultP->duration,
+            resultP->notificationCount / resultP->duration,
+            operationCount > 0 ? (double)resultP->allocationCount / operationCount : 0.0);
+    fprintf(stdout, "    registrations: %u, updates: %u, errors: %u, timeouts: %u\r\n",
+            prv_server.registrationCount, prv_server.updateCount, prv_server.errorCount, prv_server.timeoutCount);
+    for (i = 0; i < BENCH_OP_COUNT; i++)
+    {
+        if (prv_server.latencyArray[i].count > 0)
+        {
+            fprintf(stdout, "    %-9s %8u responses, p50 %8.1f us, p99 %8.1f us\r\n",
+                    prv_opNameArray[i],
+                    prv_server.responseCount[i],
+                    prv_percentile(prv_server.latencyArray + i, 50.0),
+                    prv_percentile(prv_server.latencyArray + i, 99.0));
+        }
+    }
+}
+
+static void prv_writeJsonResult(FILE *fileP,
+                                bench_scenario_t *scenarioP,
+                                bench_result_t *resultP)
+{
+    size_t i;
+    bool first;
+    double operationCount;
+
+    operationCount = (double)resultP->requestCount + resultP->notificationCount;
+
+    fprintf(fileP, "    {\n");
+    fprintf(fileP, "      \"name\": \"%s\",\n", scenarioP->name);
+    fprintf(fileP, "      \"duration_s\": %.3f,\n", resultP->duration);
+    fprintf(fileP, "      \"requests\": %u,\n", resultP->requestCount);
+    fprintf(fileP, "      \"requests_per_s\": %.1f,\n", resultP->requestCount / resultP->duration);
+    fprintf(fileP, "      \"errors\": %u,\n", prv_server.errorCount);
+    fprintf(fileP, "      \"timeouts\": %u,\n", prv_server.timeoutCount);
+    fprintf(fileP, "      \"latency_us\": {");
+    first = true;
+    for (i = 0; i < BENCH_OP_COUNT; i++)
+    {
+        if (prv_server.latencyArray[i].count > 0)
+        {
+            fprintf(fileP, "%s\n        \"%s\": { \"count\": %u, \"p50\": %.1f, \"p99\": %.1f }",
+                    first ? "" : ",",
+                    prv_opNameArray[i],
+                    prv_server.responseCount[i],
+                    prv_percentile(prv_server.latencyArray + i, 50.0),
+                    prv_percentile(prv_server.latencyArray + i, 99.0));
+            first = false;
+        }
+    }
+    fprintf(fileP, "%s},\n", first ? "" : "\n      ");
+    fprintf(fileP, "      \"notifications\": %u,\n", resultP->notificationCount);
+    fprintf(fileP, "      \"notifications_per_s\": %.1f,\n", resultP->notificationCount / resultP->duration);
+    fprintf(fileP, "      \"registrations\": %u,\n", prv_server.registrationCount);
+    fprintf(fileP, "      \"updates\": %u,\n", prv_server.updateCount);
+    fprintf(fileP, "      \"allocations\": %llu,\n", (unsigned long long)resultP->allocationCount);
+    fprintf(fileP, "      \"allocated_bytes\": %llu,\n", (unsigned long long)resultP->allocatedBytes);
+    fprintf(fileP, "      \"allocations_per_operation\": %.2f,\n", operationCount > 0 ? (double)resultP->allocationCount / operationCount : 0.0);
+    fprintf(fileP, "      \"peak_heap_bytes\": %lu\n", (unsigned long)resultP->peakBytes);
+    fprintf(fileP, "    }");
+}
+
+static void prv_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [options]\r\n", name);
+    fprintf(stderr, "  -t SECONDS   measured duration of each object setup (default: 5)\r\n");
+    fprintf(stderr, "  -r RATE      Read requests per second (default: 2000)\r\n");
+    fprintf(stderr, "  -w RATE      Write requests per second (default: 1000)\r\n");
+    fprintf(stderr, "  -o RATE      Observe requests per second (default: 200)\r\n");
+    fprintf(stderr, "  -d RATE      Discover requests per second (default: 200)\r\n");
+    fprintf(stderr, "  -u RATE      observed value changes per second (default: 1000)\r\n");
+    fprintf(stderr, "  -c COUNT     maximum outstanding requests, up to %d (default: 8)\r\n", BENCH_MAX_OUTSTANDING);
+    fprintf(stderr, "  -l SECONDS   registration lifetime (default: 4)\r\n");
+    fprintf(stderr, "  -s NAME      only run this object setup (device, ipso or multi_instance)\r\n");
+    fprintf(stderr, "  -j FILE      JSON output file (default: lwm2m_load_benchmark.json)\r\n");
+}
+
+int main(int argc,
+         char *argv[])
+{
+    bench_settings_t settings;
+    bench_result_t result;
+    struct rusage usage;
+    const char *onlyScenario;
+    FILE *fileP;
+    size_t scenarioCount;
+    size_t i;
+    int argIndex;
+    bool isFirst;
+
+    settings.duration = 5.0;
+    settings.rateArray[BENCH_OP_READ] = 2000;
+    settings.rateArray[BENCH_OP_WRITE] = 1000;
+    settings.rateArray[BENCH_OP_OBSERVE] = 200;
+    settings.rateArray[BENCH_OP_DISCOVER] = 200;
+    settings.updateRate = 1000;
+    settings.maxOutstanding = 8;
+    settings.lifetime = 4;
+    settings.jsonPath = "lwm2m_load_benchmark.json";
+    onlyScenario = NULL;
+
+    for (argIndex = 1; argIndex < argc; argIndex++)
+    {
+        const char *valueP;
+
+        if (argv[argIndex][0] != '-'
+            || argv[argIndex][1] == 0
+            || argv[argIndex][2] != 0
+            || argIndex + 1 >= argc)
+        {
+            prv_usage(argv[0]);
+            return 1;
+        }
+        valueP = argv[argIndex + 1];
+
+        switch (argv[argIndex][1])
+        {
+        case 't':
+            settings.duration = atof(valueP);
+            break;
+        case 'r':
+            settings.rateArray[BENCH_OP_READ] = atof(valueP);
+            break;
+        case 'w':
+            settings.rateArray[BENCH_OP_WRITE] = atof(valueP);
+            break;
+        case 'o':
+            settings.rateArray[BENCH_OP_OBSERVE] = atof(valueP);
+            break;
+        case 'd':
+            settings.rateArray[BENCH_OP_DISCOVER] = atof(valueP);
+            break;
+        case 'u':
+            settings.updateRate = atof(valueP);
+            break;
+        case 'c':
+            settings.maxOutstanding = (size_t)atoi(valueP);
+            break;
+        case 'l':
+            settings.lifetime = (int32_t)atoi(valueP);
+            break;
+        case 's':
+            onlyScenario = valueP;
+            break;
+        case 'j':
+            settings.jsonPath = valueP;
+            break;
+        default:
+            prv_usage(argv[0]);
+            return 1;
+        }
+        argIndex++;
+    }
+    if (settings.duration <= 0
+        || settings.maxOutstanding == 0
+        || settings.maxOutstanding > BENCH_MAX_OUTSTANDING
+        || settings.lifetime <= 0)
+    {
+        prv_usage(argv[0]);
+        return 1;
+    }
+
+    fileP = fopen(settings.jsonPath, "w");
+    if (fileP == NULL)
+    {
+        fprintf(stderr, "Cannot open %s: %s.\r\n", settings.jsonPath, strerror(errno));
+        return 1;
+    }
+
+    fprintf(fileP, "{\n");
+    fprintf(fileP, "  \"benchmark\": \"lwm2m_load_benchmark\",\n");
+    fprintf(fileP, "  \"settings\": { \"duration_s\": %.3f, \"read_rate\": %.1f, \"write_rate\": %.1f, \"observe_rate\": %.1f, \"discover_rate\": %.1f, \"update_rate\": %.1f, \"max_outstanding\": %u, \"lifetime_s\": %d },\n",
+            settings.duration,
+            settings.rateArray[BENCH_OP_READ], settings.rateArray[BENCH_OP_WRITE], settings.rateArray[BENCH_OP_OBSERVE], settings.rateArray[BENCH_OP_DISCOVER],
+            settings.updateRate, (unsigned int)settings.maxOutstanding, settings.lifetime);
+    fprintf(fileP, "  \"scenarios\": [\n");
+
+    scenarioCount = sizeof(prv_scenarioArray) / sizeof(prv_scenarioArray[0]);
+    isFirst = true;
+    for (i = 0; i < scenarioCount; i++)
+    {
+        if (onlyScenario != NULL
+            && strcmp(onlyScenario, prv_scenarioArray[i].name) != 0)
+        {
+            continue;
+        }
+
+        if (prv_runScenario(prv_scenarioArray + i, &settings, &result) == false)
+        {
+            fclose(fileP);
+            return 1;
+        }
+
+        prv_printResult(prv_scenarioArray + i, &result);
+        if (isFirst == false)
+        {
+            fprintf(fileP, ",\n");
+        }
+        prv_writeJsonResult(fileP, prv_scenarioArray + i, &result);
+        isFirst = false;
+
+        prv_serverClose();
+    }
+
+    // ru_maxrss is the high-water mark of the whole process, not of a single setup
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(fileP, "\n  ],\n");
+    fprintf(fileP, "  \"peak_rss_kb\": %ld\n", usage.ru_maxrss);
+    fprintf(fileP, "}\n");
+    fclose(fileP);
+
+    fprintf(stdout, "\r\nPeak RSS of the run: %ld kB\r\n", usage.ru_maxrss);
+    fprintf(stdout, "Results written to %s.\r\n", settings.jsonPath);
+
+    return 0;
+}
@@ -0,0 +1,317 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Micro-benchmark of the IOWA timers.
+ *
+ * It compares the timer heap used by coreTimerStep()
+ * with the former implementation based on a linked
+ * list which was fully walked on every step.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_prv_core_internals.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_IDLE_STEP_COUNT 1000
+#define BENCH_UPDATE_COUNT    1000
+
+/**************************************************
+ * Reference implementation: linked list of timers
+ */
+
+typedef struct _list_timer_t
+{
+    struct _list_timer_t *nextP;
+    int32_t               executionTime;
+    timer_callback_t      callback;
+    void                 *userData;
+} list_timer_t;
+
+typedef struct
+{
+    list_timer_t *timerList;
+    int32_t       currentTime;
+    int32_t       timeout;
+} list_context_t;
+
+static list_timer_t * prv_listTimerNew(list_context_t *listP,
+                                       int32_t delay,
+                                       timer_callback_t callback,
+                                       void *userData)
+{
+    list_timer_t *timerP;
+
+    timerP = (list_timer_t *)malloc(sizeof(list_timer_t));
+    if (timerP == NULL)
+    {
+        return NULL;
+    }
+    timerP->callback = callback;
+    timerP->userData = userData;
+    timerP->executionTime = listP->currentTime + delay;
+    timerP->nextP = listP->timerList;
+    listP->timerList = timerP;
+
+    return timerP;
+}
+
+static void prv_listTimerDelete(list_context_t *listP,
+                                list_timer_t *timerP)
+{
+    listP->timerList = (list_timer_t *)IOWA_UTILS_LIST_REMOVE(listP->timerList, timerP);
+    free(timerP);
+}
+
+static void prv_listTimerReset(list_context_t *listP,
+                               list_timer_t *timerP,
+                               int32_t delay)
+{
+    timerP->executionTime = listP->currentTime + delay;
+}
+
+static void prv_listTimerStep(list_context_t *listP)
+{
+    list_timer_t *timerP;
+    list_timer_t *parentTimerP;
+
+    timerP = listP->timerList;
+    parentTimerP = NULL;
+    while (timerP != NULL)
+    {
+        list_timer_t *nextTimerP;
+
+        nextTimerP = timerP->nextP;
+
+        if (timerP->executionTime <= listP->currentTime)
+        {
+            timerP->callback(NULL, timerP->userData);
+
+            if (parentTimerP == NULL)
+            {
+                listP->timerList = timerP->nextP;
+            }
+            else
+            {
+                parentTimerP->nextP = timerP->nextP;
+            }
+
+            free(timerP);
+        }
+        else
+        {
+            if (timerP->executionTime - listP->currentTime < listP->timeout)
+            {
+                listP->timeout = timerP->executionTime - listP->currentTime;
+            }
+
+            parentTimerP = timerP;
+        }
+        timerP = nextTimerP;
+    }
+}
+
+/**************************************************
+ * Helpers
+ */
+
+typedef struct
+{
+    double insertNs;
+    double idleStepNs;
+    double resetNs;
+    double deleteNs;
+    double fireNs;
+} bench_result_t;
+
+static size_t g_firedCount;
+static uint32_t g_randomSeed;
+
+static void prv_timerCallback(iowa_context_t contextP,
+                              void *userData)
+{
+    (void)contextP;
+    (void)userData;
+
+    g_firedCount++;
+}
+
+static uint32_t prv_random(void)
+{
+    // Deterministic LCG so that both implementations see the same sequence
+    g_randomSeed = g_randomSeed * 1103515245 + 12345;
+    return (g_randomSeed >> 8);
+}
+
+static double prv_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**************************************************
+ * Benchmarks
+ */
+
+static void prv_benchHeap(size_t timerCount,
+                          bench_result_t *resultP)
+{
+    struct _iowa_context_t context;
+    iowa_timer_t **timerArray;
+    size_t i;
+    double start;
+
+    memset(&context, 0, sizeof(struct _iowa_context_t));
+    timerArray = (iowa_timer_t **)malloc(timerCount * sizeof(iowa_timer_t *));
+    g_randomSeed = 1;
+    g_firedCount = 0;
+
+    start = prv_now();
+    for (i = 0; i < timerCount; i++)
+    {
+        timerArray[i] = coreTimerNew(&context, (int32_t)(1 + prv_random() % timerCount), prv_timerCallback, NULL);
+    }
+    resultP->insertNs = (prv_now() - start) / (double)timerCount;
+
+    start = prv_now();
+    for (i = 0; i < BENCH_IDLE_STEP_COUNT; i++)
+    {
+        context.timeout = INT32_MAX;
+        coreTimerStep(&context);
+    }
+    resultP->idleStepNs = (prv_now() - start) / BENCH_IDLE_STEP_COUNT;
+
+    start = prv_now();
+    for (i = 0; i < BENCH_UPDATE_COUNT; i++)
+    {
+        (void)coreTimerReset(&context, timerArray[prv_random() % timerCount], (int32_t)(1 + prv_random() % timerCount));
+    }
+    resultP->resetNs = (prv_now() - start) / BENCH_UPDATE_COUNT;
+
+    start = prv_now();
+    for (i = 0; i < BENCH_UPDATE_COUNT && i < timerCount / 2; i++)
+    {
+        size_t index;
+
+        index = prv_random() % (timerCount - i);
+        coreTimerDelete(&context, timerArray[index]);
+        timerArray[index] = timerArray[timerCount - i - 1];
+    }
+    resultP->deleteNs = (prv_now() - start) / (double)i;
+
+    context.currentTime = INT32_MAX / 2;
+    start = prv_now();
+    coreTimerStep(&context);
+    resultP->fireNs = (prv_now() - start) / (double)g_firedCount;
+
+    coreTimerClose(&context);
+    free(timerArray);
+}
+
+static void prv_benchList(size_t timerCount,
+                          bench_result_t *resultP)
+{
+    list_context_t context;
+    list_timer_t **timerArray;
+    size_t i;
+    double start;
+
+    memset(&context, 0, sizeof(list_context_t));
+    timerArray = (list_timer_t **)malloc(timerCount * sizeof(list_timer_t *));
+    g_randomSeed = 1;
+    g_firedCount = 0;
+
+    start = prv_now();
+    for (i = 0; i < timerCount; i++)
+    {
+        timerArray[i] = prv_listTimerNew(&context, (int32_t)(1 + prv_random() % timerCount), prv_timerCallback, NULL);
+    }
+    resultP->insertNs = (prv_now() - start) / (double)timerCount;
+
+    start = prv_now();
+    for (i = 0; i < BENCH_IDLE_STEP_COUNT; i++)
+    {
+        context.timeout = INT32_MAX;
+        prv_listTimerStep(&context);
+    }
+    resultP->idleStepNs = (prv_now() - start) / BENCH_IDLE_STEP_COUNT;
+
+    start = prv_now();
+    for (i = 0; i < BENCH_UPDATE_COUNT; i++)
+    {
+        prv_listTimerReset(&context, timerArray[prv_random() % timerCount], (int32_t)(1 + prv_random() % timerCount));
+    }
+    resultP->resetNs = (prv_now() - start) / BENCH_UPDATE_COUNT;
+
+    start = prv_now();
+    for (i = 0; i < BENCH_UPDATE_COUNT && i < timerCount / 2; i++)
+    {
+        size_t index;
+
+        index = prv_random() % (timerCount - i);
+        prv_listTimerDelete(&context, timerArray[index]);
+        timerArray[index] = timerArray[timerCount - i - 1];
+    }
+    resultP->deleteNs = (prv_now() - start) / (double)i;
+
+    context.currentTime = INT32_MAX / 2;
+    start = prv_now();
+    prv_listTimerStep(&context);
+    resultP->fireNs = (prv_now() - start) / (double)g_firedCount;
+
+    free(timerArray);
+}
+
+static void prv_printResult(const char *name,
+                            size_t timerCount,
+                            bench_result_t *resultP)
+{
+    fprintf(stdout, "%-6s %8u %12.1f %14.1f %12.1f %12.1f %12.1f\r\n",
+            name, (unsigned int)timerCount,
+            resultP->insertNs, resultP->idleStepNs, resultP->resetNs, resultP->deleteNs, resultP->fireNs);
+}
+
+int main(int argc,
+         char *argv[])
+{
+    size_t timerCountArray[] = { 10, 1000, 100000 };
+    size_t i;
+
+    (void)argc;
+    (void)argv;
+
+    fprintf(stdout, "All durations are in nanoseconds per operation.\r\n\n");
+    fprintf(stdout, "%-6s %8s %12s %14s %12s %12s %12s\r\n", "impl", "timers", "new", "idle step", "reset", "delete", "fire");
+
+    for (i = 0; i < sizeof(timerCountArray) / sizeof(timerCountArray[0]); i++)
+    {
+        bench_result_t result;
+
+        prv_benchList(timerCountArray[i], &result);
+        prv_printResult("list", timerCountArray[i], &result);
+
+        prv_benchHeap(timerCountArray[i], &result);
+        prv_printResult("heap", timerCountArray[i], &result);
+    }
+
+    return 0;
+}
@@ -0,0 +1,196 @@
+/**********************************************
+ *
+ * Copyright (c) 2016-2021 IoTerop.
+ * All rights reserved.
+ *
+ * This program and the accompanying materials
+ * are made available under the terms of
+ * IoTerop’s IOWA License (LICENSE.TXT) which
+ * accompany this distribution.
+ *
+ **********************************************/
+
+/**************************************************
+ *
+ * Micro-benchmark of the TLV serializer.
+ *
+ * It measures tlvSerialize() on 1, 100 and 10k
+ * resources, either as single resources of one
+ * Object Instance or as an Object dump where each
+ * Object Instance holds seven single resources and
+ * a Multiple Resource with three instances.
+ *
+ **************************************************/
+
+// IOWA headers
+#include "iowa_prv_data_internals.h"
+
+// Platform specific headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_OBJECT_ID          1000
+#define BENCH_INSTANCE_DATA_SIZE 10
+#define BENCH_TOTAL_DATA_COUNT   1000000
+
+/**************************************************
+ * Helpers
+ */
+
+static double prv_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void prv_setValue(iowa_lwm2m_data_t *dataP,
+                         size_t i)
+{
+    switch (i % 4)
+    {
+    case 0:
+        dataP->type = IOWA_LWM2M_TYPE_INTEGER;
+        dataP->value.asInteger = (int64_t)(i * 37);
+        break;
+
+    case 1:
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        dataP->value.asFloat = 21.5 + (double)i;
+        break;
+
+    case 2:
+        dataP->type = IOWA_LWM2M_TYPE_STRING;
+        dataP->value.asBuffer.buffer = (uint8_t *)"benchmark value";
+        dataP->value.asBuffer.length = 15;
+        break;
+
+    default:
+        dataP->type = IOWA_LWM2M_TYPE_BOOLEAN;
+        dataP->value.asBoolean = (i % 8) == 3;
+        break;
+    }
+}
+
+// Single resources /1000/0/0 to /1000/0/count-1
+static void prv_buildResources(iowa_lwm2m_data_t *dataP,
+                               size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        memset(dataP + i, 0, sizeof(iowa_lwm2m_data_t));
+        dataP[i].objectID = BENCH_OBJECT_ID;
+        dataP[i].instanceID = 0;
+        dataP[i].resourceID = (uint16_t)i;
+        dataP[i].resInstanceID = IOWA_LWM2M_ID_ALL;
+        prv_setValue(dataP + i, i);
+    }
+}
+
+// Object Instances of seven single resources and a Multiple Resource with three instances
+static void prv_buildInstances(iowa_lwm2m_data_t *dataP,
+                               size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        size_t rank;
+
+        rank = i % BENCH_INSTANCE_DATA_SIZE;
+
+        memset(dataP + i, 0, sizeof(iowa_lwm2m_data_t));
+        dataP[i].objectID = BENCH_OBJECT_ID;
+        dataP[i].instanceID = (uint16_t)(i / BENCH_INSTANCE_DATA_SIZE);
+        if (rank < 7)
+        {
+            dataP[i].resourceID = (uint16_t)rank;
+            dataP[i].resInstanceID = IOWA_LWM2M_ID_ALL;
+        }
+        else
+        {
+            dataP[i].resourceID = 7;
+            dataP[i].resInstanceID = (uint16_t)(rank - 7);
+        }
+        prv_setValue(dataP + i, i);
+    }
+}
+
+static void prv_bench(const char *name,
+                      iowa_lwm2m_uri_t *baseUriP,
+                      iowa_lwm2m_data_t *dataP,
+                      size_t count)
+{
+    size_t iterationCount;
+    size_t i;
+    size_t length;
+    double start;
+    double duration;
+
+    iterationCount = BENCH_TOTAL_DATA_COUNT / count;
+
+    length = 0;
+    start = prv_now();
+    for (i = 0; i < iterationCount; i++)
+    {
+        uint8_t *bufferP;
+
+        if (tlvSerialize(baseUriP, dataP, count, 0, &bufferP, &length) != IOWA_COAP_NO_ERROR)
+        {
+            fprintf(stdout, "%-10s %8u serialization failed\r\n", name, (unsigned int)count);
+            return;
+        }
+        free(bufferP);
+    }
+    duration = (prv_now() - start) / (double)iterationCount;
+
+    fprintf(stdout, "%-10s %8u %10u %14.1f %12.1f\r\n", name, (unsigned int)count, (unsigned int)length, duration, duration / (double)count);
+}
+
+int main(int argc,
+         char *argv[])
+{
+    size_t countArray[] = { 1, 100, 10000 };
+    iowa_lwm2m_data_t *dataP;
+    iowa_lwm2m_uri_t uri;
+    size_t i;
+
+    (void)argc;
+    (void)argv;
+
+    dataP = (iowa_lwm2m_data_t *)malloc(10000 * sizeof(iowa_lwm2m_data_t));
+    if (dataP == NULL)
+    {
+        return 1;
+    }
+
+    fprintf(stdout, "Sizes are in bytes, durations in nanoseconds.\r\n\n");
+    fprintf(stdout, "%-10s %8s %10s %14s %12s\r\n", "payload", "data", "size", "per payload", "per data");
+
+    for (i = 0; i < sizeof(countArray) / sizeof(countArray[0]); i++)
+    {
+        LWM2M_URI_RESET(&uri);
+        uri.objectId = BENCH_OBJECT_ID;
+        uri.instanceId = 0;
+        prv_buildResources(dataP, countArray[i]);
+        prv_bench("resources", &uri, dataP, countArray[i]);
+    }
+
+    for (i = 0; i < sizeof(countArray) / sizeof(countArray[0]); i++)
+    {
+        LWM2M_URI_RESET(&uri);
+        uri.objectId = BENCH_OBJECT_ID;
+        prv_buildInstances(dataP, countArray[i]);
+        prv_bench("instances", &uri, dataP, countArray[i]);
+    }
+
+    free(dataP);
+
+    return 0;
+}
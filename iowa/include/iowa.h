@@ -128,8 +128,8 @@ typedef struct
         } asBuffer;
         struct
         {
-            size_t   totalSize;
-            uint32_t details;
+            size_t   totalSize;   // length of the data in buffer
+            uint32_t details;     // see iowa_data_get_block_info() and iowa_data_set_block_info()
             uint8_t *buffer;
         } asBlock;
         iowa_lwm2m_object_link_t asObjLink;
@@ -369,6 +369,187 @@ void iowa_backup_deregister_callback(iowa_context_t contextP,
 void iowa_connection_closed(iowa_context_t contextP,
                             void *connP);
 
+// The memory pools used when IOWA_MEMORY_POOL_SUPPORT is defined.
+typedef enum
+{
+    IOWA_MEMORY_POOL_COAP_MESSAGE = 0,
+    IOWA_MEMORY_POOL_COAP_OPTION,
+    IOWA_MEMORY_POOL_COAP_TRANSACTION,
+    IOWA_MEMORY_POOL_COAP_ACK,
+    IOWA_MEMORY_POOL_COAP_EXCHANGE,
+    IOWA_MEMORY_POOL_TIMER,
+    IOWA_MEMORY_POOL_LWM2M_VALUE,
+    IOWA_MEMORY_POOL_COAP_OPTION_VIEW, // received CoAP messages with their option views
+    IOWA_MEMORY_POOL_REQUEST_ARENA,
+    IOWA_MEMORY_POOL_COUNT
+} iowa_memory_pool_t;
+
+// Usage of a memory pool.
+// For IOWA_MEMORY_POOL_REQUEST_ARENA, objectSize is 1 and the other values are in bytes.
+// - objectSize: the size of an object in the pool. 0 if the pool was never used.
+// - capacity: the number of objects the allocated slabs can hold.
+// - used: the number of objects currently allocated.
+// - highWater: the maximum number of objects allocated at the same time.
+// - failureCount: the number of allocations which failed. For the request arena, the number of allocations which did not fit in it.
+typedef struct
+{
+    size_t   objectSize;
+    size_t   capacity;
+    size_t   used;
+    size_t   highWater;
+    uint32_t failureCount;
+} iowa_memory_pool_stats_t;
+
+// Get the usage of a memory pool.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - pool: the memory pool.
+// - statsP: OUT. the usage of the memory pool.
+// Note: only available when IOWA_MEMORY_POOL_SUPPORT is defined. The pools are shared by all the IOWA contexts.
+iowa_status_t iowa_memory_pool_get_stats(iowa_memory_pool_t pool,
+                                         iowa_memory_pool_stats_t *statsP);
+
+// The phases of iowa_step() timed when IOWA_METRICS_SUPPORT is defined.
+typedef enum
+{
+    IOWA_METRICS_PHASE_SECURITY = 0,   // securityStep()
+    IOWA_METRICS_PHASE_COAP,           // coapStep()
+    IOWA_METRICS_PHASE_LWM2M,          // lwm2m_step()
+    IOWA_METRICS_PHASE_TIMER,          // coreTimerStep()
+    IOWA_METRICS_PHASE_SELECT,         // commSelect(): waiting for the incoming data and handling them
+    IOWA_METRICS_PHASE_COUNT
+} iowa_metrics_phase_t;
+
+#define IOWA_METRICS_HISTOGRAM_BUCKET_COUNT 24
+
+// A latency histogram. The durations are in microseconds.
+// The bucket i counts the durations written with i bits: 0 in bucket 0, 1 in bucket 1, 2 to 3 in bucket 2, 4 to 7 in bucket 3 and so on.
+// The last bucket also counts all the longer durations.
+// - count: the number of recorded durations.
+// - sum: the sum of the recorded durations.
+// - max: the longest recorded duration.
+// - bucketArray: the number of recorded durations per bucket.
+typedef struct
+{
+    uint32_t count;
+    uint64_t sum;
+    uint32_t max;
+    uint32_t bucketArray[IOWA_METRICS_HISTOGRAM_BUCKET_COUNT];
+} iowa_metrics_histogram_t;
+
+// Counters of a CoAP peer.
+// On stream connections, a datagram is a read or a write on the connection.
+// - datagramInCount, byteInCount: the received datagrams and their total size.
+// - datagramOutCount, byteOutCount: the sent datagrams, retransmissions included, and their total size.
+// - retransmissionCount: the retransmissions of confirmable messages.
+// - timeoutCount: the confirmable messages never acknowledged.
+// - duplicateCount: the duplicated confirmable messages answered from the acknowledgement cache.
+// - truncationCount: the datagrams larger than the receive buffer, handled as 4.13 (Request Entity Too Large).
+typedef struct
+{
+    uint32_t datagramInCount;
+    uint32_t datagramOutCount;
+    uint64_t byteInCount;
+    uint64_t byteOutCount;
+    uint32_t retransmissionCount;
+    uint32_t timeoutCount;
+    uint32_t duplicateCount;
+    uint32_t truncationCount;
+} iowa_metrics_peer_counters_t;
+
+// Counters of a LwM2M Server in client mode.
+// - registrationCount: the Register requests sent.
+// - updateCount: the Update requests sent.
+// - notificationCount: the notifications sent.
+// - notificationDropCount: the notifications which could not be built or sent.
+// - pminSuppressionCount: the value changes not notified because the minimum period was not elapsed.
+typedef struct
+{
+    uint32_t registrationCount;
+    uint32_t updateCount;
+    uint32_t notificationCount;
+    uint32_t notificationDropCount;
+    uint32_t pminSuppressionCount;
+} iowa_metrics_server_counters_t;
+
+// The metrics of a CoAP peer.
+// - shortId: the Short ID of the LwM2M Server using this peer in client mode, IOWA_LWM2M_ID_ALL otherwise.
+// - type: the connection type of the peer.
+// - counters: the counters of the peer since its creation.
+typedef struct
+{
+    uint16_t                     shortId;
+    iowa_connection_type_t       type;
+    iowa_metrics_peer_counters_t counters;
+} iowa_metrics_peer_t;
+
+// The metrics of a LwM2M Server.
+// - shortId: the Short ID of the LwM2M Server.
+// - counters: the counters of the LwM2M Server since its addition.
+typedef struct
+{
+    uint16_t                       shortId;
+    iowa_metrics_server_counters_t counters;
+} iowa_metrics_server_t;
+
+// The metrics of an IOWA context.
+// - phaseArray: the durations of the iowa_step() phases.
+// - dataCallback: the durations of the calls to the objects data callbacks.
+// - peerCount, peerArray: the metrics of the current CoAP peers.
+// - serverCount, serverArray: the metrics of the LwM2M Servers in client mode.
+typedef struct
+{
+    iowa_metrics_histogram_t  phaseArray[IOWA_METRICS_PHASE_COUNT];
+    iowa_metrics_histogram_t  dataCallback;
+    size_t                    peerCount;
+    iowa_metrics_peer_t      *peerArray;
+    size_t                    serverCount;
+    iowa_metrics_server_t    *serverArray;
+} iowa_metrics_t;
+
+// Get the metrics of an IOWA context.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - metricsP: OUT. the metrics. To be released with iowa_metrics_release().
+// Note: only available when IOWA_METRICS_SUPPORT is defined.
+iowa_status_t iowa_metrics_get(iowa_context_t contextP,
+                               iowa_metrics_t *metricsP);
+
+// Release the metrics returned by iowa_metrics_get().
+// Returned value: none.
+// Parameters:
+// - metricsP: the metrics filled by iowa_metrics_get().
+void iowa_metrics_release(iowa_metrics_t *metricsP);
+
+// Usage of the queue of the updates posted by the application threads.
+// - postCount: the number of updates queued.
+// - retryCount: the number of times a posting thread lost the race for a slot against another thread and tried again. This measures the contention between the posting threads.
+// - fullCount: the number of updates rejected because the queue was full.
+// - appliedCount: the number of updates applied by iowa_step().
+// - failedCount: the number of updates which failed when applied, e.g. because the sensor was removed.
+// - batchCount: the number of iterations of iowa_step() which applied updates.
+// - maxBatchSize: the largest number of updates applied by one iteration of iowa_step().
+typedef struct
+{
+    uint32_t postCount;
+    uint32_t retryCount;
+    uint32_t fullCount;
+    uint32_t appliedCount;
+    uint32_t failedCount;
+    uint32_t batchCount;
+    uint32_t maxBatchSize;
+} iowa_command_queue_stats_t;
+
+// Get the usage of the queue of the updates posted by the application threads.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - statsP: OUT. the usage of the queue.
+// Note: only available when IOWA_COMMAND_QUEUE_SUPPORT is defined.
+iowa_status_t iowa_command_queue_get_stats(iowa_context_t contextP,
+                                           iowa_command_queue_stats_t *statsP);
+
 // The possible size of the data block when "more" is true.
 #define IOWA_DATA_BLOCK_SIZE_16    16
 #define IOWA_DATA_BLOCK_SIZE_32    32
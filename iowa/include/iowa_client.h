@@ -730,6 +730,20 @@ iowa_status_t iowa_client_object_resource_changed(iowa_context_t contextP,
                                                   uint16_t instanceID,
                                                   uint16_t resourceID);
 
+// Inform the stack that a resource value changed, from any thread and without waiting for iowa_step().
+// The information is queued and applied by the next iteration of iowa_step().
+// Returned value: IOWA_COAP_NO_ERROR in case of success, IOWA_COAP_503_SERVICE_UNAVAILABLE if the queue is full, or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - objectID: ID of the Object.
+// - instanceID: ID of the Instance. This can be IOWA_LWM2M_ID_ALL.
+// - resourceID: ID of the Resource. This can be IOWA_LWM2M_ID_ALL.
+// Note: only available when IOWA_COMMAND_QUEUE_SUPPORT is defined.
+iowa_status_t iowa_client_post_resource_changed(iowa_context_t contextP,
+                                                uint16_t objectID,
+                                                uint16_t instanceID,
+                                                uint16_t resourceID);
+
 // Inform the stack that an instance was created or deleted.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
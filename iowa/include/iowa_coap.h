@@ -70,6 +70,9 @@ extern "C" {
 #define IOWA_COAP_SETTING_MAX_RETRANSMIT  2    // uint8_t
 #define IOWA_COAP_SETTING_URI_LENGTH      3    // size_t
 #define IOWA_COAP_SETTING_URI             4    // char *
+#define IOWA_COAP_SETTING_ACK_CACHE_STATS 5    // iowa_coap_ack_cache_stats_t, read-only
+#define IOWA_COAP_SETTING_NSTART          6    // uint8_t
+#define IOWA_COAP_SETTING_MAX_DATAGRAM_SIZE 7  // size_t
 
 /**************************************************************
  * Types
@@ -79,6 +82,23 @@ typedef struct _iowa_coap_peer_t iowa_coap_peer_t;
 typedef struct _iowa_coap_message_t iowa_coap_message_t;
 typedef uint8_t iowa_coap_setting_id_t;
 
+// Usage of the cache of the acknowledgements sent to a datagram peer, used to reply to duplicate confirmable messages.
+// - memory: the number of bytes used by the cached acknowledgements.
+// - peakMemory: the maximum value reached by memory.
+// - count: the number of cached acknowledgements.
+// - hitCount: the number of duplicate confirmable messages replied from the cache.
+// - evictionCount: the number of acknowledgements removed before their expiration to respect IOWA_COAP_ACK_MEMORY_LIMIT.
+// - expirationCount: the number of acknowledgements removed at their expiration.
+typedef struct
+{
+    size_t   memory;
+    size_t   peakMemory;
+    size_t   count;
+    uint32_t hitCount;
+    uint32_t evictionCount;
+    uint32_t expirationCount;
+} iowa_coap_ack_cache_stats_t;
+
 typedef enum
 {
     COAP_EVENT_UNDEFINED = 0,
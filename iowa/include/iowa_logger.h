@@ -121,6 +121,19 @@ void iowa_log_arg_buffer(uint8_t part,
                          size_t bufferLength,
                          ...);
 
+// The following functions are available only if the define IOWA_LOG_RING_BUFFER_SIZE is used.
+// The log functions above then store binary records in a ring buffer instead of writing to the output.
+// The message and functionName strings must remain valid until the records are output.
+
+// Writes the logs stored in the ring buffer to the output, followed by the count of logs dropped since the previous call.
+// This is intended to be called from a background thread or from the application's main loop. Concurrent calls return immediately.
+// Returned value: the number of logs written.
+size_t iowa_log_flush(void);
+
+// Get the number of logs dropped because the ring buffer was full.
+// Returned value: the total number of dropped logs.
+uint32_t iowa_log_get_dropped_count(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -165,6 +165,105 @@ void iowa_system_connection_close(void * connP,
                                   void * userData);
 
 
+/*************************************
+* Connection Monitoring Interface
+*
+* To be implemented by the user if the define IOWA_CONNECTION_MONITOR_SUPPORT is used.
+* These functions replace iowa_system_connection_select(): connections are registered
+* once when opened and unregistered when closed, instead of being passed at each call.
+*/
+
+// This function adds a connection to the set of monitored connections.
+// Returned value: 0 in case of success or a negative number in case of error.
+// Parameters:
+// - connP: the connection as returned by iowa_system_connection_open().
+// - eventData: an opaque pointer to return in iowa_system_connection_wait() when data are available on the connection.
+// - userData: the iowa_init() parameter.
+int iowa_system_connection_monitor_add(void * connP,
+                                       void * eventData,
+                                       void * userData);
+
+// This function removes a connection from the set of monitored connections.
+// Returned value: none.
+// Parameters:
+// - connP: the connection as returned by iowa_system_connection_open().
+// - userData: the iowa_init() parameter.
+void iowa_system_connection_monitor_remove(void * connP,
+                                           void * userData);
+
+// This functions waits for incoming data on the monitored connections during the specified time.
+// Returned value: the number of connections with available data, 0 if the time elapsed or a negative number in case of error.
+// Parameters:
+// - eventDataArray: OUT. The eventData of the connections with available data, as provided to iowa_system_connection_monitor_add().
+// - eventDataCount: The size of the array.
+// - timeout: the time to wait for data in seconds.
+// - userData: the iowa_init() parameter.
+int iowa_system_connection_wait(void ** eventDataArray,
+                                size_t eventDataCount,
+                                int32_t timeout,
+                                void * userData);
+
+
+/*************************************
+* Batched Reception Interface
+*
+* To be implemented by the user if the define IOWA_CONNECTION_RECV_BATCH_SUPPORT is used.
+*/
+
+// This function reads several datagrams from a connection in a non-blocking way.
+// Returned value: the number of datagrams read, 0 if no datagram is available or a negative number in case of error.
+// Parameters:
+// - connP: the connection as returned by iowa_system_connection_open().
+// - buffer: to store the read datagrams. The datagram i is stored at buffer + i * length.
+// - length: the maximum size of a datagram.
+// - lengthArray: OUT. The size of each read datagram.
+// - count: the maximum number of datagrams to read. buffer is count * length bytes long.
+// - userData: the iowa_init() parameter.
+int iowa_system_connection_recv_batch(void * connP,
+                                      uint8_t * buffer,
+                                      size_t length,
+                                      size_t * lengthArray,
+                                      size_t count,
+                                      void * userData);
+
+
+/*************************************
+* Batched Transmission Interface
+*
+* To be implemented by the user if the define IOWA_CONNECTION_SEND_BATCH_SUPPORT is used.
+*/
+
+// This function sends several datagrams on a connection.
+// Only the notifications and the datagrams whose sending result is not checked by IOWA, like the retransmissions of
+// confirmable messages, are sent with this function. The other ones are sent with iowa_system_connection_send() so that
+// a failure or a truncation is reported to the CoAP layer.
+// When fewer than count datagrams are sent, this function is called again with the remaining ones until it fails.
+// A confirmable notification which could not be sent fails as if it was not acknowledged.
+// Returned value: the number of datagrams sent or a negative number in case of error.
+// Parameters:
+// - connP: the connection as returned by iowa_system_connection_open().
+// - bufferArray: the datagrams to send, in order.
+// - lengthArray: the size of each datagram.
+// - count: the number of datagrams.
+// - userData: the iowa_init() parameter.
+int iowa_system_connection_send_batch(void * connP,
+                                      uint8_t ** bufferArray,
+                                      size_t * lengthArray,
+                                      size_t count,
+                                      void * userData);
+
+
+/*******************************
+* Metrics Interface
+*
+* To be implemented by the user if the define IOWA_METRICS_SUPPORT is used.
+*/
+
+// This function returns the value of a monotonic clock in microseconds.
+// The origin does not matter and the value can wrap around as this function is only used to measure short durations.
+uint32_t iowa_system_gettime_us(void);
+
+
 /*******************************
 * Mutex Interface
 *
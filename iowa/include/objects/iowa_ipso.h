@@ -82,6 +82,18 @@ iowa_status_t iowa_client_IPSO_update_value(iowa_context_t contextP,
                                             iowa_sensor_t id,
                                             float value);
 
+// Update the value of an IPSO Object sensor, from any thread and without waiting for iowa_step().
+// The value is queued and applied by the next iteration of iowa_step().
+// Returned value: IOWA_COAP_NO_ERROR in case of success, IOWA_COAP_503_SERVICE_UNAVAILABLE if the queue is full, or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - id: ID of the sensor.
+// - value: the new value of the sensor.
+// Note: only available when IOWA_COMMAND_QUEUE_SUPPORT is defined. An unknown sensor is only reported in the command queue statistics.
+iowa_status_t iowa_client_IPSO_post_value(iowa_context_t contextP,
+                                          iowa_sensor_t id,
+                                          float value);
+
 typedef struct
 {
     float value;
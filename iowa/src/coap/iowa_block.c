@@ -22,3 +22,585 @@
 
 #include "iowa_prv_coap_internals.h"
 #include <stdbool.h>
+
+#define PRV_BLOCK_SZX_MAX          6
+#define PRV_BLOCK_NUMBER_MAX       0xFFFFF
+#define PRV_BLOCK_MORE_FLAG        0x08
+#define PRV_BLOCK_SZX_MASK         0x07
+
+#define PRV_BLOCK_SIZE_MIN         16
+#define PRV_BLOCK_SIZE_MAX         1024
+
+// Room left in a datagram for the CoAP header, the token and the options of a block
+#define PRV_BLOCK_HEADER_RESERVE   64
+
+#define PRV_HASH_INIT              2166136261u
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static uint8_t prv_sizeToSzx(uint16_t size)
+{
+    uint8_t szx;
+
+    for (szx = 0; szx <= PRV_BLOCK_SZX_MAX; szx++)
+    {
+        if ((PRV_BLOCK_SIZE_MIN << szx) == size)
+        {
+            return szx;
+        }
+    }
+
+    return PRV_BLOCK_SZX_MASK;
+}
+
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+
+// Get the largest block size fitting in a payload length.
+// Returned value: the block size, or 0 if the length is less than the smallest block size.
+// Parameters:
+// - maxPayloadSize: the payload length.
+static uint16_t prv_getFittingSize(size_t maxPayloadSize)
+{
+    uint16_t size;
+
+    if (maxPayloadSize < PRV_BLOCK_SIZE_MIN)
+    {
+        return 0;
+    }
+
+    size = PRV_BLOCK_SIZE_MAX;
+    while (size > maxPayloadSize)
+    {
+        size >>= 1;
+    }
+
+    return size;
+}
+
+static uint8_t prv_addIntegerOption(iowa_coap_message_t *messageP,
+                                    uint16_t number,
+                                    uint32_t value)
+{
+    iowa_coap_option_t *optionP;
+
+    optionP = iowa_coap_option_new(number);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    optionP->value.asInteger = value;
+    iowa_coap_message_add_option(messageP, optionP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Continue a FNV-1a hash.
+// Returned value: the updated hash.
+// Parameters:
+// - hash: the current hash. PRV_HASH_INIT to start a new one.
+// - data, length: the bytes to add to the hash.
+static uint32_t prv_hashBuffer(uint32_t hash,
+                               const uint8_t *data,
+                               size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// Compute a key identifying the content requested by a request.
+// Returned value: a hash of the Uri-Path, Uri-Query and Accept options.
+// Parameters:
+// - requestP: the request.
+static uint32_t prv_getContentKey(iowa_coap_message_t *requestP)
+{
+    iowa_coap_option_t *optionP;
+    uint32_t key;
+
+    key = PRV_HASH_INIT;
+    for (optionP = requestP->optionList; optionP != NULL; optionP = optionP->next)
+    {
+        uint8_t header[4];
+
+        switch (optionP->number)
+        {
+        case IOWA_COAP_OPTION_URI_PATH:
+        case IOWA_COAP_OPTION_URI_QUERY:
+            header[0] = (uint8_t)optionP->number;
+            header[1] = (uint8_t)(optionP->length >> 8);
+            header[2] = (uint8_t)optionP->length;
+            key = prv_hashBuffer(key, header, 3);
+            key = prv_hashBuffer(key, optionP->value.asBuffer, optionP->length);
+            break;
+
+        case IOWA_COAP_OPTION_ACCEPT:
+            header[0] = (uint8_t)(optionP->value.asInteger >> 24);
+            header[1] = (uint8_t)(optionP->value.asInteger >> 16);
+            header[2] = (uint8_t)(optionP->value.asInteger >> 8);
+            header[3] = (uint8_t)optionP->value.asInteger;
+            key = prv_hashBuffer(key, header, 4);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return key;
+}
+
+// Add an ETag option identifying the whole content of a response sent block-wise.
+// Returned value: '0' in case of success or an error code in the form of a CoAP code.
+// Parameters:
+// - messageP: the response. The value of the option is stored in it.
+// - hash: the hash of the whole content.
+static uint8_t prv_addETagOption(iowa_coap_message_t *messageP,
+                                 uint32_t hash)
+{
+    iowa_coap_option_t *optionP;
+
+    optionP = iowa_coap_option_new(IOWA_COAP_OPTION_ETAG);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (optionP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    messageP->blockETag[0] = (uint8_t)(hash >> 24);
+    messageP->blockETag[1] = (uint8_t)(hash >> 16);
+    messageP->blockETag[2] = (uint8_t)(hash >> 8);
+    messageP->blockETag[3] = (uint8_t)hash;
+    optionP->length = COAP_BLOCK_ETAG_LEN;
+    optionP->value.asBuffer = messageP->blockETag;
+    iowa_coap_message_add_option(messageP, optionP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // IOWA_COAP_BLOCK_SUPPORT
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+uint8_t coapDecodeBlockInfo(uint32_t value,
+                            uint32_t *numberP,
+                            bool *moreP,
+                            uint16_t *sizeP)
+{
+    uint8_t szx;
+
+    szx = (uint8_t)(value & PRV_BLOCK_SZX_MASK);
+    if (szx > PRV_BLOCK_SZX_MAX)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Reserved block size exponent 7.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *numberP = value >> 4;
+    *moreP = ((value & PRV_BLOCK_MORE_FLAG) != 0);
+    *sizeP = (uint16_t)(PRV_BLOCK_SIZE_MIN << szx);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t coapEncodeBlockInfo(uint32_t number,
+                            bool more,
+                            uint16_t size,
+                            uint32_t *valueP)
+{
+    uint8_t szx;
+
+    szx = prv_sizeToSzx(size);
+    if (szx > PRV_BLOCK_SZX_MAX
+        || number > PRV_BLOCK_NUMBER_MAX)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Invalid block number %u or size %u.", number, size);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *valueP = (number << 4) | szx;
+    if (more == true)
+    {
+        *valueP |= PRV_BLOCK_MORE_FLAG;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+
+uint16_t coapBlockGetPeerSize(iowa_coap_peer_t *peerP)
+{
+    switch (peerP->base.type)
+    {
+#ifdef IOWA_UDP_SUPPORT
+    case IOWA_CONN_DATAGRAM:
+    {
+        size_t maxDatagramSize;
+        uint16_t size;
+
+        maxDatagramSize = ((coap_peer_datagram_t *)peerP)->maxDatagramSize;
+
+        size = PRV_BLOCK_SIZE_MAX;
+        while (size > PRV_BLOCK_SIZE_MIN
+               && (size_t)size + PRV_BLOCK_HEADER_RESERVE > maxDatagramSize)
+        {
+            size >>= 1;
+        }
+
+        return size;
+    }
+#endif
+
+    default:
+        // Stream transports have no datagram size limit
+        return 0;
+    }
+}
+
+uint8_t coapBlockGetInfo(iowa_coap_peer_t *peerP,
+                         iowa_coap_message_t *messageP,
+                         uint16_t optionNumber,
+                         uint32_t *numberP,
+                         bool *moreP,
+                         uint16_t *sizeP)
+{
+    iowa_coap_option_t *optionP;
+    uint8_t result;
+    uint16_t peerSize;
+
+    optionP = iowa_coap_message_find_option(messageP, optionNumber);
+    if (optionP == NULL)
+    {
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    result = coapDecodeBlockInfo(optionP->value.asInteger, numberP, moreP, sizeP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    if (optionNumber == IOWA_COAP_OPTION_BLOCK_2)
+    {
+        peerSize = coapBlockGetPeerSize(peerP);
+        if (peerSize != 0
+            && *sizeP > peerSize)
+        {
+            // Late negotiation: answer with smaller blocks covering the same offset
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Reducing the requested block size from %u to %u.", *sizeP, peerSize);
+            *numberP *= *sizeP / peerSize;
+            *sizeP = peerSize;
+        }
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t coapBlockAddOption(iowa_coap_message_t *messageP,
+                           uint16_t optionNumber,
+                           uint32_t number,
+                           bool more,
+                           uint16_t size)
+{
+    uint32_t value;
+    uint8_t result;
+
+    result = coapEncodeBlockInfo(number, more, size, &value);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return prv_addIntegerOption(messageP, optionNumber, value);
+}
+
+uint8_t coapBlockSliceResponse(iowa_coap_peer_t *peerP,
+                               iowa_coap_message_t *requestP,
+                               iowa_coap_message_t *responseP,
+                               uint16_t contentFormat)
+{
+    uint32_t number;
+    bool more;
+    uint16_t size;
+    uint8_t result;
+    size_t offset;
+    size_t totalLength;
+    size_t blockLength;
+    uint32_t hash;
+    bool isStored;
+
+    if (requestP != NULL)
+    {
+        result = coapBlockGetInfo(peerP, requestP, IOWA_COAP_OPTION_BLOCK_2, &number, &more, &size);
+    }
+    else
+    {
+        result = IOWA_COAP_404_NOT_FOUND;
+    }
+
+    if (result == IOWA_COAP_404_NOT_FOUND)
+    {
+        size = coapBlockGetPeerSize(peerP);
+        if (size == 0
+            || responseP->payload.length <= size)
+        {
+            // The response fits in a single datagram
+            return IOWA_COAP_NO_ERROR;
+        }
+        number = 0;
+    }
+    else if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    totalLength = responseP->payload.length;
+    offset = (size_t)number * size;
+    if (offset > totalLength
+        || (offset == totalLength && offset != 0))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Requested block %u is beyond the %u bytes of the content.", number, totalLength);
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+
+    // Computed on the whole content so that all the blocks of the same content carry the same ETag
+    hash = prv_hashBuffer(PRV_HASH_INIT, responseP->payload.data, totalLength);
+    if (iowa_coap_message_find_option(responseP, IOWA_COAP_OPTION_ETAG) == NULL)
+    {
+        result = prv_addETagOption(responseP, hash);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+    }
+
+    if (totalLength - offset > size)
+    {
+        more = true;
+        blockLength = size;
+    }
+    else
+    {
+        more = false;
+        blockLength = totalLength - offset;
+    }
+
+    isStored = false;
+    if (requestP != NULL
+        && more == true)
+    {
+        iowa_buffer_t blockBuffer;
+
+        // Keep the whole content for the next blocks requested by the peer: they are copied from it instead of being built again
+        blockBuffer = coreBufferNew(responseP->payload.data + offset, blockLength);
+        if (blockBuffer.memory != NULL)
+        {
+            coapBlockClearContent(peerP);
+            peerP->base.blockContent = responseP->payload;
+            peerP->base.blockContentKey = prv_getContentKey(requestP);
+            peerP->base.blockContentETag = hash;
+            peerP->base.blockContentFormat = contentFormat;
+            responseP->payload = blockBuffer;
+            isStored = true;
+        }
+        // Else the block is sent from the payload buffer and the next blocks build the content again
+    }
+
+    if (isStored == false)
+    {
+        responseP->payload.length = blockLength;
+        if (offset != 0)
+        {
+            // Only the block is sent: keep it at the start of the payload buffer
+            memmove(responseP->payload.data, responseP->payload.data + offset, blockLength);
+        }
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending block %u (%u bytes at offset %u of %u).", number, responseP->payload.length, offset, totalLength);
+
+    result = coapBlockAddOption(responseP, IOWA_COAP_OPTION_BLOCK_2, number, more, size);
+    if (result == IOWA_COAP_NO_ERROR
+        && number == 0
+        && more == true)
+    {
+        // Let the peer know the size of the whole content
+        result = prv_addIntegerOption(responseP, IOWA_COAP_OPTION_SIZE_2, (uint32_t)totalLength);
+    }
+
+    return result;
+}
+
+bool coapBlockHasStoredContent(iowa_coap_peer_t *peerP,
+                               iowa_coap_message_t *requestP)
+{
+    uint32_t number;
+    bool more;
+    uint16_t size;
+
+    if (peerP->base.blockContent.length == 0)
+    {
+        return false;
+    }
+
+    if (coapBlockGetInfo(peerP, requestP, IOWA_COAP_OPTION_BLOCK_2, &number, &more, &size) != IOWA_COAP_NO_ERROR
+        || number == 0)
+    {
+        // A transfer starting with the first block gets the current content
+        return false;
+    }
+
+    return peerP->base.blockContentKey == prv_getContentKey(requestP);
+}
+
+uint8_t coapBlockGetStoredResponse(iowa_coap_peer_t *peerP,
+                                   iowa_coap_message_t *requestP,
+                                   iowa_coap_message_t *responseP,
+                                   uint16_t *contentFormatP)
+{
+    uint32_t number;
+    bool more;
+    uint16_t size;
+    uint8_t result;
+    size_t offset;
+    size_t blockLength;
+    iowa_buffer_t *contentP;
+
+    result = coapBlockGetInfo(peerP, requestP, IOWA_COAP_OPTION_BLOCK_2, &number, &more, &size);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    contentP = &(peerP->base.blockContent);
+    offset = (size_t)number * size;
+    if (offset >= contentP->length)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Requested block %u is beyond the %u bytes of the content.", number, contentP->length);
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+
+    if (contentP->length - offset > size)
+    {
+        more = true;
+        blockLength = size;
+    }
+    else
+    {
+        more = false;
+        blockLength = contentP->length - offset;
+    }
+
+    responseP->payload = coreBufferNew(contentP->data + offset, blockLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (responseP->payload.memory == NULL)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending stored block %u (%u bytes at offset %u of %u).", number, blockLength, offset, contentP->length);
+
+    result = coapBlockAddOption(responseP, IOWA_COAP_OPTION_BLOCK_2, number, more, size);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = prv_addETagOption(responseP, peerP->base.blockContentETag);
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        coreBufferClear(&(responseP->payload));
+        return result;
+    }
+
+    *contentFormatP = peerP->base.blockContentFormat;
+
+    if (more == false)
+    {
+        // The transfer is complete
+        coapBlockClearContent(peerP);
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void coapBlockClearContent(iowa_coap_peer_t *peerP)
+{
+    coreBufferClear(&(peerP->base.blockContent));
+}
+
+iowa_status_t blockCreateOption(size_t maxPayloadSize,
+                                iowa_coap_option_t **optionPP)
+{
+    uint16_t size;
+    uint32_t value;
+
+    *optionPP = NULL;
+
+    size = prv_getFittingSize(maxPayloadSize);
+    if (size == 0)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "%u bytes are less than the smallest block size.", maxPayloadSize);
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    (void)coapEncodeBlockInfo(0, false, size, &value);
+
+    *optionPP = iowa_coap_option_new(IOWA_COAP_OPTION_BLOCK_1);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*optionPP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    (*optionPP)->value.asInteger = value;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+uint8_t blockSend413Reply(iowa_context_t contextP,
+                          iowa_coap_peer_t *peerP,
+                          iowa_coap_message_t *messageP,
+                          size_t maxPayloadSize)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *responseP;
+    iowa_coap_option_t *optionP;
+    uint8_t result;
+
+    responseP = iowa_coap_message_prepare_response(messageP, IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (responseP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create response packet.");
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    // The Block1 option tells the peer the block size to use to send the payload
+    if (blockCreateOption(maxPayloadSize, &optionP) == IOWA_COAP_NO_ERROR)
+    {
+        iowa_coap_message_add_option(responseP, optionP);
+    }
+
+    result = peerSend(contextP, peerP, responseP, NULL, NULL);
+
+    iowa_coap_message_free(responseP);
+
+    return result;
+}
+
+#endif // IOWA_COAP_BLOCK_SUPPORT
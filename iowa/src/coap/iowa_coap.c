@@ -69,6 +69,7 @@ void coapClose(iowa_context_t contextP)
         peerP = nextPeerP;
     }
 
+    iowa_system_free(contextP->coapContextP->recvBuffer);
     iowa_system_free(contextP->coapContextP);
     contextP->coapContextP = NULL;
 
@@ -122,6 +123,14 @@ uint8_t coapStep(iowa_context_t contextP)
     return result;
 }
 
+#ifdef IOWA_METRICS_SUPPORT
+iowa_coap_peer_t * coapGetPeerList(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    return contextP->coapContextP->peerList;
+}
+#endif
+
 uint8_t coapSend(iowa_context_t contextP,
                  iowa_coap_peer_t *peerP,
                  iowa_coap_message_t *messageP,
@@ -149,6 +158,21 @@ uint8_t coapSend(iowa_context_t contextP,
     return result;
 }
 
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+void coapSendBatchStart(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    contextP->coapContextP->sendBatching = true;
+}
+
+void coapSendBatchStop(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    contextP->coapContextP->sendBatching = false;
+    commSendBatchFlush(contextP);
+}
+#endif
+
 void messageLog(const char *function,
                 unsigned int line,
                 const char *info,
@@ -251,7 +275,7 @@ iowa_coap_message_t * iowa_coap_message_new(uint8_t type,
     }
 #endif
 
-    messageP = (iowa_coap_message_t *)iowa_system_malloc(sizeof(iowa_coap_message_t));
+    messageP = (iowa_coap_message_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_COAP_MESSAGE, sizeof(iowa_coap_message_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (messageP == NULL)
     {
@@ -281,14 +305,60 @@ void prv_freeBufferList(iowa_linked_buffer_t *bufferP)
     iowa_system_free(bufferP);
 }
 
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+// Free the options of a message which are not among its views, then the message.
+// Returned value: none.
+// Parameters:
+// - messageP: the CoAP message.
+static void prv_freeMessage(iowa_coap_message_t *messageP)
+{
+    iowa_coap_option_t *optionP;
+
+    optionP = messageP->optionList;
+    while (optionP != NULL)
+    {
+        iowa_coap_option_t *nextP;
+        size_t viewIndex;
+
+        nextP = optionP->next;
+
+        viewIndex = 0;
+        while (viewIndex < messageP->optionViewSize
+               && optionP != COAP_MESSAGE_OPTION_VIEWS(messageP) + viewIndex)
+        {
+            viewIndex++;
+        }
+        if (viewIndex == messageP->optionViewSize)
+        {
+            optionP->next = NULL;
+            iowa_coap_option_free(optionP);
+        }
+
+        optionP = nextP;
+    }
+
+    if (messageP->optionViewSize != 0)
+    {
+        CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_OPTION_VIEW, messageP);
+    }
+    else
+    {
+        CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_MESSAGE, messageP);
+    }
+}
+#endif
+
 void iowa_coap_message_free(iowa_coap_message_t *messageP)
 {
     if (messageP != NULL)
     {
-        iowa_coap_option_free(messageP->optionList);
-
         IOWA_UTILS_LIST_FREE(messageP->userBufferList, prv_freeBufferList);
-        iowa_system_free(messageP);
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+        prv_freeMessage(messageP);
+#else
+        iowa_coap_option_free(messageP->optionList);
+        CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_MESSAGE, messageP);
+#endif
     }
 }
 
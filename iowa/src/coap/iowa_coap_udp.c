@@ -37,51 +37,205 @@ uint8_t messageSendUDP(iowa_context_t contextP,
     uint8_t *buffer;
     uint8_t result;
     int nbSent;
+    bool inPlace;
+    bool queued;
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    bool batched;
+    uint8_t *sendBuffer;
+#endif
 
     IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
 
     peerP = (coap_peer_datagram_t *)peerBaseP;
 
-    bufferLength = coapMessageSerializeDatagram(messageP, &buffer);
-    if (bufferLength == 0)
+    // When the payload buffer reserved room for the CoAP header, the datagram is built in it without any copy
+    bufferLength = coapMessageSerializeDatagramInPlace(messageP, &buffer);
+    if (bufferLength != 0)
     {
-        IOWA_LOG_ERROR(IOWA_PART_COAP, "Exit on error: serialization failed.");
-        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        inPlace = true;
+    }
+    else
+    {
+        inPlace = false;
+
+        bufferLength = coapMessageSerializeDatagram(messageP, &buffer);
+        if (bufferLength == 0)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_COAP, "Exit on error: serialization failed.");
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
     }
 
-    nbSent = peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, bufferLength);
-    if (nbSent < 0)
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    batched = false;
+    sendBuffer = buffer;
+#endif
+
+    if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE
+        && transactionIsNstartReached(peerP) == true)
     {
-        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Communication error: %d.", nbSent);
-        result = IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        // Sent when an outstanding interaction with the peer completes
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Queuing message %u: NSTART reached.", messageP->id);
+        queued = true;
+        result = IOWA_COAP_NO_ERROR;
     }
-    else if ((size_t)nbSent < bufferLength)
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    else if (contextP->coapContextP->sendBatching == true
+             && (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE
+                 || messageP->type == IOWA_COAP_TYPE_NON_CONFIRMABLE))
     {
-        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Need to send in blocks, %u bytes to send but connection layer returned %d.", bufferLength, nbSent);
-        result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+        // Sent once the transaction exists, so that a sending error found when the send batch is flushed is reported to it
+        queued = false;
+        batched = true;
+        result = IOWA_COAP_NO_ERROR;
     }
+#endif
     else
     {
-        result = IOWA_COAP_NO_ERROR;
+        queued = false;
+
+        nbSent = peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, bufferLength);
+        if (nbSent < 0)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Communication error: %d.", nbSent);
+            result = IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        }
+        else if ((size_t)nbSent < bufferLength)
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Need to send in blocks, %u bytes to send but connection layer returned %d.", bufferLength, nbSent);
+            result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+        }
+        else
+        {
+            result = IOWA_COAP_NO_ERROR;
+        }
     }
 
     if (result == IOWA_COAP_NO_ERROR)
     {
-        result = transactionNew(contextP, peerP, messageP, buffer, bufferLength, resultCallback, userData);
+        result = transactionNew(contextP, peerP, messageP, buffer, bufferLength, queued, resultCallback, userData);
         if (result == IOWA_COAP_201_CREATED)
         {
+            if (inPlace == true)
+            {
+                // The transaction now owns the payload buffer
+                messageP->payload = IOWA_BUFFER_EMPTY;
+            }
             buffer = NULL;
             result = IOWA_COAP_NO_ERROR;
         }
     }
 
-    iowa_system_free(buffer);
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    if (batched == true
+        && result == IOWA_COAP_NO_ERROR)
+    {
+        transactionSendBatched(contextP, peerP, messageP, sendBuffer, bufferLength);
+    }
+#endif
+
+    if (inPlace == false)
+    {
+        iowa_system_free(buffer);
+    }
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Exiting with result %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
 
     return result;
 }
 
+static uint8_t * prv_getRecvBuffer(iowa_context_t contextP,
+                                   coap_peer_datagram_t *peerP,
+                                   size_t size)
+{
+    // WARNING: This function is called in a critical section
+    coap_context_t coapContextP;
+
+    coapContextP = contextP->coapContextP;
+
+    if (coapContextP->recvBufferSize < size)
+    {
+        // The buffer only grows so that it is not allocated at each reception
+        iowa_system_free(coapContextP->recvBuffer);
+        coapContextP->recvBufferSize = 0;
+
+        coapContextP->recvBuffer = (uint8_t *)iowa_system_malloc(size);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (coapContextP->recvBuffer == NULL)
+        {
+            uint8_t discardBuffer[4];
+
+            IOWA_LOG_ERROR_MALLOC(size);
+
+            // Drop the datagram so that the connection is not reported again as having data
+            (void)peerRecvBuffer(contextP, (iowa_coap_peer_t *)peerP, discardBuffer, sizeof(discardBuffer));
+            return NULL;
+        }
+#endif
+        coapContextP->recvBufferSize = size;
+    }
+
+    return coapContextP->recvBuffer;
+}
+
+static void prv_handleDatagram(iowa_context_t contextP,
+                               coap_peer_datagram_t *peerP,
+                               uint8_t *buffer,
+                               size_t bufferLength,
+                               size_t bufferSize)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_message_t *messageP;
+    uint8_t result;
+    size_t maxPayloadSize;
+    bool truncated;
+
+    maxPayloadSize = 0;
+
+    result = messageDatagramParse(buffer, bufferLength, &messageP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+        // ignore message
+        return;
+    }
+
+    if (bufferLength >= bufferSize)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Received a message of %u bytes while the maximum datagram size is %u. Payload was truncated.", bufferLength, bufferSize);
+
+        maxPayloadSize = messageP->payload.length;
+        truncated = true;
+        CORE_METRICS_INCREMENT(peerP->base.metrics.truncationCount);
+    }
+    else
+    {
+        truncated = false;
+    }
+
+#ifndef IOWA_COAP_BLOCK_SUPPORT
+    if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1) != NULL)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 1 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+
+        coapSendResponse(contextP, (iowa_coap_peer_t *)peerP, messageP, IOWA_COAP_402_BAD_OPTION);
+        iowa_coap_message_free(messageP);
+        return;
+    }
+    else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2) != NULL) //Server cannot respond to a Block message from the Client when Block is not supported.
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 2 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+
+        iowa_coap_message_free(messageP);
+        return;
+    }
+#endif
+
+    transactionHandleMessage(contextP, peerP, messageP, truncated, maxPayloadSize);
+
+    iowa_coap_message_free(messageP);
+}
+
 void udpSecurityEventCb(iowa_security_session_t securityS,
                         iowa_security_event_t event,
                         void *userData,
@@ -112,60 +266,47 @@ void udpSecurityEventCb(iowa_security_session_t securityS,
 
     case SECURITY_EVENT_DATA_AVAILABLE:
     {
-        static uint8_t buffer[IOWA_BUFFER_SIZE];
-        int bufferLength;
+        uint8_t *buffer;
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+        size_t lengthArray[IOWA_CONNECTION_RECV_BATCH_SIZE];
+        int datagramCount;
+        int datagramIndex;
 
-        bufferLength = peerRecvBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, IOWA_BUFFER_SIZE);
-        if (bufferLength > 0)
+        buffer = prv_getRecvBuffer(contextP, peerP, IOWA_CONNECTION_RECV_BATCH_SIZE * peerP->maxDatagramSize);
+        if (buffer == NULL)
         {
-            iowa_coap_message_t *messageP;
-            uint8_t result;
-            size_t maxPayloadSize;
-            bool truncated;
-
-            maxPayloadSize = 0;
-
-            result = messageDatagramParse(buffer, (size_t)bufferLength, &messageP);
-            if (result != IOWA_COAP_NO_ERROR)
-            {
-                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Message parsing failed with error %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
-                // ignore message
-                return;
-            }
-
-            if (bufferLength >= IOWA_BUFFER_SIZE)
-            {
-                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Received a message of %u bytes while IOWA_BUFFER_SIZE is %u. Payload was truncated.", bufferLength, IOWA_BUFFER_SIZE);
-
-                maxPayloadSize = messageP->payload.length;
-                truncated = true;
-            }
-            else
-            {
-                truncated = false;
-            }
+            return;
+        }
 
-            if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_1) != NULL)
-            {
-                IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 1 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
+        datagramCount = peerRecvBatch(contextP, (iowa_coap_peer_t *)peerP, buffer, peerP->maxDatagramSize, lengthArray, IOWA_CONNECTION_RECV_BATCH_SIZE);
 
-                coapSendResponse(contextP, (iowa_coap_peer_t *)peerP, messageP, IOWA_COAP_402_BAD_OPTION);
-                iowa_coap_message_free(messageP);
-                return;
-            }
-            else if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2) != NULL) //Server cannot respond to a Block message from the Client when Block is not supported.
+        // A handled message can lead to the closure of the peer: the remaining datagrams are then dropped
+        contextP->coapContextP->recvPeerP = (iowa_coap_peer_t *)peerP;
+        for (datagramIndex = 0;
+             datagramIndex < datagramCount && contextP->coapContextP->recvPeerP != NULL;
+             datagramIndex++)
+        {
+            if (lengthArray[datagramIndex] > 0)
             {
-                IOWA_LOG_WARNING(IOWA_PART_COAP, "Received message containing Block 2 option but IOWA_COAP_BLOCK_MINIMAL_SUPPORT is not defined.");
-
-                iowa_coap_message_free(messageP);
-                return;
+                prv_handleDatagram(contextP, peerP, buffer + (size_t)datagramIndex * peerP->maxDatagramSize, lengthArray[datagramIndex], peerP->maxDatagramSize);
             }
+        }
+        contextP->coapContextP->recvPeerP = NULL;
+#else
+        int bufferLength;
 
-            transactionHandleMessage(contextP, peerP, messageP, truncated, maxPayloadSize);
-
-            iowa_coap_message_free(messageP);
+        buffer = prv_getRecvBuffer(contextP, peerP, peerP->maxDatagramSize);
+        if (buffer == NULL)
+        {
             return;
         }
+
+        bufferLength = peerRecvBuffer(contextP, (iowa_coap_peer_t *)peerP, buffer, peerP->maxDatagramSize);
+        if (bufferLength > 0)
+        {
+            prv_handleDatagram(contextP, peerP, buffer, (size_t)bufferLength, peerP->maxDatagramSize);
+        }
+#endif
     }
     break;
 
@@ -33,3 +33,180 @@ void coapUtilsfreeApplicationData(application_coap_data_t *dataP)
         iowa_system_free(dataP);
     }
 }
+
+/*************************************************************************************
+** Index functions
+*************************************************************************************/
+
+#define PRV_INDEX_MIN_SIZE 8
+
+static size_t prv_indexHome(const coap_index_t *indexP,
+                            uint32_t key)
+{
+    // Mix the bits so that sequential message IDs do not cluster
+    key ^= key >> 16;
+    key *= 0x45D9F3B;
+    key ^= key >> 16;
+
+    return (size_t)key & (indexP->size - 1);
+}
+
+static void prv_indexInsert(coap_index_t *indexP,
+                            uint32_t key,
+                            void *nodeP)
+{
+    size_t pos;
+
+    pos = prv_indexHome(indexP, key);
+    while (indexP->slotArray[pos].nodeP != NULL)
+    {
+        pos = (pos + 1) & (indexP->size - 1);
+    }
+
+    indexP->slotArray[pos].key = key;
+    indexP->slotArray[pos].nodeP = nodeP;
+    indexP->count++;
+}
+
+static iowa_status_t prv_indexResize(coap_index_t *indexP,
+                                     size_t newSize)
+{
+    coap_index_slot_t *oldArray;
+    size_t oldSize;
+    size_t i;
+
+    oldArray = indexP->slotArray;
+    oldSize = indexP->size;
+
+    indexP->slotArray = (coap_index_slot_t *)iowa_system_malloc(newSize * sizeof(coap_index_slot_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (indexP->slotArray == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(newSize * sizeof(coap_index_slot_t));
+        indexP->slotArray = oldArray;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(indexP->slotArray, 0, newSize * sizeof(coap_index_slot_t));
+    indexP->size = newSize;
+    indexP->count = 0;
+
+    for (i = 0; i < oldSize; i++)
+    {
+        if (oldArray[i].nodeP != NULL)
+        {
+            prv_indexInsert(indexP, oldArray[i].key, oldArray[i].nodeP);
+        }
+    }
+
+    iowa_system_free(oldArray);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t coapIndexAdd(coap_index_t *indexP,
+                           uint32_t key,
+                           void *nodeP)
+{
+    // Keep the load factor under 3/4
+    if ((indexP->count + 1) * 4 > indexP->size * 3)
+    {
+        iowa_status_t result;
+
+        result = prv_indexResize(indexP, indexP->size == 0 ? PRV_INDEX_MIN_SIZE : indexP->size * 2);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+    }
+
+    prv_indexInsert(indexP, key, nodeP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void * coapIndexFind(coap_index_t *indexP,
+                     uint32_t key,
+                     coap_index_match_callback_t matchCallback,
+                     const void *criteriaP)
+{
+    size_t pos;
+
+    if (indexP->count == 0)
+    {
+        return NULL;
+    }
+
+    pos = prv_indexHome(indexP, key);
+    while (indexP->slotArray[pos].nodeP != NULL)
+    {
+        if (indexP->slotArray[pos].key == key
+            && (matchCallback == NULL
+                || matchCallback(indexP->slotArray[pos].nodeP, criteriaP) == true))
+        {
+            return indexP->slotArray[pos].nodeP;
+        }
+        pos = (pos + 1) & (indexP->size - 1);
+    }
+
+    return NULL;
+}
+
+void coapIndexRemove(coap_index_t *indexP,
+                     uint32_t key,
+                     void *nodeP)
+{
+    size_t mask;
+    size_t pos;
+    size_t next;
+
+    if (indexP->count == 0)
+    {
+        return;
+    }
+
+    mask = indexP->size - 1;
+
+    pos = prv_indexHome(indexP, key);
+    while (indexP->slotArray[pos].nodeP != nodeP)
+    {
+        if (indexP->slotArray[pos].nodeP == NULL)
+        {
+            // Not in the index
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    // Shift back the following slots of the probe sequence instead of leaving a tombstone
+    next = pos;
+    while (true)
+    {
+        size_t home;
+
+        next = (next + 1) & mask;
+        if (indexP->slotArray[next].nodeP == NULL)
+        {
+            break;
+        }
+
+        home = prv_indexHome(indexP, indexP->slotArray[next].key);
+        // The slot can be moved if its home is not cyclically in (pos, next]
+        if (((next - home) & mask) >= ((next - pos) & mask))
+        {
+            indexP->slotArray[pos] = indexP->slotArray[next];
+            pos = next;
+        }
+    }
+
+    indexP->slotArray[pos].nodeP = NULL;
+    indexP->count--;
+}
+
+void coapIndexClear(coap_index_t *indexP)
+{
+    iowa_system_free(indexP->slotArray);
+    indexP->slotArray = NULL;
+    indexP->size = 0;
+    indexP->count = 0;
+}
@@ -47,49 +47,42 @@
 #define PRV_STREAM_MSG_LENGTH_EXTEND_2   0x0E
 #define PRV_STREAM_MSG_LENGTH_EXTEND_3   0x0F
 
-size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
-                                    uint8_t **bufferP)
+// Compute the length of the datagram header, the token and the options of a CoAP message.
+// Returned value: the length or 0 if the options are not in order.
+// Parameters:
+// - messageP: the CoAP message.
+static size_t prv_getDatagramHeaderLength(iowa_coap_message_t *messageP)
 {
-    size_t bufferLength;
-    uint8_t *buffer;
-    size_t index;
+    size_t length;
     iowa_coap_option_t *optionP;
     uint16_t prevNumber;
 
-    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
-
-    // Compute serialized length
-    bufferLength = PRV_DATAGRAM_MSG_HEADER_LENGTH + (size_t)messageP->tokenLength + messageP->payload.length;
-
-    if (messageP->payload.length != 0)
-    {
-        bufferLength += 1;
-    }
+    length = PRV_DATAGRAM_MSG_HEADER_LENGTH + (size_t)messageP->tokenLength;
 
     prevNumber = 0;
     for (optionP = messageP->optionList; optionP != NULL; optionP = optionP->next)
     {
         if (optionP->number < prevNumber)
         {
-            IOWA_LOG_WARNING(IOWA_PART_COAP, "Exit on error: options are not in order.");
+            IOWA_LOG_WARNING(IOWA_PART_COAP, "Options are not in order.");
             return 0;
         }
-        bufferLength += option_getSerializedLength(optionP, iowa_coap_option_is_integer);
+        length += option_getSerializedLength(optionP, iowa_coap_option_is_integer);
         prevNumber = optionP->number;
     }
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Estimated length: %u", bufferLength);
+    return length;
+}
 
-    // Allocate buffer for serialized packet
-    buffer = (uint8_t *)iowa_system_malloc(bufferLength);
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-    if (buffer == NULL)
-    {
-        IOWA_LOG_ERROR_MALLOC(bufferLength);
-        return 0;
-    }
-#endif
-    memset(buffer, 0, bufferLength);
+// Write the datagram header, the token, the options and the payload marker of a CoAP message.
+// Returned value: the number of bytes written.
+// Parameters:
+// - messageP: the CoAP message.
+// - buffer: the buffer to write to. It is large enough and zeroed.
+static size_t prv_serializeDatagramHeader(iowa_coap_message_t *messageP,
+                                          uint8_t *buffer)
+{
+    size_t index;
 
     // Set CoAP header
     buffer[0] = (uint8_t)(PRV_DATAGRAM_MSG_HEADER_VERSION + (messageP->type << PRV_DATAGRAM_MSG_HEADER_TYPE_SHIFT) + messageP->tokenLength);
@@ -98,24 +91,69 @@ size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
     buffer[3] = (uint8_t)(messageP->id & 0xFF);
 
     // Add token if any
-    if (messageP->tokenLength > 0 && messageP->tokenLength <= COAP_MSG_TOKEN_MAX_LEN)
+    if (messageP->tokenLength > 0)
     {
         memcpy(buffer + PRV_DATAGRAM_MSG_TOKEN_OFFSET, messageP->token, messageP->tokenLength);
     }
-    else
-    {
-        messageP->tokenLength = 0;
-    }
 
     index = (size_t)(PRV_DATAGRAM_MSG_TOKEN_OFFSET + messageP->tokenLength);
 
     index += option_serialize(messageP->optionList, buffer + index, iowa_coap_option_is_integer);
 
-    // Add payload if any
     if (messageP->payload.length != 0)
     {
         buffer[index] = PRV_MSG_PAYLOAD_MARKER;
         index++;
+    }
+
+    return index;
+}
+
+size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
+                                    uint8_t **bufferP)
+{
+    size_t bufferLength;
+    uint8_t *buffer;
+    size_t index;
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+
+    if (messageP->tokenLength > COAP_MSG_TOKEN_MAX_LEN)
+    {
+        messageP->tokenLength = 0;
+    }
+
+    // Compute serialized length
+    bufferLength = prv_getDatagramHeaderLength(messageP);
+    if (bufferLength == 0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_COAP, "Exit on error: options are not in order.");
+        return 0;
+    }
+
+    if (messageP->payload.length != 0)
+    {
+        bufferLength += 1 + messageP->payload.length;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Estimated length: %u", bufferLength);
+
+    // Allocate buffer for serialized packet
+    buffer = (uint8_t *)iowa_system_malloc(bufferLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(bufferLength);
+        return 0;
+    }
+#endif
+    memset(buffer, 0, bufferLength);
+
+    index = prv_serializeDatagramHeader(messageP, buffer);
+
+    // Add payload if any
+    if (messageP->payload.length != 0)
+    {
         memcpy(buffer + index, messageP->payload.data, messageP->payload.length);
         index += messageP->payload.length;
     }
@@ -127,11 +165,66 @@ size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
     return index;
 }
 
+size_t coapMessageGetDatagramHeadroom(iowa_coap_message_t *messageP)
+{
+    size_t length;
+
+    if (messageP->tokenLength > COAP_MSG_TOKEN_MAX_LEN)
+    {
+        return 0;
+    }
+
+    length = prv_getDatagramHeaderLength(messageP);
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    // Add the payload marker
+    return length + 1;
+}
+
+size_t coapMessageSerializeDatagramInPlace(iowa_coap_message_t *messageP,
+                                           uint8_t **bufferP)
+{
+    size_t headroom;
+    size_t index;
+
+    IOWA_LOG_TRACE(IOWA_PART_COAP, "Entering");
+
+    if (messageP->payload.memory == NULL
+        || messageP->payload.length == 0)
+    {
+        return 0;
+    }
+
+    headroom = coapMessageGetDatagramHeadroom(messageP);
+    if (headroom == 0
+        || (size_t)(messageP->payload.data - messageP->payload.memory) != headroom)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_COAP, "No matching headroom in the payload buffer.");
+        return 0;
+    }
+
+    memset(messageP->payload.memory, 0, headroom);
+    index = prv_serializeDatagramHeader(messageP, messageP->payload.memory);
+
+    *bufferP = messageP->payload.memory;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Serialized message in place is %u bytes.", index + messageP->payload.length);
+
+    return index + messageP->payload.length;
+}
+
 size_t messageDatagramParseHeader(uint8_t *buffer,
                                   size_t bufferLength,
                                   iowa_coap_message_t **messageP)
 {
     uint8_t tokenLen;
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+    size_t viewSize;
+    size_t allocSize;
+#endif
 
     *messageP = NULL;
 
@@ -159,7 +252,34 @@ size_t messageDatagramParseHeader(uint8_t *buffer,
         return 0;
     }
 
-    *messageP = (iowa_coap_message_t *)iowa_system_malloc(sizeof(iowa_coap_message_t));
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+    // Only the received messages with options have views, allocated with the message and sized for their options
+    viewSize = option_count(buffer + PRV_DATAGRAM_MSG_HEADER_LENGTH + tokenLen, bufferLength - PRV_DATAGRAM_MSG_HEADER_LENGTH - tokenLen, IOWA_COAP_OPTION_VIEW_COUNT);
+    if (viewSize != 0)
+    {
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+        // All the objects of a pool have the same size
+        viewSize = IOWA_COAP_OPTION_VIEW_COUNT;
+#endif
+        allocSize = sizeof(iowa_coap_message_t) + viewSize * sizeof(iowa_coap_option_t);
+        *messageP = (iowa_coap_message_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_COAP_OPTION_VIEW, allocSize);
+    }
+    else
+    {
+        allocSize = sizeof(iowa_coap_message_t);
+        *messageP = (iowa_coap_message_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_COAP_MESSAGE, allocSize);
+    }
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*messageP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(allocSize);
+        return 0;
+    }
+#endif
+    memset(*messageP, 0, sizeof(iowa_coap_message_t));
+    (*messageP)->optionViewSize = (uint8_t)viewSize;
+#else
+    *messageP = (iowa_coap_message_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_COAP_MESSAGE, sizeof(iowa_coap_message_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (*messageP == NULL)
     {
@@ -168,6 +288,7 @@ size_t messageDatagramParseHeader(uint8_t *buffer,
     }
 #endif
     memset(*messageP, 0, sizeof(iowa_coap_message_t));
+#endif
 
     (*messageP)->type = ((uint8_t)(buffer[0] & PRV_DATAGRAM_MSG_HEADER_TYPE_MASK)) >> PRV_DATAGRAM_MSG_HEADER_TYPE_SHIFT;
     (*messageP)->code = buffer[1];
@@ -196,7 +317,11 @@ uint8_t messageDatagramParse(uint8_t *buffer,
         return IOWA_COAP_400_BAD_REQUEST;
     }
 
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+    result = option_parse(buffer + index, bufferLength - index, &((*messageP)->optionList), &optLen, iowa_coap_option_is_integer, COAP_MESSAGE_OPTION_VIEWS(*messageP), (*messageP)->optionViewSize);
+#else
     result = option_parse(buffer + index, bufferLength - index, &((*messageP)->optionList), &optLen, iowa_coap_option_is_integer);
+#endif
     if (result != IOWA_COAP_NO_ERROR)
     {
         IOWA_LOG_WARNING(IOWA_PART_COAP, "Parsing of the options failed.");
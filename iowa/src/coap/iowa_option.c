@@ -21,6 +21,11 @@
 
 #include "iowa_prv_coap_internals.h"
 
+static void prv_freeOption(void *optionP)
+{
+    CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_OPTION, optionP);
+}
+
 bool iowa_coap_option_is_integer(const iowa_coap_option_t *optionP)
 {
     switch (optionP->number)
@@ -197,24 +202,44 @@ size_t option_serialize(iowa_coap_option_t *optionList,
     return index;
 }
 
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+uint8_t option_parse(uint8_t *buffer,
+                     size_t bufferLength,
+                     iowa_coap_option_t **optionListP,
+                     size_t *lengthP,
+                     coap_option_callback_t isIntegerCallback,
+                     iowa_coap_option_t *viewArray,
+                     size_t viewSize)
+#else
 uint8_t option_parse(uint8_t *buffer,
                      size_t bufferLength,
                      iowa_coap_option_t **optionListP,
                      size_t *lengthP,
                      coap_option_callback_t isIntegerCallback)
+#endif
 {
     uint8_t result;
     size_t index;
     iowa_coap_option_t *currOptionP;
+    iowa_coap_option_t *newOptionP;
+    iowa_coap_option_t *firstAllocatedP;
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+    size_t viewCount;
+#endif
 
     index = 0;
     currOptionP = NULL;
+    firstAllocatedP = NULL;
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+    viewCount = 0;
+#endif
 
     while (index < bufferLength
            && buffer[index] != PRV_MSG_PAYLOAD_MARKER)
     {
         uint16_t delta;
         uint16_t length;
+        uint16_t number;
 
         delta = ((uint8_t)(buffer[index] & PRV_OPT_DELTA_MASK)) >> PRV_OPT_DELTA_SHIFT;
         length = buffer[index] & PRV_OPT_LENGTH_MASK;
@@ -283,32 +308,44 @@ uint8_t option_parse(uint8_t *buffer,
             goto exit_on_error;
         }
 
-        if (currOptionP != NULL)
+        number = currOptionP != NULL ? (uint16_t)(currOptionP->number + delta) : delta;
+
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+        // The options are taken from the view array until it is full. The next ones are allocated.
+        if (viewCount < viewSize)
         {
-            currOptionP->next = iowa_coap_option_new((uint16_t)(currOptionP->number + delta));
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-            if (currOptionP->next == NULL)
-            {
-                IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
-                result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
-                goto exit_on_error;
-            }
-#endif
-            currOptionP = currOptionP->next;
+            newOptionP = viewArray + viewCount;
+            memset(newOptionP, 0, sizeof(iowa_coap_option_t));
+            newOptionP->number = number;
+            viewCount++;
         }
         else
+#endif
         {
-            *optionListP = iowa_coap_option_new(delta);
+            newOptionP = iowa_coap_option_new(number);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-            if (*optionListP == NULL)
+            if (newOptionP == NULL)
             {
                 IOWA_LOG_ERROR(IOWA_PART_COAP, "Failed to create new CoAP option.");
                 result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
                 goto exit_on_error;
             }
 #endif
-            currOptionP = *optionListP;
+            if (firstAllocatedP == NULL)
+            {
+                firstAllocatedP = newOptionP;
+            }
+        }
+
+        if (currOptionP != NULL)
+        {
+            currOptionP->next = newOptionP;
+        }
+        else
+        {
+            *optionListP = newOptionP;
         }
+        currOptionP = newOptionP;
 
         if (length > 0)
         {
@@ -341,17 +378,76 @@ uint8_t option_parse(uint8_t *buffer,
     return IOWA_COAP_NO_ERROR;
 
 exit_on_error:
-    iowa_coap_option_free(*optionListP);
+    // The allocated options are all at the end of the list
+    iowa_coap_option_free(firstAllocatedP);
     *optionListP = NULL;
 
     return result;
 }
 
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+size_t option_count(const uint8_t *buffer,
+                    size_t bufferLength,
+                    size_t maxCount)
+{
+    size_t count;
+    size_t index;
+
+    // Malformed options are reported by option_parse()
+    count = 0;
+    index = 0;
+    while (count < maxCount
+           && index < bufferLength
+           && buffer[index] != PRV_MSG_PAYLOAD_MARKER)
+    {
+        uint8_t delta;
+        size_t length;
+
+        delta = ((uint8_t)(buffer[index] & PRV_OPT_DELTA_MASK)) >> PRV_OPT_DELTA_SHIFT;
+        length = buffer[index] & PRV_OPT_LENGTH_MASK;
+        index += PRV_OPT_HEADER_LENGTH;
+
+        if (delta == PRV_OPT_EXTEND_1)
+        {
+            index++;
+        }
+        else if (delta == PRV_OPT_EXTEND_2)
+        {
+            index += 2;
+        }
+
+        if (length == PRV_OPT_EXTEND_1)
+        {
+            if (index >= bufferLength)
+            {
+                break;
+            }
+            length = PRV_OPT_LIMIT_1 + (size_t)buffer[index];
+            index++;
+        }
+        else if (length == PRV_OPT_EXTEND_2)
+        {
+            if (index + 1 >= bufferLength)
+            {
+                break;
+            }
+            length = PRV_OPT_LIMIT_2 + ((size_t)buffer[index] << 8) + buffer[index + 1];
+            index += 2;
+        }
+
+        index += length;
+        count++;
+    }
+
+    return count;
+}
+#endif
+
 iowa_coap_option_t * iowa_coap_option_new(uint16_t number)
 {
     iowa_coap_option_t *optionP;
 
-    optionP = (iowa_coap_option_t *)iowa_system_malloc(sizeof(iowa_coap_option_t));
+    optionP = (iowa_coap_option_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_COAP_OPTION, sizeof(iowa_coap_option_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (optionP == NULL)
     {
@@ -367,7 +463,7 @@ iowa_coap_option_t * iowa_coap_option_new(uint16_t number)
 
 void iowa_coap_option_free(iowa_coap_option_t *optionP)
 {
-    IOWA_UTILS_LIST_FREE(optionP, iowa_system_free);
+    IOWA_UTILS_LIST_FREE(optionP, prv_freeOption);
 }
 
 iowa_coap_option_t * iowa_coap_path_to_option(uint16_t number,
@@ -27,13 +27,73 @@
 ** Private functions
 *************************************************************************************/
 
-#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
-static bool prv_exchangeFindCallback(void *nodeP,
-                                     void *criteriaP)
+static uint32_t prv_exchangeKey(uint8_t tokenLength,
+                                const uint8_t *token)
+{
+    uint32_t key;
+    uint8_t i;
+
+    // FNV-1a hash of the token
+    key = 2166136261u;
+    key ^= tokenLength;
+    key *= 16777619u;
+    for (i = 0; i < tokenLength; i++)
+    {
+        key ^= token[i];
+        key *= 16777619u;
+    }
+
+    return key;
+}
+
+static bool prv_exchangeMatchCallback(void *nodeP,
+                                      const void *criteriaP)
 {
-    return nodeP == criteriaP;
+    coap_exchange_t *exchangeP;
+    const coap_exchange_t *criteriaExchangeP;
+
+    exchangeP = (coap_exchange_t *)nodeP;
+    criteriaExchangeP = (const coap_exchange_t *)criteriaP;
+
+    return (exchangeP->tokenLength == criteriaExchangeP->tokenLength
+            && 0 == memcmp(exchangeP->token, criteriaExchangeP->token, exchangeP->tokenLength));
 }
 
+static coap_exchange_t *prv_exchangeFind(iowa_coap_peer_t *peerP,
+                                         uint8_t tokenLength,
+                                         const uint8_t *token)
+{
+    coap_exchange_t criteria;
+
+    criteria.tokenLength = tokenLength;
+    memcpy(criteria.token, token, tokenLength);
+
+    return (coap_exchange_t *)coapIndexFind(&peerP->base.exchangeIndex, prv_exchangeKey(tokenLength, token), prv_exchangeMatchCallback, &criteria);
+}
+
+static void prv_exchangeRemove(iowa_coap_peer_t *peerP,
+                               coap_exchange_t *exchangeP)
+{
+    coapIndexRemove(&peerP->base.exchangeIndex, prv_exchangeKey(exchangeP->tokenLength, exchangeP->token), exchangeP);
+
+    if (exchangeP->prev == NULL)
+    {
+        peerP->base.exchangeList = exchangeP->next;
+    }
+    else
+    {
+        exchangeP->prev->next = exchangeP->next;
+    }
+    if (exchangeP->next != NULL)
+    {
+        exchangeP->next->prev = exchangeP->prev;
+    }
+    exchangeP->next = NULL;
+    exchangeP->prev = NULL;
+}
+
+#if defined(IOWA_UDP_SUPPORT) || defined(IOWA_LORAWAN_SUPPORT) || defined(IOWA_SMS_SUPPORT)
+
 static void prv_datagramSendResult(iowa_coap_peer_t *fromPeer,
                                    uint8_t code,
                                    iowa_coap_message_t *messageP,
@@ -44,18 +104,22 @@ static void prv_datagramSendResult(iowa_coap_peer_t *fromPeer,
 
     if (messageP == NULL)
     {
-        coap_exchange_t *exchangeP;
         coap_exchange_t *exchangeFoundP;
 
-        exchangeP = (coap_exchange_t *)userData;
-        exchangeFoundP = NULL;
-
-        fromPeer->base.exchangeList = (coap_exchange_t *)IOWA_UTILS_LIST_FIND_AND_REMOVE(fromPeer->base.exchangeList, prv_exchangeFindCallback, exchangeP, &exchangeFoundP);
+        // The exchange may have already been freed: compare the pointers only
+        exchangeFoundP = fromPeer->base.exchangeList;
+        while (exchangeFoundP != NULL
+               && exchangeFoundP != (coap_exchange_t *)userData)
+        {
+            exchangeFoundP = exchangeFoundP->next;
+        }
         if (exchangeFoundP != NULL)
         {
+            prv_exchangeRemove(fromPeer, exchangeFoundP);
+
             IOWA_LOG_TRACE(IOWA_PART_COAP, "Forward reply to the upper layer.");
             exchangeFoundP->callback(fromPeer, code, messageP, exchangeFoundP->userData, contextP);
-            iowa_system_free(exchangeFoundP);
+            CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_EXCHANGE, exchangeFoundP);
         }
     }
 }
@@ -149,6 +213,8 @@ static iowa_coap_peer_t *peer_new(iowa_connection_type_t type)
         memset(peerP, 0, sizeof(coap_peer_datagram_t));
         ((coap_peer_datagram_t *)peerP)->ackTimeout = COAP_UDP_ACK_REAL_TIMEOUT;
         ((coap_peer_datagram_t *)peerP)->maxRetransmit = COAP_UDP_MAX_RETRANSMIT;
+        ((coap_peer_datagram_t *)peerP)->nstart = COAP_DEFAULT_NSTART;
+        ((coap_peer_datagram_t *)peerP)->maxDatagramSize = IOWA_COAP_DATAGRAM_MAX_SIZE;
         ((coap_peer_datagram_t *)peerP)->transmitWait = COAP_COMPUTE_MAX_TRANSMIT_WAIT(COAP_UDP_ACK_REAL_TIMEOUT, COAP_UDP_MAX_RETRANSMIT);
         break;
 #endif
@@ -189,14 +255,15 @@ static void peer_free(iowa_context_t contextP,
     case IOWA_CONN_DATAGRAM:
     case IOWA_CONN_LORAWAN:
     case IOWA_CONN_SMS:
-        IOWA_UTILS_LIST_FREE(((coap_peer_datagram_t *)peerP)->transactionList, transactionFree);
-        IOWA_UTILS_LIST_FREE(((coap_peer_datagram_t *)peerP)->ackList, acknowledgeFree);
+        transactionClear((coap_peer_datagram_t *)peerP);
         break;
 
     default:
         break;
     }
 
+    coapIndexClear(&peerP->base.exchangeIndex);
+
     iowa_system_free(peerP);
 }
 
@@ -236,6 +303,51 @@ static iowa_status_t prv_datagramConfig(coap_peer_datagram_t *peerP,
         }
         break;
 
+    case IOWA_COAP_SETTING_NSTART:
+        if (set == true)
+        {
+            if (*((uint8_t *)argP) == 0)
+            {
+                IOWA_LOG_WARNING(IOWA_PART_COAP, "NSTART can not be 0.");
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            peerP->nstart = *((uint8_t *)argP);
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p new NSTART: %u.", peerP, peerP->nstart);
+        }
+        else
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p NSTART is %u.", peerP, peerP->nstart);
+            *((uint8_t *)argP) = peerP->nstart;
+        }
+        break;
+
+    case IOWA_COAP_SETTING_MAX_DATAGRAM_SIZE:
+        if (set == true)
+        {
+            if (*((size_t *)argP) < COAP_DATAGRAM_MIN_SIZE)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Maximum datagram size can not be less than %u.", COAP_DATAGRAM_MIN_SIZE);
+                return IOWA_COAP_400_BAD_REQUEST;
+            }
+            peerP->maxDatagramSize = *((size_t *)argP);
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p new maximum datagram size: %u.", peerP, peerP->maxDatagramSize);
+        }
+        else
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p maximum datagram size is %u.", peerP, peerP->maxDatagramSize);
+            *((size_t *)argP) = peerP->maxDatagramSize;
+        }
+        break;
+
+    case IOWA_COAP_SETTING_ACK_CACHE_STATS:
+        if (set == true)
+        {
+            return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+        }
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "RFC7252 peer %p caches %u acknowledgements in %u bytes.", peerP, peerP->ackCacheStats.count, peerP->ackCacheStats.memory);
+        *((iowa_coap_ack_cache_stats_t *)argP) = peerP->ackCacheStats;
+        break;
+
         default:
             IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Unknown setting: %u.", settingId);
             return IOWA_COAP_405_METHOD_NOT_ALLOWED;
@@ -487,6 +599,11 @@ void coapPeerDelete(iowa_context_t contextP,
     {
         iowa_connection_type_t savedType;
 
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+        // Report the sending errors to the transactions of the peer while they exist
+        commSendBatchFlush(contextP);
+#endif
+
         // Mark the peer has being deleted in case a transaction callback would delete the peer.
         savedType = peerP->base.type;
         peerP->base.type = IOWA_CONN_UNDEFINED;
@@ -494,19 +611,26 @@ void coapPeerDelete(iowa_context_t contextP,
         coapPeerDisconnect(contextP, peerP);
 
         contextP->coapContextP->peerList = (iowa_coap_peer_t *)IOWA_UTILS_LIST_REMOVE(contextP->coapContextP->peerList, peerP);
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+        if (contextP->coapContextP->recvPeerP == peerP)
+        {
+            // Stop handling the datagrams received for this peer
+            contextP->coapContextP->recvPeerP = NULL;
+        }
+#endif
 
         while (peerP->base.exchangeList != NULL)
         {
             coap_exchange_t *exchangeP;
 
             exchangeP = peerP->base.exchangeList;
-            peerP->base.exchangeList = exchangeP->next;
+            prv_exchangeRemove(peerP, exchangeP);
 
             if (exchangeP->callback != NULL)
             {
                 exchangeP->callback(peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, exchangeP->userData, contextP);
             }
-            iowa_system_free(exchangeP);
+            CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_EXCHANGE, exchangeP);
         }
 
         switch (savedType)
@@ -514,26 +638,18 @@ void coapPeerDelete(iowa_context_t contextP,
         case IOWA_CONN_DATAGRAM:
         case IOWA_CONN_LORAWAN:
         case IOWA_CONN_SMS:
-            while (((coap_peer_datagram_t *)peerP)->transactionList != NULL)
-            {
-                coap_transaction_t *transacP;
-
-                transacP = ((coap_peer_datagram_t *)peerP)->transactionList;
-                ((coap_peer_datagram_t *)peerP)->transactionList = ((coap_peer_datagram_t *)peerP)->transactionList->next;
-
-                if (transacP->callback != NULL)
-                {
-                    transacP->callback(peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, transacP->userData, contextP);
-                }
-                transactionFree(transacP);
-            }
-            IOWA_UTILS_LIST_FREE(((coap_peer_datagram_t *)peerP)->ackList, acknowledgeFree);
+            transactionCancelAll(contextP, (coap_peer_datagram_t *)peerP);
+            transactionClear((coap_peer_datagram_t *)peerP);
             break;
 
         default:
             break;
         }
 
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+        coapBlockClearContent(peerP);
+#endif
+
         peer_free(contextP, peerP);
     }
 }
@@ -695,11 +811,24 @@ uint8_t peerSend(iowa_context_t contextP,
     intermediateCallback = resultCallback;
     intermediateUserdata = userData;
 
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+    if (!COAP_IS_REQUEST(messageP->code)
+        && iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_BLOCK_2) == NULL)
+    {
+        // A response too large for the peer, like a notification, is sent as its first block
+        result = coapBlockSliceResponse(peerP, NULL, messageP, 0);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            return result;
+        }
+    }
+#endif
+
     if (resultCallback != NULL
         && COAP_IS_REQUEST(messageP->code))
     {
 
-        exchangeP = (coap_exchange_t *)iowa_system_malloc(sizeof(coap_exchange_t));
+        exchangeP = (coap_exchange_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_COAP_EXCHANGE, sizeof(coap_exchange_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (exchangeP == NULL)
         {
@@ -739,20 +868,37 @@ uint8_t peerSend(iowa_context_t contextP,
     }
 #endif
 
+    if (exchangeP != NULL)
+    {
+        // Index the exchange before sending so that no failure can occur once the request is sent
+        result = coapIndexAdd(&peerP->base.exchangeIndex, prv_exchangeKey(exchangeP->tokenLength, exchangeP->token), exchangeP);
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_EXCHANGE, exchangeP);
+            return result;
+        }
+    }
+
     result = prv_send(contextP, peerP, messageP, intermediateCallback, intermediateUserdata);
 
-    if (result == IOWA_COAP_NO_ERROR)
+    if (exchangeP != NULL)
     {
-        if (exchangeP != NULL)
+        if (result == IOWA_COAP_NO_ERROR)
         {
             // Send was successful, enqueue the exchange
-            peerP->base.exchangeList = (coap_exchange_t *)IOWA_UTILS_LIST_ADD(peerP->base.exchangeList, exchangeP);
+            exchangeP->next = peerP->base.exchangeList;
+            if (exchangeP->next != NULL)
+            {
+                exchangeP->next->prev = exchangeP;
+            }
+            peerP->base.exchangeList = exchangeP;
+        }
+        else
+        {
+            // an error occurred, free the exchange
+            coapIndexRemove(&peerP->base.exchangeIndex, prv_exchangeKey(exchangeP->tokenLength, exchangeP->token), exchangeP);
+            CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_EXCHANGE, exchangeP);
         }
-    }
-    else
-    {
-        // an error occurred, free the exchange
-        iowa_system_free(exchangeP);
     }
 
     if (!COAP_IS_REQUEST(messageP->code)
@@ -786,7 +932,40 @@ int peerSendBuffer(iowa_context_t contextP,
                    size_t bufferLength)
 {
     // WARNING: This function is called in a critical section
-    return securitySend(contextP, peerP->base.securityS, buffer, bufferLength);
+    int result;
+
+    result = securitySend(contextP, peerP->base.securityS, buffer, bufferLength);
+    if (result > 0)
+    {
+        CORE_METRICS_INCREMENT(peerP->base.metrics.datagramOutCount);
+        CORE_METRICS_ADD(peerP->base.metrics.byteOutCount, (size_t)result);
+    }
+
+    return result;
+}
+
+void peerSendBufferDeferred(iowa_context_t contextP,
+                            iowa_coap_peer_t *peerP,
+                            uint8_t *buffer,
+                            size_t bufferLength,
+                            comm_send_failure_callback_t failureCallback,
+                            void *userData)
+{
+    // WARNING: This function is called in a critical section
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    commSendBatchDeferStart(contextP, failureCallback, userData);
+    (void)peerSendBuffer(contextP, peerP, buffer, bufferLength);
+    commSendBatchDeferStop(contextP);
+#else
+    int result;
+
+    result = peerSendBuffer(contextP, peerP, buffer, bufferLength);
+    if (failureCallback != NULL
+        && (result < 0 || (size_t)result < bufferLength))
+    {
+        failureCallback(contextP, userData);
+    }
+#endif
 }
 
 int peerRecvBuffer(iowa_context_t contextP,
@@ -794,8 +973,47 @@ int peerRecvBuffer(iowa_context_t contextP,
                    uint8_t *buffer,
                    size_t bufferLength)
 {
-    return securityRecv(contextP, peerP->base.securityS, buffer, bufferLength);
+    int result;
+
+    result = securityRecv(contextP, peerP->base.securityS, buffer, bufferLength);
+    if (result > 0)
+    {
+        CORE_METRICS_INCREMENT(peerP->base.metrics.datagramInCount);
+        CORE_METRICS_ADD(peerP->base.metrics.byteInCount, (size_t)result);
+    }
+
+    return result;
+}
+
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+int peerRecvBatch(iowa_context_t contextP,
+                  iowa_coap_peer_t *peerP,
+                  uint8_t *buffer,
+                  size_t bufferLength,
+                  size_t *lengthArray,
+                  size_t count)
+{
+    int result;
+#ifdef IOWA_METRICS_SUPPORT
+    int i;
+#endif
+
+    result = securityRecvBatch(contextP, peerP->base.securityS, buffer, bufferLength, lengthArray, count);
+
+#ifdef IOWA_METRICS_SUPPORT
+    for (i = 0; i < result; i++)
+    {
+        if (lengthArray[i] > 0)
+        {
+            peerP->base.metrics.datagramInCount++;
+            peerP->base.metrics.byteInCount += lengthArray[i];
+        }
+    }
+#endif
+
+    return result;
 }
+#endif
 
 int32_t coapPeerGetMaxTxWait(iowa_coap_peer_t *peerP)
 {
@@ -888,41 +1106,19 @@ void peerHandleMessage(iowa_context_t contextP,
     if (!COAP_IS_REQUEST(messageP->code))
     {
         coap_exchange_t *exchangeP;
-        coap_exchange_t *parentP;
 
         IOWA_LOG_INFO(IOWA_PART_COAP, "Looking for matching exchange.");
 
-        exchangeP = peerP->base.exchangeList;
-        parentP = NULL;
-        while (exchangeP != NULL)
-        {
-            if (exchangeP->tokenLength == messageP->tokenLength
-                && 0 == memcmp(exchangeP->token, messageP->token, exchangeP->tokenLength))
-            {
-                break;
-            }
-            else
-            {
-                parentP = exchangeP;
-                exchangeP = exchangeP->next;
-            }
-        }
+        exchangeP = prv_exchangeFind(peerP, messageP->tokenLength, messageP->token);
         if (exchangeP != NULL)
         {
             IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Matching exchange found (%p).", (void *)exchangeP);
 
-            if (parentP != NULL)
-            {
-                parentP->next = exchangeP->next;
-            }
-            else
-            {
-                peerP->base.exchangeList = exchangeP->next;
-            }
+            prv_exchangeRemove(peerP, exchangeP);
             {
                 exchangeP->callback(peerP, code, messageP, exchangeP->userData, contextP);
             }
-            iowa_system_free(exchangeP);
+            CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_EXCHANGE, exchangeP);
 
             IOWA_LOG_INFO(IOWA_PART_COAP, "Exiting.");
 
@@ -932,6 +1128,10 @@ void peerHandleMessage(iowa_context_t contextP,
     else if (truncated == true)
     {
         // This is a request too big for our MTU
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+        // Tell the peer which block size fits
+        (void)blockSend413Reply(contextP, peerP, messageP, maxPayloadSize);
+#else
         iowa_coap_message_t *responseP;
 
         responseP = iowa_coap_message_prepare_response(messageP, IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE);
@@ -946,6 +1146,7 @@ void peerHandleMessage(iowa_context_t contextP,
         (void)peerSend(contextP, peerP, responseP, NULL, NULL);
 
         iowa_coap_message_free(responseP);
+#endif
         goto exit;
     }
 
@@ -976,7 +1177,6 @@ uint8_t coapPeerGenerateToken(iowa_coap_peer_t *peerP,
     size_t i;
     int32_t curTime;
     uint8_t newToken[COAP_MSG_TOKEN_MAX_LEN];
-    coap_exchange_t *exchangeP;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Entering peerP: %p, exchangeList: %p", peerP, peerP->base.exchangeList);
 
@@ -993,39 +1193,27 @@ uint8_t coapPeerGenerateToken(iowa_coap_peer_t *peerP,
 
     // check it is not already in use
     i = 0;
-    exchangeP = peerP->base.exchangeList;
-    while (exchangeP != NULL)
+    while (prv_exchangeFind(peerP, *lengthP, newToken) != NULL)
     {
-        if (*lengthP == exchangeP->tokenLength
-            && 0 == memcmp(newToken, exchangeP->token, *lengthP))
+        uint8_t temp;
+
+        // change the token
+        i++;
+        if (i > (1 << ((uint8_t)(*lengthP * 8))))
         {
-            uint8_t temp;
+            IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No more token possibilities with length of %d bytes.", *lengthP);
 
-            // change the token
-            i++;
-            if (i > (1 << ((uint8_t)(*lengthP * 8))))
+            (*lengthP)++;
+            if (*lengthP > COAP_MSG_TOKEN_MAX_LEN)
             {
-                IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "No more token possibilities with length of %d bytes.", *lengthP);
-
-                (*lengthP)++;
-                if (*lengthP > COAP_MSG_TOKEN_MAX_LEN)
-                {
-                    IOWA_LOG_ERROR(IOWA_PART_COAP, "No more token possibilities.");
-                    return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
-                }
+                IOWA_LOG_ERROR(IOWA_PART_COAP, "No more token possibilities.");
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
             }
-
-            temp = newToken[*lengthP - 1];
-            newToken[*lengthP - 1] = newToken[i % COAP_MSG_TOKEN_MAX_LEN] + 1;
-            newToken[i % COAP_MSG_TOKEN_MAX_LEN] = temp;
-
-            // retest
-            exchangeP = peerP->base.exchangeList;
-        }
-        else
-        {
-          exchangeP = exchangeP->next;
         }
+
+        temp = newToken[*lengthP - 1];
+        newToken[*lengthP - 1] = newToken[i % COAP_MSG_TOKEN_MAX_LEN] + 1;
+        newToken[i % COAP_MSG_TOKEN_MAX_LEN] = temp;
     }
 
     memcpy(tokenP, newToken, *lengthP);
@@ -143,6 +143,16 @@ typedef struct _iowa_linked_buffer_t
 
 #define IOWA_BUFFER_EMPTY (iowa_buffer_t){NULL, NULL, 0}
 
+#define COAP_BLOCK_ETAG_LEN 4
+
+#if defined(IOWA_COAP_OPTION_VIEW_SUPPORT) && !defined(IOWA_COAP_OPTION_VIEW_COUNT)
+#define IOWA_COAP_OPTION_VIEW_COUNT 8
+#endif
+
+#if defined(IOWA_COAP_OPTION_VIEW_SUPPORT) && (IOWA_COAP_OPTION_VIEW_COUNT < 1 || IOWA_COAP_OPTION_VIEW_COUNT > 255)
+#error "IOWA_COAP_OPTION_VIEW_COUNT must be between 1 and 255."
+#endif
+
 typedef struct _iowa_coap_option_t
 {
     struct _iowa_coap_option_t *next;
@@ -163,11 +173,22 @@ struct _iowa_coap_message_t
     uint16_t              id;          // if equal to 0, this is set by the CoAP engine when sending the message
     uint8_t               tokenLength; // '0' means no token.
     uint8_t               token[COAP_MSG_TOKEN_MAX_LEN];
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+    uint8_t               optionViewSize; // number of option views allocated after the message, 0 if not received.
+#endif
     iowa_coap_option_t   *optionList;
     iowa_buffer_t         payload;
     iowa_linked_buffer_t *userBufferList;  // user-provided buffers that will be freed by iowa_coap_message_free().
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+    uint8_t               blockETag[COAP_BLOCK_ETAG_LEN]; // value of the ETag option added by coapBlockSliceResponse().
+#endif
 };
 
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+// The options of a received message, pointing to the received datagram, are allocated with it right after the structure.
+#define COAP_MESSAGE_OPTION_VIEWS(M) ((iowa_coap_option_t *)((M) + 1))
+#endif
+
 // The callback called when a CoAP request or a CoAP response is received,
 // or when a confirmable transmission failed.
 // code: the code of the message or the status of the transmission.
@@ -195,6 +216,21 @@ typedef void(*coap_event_callback_t)(iowa_coap_peer_t *fromPeer,
 // optionP: the option to test.
 typedef bool(*coap_option_callback_t) (const iowa_coap_option_t *optionP);
 
+// A slot of a coap_index_t.
+typedef struct
+{
+    uint32_t  key;
+    void     *nodeP;   // nil for an empty slot
+} coap_index_slot_t;
+
+// Open-addressing table finding the transactions, acknowledges and exchanges of a peer by key.
+typedef struct
+{
+    coap_index_slot_t *slotArray;
+    size_t             size;   // number of slots, a power of two
+    size_t             count;
+} coap_index_t;
+
 typedef struct _coap_peer_base_t
 {
     struct _iowa_coap_peer_t *next;
@@ -202,8 +238,18 @@ typedef struct _coap_peer_base_t
     coap_message_callback_t   requestCallback;
     coap_event_callback_t     eventCallback;
     coap_exchange_t          *exchangeList;
+    coap_index_t              exchangeIndex;   // exchanges by token
     void                     *userData;
     iowa_security_session_t   securityS;
+#ifdef IOWA_METRICS_SUPPORT
+    iowa_metrics_peer_counters_t metrics;
+#endif
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+    iowa_buffer_t             blockContent;       // whole content of the last response sliced in blocks, until its last block is sent
+    uint32_t                  blockContentKey;    // identifies the request the content answers
+    uint32_t                  blockContentETag;
+    uint16_t                  blockContentFormat;
+#endif
 } coap_peer_base_t;
 
 struct _iowa_coap_peer_t
@@ -214,7 +260,12 @@ struct _iowa_coap_peer_t
 // Implemented in iowa_option.c
 size_t option_getSerializedLength(iowa_coap_option_t * optionP, coap_option_callback_t isIntegerCallback);
 size_t option_serialize(iowa_coap_option_t * optionList, uint8_t * buffer, coap_option_callback_t isIntegerCallback);
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+uint8_t option_parse(uint8_t * buffer, size_t bufferLength, iowa_coap_option_t * *optionListP, size_t * lengthP, coap_option_callback_t isIntegerCallback, iowa_coap_option_t *viewArray, size_t viewSize);
+size_t option_count(const uint8_t *buffer, size_t bufferLength, size_t maxCount);
+#else
 uint8_t option_parse(uint8_t * buffer, size_t bufferLength, iowa_coap_option_t * *optionListP, size_t * lengthP, coap_option_callback_t isIntegerCallback);
+#endif
 
 /************************************************
 * APIs
@@ -245,6 +296,14 @@ uint8_t coapStep(iowa_context_t contextP);
 // - contextP: returned by iowa_init().
 void coapClockReset(iowa_context_t contextP);
 
+#ifdef IOWA_METRICS_SUPPORT
+// Get the CoAP peers of a context.
+// Returned value: the first CoAP peer or NULL if there is none. The next ones are linked by their base.next field.
+// Parameters:
+// - contextP: returned by iowa_init().
+iowa_coap_peer_t * coapGetPeerList(iowa_context_t contextP);
+#endif
+
 // Set the request and event callbacks of a CoAP peer.
 // Returned value: none.
 // Parameters:
@@ -356,6 +415,21 @@ uint8_t coapSend(iowa_context_t contextP,
                  coap_message_callback_t resultCallback,
                  void *userData);
 
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+// Store the datagrams of the messages sent by coapSend() in the send batch until coapSendBatchStop().
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// Note: coapSend() does not see the sending errors anymore. They are reported to the transaction of the message when the batch is flushed.
+void coapSendBatchStart(iowa_context_t contextP);
+
+// Send the datagrams stored since coapSendBatchStart().
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void coapSendBatchStop(iowa_context_t contextP);
+#endif
+
 // Get the MAX_TRANSMIT_WAIT of a CoAP peer.
 // Returned value: The MAX_TRANSMIT_WAIT, INT32_MAX if the peer is a Stream one, or -1 in case of error.
 // Parameters:
@@ -425,6 +499,22 @@ iowa_status_t coapRequestAll(iowa_context_t contextP,
 size_t coapMessageSerializeDatagram(iowa_coap_message_t *messageP,
                                     uint8_t **bufferP);
 
+// Get the number of bytes preceding the payload of a CoAP message serialized for datagram transports.
+// Returned value: the length of the header, the token, the options and the payload marker, or 0 in case of error.
+// Parameters:
+// - messageP: the CoAP message. Its options must not change before it is sent.
+// Note: a payload allocated with this headroom and set with payload.memory pointing to the headroom and payload.data
+//       pointing to the payload is serialized in place by coapMessageSerializeDatagramInPlace().
+size_t coapMessageGetDatagramHeadroom(iowa_coap_message_t *messageP);
+
+// Serialize a CoAP message for datagram transports in the headroom of its payload buffer.
+// Returned value: the length of the serialized buffer, or 0 if the payload buffer does not have the exact headroom.
+// Parameters:
+// - messageP: the CoAP message to serialize.
+// - bufferP: OUT. the serialized buffer. This is messageP->payload.memory.
+size_t coapMessageSerializeDatagramInPlace(iowa_coap_message_t *messageP,
+                                           uint8_t **bufferP);
+
 // Serialize a CoAP message for stream stransports (e.g. TCP).
 // Returned value: the length of the serialized buffer.
 // Parameters:
@@ -473,6 +563,92 @@ uint8_t coapEncodeBlockInfo(uint32_t number,
                             uint16_t size,
                             uint32_t *valueP);
 
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+// Get the largest block size usable with a peer.
+// Returned value: the block size, or 0 if the transport of the peer does not limit the message size.
+// Parameters:
+// - peerP: the CoAP peer.
+// Note: the block size is the largest power of two up to 1024 leaving room for the CoAP header in the maximum datagram size of the peer.
+uint16_t coapBlockGetPeerSize(iowa_coap_peer_t *peerP);
+
+// Retrieve the block information of a received message.
+// Returned value: '0' in case of success, IOWA_COAP_404_NOT_FOUND if the message has no such option, or an error code in the form of a CoAP code.
+// Parameters:
+// - peerP: the CoAP peer which sent the message.
+// - messageP: the received CoAP message.
+// - optionNumber: IOWA_COAP_OPTION_BLOCK_1 or IOWA_COAP_OPTION_BLOCK_2.
+// - numberP: OUT. the block number.
+// - moreP: OUT. true if there are more blocks coming.
+// - sizeP: OUT. the size of the block.
+// Note: a requested Block2 size larger than coapBlockGetPeerSize() is reduced, and the block number adapted to the same offset.
+uint8_t coapBlockGetInfo(iowa_coap_peer_t *peerP,
+                         iowa_coap_message_t *messageP,
+                         uint16_t optionNumber,
+                         uint32_t *numberP,
+                         bool *moreP,
+                         uint16_t *sizeP);
+
+// Add a Block1 or Block2 option to a message.
+// Returned value: '0' in case of success or an error code in the form of a CoAP code.
+// Parameters:
+// - messageP: the CoAP message.
+// - optionNumber: IOWA_COAP_OPTION_BLOCK_1 or IOWA_COAP_OPTION_BLOCK_2.
+// - number: the block number.
+// - more: true if there are more blocks coming.
+// - size: the size of the block.
+uint8_t coapBlockAddOption(iowa_coap_message_t *messageP,
+                           uint16_t optionNumber,
+                           uint32_t number,
+                           bool more,
+                           uint16_t size);
+
+// Reduce the payload of a response to the block requested by the peer.
+// Returned value: '0' in case of success or an error code in the form of a CoAP code.
+// Parameters:
+// - peerP: the CoAP peer to send the response to.
+// - requestP: the request the response is for. This can be nil.
+// - responseP: the response. Its payload is reduced to the block and the Block2, Size2 and ETag options are added.
+// - contentFormat: the content format of the payload.
+// Note: without a Block2 option in the request, a payload larger than coapBlockGetPeerSize() is reduced to its first block.
+// Note: when requestP is not nil and more blocks follow, the whole content is kept in the peer so that the next blocks
+//       are sent by coapBlockGetStoredResponse() without building it again. A peer keeps a single content.
+// Note: the ETag option is a hash of the whole content: if the content changes between two blocks, the peer detects it
+//       and restarts the transfer.
+// Note: the added options are allocated, even when responseP is not.
+uint8_t coapBlockSliceResponse(iowa_coap_peer_t *peerP,
+                               iowa_coap_message_t *requestP,
+                               iowa_coap_message_t *responseP,
+                               uint16_t contentFormat);
+
+// Check if a request asks for a block of the content kept by coapBlockSliceResponse().
+// Returned value: true if coapBlockGetStoredResponse() can answer the request.
+// Parameters:
+// - peerP: the CoAP peer the request is from.
+// - requestP: the request.
+// Note: a request for the first block always gets a new content.
+bool coapBlockHasStoredContent(iowa_coap_peer_t *peerP,
+                               iowa_coap_message_t *requestP);
+
+// Answer a request with a block of the content kept by coapBlockSliceResponse().
+// Returned value: '0' in case of success or an error code in the form of a CoAP code.
+// Parameters:
+// - peerP: the CoAP peer the request is from.
+// - requestP: the request.
+// - responseP: the response. Its payload is set to a copy of the block and the Block2 and ETag options are added.
+// - contentFormatP: OUT. The content format of the content.
+// Note: the content is released once its last block is sent.
+uint8_t coapBlockGetStoredResponse(iowa_coap_peer_t *peerP,
+                                   iowa_coap_message_t *requestP,
+                                   iowa_coap_message_t *responseP,
+                                   uint16_t *contentFormatP);
+
+// Release the content kept by coapBlockSliceResponse().
+// Returned value: none.
+// Parameters:
+// - peerP: the CoAP peer.
+void coapBlockClearContent(iowa_coap_peer_t *peerP);
+#endif
+
 // Add an user buffer to the CoAP message.
 // Parameters:
 // - messageP: the message to add the buffer too. Not tested for validity.
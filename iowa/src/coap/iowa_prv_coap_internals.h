@@ -70,6 +70,12 @@ extern "C" {
 
 #define COAP_DEFAULT_NSTART        1
 
+#ifndef IOWA_COAP_DATAGRAM_MAX_SIZE
+#define IOWA_COAP_DATAGRAM_MAX_SIZE IOWA_BUFFER_SIZE
+#endif
+
+#define COAP_DATAGRAM_MIN_SIZE     64
+
 #define COAP_UDP_ACK_TIMEOUT       2 // seconds
 #define COAP_UDP_ACK_REAL_TIMEOUT  3 // COAP_ACK_TIMEOUT * COAP_ACK_RANDOM_FACTOR
 #define COAP_UDP_MAX_RETRANSMIT    4
@@ -187,9 +193,13 @@ typedef enum
 struct _coap_transaction_t
 {
     struct _coap_transaction_t *next;
+    struct _coap_transaction_t *prev;
     uint16_t                    mID;
+    bool                        queued;            // waiting for the number of outstanding interactions to go below NSTART
     uint8_t                     retrans_counter;
     int32_t                     retrans_time;
+    int32_t                     retrans_timeout;   // current retransmission timeout in seconds
+    int32_t                     first_send_time;
     size_t                      buffer_len;
     uint8_t                    *buffer;
     coap_message_callback_t     callback;
@@ -199,6 +209,7 @@ struct _coap_transaction_t
 struct _coap_ack_t
 {
     struct _coap_ack_t *next;
+    struct _coap_ack_t *prev;
     uint16_t            mID;
     int32_t             validity_time;
     size_t              buffer_len;
@@ -208,6 +219,7 @@ struct _coap_ack_t
 struct _coap_exchange_t
 {
     struct _coap_exchange_t *next;
+    struct _coap_exchange_t *prev;
     uint8_t                  token[COAP_MSG_TOKEN_MAX_LEN];
     uint8_t                  tokenLength; // '0' means no token.
     coap_message_callback_t  callback;
@@ -239,15 +251,41 @@ struct _block_payload_t
     void                    *userData;
 };
 
+#ifdef IOWA_COAP_COCOA_SUPPORT
+// CoCoA retransmission timeout estimators. Values are in 1/8 seconds.
+typedef struct
+{
+    int32_t rtoOverall;
+    int32_t strongSrtt;
+    int32_t strongRttvar;
+    int32_t weakSrtt;
+    int32_t weakRttvar;
+    bool    strongSet;
+    bool    weakSet;
+} coap_cocoa_t;
+#endif
+
 typedef struct
 {
     coap_peer_base_t    base;
     uint8_t             ackTimeout;
     uint8_t             maxRetransmit;
+    uint8_t             nstart;
     uint16_t            transmitWait;
     uint16_t            nextMID;
-    coap_transaction_t *transactionList;
-    coap_ack_t         *ackList;
+    uint32_t            randomState;
+    size_t              maxDatagramSize;   // size of the receive buffer, larger datagrams are truncated
+    coap_transaction_t *transactionList;   // outstanding confirmable messages
+    coap_transaction_t *transactionQueue;  // confirmable messages waiting for NSTART, oldest first
+    coap_transaction_t *transactionQueueTailP;
+#ifdef IOWA_COAP_COCOA_SUPPORT
+    coap_cocoa_t        cocoa;
+#endif
+    coap_index_t        transactionIndex;  // transactions by message ID
+    coap_ack_t         *ackList;           // least recently used first
+    coap_ack_t         *ackTailP;
+    coap_index_t        ackIndex;          // acknowledges by message ID
+    iowa_coap_ack_cache_stats_t ackCacheStats;
 } coap_peer_datagram_t;
 
 typedef struct
@@ -260,6 +298,14 @@ typedef struct
 struct _coap_context_t
 {
     iowa_coap_peer_t              *peerList;
+    uint8_t                       *recvBuffer;      // Receive buffer of the datagram peers, sized for the largest maxDatagramSize
+    size_t                         recvBufferSize;
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+    iowa_coap_peer_t              *recvPeerP;  // Peer whose received datagrams are being handled, cleared if it is closed meanwhile
+#endif
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    bool                           sendBatching;    // Set by coapSendBatchStart()
+#endif
 };
 
 typedef struct
@@ -276,6 +322,44 @@ typedef struct
 
 // Implemented in iowa_coap_utils.c
 void coapUtilsfreeApplicationData(application_coap_data_t *dataP);
+
+// Callback used by coapIndexFind() to discriminate nodes having the same key.
+// Returned value: true if the node matches.
+// Parameters:
+// - nodeP: the node stored in the index.
+// - criteriaP: the coapIndexFind() parameter.
+typedef bool(*coap_index_match_callback_t)(void *nodeP, const void *criteriaP);
+
+// Add a node to an index.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - indexP: the index.
+// - key: the key of the node.
+// - nodeP: the node. Can not be nil.
+iowa_status_t coapIndexAdd(coap_index_t *indexP, uint32_t key, void *nodeP);
+
+// Find a node in an index.
+// Returned value: the first matching node or NULL if not found.
+// Parameters:
+// - indexP: the index.
+// - key: the key of the node.
+// - matchCallback: called on the nodes having this key. This can be nil to return the first one.
+// - criteriaP: passed to matchCallback.
+void * coapIndexFind(coap_index_t *indexP, uint32_t key, coap_index_match_callback_t matchCallback, const void *criteriaP);
+
+// Remove a node from an index.
+// Returned value: none.
+// Parameters:
+// - indexP: the index.
+// - key: the key of the node.
+// - nodeP: the node to remove.
+void coapIndexRemove(coap_index_t *indexP, uint32_t key, void *nodeP);
+
+// Free the memory used by an index.
+// Returned value: none.
+// Parameters:
+// - indexP: the index.
+void coapIndexClear(coap_index_t *indexP);
 void coapMessageCallback(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_coap_message_t *messageP, void *userData, iowa_context_t contextP);
 void coapInternalMessageCallback(iowa_coap_peer_t *fromPeer, uint8_t code, iowa_coap_message_t *messageP, void *userData, iowa_context_t contextP);
 
@@ -290,15 +374,58 @@ void messageLog(const char *function, unsigned int line, const char *info, iowa_
 // Implemented in iowa_peer.c
 uint8_t peerSend(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_coap_message_t *messageP, coap_message_callback_t resultCallback, void *userData);
 int peerSendBuffer(iowa_context_t contextP, iowa_coap_peer_t *peerP, uint8_t *buffer, size_t bufferLength);
+void peerSendBufferDeferred(iowa_context_t contextP, iowa_coap_peer_t *peerP, uint8_t *buffer, size_t bufferLength, comm_send_failure_callback_t failureCallback, void *userData);
 int peerRecvBuffer(iowa_context_t contextP, iowa_coap_peer_t *peerP, uint8_t *buffer, size_t bufferLength);
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+int peerRecvBatch(iowa_context_t contextP, iowa_coap_peer_t *peerP, uint8_t *buffer, size_t bufferLength, size_t *lengthArray, size_t count);
+#endif
 void peerHandleMessage(iowa_context_t contextP, iowa_coap_peer_t *peerP, iowa_coap_message_t *messageP, bool truncated, size_t maxPayloadSize);
 
 // Implemented in iowa_transaction.c
 void transactionFree(coap_transaction_t *transacP);
-uint8_t transactionNew(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_coap_message_t *messageP, uint8_t *buffer, size_t bufferLength, coap_message_callback_t resultCallback, void *userData);
+uint8_t transactionNew(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_coap_message_t *messageP, uint8_t *buffer, size_t bufferLength, bool queued, coap_message_callback_t resultCallback, void *userData);
 uint8_t transactionStep(iowa_context_t contextP, coap_peer_datagram_t *peerP, int32_t currentTime, int32_t *timeoutP);
 void transactionHandleMessage(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_coap_message_t *messageP, bool truncated, size_t maxPayloadSize);
 void acknowledgeFree(coap_ack_t *ackP);
+// Remove a transaction from its peer.
+// Returned value: none.
+// Parameters:
+// - peerP: the peer.
+// - transacP: the transaction. It is not freed.
+void transactionRemove(coap_peer_datagram_t *peerP, coap_transaction_t *transacP);
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+// Send the first datagram of a message already passed to transactionNew() in the send batch.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - peerP: the peer.
+// - messageP: the message.
+// - buffer, bufferLength: the serialized message.
+// Note: if the datagram could not be sent, the transaction of a confirmable message is terminated with a 5.03 error.
+void transactionSendBatched(iowa_context_t contextP, coap_peer_datagram_t *peerP, iowa_coap_message_t *messageP, uint8_t *buffer, size_t bufferLength);
+#endif
+// Tell if a confirmable message sent to a peer must wait for an outstanding interaction to complete.
+// Returned value: true if the peer already has NSTART outstanding confirmable messages or queued ones.
+// Parameters:
+// - peerP: the peer.
+bool transactionIsNstartReached(coap_peer_datagram_t *peerP);
+// Send the queued confirmable messages of a peer while the number of outstanding interactions is below NSTART.
+// Returned value: none.
+// Parameters:
+// - contextP: the IOWA context.
+// - peerP: the peer.
+void transactionStartQueued(iowa_context_t contextP, coap_peer_datagram_t *peerP);
+// Remove all the outstanding and queued transactions of a peer, calling their callbacks with a 5.03 status.
+// Returned value: none.
+// Parameters:
+// - contextP: the IOWA context.
+// - peerP: the peer.
+void transactionCancelAll(iowa_context_t contextP, coap_peer_datagram_t *peerP);
+// Free all the transactions and acknowledges of a peer without calling the transaction callbacks.
+// Returned value: none.
+// Parameters:
+// - peerP: the peer.
+void transactionClear(coap_peer_datagram_t *peerP);
 
 // Implemented in iowa_message.c
 
@@ -21,28 +21,328 @@
 
 #include "iowa_prv_coap_internals.h"
 
+#define PRV_ACK_MEMORY(A) (sizeof(coap_ack_t) + (A)->buffer_len)
+
+#ifdef IOWA_COAP_COCOA_SUPPORT
+#define PRV_COCOA_UNIT        8       // estimators are in 1/8 seconds
+#define PRV_COCOA_RTO_MIN     (1 * PRV_COCOA_UNIT)
+#define PRV_COCOA_RTO_MAX     (60 * PRV_COCOA_UNIT)
+#define PRV_COCOA_STRONG_K    4
+#define PRV_COCOA_WEAK_K      1
+#endif
+
+static uint32_t prv_random(coap_peer_datagram_t *peerP,
+                           int32_t curTime)
+{
+    uint32_t x;
+
+    if (peerP->randomState == 0)
+    {
+        // Seed with values differing between peers and runs
+        peerP->randomState = ((uint32_t)peerP->nextMID << 16) ^ ((uint32_t)curTime * 2654435761u) ^ (uint32_t)(size_t)peerP;
+        if (peerP->randomState == 0)
+        {
+            peerP->randomState = 1;
+        }
+    }
+
+    // xorshift32
+    x = peerP->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    peerP->randomState = x;
+
+    return x;
+}
+
+static int32_t prv_getInitialTimeout(coap_peer_datagram_t *peerP,
+                                     int32_t curTime)
+{
+    int32_t minTimeout;
+    int32_t maxTimeout;
+
+    if (peerP->ackTimeout == 0)
+    {
+        // Retransmission is disabled
+        return 0;
+    }
+
+#ifdef IOWA_COAP_COCOA_SUPPORT
+    if (peerP->cocoa.rtoOverall == 0)
+    {
+        // ackTimeout is ACK_TIMEOUT * ACK_RANDOM_FACTOR and the initial RTO is ACK_TIMEOUT
+        peerP->cocoa.rtoOverall = (int32_t)(peerP->ackTimeout * PRV_COCOA_UNIT / COAP_ACK_RANDOM_FACTOR);
+    }
+
+    // Pick a timeout between RTO and RTO * ACK_RANDOM_FACTOR, rounded up to the second
+    minTimeout = (peerP->cocoa.rtoOverall + PRV_COCOA_UNIT - 1) / PRV_COCOA_UNIT;
+    maxTimeout = ((int32_t)(peerP->cocoa.rtoOverall * COAP_ACK_RANDOM_FACTOR) + PRV_COCOA_UNIT - 1) / PRV_COCOA_UNIT;
+#else
+    // Pick a timeout between ACK_TIMEOUT and ACK_TIMEOUT * ACK_RANDOM_FACTOR
+    maxTimeout = peerP->ackTimeout;
+    minTimeout = (int32_t)(peerP->ackTimeout / COAP_ACK_RANDOM_FACTOR);
+#endif
+    if (minTimeout < 1)
+    {
+        minTimeout = 1;
+    }
+    if (maxTimeout < minTimeout)
+    {
+        maxTimeout = minTimeout;
+    }
+
+    return minTimeout + (int32_t)(prv_random(peerP, curTime) % (uint32_t)(maxTimeout - minTimeout + 1));
+}
+
+static int32_t prv_getBackoffTimeout(coap_peer_datagram_t *peerP,
+                                     int32_t timeout)
+{
+#ifdef IOWA_COAP_COCOA_SUPPORT
+    // Variable backoff factor
+    if (peerP->cocoa.rtoOverall < PRV_COCOA_RTO_MIN)
+    {
+        return timeout * 3;
+    }
+    if (peerP->cocoa.rtoOverall > 3 * PRV_COCOA_UNIT)
+    {
+        return timeout + (timeout + 1) / 2;
+    }
+#else
+    (void)peerP;
+#endif
+
+    return timeout * 2;
+}
+
+#ifdef IOWA_COAP_COCOA_SUPPORT
+static void prv_cocoaUpdate(coap_peer_datagram_t *peerP,
+                            coap_transaction_t *transacP,
+                            int32_t curTime)
+{
+    int32_t rtt;
+    int32_t delta;
+    int32_t rto;
+
+    if (transacP->retrans_counter > 2)
+    {
+        // Too ambiguous to be used as a sample
+        return;
+    }
+
+    rtt = (curTime - transacP->first_send_time) * PRV_COCOA_UNIT;
+    if (rtt < 0)
+    {
+        return;
+    }
+
+    if (transacP->retrans_counter == 0)
+    {
+        // Strong estimator: the ACK matches the only transmission
+        if (peerP->cocoa.strongSet == false)
+        {
+            peerP->cocoa.strongSrtt = rtt;
+            peerP->cocoa.strongRttvar = rtt / 2;
+            peerP->cocoa.strongSet = true;
+        }
+        else
+        {
+            delta = peerP->cocoa.strongSrtt - rtt;
+            if (delta < 0)
+            {
+                delta = -delta;
+            }
+            peerP->cocoa.strongRttvar = (3 * peerP->cocoa.strongRttvar + delta) / 4;
+            peerP->cocoa.strongSrtt = (7 * peerP->cocoa.strongSrtt + rtt) / 8;
+        }
+        rto = peerP->cocoa.strongSrtt + PRV_COCOA_STRONG_K * peerP->cocoa.strongRttvar;
+
+        peerP->cocoa.rtoOverall = (peerP->cocoa.rtoOverall + rto) / 2;
+    }
+    else
+    {
+        // Weak estimator: the RTT is measured from the first transmission
+        if (peerP->cocoa.weakSet == false)
+        {
+            peerP->cocoa.weakSrtt = rtt;
+            peerP->cocoa.weakRttvar = rtt / 2;
+            peerP->cocoa.weakSet = true;
+        }
+        else
+        {
+            delta = peerP->cocoa.weakSrtt - rtt;
+            if (delta < 0)
+            {
+                delta = -delta;
+            }
+            peerP->cocoa.weakRttvar = (3 * peerP->cocoa.weakRttvar + delta) / 4;
+            peerP->cocoa.weakSrtt = (7 * peerP->cocoa.weakSrtt + rtt) / 8;
+        }
+        rto = peerP->cocoa.weakSrtt + PRV_COCOA_WEAK_K * peerP->cocoa.weakRttvar;
+
+        peerP->cocoa.rtoOverall = (3 * peerP->cocoa.rtoOverall + rto) / 4;
+    }
+
+    if (peerP->cocoa.rtoOverall < PRV_COCOA_RTO_MIN)
+    {
+        peerP->cocoa.rtoOverall = PRV_COCOA_RTO_MIN;
+    }
+    else if (peerP->cocoa.rtoOverall > PRV_COCOA_RTO_MAX)
+    {
+        peerP->cocoa.rtoOverall = PRV_COCOA_RTO_MAX;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Peer %p RTT sample: %d/8 s, new RTO: %d/8 s.", peerP, rtt, peerP->cocoa.rtoOverall);
+}
+#endif // IOWA_COAP_COCOA_SUPPORT
+
+static bool prv_isOutstandingCountReached(coap_peer_datagram_t *peerP)
+{
+    coap_transaction_t *transacP;
+    uint8_t count;
+
+    count = 0;
+    for (transacP = peerP->transactionList; transacP != NULL; transacP = transacP->next)
+    {
+        count++;
+        if (count >= peerP->nstart)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void prv_transactionStart(iowa_context_t contextP,
+                                 coap_peer_datagram_t *peerP,
+                                 coap_transaction_t *transacP,
+                                 int32_t curTime)
+{
+    // WARNING: This function is called in a critical section
+    transacP->queued = false;
+    transacP->retrans_counter = 0;
+    transacP->first_send_time = curTime;
+    transacP->retrans_timeout = prv_getInitialTimeout(peerP, curTime);
+    transacP->retrans_time = curTime + transacP->retrans_timeout;
+
+    transacP->prev = NULL;
+    transacP->next = peerP->transactionList;
+    if (transacP->next != NULL)
+    {
+        transacP->next->prev = transacP;
+    }
+    peerP->transactionList = transacP;
+
+    if (transacP->retrans_timeout > 0
+        && contextP->timeout > transacP->retrans_timeout)
+    {
+        contextP->timeout = transacP->retrans_timeout;
+        CRIT_SECTION_LEAVE(contextP);
+        INTERRUPT_SELECT(contextP);
+        CRIT_SECTION_ENTER(contextP);
+    }
+}
+
+static void prv_acknowledgeAppend(coap_peer_datagram_t *peerP,
+                                  coap_ack_t *ackP)
+{
+    ackP->next = NULL;
+    ackP->prev = peerP->ackTailP;
+    if (peerP->ackTailP == NULL)
+    {
+        peerP->ackList = ackP;
+    }
+    else
+    {
+        peerP->ackTailP->next = ackP;
+    }
+    peerP->ackTailP = ackP;
+}
+
+static void prv_acknowledgeUnlink(coap_peer_datagram_t *peerP,
+                                  coap_ack_t *ackP)
+{
+    if (ackP->prev == NULL)
+    {
+        peerP->ackList = ackP->next;
+    }
+    else
+    {
+        ackP->prev->next = ackP->next;
+    }
+    if (ackP->next == NULL)
+    {
+        peerP->ackTailP = ackP->prev;
+    }
+    else
+    {
+        ackP->next->prev = ackP->prev;
+    }
+    ackP->next = NULL;
+    ackP->prev = NULL;
+}
+
+static void prv_acknowledgeRemove(coap_peer_datagram_t *peerP,
+                                  coap_ack_t *ackP)
+{
+    prv_acknowledgeUnlink(peerP, ackP);
+    coapIndexRemove(&peerP->ackIndex, ackP->mID, ackP);
+
+    peerP->ackCacheStats.memory -= PRV_ACK_MEMORY(ackP);
+    peerP->ackCacheStats.count = peerP->ackIndex.count;
+
+    acknowledgeFree(ackP);
+}
+
 #if defined(IOWA_UDP_SUPPORT) || defined(IOWA_SMS_SUPPORT)
 static void prv_acknowledgeCleanup(coap_peer_datagram_t *peerP)
 {
+    // WARNING: This function is called in a critical section
+#ifdef IOWA_COAP_ACK_MEMORY_LIMIT
+    // Evict the least recently used acknowledges but keep the one just added
+    while (peerP->ackCacheStats.memory > IOWA_COAP_ACK_MEMORY_LIMIT
+           && peerP->ackList != peerP->ackTailP)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Evicting cached reply for message %u.", peerP->ackList->mID);
+
+        peerP->ackCacheStats.evictionCount++;
+        prv_acknowledgeRemove(peerP, peerP->ackList);
+    }
+#else
+    (void)peerP;
+#endif
 }
 #endif // IOWA_UDP_SUPPORT || IOWA_SMS_SUPPORT
 
 static coap_ack_t *prv_acknowledgeFind(coap_peer_datagram_t *peerP,
-                                       iowa_coap_message_t *messageP)
+                                       iowa_coap_message_t *messageP,
+                                       int32_t currentTime)
 {
     coap_ack_t *ackP;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "peerP: %p, message ID: %u.", peerP, messageP->id);
 
-    ackP = peerP->ackList;
-    while (ackP != NULL)
+    ackP = (coap_ack_t *)coapIndexFind(&peerP->ackIndex, messageP->id, NULL, NULL);
+    if (ackP != NULL)
     {
-        if (ackP->mID == messageP->id)
+        if (ackP->validity_time <= currentTime)
         {
-            IOWA_LOG_TRACE(IOWA_PART_COAP, "Found acknowledge.");
-            return ackP;
+            // The list is not strictly ordered by validity time so transactionStep() may not have removed it yet
+            IOWA_LOG_TRACE(IOWA_PART_COAP, "Found expired acknowledge.");
+            peerP->ackCacheStats.expirationCount++;
+            prv_acknowledgeRemove(peerP, ackP);
+            return NULL;
         }
-        ackP = ackP->next;
+
+        IOWA_LOG_TRACE(IOWA_PART_COAP, "Found acknowledge.");
+
+        // Mark it as the most recently used
+        prv_acknowledgeUnlink(peerP, ackP);
+        prv_acknowledgeAppend(peerP, ackP);
+        peerP->ackCacheStats.hitCount++;
+
+        return ackP;
     }
 
     IOWA_LOG_TRACE(IOWA_PART_COAP, "Acknowledge not found.");
@@ -59,16 +359,12 @@ static coap_transaction_t *prv_transactionFind(coap_peer_datagram_t *peerP,
     {
         coap_transaction_t *transacP;
 
-        transacP = peerP->transactionList;
-
-        while (transacP != NULL)
+        transacP = (coap_transaction_t *)coapIndexFind(&peerP->transactionIndex, messageP->id, NULL, NULL);
+        if (transacP != NULL
+            && transacP->queued == false)
         {
-            if (transacP->mID == messageP->id)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_COAP, "Transaction found.");
-                return transacP;
-            }
-            transacP = transacP->next;
+            IOWA_LOG_TRACE(IOWA_PART_COAP, "Transaction found.");
+            return transacP;
         }
     }
 
@@ -81,7 +377,7 @@ void transactionFree(coap_transaction_t *transacP)
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Freeing transaction %p.", transacP);
 
     iowa_system_free(transacP->buffer);
-    iowa_system_free(transacP);
+    CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_TRANSACTION, transacP);
 }
 
 void acknowledgeFree(coap_ack_t *ackP)
@@ -89,7 +385,195 @@ void acknowledgeFree(coap_ack_t *ackP)
     IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Freeing acknowledge for message ID %u.", ackP->mID);
 
     iowa_system_free(ackP->buffer);
-    iowa_system_free(ackP);
+    CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_ACK, ackP);
+}
+
+void transactionRemove(coap_peer_datagram_t *peerP,
+                       coap_transaction_t *transacP)
+{
+    coapIndexRemove(&peerP->transactionIndex, transacP->mID, transacP);
+
+    if (transacP->prev == NULL)
+    {
+        peerP->transactionList = transacP->next;
+    }
+    else
+    {
+        transacP->prev->next = transacP->next;
+    }
+    if (transacP->next != NULL)
+    {
+        transacP->next->prev = transacP->prev;
+    }
+    transacP->next = NULL;
+    transacP->prev = NULL;
+}
+
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+// Called when the first datagram of a transaction could not be sent.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - userData: the transaction.
+static void prv_sendFailureCallback(iowa_context_t contextP,
+                                    void *userData)
+{
+    // WARNING: This function is called in a critical section
+    iowa_coap_peer_t *peerP;
+    coap_transaction_t *transacP;
+
+    // The send batch is flushed before a peer is deleted, but a previous failure callback may have terminated this transaction: look for it.
+    transacP = NULL;
+    for (peerP = contextP->coapContextP->peerList; peerP != NULL; peerP = peerP->base.next)
+    {
+        switch (peerP->base.type)
+        {
+        case IOWA_CONN_DATAGRAM:
+        case IOWA_CONN_LORAWAN:
+        case IOWA_CONN_SMS:
+            for (transacP = ((coap_peer_datagram_t *)peerP)->transactionList; transacP != NULL; transacP = transacP->next)
+            {
+                if (transacP == (coap_transaction_t *)userData)
+                {
+                    break;
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+        if (transacP != NULL)
+        {
+            break;
+        }
+    }
+
+    if (transacP == NULL)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_COAP, "Transaction already terminated.");
+        return;
+    }
+
+    IOWA_LOG_ARG_WARNING(IOWA_PART_COAP, "Failed to send message %u.", transacP->mID);
+
+    // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
+    transactionRemove((coap_peer_datagram_t *)peerP, transacP);
+    transactionStartQueued(contextP, (coap_peer_datagram_t *)peerP);
+    if (transacP->callback != NULL)
+    {
+        transacP->callback(peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, transacP->userData, contextP);
+    }
+    transactionFree(transacP);
+}
+
+void transactionSendBatched(iowa_context_t contextP,
+                            coap_peer_datagram_t *peerP,
+                            iowa_coap_message_t *messageP,
+                            uint8_t *buffer,
+                            size_t bufferLength)
+{
+    // WARNING: This function is called in a critical section
+    coap_transaction_t *transacP;
+
+    if (messageP->type == IOWA_COAP_TYPE_CONFIRMABLE)
+    {
+        transacP = (coap_transaction_t *)coapIndexFind(&peerP->transactionIndex, messageP->id, NULL, NULL);
+    }
+    else
+    {
+        // A lost non-confirmable message is only logged
+        transacP = NULL;
+    }
+
+    peerSendBufferDeferred(contextP, (iowa_coap_peer_t *)peerP, buffer, bufferLength, transacP == NULL ? NULL : prv_sendFailureCallback, transacP);
+}
+#endif // IOWA_CONNECTION_SEND_BATCH_SUPPORT
+
+bool transactionIsNstartReached(coap_peer_datagram_t *peerP)
+{
+    // Keep the queued messages in order
+    return (peerP->transactionQueue != NULL
+            || prv_isOutstandingCountReached(peerP) == true);
+}
+
+void transactionStartQueued(iowa_context_t contextP,
+                            coap_peer_datagram_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    while (peerP->transactionQueue != NULL
+           && prv_isOutstandingCountReached(peerP) == false)
+    {
+        coap_transaction_t *transacP;
+
+        transacP = peerP->transactionQueue;
+        peerP->transactionQueue = transacP->next;
+        if (peerP->transactionQueue == NULL)
+        {
+            peerP->transactionQueueTailP = NULL;
+        }
+
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Sending queued message %u.", transacP->mID);
+
+        // A failed sending is handled as a lost message by the retransmission
+        peerSendBufferDeferred(contextP, (iowa_coap_peer_t *)peerP, transacP->buffer, transacP->buffer_len, NULL, NULL);
+
+        prv_transactionStart(contextP, peerP, transacP, contextP->currentTime);
+    }
+}
+
+void transactionCancelAll(iowa_context_t contextP,
+                          coap_peer_datagram_t *peerP)
+{
+    // WARNING: This function is called in a critical section
+    while (peerP->transactionList != NULL)
+    {
+        coap_transaction_t *transacP;
+
+        transacP = peerP->transactionList;
+        transactionRemove(peerP, transacP);
+
+        if (transacP->callback != NULL)
+        {
+            transacP->callback((iowa_coap_peer_t *)peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, transacP->userData, contextP);
+        }
+        transactionFree(transacP);
+    }
+
+    while (peerP->transactionQueue != NULL)
+    {
+        coap_transaction_t *transacP;
+
+        transacP = peerP->transactionQueue;
+        peerP->transactionQueue = transacP->next;
+        if (peerP->transactionQueue == NULL)
+        {
+            peerP->transactionQueueTailP = NULL;
+        }
+        coapIndexRemove(&peerP->transactionIndex, transacP->mID, transacP);
+
+        if (transacP->callback != NULL)
+        {
+            transacP->callback((iowa_coap_peer_t *)peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, transacP->userData, contextP);
+        }
+        transactionFree(transacP);
+    }
+}
+
+void transactionClear(coap_peer_datagram_t *peerP)
+{
+    IOWA_UTILS_LIST_FREE(peerP->transactionList, transactionFree);
+    peerP->transactionList = NULL;
+    IOWA_UTILS_LIST_FREE(peerP->transactionQueue, transactionFree);
+    peerP->transactionQueue = NULL;
+    peerP->transactionQueueTailP = NULL;
+    coapIndexClear(&peerP->transactionIndex);
+
+    IOWA_UTILS_LIST_FREE(peerP->ackList, acknowledgeFree);
+    peerP->ackList = NULL;
+    peerP->ackTailP = NULL;
+    coapIndexClear(&peerP->ackIndex);
+    peerP->ackCacheStats.memory = 0;
+    peerP->ackCacheStats.count = 0;
 }
 
 uint8_t transactionNew(iowa_context_t contextP,
@@ -97,6 +581,7 @@ uint8_t transactionNew(iowa_context_t contextP,
                        iowa_coap_message_t *messageP,
                        uint8_t *buffer,
                        size_t bufferLength,
+                       bool queued,
                        coap_message_callback_t resultCallback,
                        void *userData)
 {
@@ -117,7 +602,7 @@ uint8_t transactionNew(iowa_context_t contextP,
         }
 #endif
 
-        transacP = (coap_transaction_t *)iowa_system_malloc(sizeof(coap_transaction_t));
+        transacP = (coap_transaction_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_COAP_TRANSACTION, sizeof(coap_transaction_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (transacP == NULL)
         {
@@ -128,22 +613,35 @@ uint8_t transactionNew(iowa_context_t contextP,
         memset(transacP, 0, sizeof(coap_transaction_t));
 
         transacP->mID = messageP->id;
-        transacP->retrans_counter = 0;
-        transacP->retrans_time = curTime + peerP->ackTimeout;
         transacP->buffer_len = bufferLength;
         transacP->buffer = buffer;
         transacP->callback = resultCallback;
         transacP->userData = userData;
 
-        peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_ADD(peerP->transactionList, transacP);
+        if (coapIndexAdd(&peerP->transactionIndex, transacP->mID, transacP) != IOWA_COAP_NO_ERROR)
+        {
+            // The buffer is still owned by the caller
+            CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_TRANSACTION, transacP);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
 
-        if (peerP->ackTimeout > 0
-            && contextP->timeout > peerP->ackTimeout)
+        if (queued == true)
+        {
+            // Sent by transactionStartQueued() when an outstanding interaction completes
+            transacP->queued = true;
+            if (peerP->transactionQueueTailP == NULL)
+            {
+                peerP->transactionQueue = transacP;
+            }
+            else
+            {
+                peerP->transactionQueueTailP->next = transacP;
+            }
+            peerP->transactionQueueTailP = transacP;
+        }
+        else
         {
-            contextP->timeout = peerP->ackTimeout;
-            CRIT_SECTION_LEAVE(contextP);
-            INTERRUPT_SELECT(contextP);
-            CRIT_SECTION_ENTER(contextP);
+            prv_transactionStart(contextP, peerP, transacP, curTime);
         }
 
         return IOWA_COAP_201_CREATED;
@@ -165,7 +663,7 @@ uint8_t transactionNew(iowa_context_t contextP,
                 break;
             }
 #endif
-            ackP = (coap_ack_t *)iowa_system_malloc(sizeof(coap_ack_t));
+            ackP = (coap_ack_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_COAP_ACK, sizeof(coap_ack_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (ackP == NULL)
             {
@@ -180,7 +678,21 @@ uint8_t transactionNew(iowa_context_t contextP,
             ackP->mID = messageP->id;
             ackP->validity_time = curTime + peerP->transmitWait;
 
-            peerP->ackList = (coap_ack_t *)IOWA_UTILS_LIST_ADD(peerP->ackList, ackP);
+            if (coapIndexAdd(&peerP->ackIndex, ackP->mID, ackP) != IOWA_COAP_NO_ERROR)
+            {
+                // The buffer is still owned by the caller
+                CORE_POOL_FREE(IOWA_MEMORY_POOL_COAP_ACK, ackP);
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+
+            prv_acknowledgeAppend(peerP, ackP);
+
+            peerP->ackCacheStats.memory += PRV_ACK_MEMORY(ackP);
+            if (peerP->ackCacheStats.memory > peerP->ackCacheStats.peakMemory)
+            {
+                peerP->ackCacheStats.peakMemory = peerP->ackCacheStats.memory;
+            }
+            peerP->ackCacheStats.count = peerP->ackIndex.count;
 
             prv_acknowledgeCleanup(peerP);
 
@@ -203,46 +715,24 @@ uint8_t transactionStep(iowa_context_t contextP,
 {
     // WARNING: This function is called in a critical section
 
-    coap_ack_t *ackP;
-    coap_ack_t *parentAckP;
     coap_transaction_t *transacP;
 
     IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Entering peer %p, currentTime: %u, timeoutP: %u", peerP, currentTime, *timeoutP);
 
-    ackP = peerP->ackList;
-    parentAckP = NULL;
-    while (ackP != NULL)
+    // The acknowledges are mostly ordered by validity time: stop at the first one still valid.
+    // The ones moved at the end of the list when used expire when reaching the head or when found again.
+    while (peerP->ackList != NULL
+           && peerP->ackList->validity_time <= currentTime)
     {
-        coap_ack_t *nextP;
-
-        nextP = ackP->next;
-
-        IOWA_LOG_ARG_TRACE(IOWA_PART_COAP, "Ack ID %u: validity time: %u, buffer size: %u.",
-                           ackP->mID, ackP->validity_time, ackP->buffer_len);
+        IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Removing cached reply for message %u.", peerP->ackList->mID);
 
-        if (ackP->validity_time <= currentTime)
-        {
-            IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Removing cached reply for message %u.", ackP->mID);
-            if (parentAckP == NULL)
-            {
-                peerP->ackList = ackP->next;
-            }
-            else
-            {
-                parentAckP->next = ackP->next;
-            }
-
-            acknowledgeFree(ackP);
-            ackP = NULL;
-        }
-        else
-        {
-            parentAckP = ackP;
-        }
-        ackP = nextP;
+        peerP->ackCacheStats.expirationCount++;
+        prv_acknowledgeRemove(peerP, peerP->ackList);
     }
 
-    // TODO: handle NSTART
+    // NSTART may have been raised since the messages were queued
+    transactionStartQueued(contextP, peerP);
+
     transacP = peerP->transactionList;
     while (transacP != NULL)
     {
@@ -260,11 +750,13 @@ uint8_t transactionStep(iowa_context_t contextP,
 
                 IOWA_LOG_ARG_INFO(IOWA_PART_COAP, "Resending transaction %u.", transacP->mID);
 
-                (void)peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, transacP->buffer, transacP->buffer_len);
+                peerSendBufferDeferred(contextP, (iowa_coap_peer_t *)peerP, transacP->buffer, transacP->buffer_len, NULL, NULL);
+                CORE_METRICS_INCREMENT(peerP->base.metrics.retransmissionCount);
 
                 transacP->retrans_counter++;
 
-                timeout = peerP->ackTimeout << transacP->retrans_counter;
+                timeout = prv_getBackoffTimeout(peerP, transacP->retrans_timeout);
+                transacP->retrans_timeout = timeout;
 
                 transacP->retrans_time = currentTime + timeout;
                 if (*timeoutP > timeout)
@@ -274,8 +766,11 @@ uint8_t transactionStep(iowa_context_t contextP,
             }
             else
             {
+                CORE_METRICS_INCREMENT(peerP->base.metrics.timeoutCount);
+
                 // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
-                peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
+                transactionRemove(peerP, transacP);
+                transactionStartQueued(contextP, peerP);
                 if (transacP->callback != NULL)
                 {
                     transacP->callback((iowa_coap_peer_t *)peerP, IOWA_COAP_503_SERVICE_UNAVAILABLE, NULL, transacP->userData, contextP);
@@ -314,14 +809,15 @@ void transactionHandleMessage(iowa_context_t contextP,
     {
         coap_ack_t *ackP;
 
-        ackP = prv_acknowledgeFind(peerP, messageP);
+        ackP = prv_acknowledgeFind(peerP, messageP, contextP->currentTime);
 
         if (ackP != NULL)
         {
             if (ackP->buffer != NULL)
             {
                 // We retransmit the previously sent acknowledge
-                (void)peerSendBuffer(contextP, (iowa_coap_peer_t *)peerP, ackP->buffer, ackP->buffer_len);
+                peerSendBufferDeferred(contextP, (iowa_coap_peer_t *)peerP, ackP->buffer, ackP->buffer_len, NULL, NULL);
+                CORE_METRICS_INCREMENT(peerP->base.metrics.duplicateCount);
             }
             // else the peer already started more transmissions than the NSTART so we ignore this lost message.
         }
@@ -345,8 +841,12 @@ void transactionHandleMessage(iowa_context_t contextP,
         transacP = prv_transactionFind(peerP, messageP);
         if (transacP != NULL)
         {
+#ifdef IOWA_COAP_COCOA_SUPPORT
+            prv_cocoaUpdate(peerP, transacP, contextP->currentTime);
+#endif
             // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
-            peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
+            transactionRemove(peerP, transacP);
+            transactionStartQueued(contextP, peerP);
             if (transacP->callback != NULL)
             {
                 uint8_t code;
@@ -371,7 +871,8 @@ void transactionHandleMessage(iowa_context_t contextP,
         if (transacP != NULL)
         {
             // Remove the transaction from the peer before to call the callback. Because the callback can delete the peer
-            peerP->transactionList = (coap_transaction_t *)IOWA_UTILS_LIST_REMOVE(peerP->transactionList, transacP);
+            transactionRemove(peerP, transacP);
+            transactionStartQueued(contextP, peerP);
             if (transacP->callback != NULL)
             {
                 transacP->callback((iowa_coap_peer_t *)peerP, messageP->code, messageP, transacP->userData, contextP);
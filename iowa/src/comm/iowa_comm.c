@@ -64,6 +64,24 @@ static comm_channel_t * prv_channelNew(iowa_context_t contextP,
     channelP->type = type;
     channelP->connP = connP;
 
+#ifdef IOWA_CONNECTION_MONITOR_SUPPORT
+    {
+        int result;
+
+        CRIT_SECTION_LEAVE(contextP);
+        result = iowa_system_connection_monitor_add(connP, channelP, contextP->userData);
+        CRIT_SECTION_ENTER(contextP);
+
+        if (result < 0)
+        {
+            IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "iowa_system_connection_monitor_add() returned %d.", result);
+            iowa_system_free(channelP);
+            iowa_system_free(newChannelArray);
+            return NULL;
+        }
+    }
+#endif
+
     iowa_system_free(contextP->commContextP->channelArray);
     contextP->commContextP->channelArray = newChannelArray;
     contextP->commContextP->channelCount += 1;
@@ -71,6 +89,28 @@ static comm_channel_t * prv_channelNew(iowa_context_t contextP,
     return channelP;
 }
 
+static uint8_t prv_updateCurrentTime(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    int32_t currentTime;
+
+    CRIT_SECTION_LEAVE(contextP);
+    currentTime = iowa_system_gettime();
+    CRIT_SECTION_ENTER(contextP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (currentTime < 0
+        || currentTime < contextP->currentTime)
+    {
+        IOWA_LOG_ERROR_GETTIME(currentTime);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    contextP->currentTime = currentTime;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -104,12 +144,19 @@ void commClose(iowa_context_t contextP)
 
     IOWA_LOG_TRACE(IOWA_PART_COMM, "Entering");
 
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    commSendBatchStop(contextP);
+#endif
+
     commContextP = contextP->commContextP;
     contextP->commContextP = NULL;
 
     for (i = 0; i < commContextP->channelCount; i++)
     {
         CRIT_SECTION_LEAVE(contextP);
+#ifdef IOWA_CONNECTION_MONITOR_SUPPORT
+        iowa_system_connection_monitor_remove(commContextP->channelArray[i]->connP, contextP->userData);
+#endif
         iowa_system_connection_close(commContextP->channelArray[i]->connP, contextP->userData);
         CRIT_SECTION_ENTER(contextP);
 
@@ -117,6 +164,9 @@ void commClose(iowa_context_t contextP)
     }
 
     iowa_system_free(commContextP->channelArray);
+#ifndef IOWA_CONNECTION_MONITOR_SUPPORT
+    iowa_system_free(commContextP->connArray);
+#endif
     iowa_system_free(commContextP);
 
     IOWA_LOG_TRACE(IOWA_PART_COMM, "Comm closed.");
@@ -260,6 +310,11 @@ void commChannelDelete(iowa_context_t contextP,
         return;
     }
 
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    // Send the datagrams stored for this channel before it is closed
+    commSendBatchFlush(contextP);
+#endif
+
     if (contextP->commContextP->channelCount == 1)
     {
         newChannelArray = NULL;
@@ -289,9 +344,23 @@ void commChannelDelete(iowa_context_t contextP,
 
     contextP->commContextP->channelCount -= 1;
 
+#ifdef IOWA_CONNECTION_MONITOR_SUPPORT
+    // The channel may be deleted while the ready channels are being processed
+    for (i = 0; i < contextP->commContextP->readyCount; i++)
+    {
+        if (contextP->commContextP->readyArray[i] == channelP)
+        {
+            contextP->commContextP->readyArray[i] = NULL;
+        }
+    }
+#endif
+
     if (channelP->connP != NULL)
     {
         CRIT_SECTION_LEAVE(contextP);
+#ifdef IOWA_CONNECTION_MONITOR_SUPPORT
+        iowa_system_connection_monitor_remove(channelP->connP, contextP->userData);
+#endif
         iowa_system_connection_close(channelP->connP, contextP->userData);
         CRIT_SECTION_ENTER(contextP);
     }
@@ -323,6 +392,134 @@ comm_channel_t * commChannelFind(iowa_context_t contextP,
     return NULL;
 }
 
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+void commSendBatchStart(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    contextP->commContextP->sendBatching = true;
+}
+
+void commSendBatchFlush(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    comm_context_t commContextP;
+    size_t i;
+    comm_send_failure_callback_t failureCallbackArray[IOWA_CONNECTION_SEND_BATCH_SIZE];
+    void *failureUserDataArray[IOWA_CONNECTION_SEND_BATCH_SIZE];
+    size_t failureCount;
+
+    commContextP = contextP->commContextP;
+
+    if (commContextP->sendCount == 0)
+    {
+        return;
+    }
+
+    failureCount = 0;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "Flushing %u datagrams.", commContextP->sendCount);
+
+    for (i = 0; i < commContextP->sendCount; i++)
+    {
+        comm_channel_t *channelP;
+        uint8_t *bufferArray[IOWA_CONNECTION_SEND_BATCH_SIZE];
+        size_t lengthArray[IOWA_CONNECTION_SEND_BATCH_SIZE];
+        size_t indexArray[IOWA_CONNECTION_SEND_BATCH_SIZE];
+        size_t count;
+        size_t sentCount;
+        size_t j;
+
+        channelP = commContextP->sendArray[i].channelP;
+        if (channelP == NULL)
+        {
+            // Already sent with the datagrams of a previous channel
+            continue;
+        }
+
+        // Gather the datagrams of this channel, in order
+        count = 0;
+        for (j = i; j < commContextP->sendCount; j++)
+        {
+            if (commContextP->sendArray[j].channelP == channelP)
+            {
+                bufferArray[count] = commContextP->sendBuffer + commContextP->sendArray[j].offset;
+                lengthArray[count] = commContextP->sendArray[j].length;
+                indexArray[count] = j;
+                count++;
+                commContextP->sendArray[j].channelP = NULL;
+            }
+        }
+
+        sentCount = 0;
+        while (sentCount < count)
+        {
+            int result;
+
+            CRIT_SECTION_LEAVE(contextP);
+            result = iowa_system_connection_send_batch(channelP->connP, bufferArray + sentCount, lengthArray + sentCount, count - sentCount, contextP->userData);
+            CRIT_SECTION_ENTER(contextP);
+
+            IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "iowa_system_connection_send_batch() returned %d.", result);
+
+            if (result <= 0)
+            {
+                // Lost datagrams: the confirmable ones are retransmitted
+                IOWA_LOG_ARG_WARNING(IOWA_PART_COMM, "Failed to send %u datagrams on channelP: %p.", count - sentCount, channelP);
+                break;
+            }
+            sentCount += (size_t)result;
+        }
+
+        for (j = sentCount; j < count; j++)
+        {
+            comm_send_entry_t *entryP;
+
+            entryP = commContextP->sendArray + indexArray[j];
+            if (entryP->failureCallback != NULL)
+            {
+                failureCallbackArray[failureCount] = entryP->failureCallback;
+                failureUserDataArray[failureCount] = entryP->userData;
+                failureCount++;
+            }
+        }
+    }
+
+    commContextP->sendCount = 0;
+    commContextP->sendLength = 0;
+
+    // The callbacks are called once the send batch is empty, as they can send other datagrams
+    for (i = 0; i < failureCount; i++)
+    {
+        failureCallbackArray[i](contextP, failureUserDataArray[i]);
+    }
+}
+
+void commSendBatchStop(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    commSendBatchFlush(contextP);
+    contextP->commContextP->sendBatching = false;
+}
+
+void commSendBatchDeferStart(iowa_context_t contextP,
+                             comm_send_failure_callback_t failureCallback,
+                             void *userData)
+{
+    // WARNING: This function is called in a critical section
+    contextP->commContextP->sendDeferred = true;
+    contextP->commContextP->sendFailureCallback = failureCallback;
+    contextP->commContextP->sendUserData = userData;
+}
+
+void commSendBatchDeferStop(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    contextP->commContextP->sendDeferred = false;
+    contextP->commContextP->sendFailureCallback = NULL;
+    contextP->commContextP->sendUserData = NULL;
+}
+#endif // IOWA_CONNECTION_SEND_BATCH_SUPPORT
+
 int commSend(iowa_context_t contextP,
              comm_channel_t *channelP,
              uint8_t *buffer,
@@ -330,16 +527,70 @@ int commSend(iowa_context_t contextP,
 {
     // WARNING: This function is called in a critical section
     int result;
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    bool deferred;
+    comm_send_failure_callback_t failureCallback;
+    void *userData;
+#endif
 
     IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "On channelP: %p.", channelP);
     IOWA_LOG_BUFFER_INFO(IOWA_PART_COMM, "Sending", buffer, length);
 
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    // Read before flushing the send batch, as the failure callbacks can send other datagrams
+    deferred = contextP->commContextP->sendDeferred;
+    failureCallback = contextP->commContextP->sendFailureCallback;
+    userData = contextP->commContextP->sendUserData;
+
+    if (contextP->commContextP->sendBatching == true
+        && channelP->type == IOWA_CONN_DATAGRAM)
+    {
+        comm_context_t commContextP;
+
+        commContextP = contextP->commContextP;
+
+        // Only the datagrams whose result is not checked are stored. The other ones are sent now, after the stored ones to keep the order.
+        if (deferred == false
+            || commContextP->sendCount == IOWA_CONNECTION_SEND_BATCH_SIZE
+            || length > sizeof(commContextP->sendBuffer) - commContextP->sendLength)
+        {
+            commSendBatchFlush(contextP);
+        }
+
+        // Larger datagrams are sent directly too
+        if (deferred == true
+            && length <= sizeof(commContextP->sendBuffer))
+        {
+            memcpy(commContextP->sendBuffer + commContextP->sendLength, buffer, length);
+            commContextP->sendArray[commContextP->sendCount].channelP = channelP;
+            commContextP->sendArray[commContextP->sendCount].offset = commContextP->sendLength;
+            commContextP->sendArray[commContextP->sendCount].length = length;
+            commContextP->sendArray[commContextP->sendCount].failureCallback = failureCallback;
+            commContextP->sendArray[commContextP->sendCount].userData = userData;
+            commContextP->sendCount++;
+            commContextP->sendLength += length;
+
+            IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "Stored in the send batch (%u datagrams).", commContextP->sendCount);
+
+            return (int)length;
+        }
+    }
+#endif
+
     CRIT_SECTION_LEAVE(contextP);
     result = iowa_system_connection_send(channelP->connP, buffer, length, contextP->userData);
     CRIT_SECTION_ENTER(contextP);
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "Exiting with result %d.", result);
 
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    if (failureCallback != NULL
+        && (result < 0 || (size_t)result < length))
+    {
+        failureCallback(contextP, userData);
+    }
+#endif
+
     return result;
 }
 
@@ -369,6 +620,110 @@ int commRecv(iowa_context_t contextP,
     return result;
 }
 
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+int commRecvBatch(iowa_context_t contextP,
+                  comm_channel_t *channelP,
+                  uint8_t *buffer,
+                  size_t length,
+                  size_t *lengthArray,
+                  size_t count)
+{
+    // WARNING: This function is called in a critical section
+    int result;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Receiving up to %u datagrams on channelP: %p.", count, channelP);
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_connection_recv_batch(channelP->connP, buffer, length, lengthArray, count, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "iowa_system_connection_recv_batch() returned %d.", result);
+
+    if (result > (int)count)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "iowa_system_connection_recv_batch() returned more than %u datagrams.", count);
+        return -1;
+    }
+
+#if (IOWA_LOG_LEVEL >= IOWA_LOG_LEVEL_INFO)
+    {
+        int i;
+
+        for (i = 0; i < result; i++)
+        {
+            IOWA_LOG_BUFFER_INFO(IOWA_PART_COMM, "Received", buffer + (size_t)i * length, lengthArray[i]);
+        }
+    }
+#endif
+
+    return result;
+}
+#endif // IOWA_CONNECTION_RECV_BATCH_SUPPORT
+
+#ifdef IOWA_CONNECTION_MONITOR_SUPPORT
+uint8_t commSelect(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    int result;
+    int32_t currentTimeout;
+    size_t readyIndex;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "Channel count: %u.", contextP->commContextP->channelCount);
+
+    currentTimeout = contextP->timeout; // Store the timeout before to leave the critical section to prevent a possible data race condition
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Calling iowa_system_connection_wait() for %u connections with a timeout of %ds.", contextP->commContextP->channelCount, currentTimeout);
+
+    CRIT_SECTION_LEAVE(contextP);
+    result = iowa_system_connection_wait((void **)contextP->commContextP->readyArray, IOWA_CONNECTION_MONITOR_EVENT_COUNT, currentTimeout, contextP->userData);
+    CRIT_SECTION_ENTER(contextP);
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "iowa_system_connection_wait() returned %d.", result);
+
+    if (result < 0)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "iowa_system_connection_wait() returned %d. Exiting with error 5.03 (SERVICE UNAVAILABLE).", result);
+
+        return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+    }
+
+    if (result == 0)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    // Retrieve the current time before calling the callbacks
+    if (prv_updateCurrentTime(contextP) != IOWA_COAP_NO_ERROR)
+    {
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    if ((size_t)result > IOWA_CONNECTION_MONITOR_EVENT_COUNT)
+    {
+        result = IOWA_CONNECTION_MONITOR_EVENT_COUNT;
+    }
+    contextP->commContextP->readyCount = (size_t)result;
+
+    for (readyIndex = 0; readyIndex < contextP->commContextP->readyCount; readyIndex++)
+    {
+        comm_channel_t *channelP;
+
+        // The entry is cleared by commChannelDelete() if a previous callback deleted the channel
+        channelP = contextP->commContextP->readyArray[readyIndex];
+        if (channelP != NULL)
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Channel %p has data.", channelP);
+
+            channelP->eventCallback(channelP, COMM_EVENT_DATA_AVAILABLE, channelP->userData, contextP);
+        }
+    }
+    contextP->commContextP->readyCount = 0;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#else
+
 uint8_t commSelect(iowa_context_t contextP)
 {
     // WARNING: This function is called in a critical section
@@ -379,28 +734,30 @@ uint8_t commSelect(iowa_context_t contextP)
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_COMM, "Channel count: %u.", contextP->commContextP->channelCount);
 
-    connArray = NULL;
-    if (contextP->commContextP->channelCount > 0)
+    connCount = contextP->commContextP->channelCount;
+    if (connCount > contextP->commContextP->connArraySize)
     {
-        size_t connIndex;
-
-        connArray = (void **)iowa_system_malloc(contextP->commContextP->channelCount * sizeof(void *));
+        // The array only grows so that it is not allocated at each step
+        connArray = (void **)utilsRealloc(contextP->commContextP->connArray, contextP->commContextP->connArraySize * sizeof(void *), connCount * sizeof(void *));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (connArray == NULL)
         {
-            IOWA_LOG_ERROR_MALLOC(contextP->commContextP->channelCount * sizeof(void *));
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
-        for (connIndex = 0; connIndex < contextP->commContextP->channelCount; connIndex++)
+        contextP->commContextP->connArray = connArray;
+        contextP->commContextP->connArraySize = connCount;
+    }
+    connArray = contextP->commContextP->connArray;
+
+    if (connCount > 0)
+    {
+        size_t connIndex;
+
+        for (connIndex = 0; connIndex < connCount; connIndex++)
         {
             connArray[connIndex] = contextP->commContextP->channelArray[connIndex]->connP;
         }
-        connCount = contextP->commContextP->channelCount;
-    }
-    else
-    {
-        connCount = 0;
     }
 
     currentTimeout = contextP->timeout; // Store the timeout before to leave the critical section to prevent a possible data race condition
@@ -416,7 +773,6 @@ uint8_t commSelect(iowa_context_t contextP)
     if (result < 0)
     {
         IOWA_LOG_ARG_ERROR(IOWA_PART_SYSTEM, "iowa_system_connection_select() returned %d. Exiting with error 5.03 (SERVICE UNAVAILABLE).", result);
-        iowa_system_free(connArray);
 
         return IOWA_COAP_503_SERVICE_UNAVAILABLE;
     }
@@ -424,26 +780,14 @@ uint8_t commSelect(iowa_context_t contextP)
              && connCount != 0
              && contextP->commContextP->channelCount > 0)
     {
-        int32_t currentTime;
         comm_channel_t *channelP;
         size_t connIndex;
 
         // Retrieve the current time before calling the callbacks
-        CRIT_SECTION_LEAVE(contextP);
-        currentTime = iowa_system_gettime();
-        CRIT_SECTION_ENTER(contextP);
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-        if (currentTime < 0
-            || currentTime < contextP->currentTime)
+        if (prv_updateCurrentTime(contextP) != IOWA_COAP_NO_ERROR)
         {
-            IOWA_LOG_ERROR_GETTIME(currentTime);
-            iowa_system_free(connArray);
-
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
-#endif
-
-        contextP->currentTime = currentTime;
 
         for (connIndex = 0; connIndex < connCount; connIndex++)
         {
@@ -454,7 +798,16 @@ uint8_t commSelect(iowa_context_t contextP)
 
                 IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Connection #%u (%p) has data.", connIndex, connArray[connIndex]);
 
-                channelP = commChannelFind(contextP, connArray[connIndex]);
+                // connArray was filled from channelArray: use the channel at the same index unless a callback modified the channels
+                if (connIndex < contextP->commContextP->channelCount
+                    && contextP->commContextP->channelArray[connIndex]->connP == connArray[connIndex])
+                {
+                    channelP = contextP->commContextP->channelArray[connIndex];
+                }
+                else
+                {
+                    channelP = commChannelFind(contextP, connArray[connIndex]);
+                }
                 if (channelP != NULL)
                 {
                    IOWA_LOG_ARG_INFO(IOWA_PART_COMM, "Found matching channel %p.", channelP);
@@ -465,7 +818,6 @@ uint8_t commSelect(iowa_context_t contextP)
         }
     }
 
-    iowa_system_free(connArray);
-
     return IOWA_COAP_NO_ERROR;
 }
+#endif // IOWA_CONNECTION_MONITOR_SUPPORT
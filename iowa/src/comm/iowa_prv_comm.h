@@ -76,6 +76,12 @@ typedef void(*comm_event_callback_t)(comm_channel_t *fromChannel,
                                      void *userData,
                                      iowa_context_t contextP);
 
+// The callback called when a datagram stored in the send batch could not be sent.
+// contextP: the IOWA context.
+// userData: the commSendBatchDeferStart() parameter.
+typedef void(*comm_send_failure_callback_t)(iowa_context_t contextP,
+                                            void *userData);
+
 typedef void(*comm_new_channel_callback_t)(iowa_context_t contextP,
                                            comm_channel_t *fromChannel,
                                            void * userData);
@@ -88,12 +94,53 @@ struct _comm_channel_t
     void                   *userData;
 };
 
+#if defined(IOWA_CONNECTION_RECV_BATCH_SUPPORT) && !defined(IOWA_CONNECTION_RECV_BATCH_SIZE)
+#define IOWA_CONNECTION_RECV_BATCH_SIZE 8
+#endif
+
+#if defined(IOWA_CONNECTION_MONITOR_SUPPORT) && !defined(IOWA_CONNECTION_MONITOR_EVENT_COUNT)
+#define IOWA_CONNECTION_MONITOR_EVENT_COUNT 16
+#endif
+
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+#ifndef IOWA_CONNECTION_SEND_BATCH_SIZE
+#define IOWA_CONNECTION_SEND_BATCH_SIZE 8
+#endif
+
+// A datagram waiting in the send batch.
+typedef struct
+{
+    comm_channel_t              *channelP;         // Set to NULL once sent
+    size_t                       offset;           // Position of the datagram in the batch buffer
+    size_t                       length;
+    comm_send_failure_callback_t failureCallback;  // Called if the datagram could not be sent. This can be nil.
+    void                        *userData;
+} comm_send_entry_t;
+#endif
+
 struct _comm_context_t
 {
     size_t           channelCount;
     comm_channel_t **channelArray;    // Dynamically-allocated array of created channels
     comm_new_channel_callback_t newChannelCallback;
     void *callbackUserData;
+#ifdef IOWA_CONNECTION_MONITOR_SUPPORT
+    size_t           readyCount;
+    comm_channel_t  *readyArray[IOWA_CONNECTION_MONITOR_EVENT_COUNT]; // Channels with available data, as returned by iowa_system_connection_wait()
+#else
+    size_t           connArraySize;
+    void           **connArray;       // Array passed to iowa_system_connection_select(), kept between steps
+#endif
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    bool              sendBatching;   // Datagrams are stored in the send batch instead of being sent
+    bool              sendDeferred;   // The caller of commSend() does not check the result
+    comm_send_failure_callback_t sendFailureCallback; // Set by commSendBatchDeferStart()
+    void             *sendUserData;
+    size_t            sendCount;
+    size_t            sendLength;     // Number of bytes used in sendBuffer
+    comm_send_entry_t sendArray[IOWA_CONNECTION_SEND_BATCH_SIZE];
+    uint8_t           sendBuffer[IOWA_CONNECTION_SEND_BATCH_SIZE * IOWA_BUFFER_SIZE];
+#endif
 };
 
 /************************************************
@@ -180,6 +227,8 @@ comm_channel_t * commChannelFind(iowa_context_t contextP,
 // - contextP: as returned by iowa_init().
 // - channelP: a Comm channel.
 // - buffer, length: data to send.
+// Note: between commSendBatchDeferStart() and commSendBatchDeferStop(), a datagram can be stored in the send batch.
+//       The returned value is then its length, whether it will be sent or not.
 int commSend(iowa_context_t contextP,
              comm_channel_t *channelP,
              uint8_t * buffer,
@@ -197,6 +246,64 @@ int commRecv(iowa_context_t contextP,
              uint8_t * buffer,
              size_t length);
 
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+// Read several datagrams on a channel.
+// Returned value: the number of datagrams read or a negative number in case of error.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - channelP: a Comm channel.
+// - buffer: to store the read datagrams. The datagram i is stored at buffer + i * length.
+// - length: the maximum size of a datagram.
+// - lengthArray: OUT. The size of each read datagram.
+// - count: the maximum number of datagrams to read.
+int commRecvBatch(iowa_context_t contextP,
+                  comm_channel_t *channelP,
+                  uint8_t *buffer,
+                  size_t length,
+                  size_t *lengthArray,
+                  size_t count);
+#endif
+
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+// Start storing the datagrams sent by commSend() in the send batch.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void commSendBatchStart(iowa_context_t contextP);
+
+// Send the datagrams stored in the send batch.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// Note: the datagrams of a channel are sent in the order of the commSend() calls.
+void commSendBatchFlush(iowa_context_t contextP);
+
+// Send the datagrams stored in the send batch and stop storing new ones.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void commSendBatchStop(iowa_context_t contextP);
+
+// Allow commSend() to store the following datagrams in the send batch.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+// - failureCallback: called when a following datagram could not be sent. This can be nil.
+// - userData: past as parameter to failureCallback. This can be nil.
+// Note: only for datagrams whose sending result is not checked by the caller of commSend(), like retransmissions.
+//       The other ones are sent immediately so that commSend() returns the actual result.
+//       failureCallback is called once the send batch is flushed, or during commSend() if the datagram is sent immediately.
+void commSendBatchDeferStart(iowa_context_t contextP,
+                             comm_send_failure_callback_t failureCallback,
+                             void *userData);
+
+// Send the following datagrams immediately.
+// Returned value: none.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void commSendBatchDeferStop(iowa_context_t contextP);
+#endif
+
 // Monitor channels during the specified time.
 // Returned value: '0' in case of success or an error code in the form of a CoAP code.
 // Parameters:
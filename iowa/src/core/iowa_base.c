@@ -58,6 +58,26 @@ iowa_context_t iowa_init(void *userData)
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_SECURITY_LAYER: IOWA_SECURITY_LAYER_NONE");
 #endif
 
+#ifdef IOWA_CONNECTION_MONITOR_SUPPORT
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_CONNECTION_MONITOR_SUPPORT (event count: %d)", IOWA_CONNECTION_MONITOR_EVENT_COUNT);
+#endif
+
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_LOG_RING_BUFFER_SIZE: %d", IOWA_LOG_RING_BUFFER_SIZE);
+#endif
+
+#ifdef IOWA_METRICS_SUPPORT
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_METRICS_SUPPORT");
+#endif
+
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_COMMAND_QUEUE_SUPPORT (queue size: %d)", IOWA_COMMAND_QUEUE_SIZE);
+#endif
+
+#ifdef IOWA_COAP_OPTION_VIEW_SUPPORT
+    IOWA_LOG_ARG_INFO(IOWA_PART_SYSTEM, "IOWA_COAP_OPTION_VIEW_SUPPORT (view count: %d)", IOWA_COAP_OPTION_VIEW_COUNT);
+#endif
+
 #ifdef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK");
 #endif
@@ -78,6 +98,18 @@ iowa_context_t iowa_init(void *userData)
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "LWM2M_SUPPORT_TLV");
 #endif
 
+#ifdef LWM2M_SUPPORT_CBOR
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "LWM2M_SUPPORT_CBOR");
+#endif
+
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "LWM2M_SUPPORT_SENML_CBOR");
+#endif
+
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    IOWA_LOG_INFO(IOWA_PART_SYSTEM, "LWM2M_SUPPORT_LWM2M_CBOR");
+#endif
+
 #ifdef LWM2M_ALTPATH_SUPPORT
     IOWA_LOG_INFO(IOWA_PART_SYSTEM, "LWM2M_ALTPATH_SUPPORT");
 #endif
@@ -174,6 +206,9 @@ iowa_context_t iowa_init(void *userData)
     memset(contextP, 0, sizeof(struct _iowa_context_t));
 
     contextP->userData = userData;
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+    coreCommandQueueInit(contextP);
+#endif
 
     if (IOWA_COAP_NO_ERROR != commInit(contextP))
     {
@@ -263,6 +298,9 @@ void iowa_close(iowa_context_t contextP)
 
     iowa_system_free(contextP);
 
+    // Slabs still used by another context are kept
+    CORE_POOL_RELEASE();
+
     IOWA_LOG_INFO(IOWA_PART_BASE, "IOWA closed");
 }
 
@@ -294,6 +332,9 @@ iowa_status_t iowa_step(iowa_context_t contextP,
     do
     {
         int32_t currentTime;
+#ifdef IOWA_METRICS_SUPPORT
+        uint32_t metricsTime;
+#endif
 
         CRIT_SECTION_ENTER(contextP);
         if (timeout < 0)
@@ -345,17 +386,37 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 
         contextP->currentTime = currentTime;
 
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+        // Apply the updates posted by the application threads since the previous iteration
+        coreCommandQueueStep(contextP);
+#endif
+
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+        // The retransmissions of the step are sent together before waiting for incoming data
+        commSendBatchStart(contextP);
+#endif
+
+        CORE_METRICS_START(metricsTime);
+
         status = securityStep(contextP);
+        CORE_METRICS_RECORD(contextP->metricsPhaseArray[IOWA_METRICS_PHASE_SECURITY], metricsTime);
         if (status != IOWA_COAP_NO_ERROR)
         {
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+            commSendBatchStop(contextP);
+#endif
             CRIT_SECTION_LEAVE(contextP);
             IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "An error occurred during the Security step routine: %u.%02u.", (status & 0xFF) >> 5, (status & 0x1F));
             return status;
         }
 
         status = coapStep(contextP);
+        CORE_METRICS_RECORD(contextP->metricsPhaseArray[IOWA_METRICS_PHASE_COAP], metricsTime);
         if (status != IOWA_COAP_NO_ERROR)
         {
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+            commSendBatchStop(contextP);
+#endif
             CRIT_SECTION_LEAVE(contextP);
             IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "An error occurred during the CoAP step routine: %u.%02u.", (status & 0xFF) >> 5, (status & 0x1F));
             return status;
@@ -363,17 +424,32 @@ iowa_status_t iowa_step(iowa_context_t contextP,
 
 #if defined(LWM2M_CLIENT_MODE) || defined(LWM2M_SERVER_MODE) || defined(LWM2M_BOOTSTRAP_SERVER_MODE)
         status = lwm2m_step(contextP);
+        CORE_METRICS_RECORD(contextP->metricsPhaseArray[IOWA_METRICS_PHASE_LWM2M], metricsTime);
         if (status != IOWA_COAP_NO_ERROR)
         {
             IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "An error occurred during the LwM2M step routine: %u.%02u.", (status & 0xFF) >> 5, (status & 0x1F));
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+            commSendBatchStop(contextP);
+#endif
             CRIT_SECTION_LEAVE(contextP);
             return status;
         }
 #endif
 
         coreTimerStep(contextP);
+        CORE_METRICS_RECORD(contextP->metricsPhaseArray[IOWA_METRICS_PHASE_TIMER], metricsTime);
 
+        CORE_COMMAND_QUEUE_SELECT_START(contextP);
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+        commSendBatchFlush(contextP);
+        status = commSelect(contextP);
+        // Send the replies to the received messages
+        commSendBatchStop(contextP);
+#else
         status = commSelect(contextP);
+#endif
+        CORE_COMMAND_QUEUE_SELECT_STOP(contextP);
+        CORE_METRICS_RECORD(contextP->metricsPhaseArray[IOWA_METRICS_PHASE_SELECT], metricsTime);
         CRIT_SECTION_LEAVE(contextP);
 
         if (status != IOWA_COAP_NO_ERROR)
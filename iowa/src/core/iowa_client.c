@@ -1052,6 +1052,42 @@ iowa_status_t iowa_client_object_resource_changed(iowa_context_t contextP,
     return IOWA_COAP_NO_ERROR;
 }
 
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+iowa_status_t iowa_client_post_resource_changed(iowa_context_t contextP,
+                                                uint16_t objectID,
+                                                uint16_t instanceID,
+                                                uint16_t resourceID)
+{
+    core_command_t command;
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    // Check arguments
+    switch (objectID)
+    {
+    case IOWA_LWM2M_SECURITY_OBJECT_ID:
+    case IOWA_LWM2M_SERVER_OBJECT_ID:
+    case IOWA_LWM2M_DEVICE_OBJECT_ID:
+        IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object ID %u is reserved.", objectID);
+        return IOWA_COAP_403_FORBIDDEN;
+
+    case IOWA_LWM2M_ID_ALL:
+        IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Object ID 65535 is not acceptable.");
+        return IOWA_COAP_406_NOT_ACCEPTABLE;
+
+    default:
+        break;
+    }
+#endif
+
+    command.type = CORE_COMMAND_RESOURCE_CHANGED;
+    command.u.resource.objectId = objectID;
+    command.u.resource.instanceId = instanceID;
+    command.u.resource.resourceId = resourceID;
+
+    return coreCommandQueuePost(contextP, &command);
+}
+#endif
+
 iowa_status_t iowa_client_object_instance_changed(iowa_context_t contextP,
                                                   uint16_t objectID,
                                                   uint16_t instanceID,
@@ -0,0 +1,259 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2019-2020 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+#include "iowa_prv_core_internals.h"
+
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+
+// The queue is shared by all the threads posting commands and the one calling iowa_step()
+#if defined(__GNUC__) || defined(__clang__)
+#define PRV_ATOMIC_LOAD(P)             __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define PRV_ATOMIC_LOAD_RELAXED(P)     __atomic_load_n((P), __ATOMIC_RELAXED)
+#define PRV_ATOMIC_STORE(P, V)         __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+#define PRV_ATOMIC_STORE_RELAXED(P, V) __atomic_store_n((P), (V), __ATOMIC_RELAXED)
+#define PRV_ATOMIC_CAS(P, E, V)        __atomic_compare_exchange_n((P), (E), (V), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define PRV_ATOMIC_EXCHANGE(P, V)      __atomic_exchange_n((P), (V), __ATOMIC_ACQ_REL)
+#define PRV_ATOMIC_INCREMENT(P)        (void)__atomic_add_fetch((P), 1, __ATOMIC_RELAXED)
+#elif defined(IOWA_THREAD_SUPPORT)
+#error "IOWA_COMMAND_QUEUE_SUPPORT with IOWA_THREAD_SUPPORT requires the GCC atomic built-ins."
+#else
+#define PRV_ATOMIC_LOAD(P)             (*(P))
+#define PRV_ATOMIC_LOAD_RELAXED(P)     (*(P))
+#define PRV_ATOMIC_STORE(P, V)         (*(P) = (V))
+#define PRV_ATOMIC_STORE_RELAXED(P, V) (*(P) = (V))
+#define PRV_ATOMIC_CAS(P, E, V)        (*(P) == *(E) ? (*(P) = (V), true) : (*(E) = *(P), false))
+#define PRV_ATOMIC_INCREMENT(P)        ((*(P))++)
+#endif
+
+#define PRV_POSITION_MASK ((uint32_t)IOWA_COMMAND_QUEUE_SIZE - 1)
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Apply a command dequeued from the queue.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - commandP: the command.
+static iowa_status_t prv_applyCommand(iowa_context_t contextP,
+                                      core_command_t *commandP)
+{
+    // WARNING: This function is called in a critical section
+    switch (commandP->type)
+    {
+    case CORE_COMMAND_IPSO_VALUE:
+        return objectIpsoUpdateValue(contextP, commandP->u.ipso.id, commandP->u.ipso.value);
+
+    case CORE_COMMAND_RESOURCE_CHANGED:
+        customObjectResourceChanged(contextP, commandP->u.resource.objectId, commandP->u.resource.instanceId, commandP->u.resource.resourceId);
+        return IOWA_COAP_NO_ERROR;
+
+    default:
+        IOWA_LOG_ARG_ERROR(IOWA_PART_BASE, "Unknown command type %d.", commandP->type);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+void coreCommandQueueInit(iowa_context_t contextP)
+{
+    uint32_t position;
+
+    // A free slot holds the position at which it will be claimed
+    for (position = 0; position < IOWA_COMMAND_QUEUE_SIZE; position++)
+    {
+        contextP->commandQueue.cellArray[position].sequence = position;
+    }
+}
+
+iowa_status_t coreCommandQueuePost(iowa_context_t contextP,
+                                   const core_command_t *commandP)
+{
+    core_command_queue_t *queueP;
+    core_command_cell_t *cellP;
+    uint32_t position;
+
+    queueP = &(contextP->commandQueue);
+
+    position = PRV_ATOMIC_LOAD_RELAXED(&(queueP->enqueuePosition));
+    while (true)
+    {
+        int32_t difference;
+
+        cellP = queueP->cellArray + (position & PRV_POSITION_MASK);
+        difference = (int32_t)(PRV_ATOMIC_LOAD(&(cellP->sequence)) - position);
+        if (difference == 0)
+        {
+            // The slot is free: claim it
+            if (PRV_ATOMIC_CAS(&(queueP->enqueuePosition), &position, position + 1) == true)
+            {
+                break;
+            }
+            // Another thread claimed it first. position now holds the current value.
+            PRV_ATOMIC_INCREMENT(&(queueP->retryCount));
+        }
+        else if (difference < 0)
+        {
+            // The slot still holds the command posted one lap before
+            PRV_ATOMIC_INCREMENT(&(queueP->fullCount));
+            return IOWA_COAP_503_SERVICE_UNAVAILABLE;
+        }
+        else
+        {
+            // Another thread claimed this slot in the meantime
+            PRV_ATOMIC_INCREMENT(&(queueP->retryCount));
+            position = PRV_ATOMIC_LOAD_RELAXED(&(queueP->enqueuePosition));
+        }
+    }
+
+    cellP->command = *commandP;
+    PRV_ATOMIC_STORE(&(cellP->sequence), position + 1);
+    PRV_ATOMIC_INCREMENT(&(queueP->postCount));
+
+#ifdef IOWA_THREAD_SUPPORT
+    // Only the first command posted while iowa_step() waits in the select interrupts it
+    if (PRV_ATOMIC_EXCHANGE(&(queueP->isWaiting), 0) != 0)
+    {
+        iowa_system_connection_interrupt_select(contextP->userData);
+    }
+#endif
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void coreCommandQueueStep(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    core_command_queue_t *queueP;
+    uint32_t batchSize;
+    uint32_t failedCount;
+
+    queueP = &(contextP->commandQueue);
+
+    // The batch is limited to the queue size so that continuous posts do not starve the other steps.
+    // The commands posted meanwhile are applied at the next iteration.
+    // No notification is built before lwm2m_step(): several updates of the same resource lead to a single notification.
+    batchSize = 0;
+    failedCount = 0;
+    while (batchSize < IOWA_COMMAND_QUEUE_SIZE)
+    {
+        core_command_cell_t *cellP;
+        core_command_t command;
+
+        cellP = queueP->cellArray + (queueP->dequeuePosition & PRV_POSITION_MASK);
+        if (PRV_ATOMIC_LOAD(&(cellP->sequence)) != queueP->dequeuePosition + 1)
+        {
+            // Empty or the producer is still copying the command
+            break;
+        }
+
+        command = cellP->command;
+
+        // Release the slot for the next lap
+        PRV_ATOMIC_STORE(&(cellP->sequence), queueP->dequeuePosition + IOWA_COMMAND_QUEUE_SIZE);
+        queueP->dequeuePosition++;
+
+        if (prv_applyCommand(contextP, &command) != IOWA_COAP_NO_ERROR)
+        {
+            failedCount++;
+        }
+        batchSize++;
+    }
+
+    if (batchSize != 0)
+    {
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Applied %u posted commands.", batchSize);
+
+        // The counters are only written here but can be read by iowa_command_queue_get_stats() from another thread
+        PRV_ATOMIC_STORE_RELAXED(&(queueP->appliedCount), queueP->appliedCount + batchSize);
+        PRV_ATOMIC_STORE_RELAXED(&(queueP->failedCount), queueP->failedCount + failedCount);
+        PRV_ATOMIC_STORE_RELAXED(&(queueP->batchCount), queueP->batchCount + 1);
+        if (batchSize > queueP->maxBatchSize)
+        {
+            PRV_ATOMIC_STORE_RELAXED(&(queueP->maxBatchSize), batchSize);
+        }
+    }
+}
+
+#ifdef IOWA_THREAD_SUPPORT
+void coreCommandQueueSelectStart(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    core_command_queue_t *queueP;
+    core_command_cell_t *cellP;
+
+    queueP = &(contextP->commandQueue);
+
+    // The exchange orders the flag with the load below: either a producer sees the flag set, or the command it posted is seen here
+    (void)PRV_ATOMIC_EXCHANGE(&(queueP->isWaiting), 1);
+
+    cellP = queueP->cellArray + (queueP->dequeuePosition & PRV_POSITION_MASK);
+    if (PRV_ATOMIC_LOAD(&(cellP->sequence)) == queueP->dequeuePosition + 1)
+    {
+        // Commands were posted since coreCommandQueueStep(): do not wait
+        contextP->timeout = 0;
+    }
+}
+
+void coreCommandQueueSelectStop(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    (void)PRV_ATOMIC_EXCHANGE(&(contextP->commandQueue.isWaiting), 0);
+}
+#endif
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_command_queue_get_stats(iowa_context_t contextP,
+                                           iowa_command_queue_stats_t *statsP)
+{
+    core_command_queue_t *queueP;
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (contextP == NULL
+        || statsP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Invalid arguments.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    queueP = &(contextP->commandQueue);
+
+    statsP->postCount = PRV_ATOMIC_LOAD_RELAXED(&(queueP->postCount));
+    statsP->retryCount = PRV_ATOMIC_LOAD_RELAXED(&(queueP->retryCount));
+    statsP->fullCount = PRV_ATOMIC_LOAD_RELAXED(&(queueP->fullCount));
+    statsP->appliedCount = PRV_ATOMIC_LOAD_RELAXED(&(queueP->appliedCount));
+    statsP->failedCount = PRV_ATOMIC_LOAD_RELAXED(&(queueP->failedCount));
+    statsP->batchCount = PRV_ATOMIC_LOAD_RELAXED(&(queueP->batchCount));
+    statsP->maxBatchSize = PRV_ATOMIC_LOAD_RELAXED(&(queueP->maxBatchSize));
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // IOWA_COMMAND_QUEUE_SUPPORT
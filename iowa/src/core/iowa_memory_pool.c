@@ -0,0 +1,334 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2019-2020 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+#include "iowa_prv_core_internals.h"
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+
+#ifndef IOWA_MEMORY_POOL_SLAB_OBJECT_COUNT
+#define IOWA_MEMORY_POOL_SLAB_OBJECT_COUNT 8
+#endif
+
+#define PRV_POOL_ALIGNMENT    (size_t)8
+#define PRV_POOL_ALIGN(S)     (((S) + PRV_POOL_ALIGNMENT - 1) & ~(PRV_POOL_ALIGNMENT - 1))
+#define PRV_POOL_SLAB_HEADER  PRV_POOL_ALIGN(sizeof(pool_slab_t))
+
+// A slab is a block of IOWA_MEMORY_POOL_SLAB_OBJECT_COUNT objects preceded by this header.
+typedef struct _pool_slab_t
+{
+    struct _pool_slab_t *nextP;
+} pool_slab_t;
+
+// A free object is reused to link the free objects together.
+typedef struct _pool_object_t
+{
+    struct _pool_object_t *nextP;
+} pool_object_t;
+
+typedef struct
+{
+    size_t         objectSize;   // set on the first allocation
+    pool_slab_t   *slabList;
+    pool_object_t *freeList;
+    size_t         capacity;     // number of objects in the slabs
+    size_t         used;
+    size_t         highWater;
+    uint32_t       failureCount;
+} pool_t;
+
+typedef struct
+{
+    uint8_t     *memory;
+    size_t       size;
+    size_t       used;
+    size_t       requiredSize;   // bytes requested during the current request, including the ones which did not fit
+    size_t       highWater;
+    uint32_t     failureCount;   // allocations which did not fit in the arena
+    unsigned int depth;
+} arena_t;
+
+// The pools are shared by all the IOWA contexts.
+static pool_t prv_poolArray[IOWA_MEMORY_POOL_REQUEST_ARENA];
+static arena_t prv_arena;
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static iowa_status_t prv_addSlab(pool_t *poolP)
+{
+    pool_slab_t *slabP;
+    uint8_t *objectP;
+    size_t slabSize;
+    size_t i;
+
+    slabSize = PRV_POOL_SLAB_HEADER + IOWA_MEMORY_POOL_SLAB_OBJECT_COUNT * poolP->objectSize;
+
+    slabP = (pool_slab_t *)iowa_system_malloc(slabSize);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (slabP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(slabSize);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    slabP->nextP = poolP->slabList;
+    poolP->slabList = slabP;
+
+    objectP = (uint8_t *)slabP + PRV_POOL_SLAB_HEADER;
+    for (i = 0; i < IOWA_MEMORY_POOL_SLAB_OBJECT_COUNT; i++)
+    {
+        ((pool_object_t *)objectP)->nextP = poolP->freeList;
+        poolP->freeList = (pool_object_t *)objectP;
+        objectP += poolP->objectSize;
+    }
+
+    poolP->capacity += IOWA_MEMORY_POOL_SLAB_OBJECT_COUNT;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static bool prv_isInArena(void *pointer)
+{
+    return (prv_arena.memory != NULL
+            && (uint8_t *)pointer >= prv_arena.memory
+            && (uint8_t *)pointer < prv_arena.memory + prv_arena.size);
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+void * corePoolAlloc(iowa_memory_pool_t pool,
+                     size_t size)
+{
+    pool_t *poolP;
+    pool_object_t *objectP;
+
+    assert(pool < IOWA_MEMORY_POOL_REQUEST_ARENA);
+
+    poolP = prv_poolArray + pool;
+
+    if (poolP->objectSize == 0)
+    {
+        if (size < sizeof(pool_object_t))
+        {
+            size = sizeof(pool_object_t);
+        }
+        poolP->objectSize = PRV_POOL_ALIGN(size);
+    }
+    assert(size <= poolP->objectSize);
+
+    if (poolP->freeList == NULL)
+    {
+        if (prv_addSlab(poolP) != IOWA_COAP_NO_ERROR)
+        {
+            poolP->failureCount++;
+            return NULL;
+        }
+    }
+
+    objectP = poolP->freeList;
+    poolP->freeList = objectP->nextP;
+
+    poolP->used++;
+    if (poolP->used > poolP->highWater)
+    {
+        poolP->highWater = poolP->used;
+    }
+
+    return objectP;
+}
+
+void corePoolFree(iowa_memory_pool_t pool,
+                  void *objectP)
+{
+    pool_t *poolP;
+
+    if (objectP == NULL)
+    {
+        return;
+    }
+
+    assert(pool < IOWA_MEMORY_POOL_REQUEST_ARENA);
+
+    poolP = prv_poolArray + pool;
+
+    assert(poolP->used > 0);
+
+    ((pool_object_t *)objectP)->nextP = poolP->freeList;
+    poolP->freeList = (pool_object_t *)objectP;
+    poolP->used--;
+}
+
+void corePoolRelease(void)
+{
+    size_t i;
+
+    IOWA_LOG_TRACE(IOWA_PART_BASE, "Releasing the unused memory pools.");
+
+    for (i = 0; i < IOWA_MEMORY_POOL_REQUEST_ARENA; i++)
+    {
+        pool_t *poolP;
+
+        poolP = prv_poolArray + i;
+
+        // Objects may still be used by another context
+        if (poolP->used == 0)
+        {
+            while (poolP->slabList != NULL)
+            {
+                pool_slab_t *slabP;
+
+                slabP = poolP->slabList;
+                poolP->slabList = slabP->nextP;
+                iowa_system_free(slabP);
+            }
+            poolP->freeList = NULL;
+            poolP->capacity = 0;
+        }
+    }
+
+    if (prv_arena.depth == 0)
+    {
+        iowa_system_free(prv_arena.memory);
+        prv_arena.memory = NULL;
+        prv_arena.size = 0;
+    }
+}
+
+void coreArenaBegin(void)
+{
+    prv_arena.depth++;
+}
+
+void coreArenaEnd(void)
+{
+    assert(prv_arena.depth > 0);
+
+    prv_arena.depth--;
+    if (prv_arena.depth != 0)
+    {
+        return;
+    }
+
+    if (prv_arena.requiredSize > prv_arena.highWater)
+    {
+        prv_arena.highWater = prv_arena.requiredSize;
+    }
+
+    // Grow the arena so that the next request of the same size fits in it
+    if (prv_arena.requiredSize > prv_arena.size)
+    {
+        iowa_system_free(prv_arena.memory);
+        prv_arena.memory = (uint8_t *)iowa_system_malloc(prv_arena.requiredSize);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (prv_arena.memory == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(prv_arena.requiredSize);
+            prv_arena.size = 0;
+        }
+        else
+#endif
+        {
+            prv_arena.size = prv_arena.requiredSize;
+        }
+    }
+
+    prv_arena.used = 0;
+    prv_arena.requiredSize = 0;
+}
+
+void * coreArenaAlloc(size_t size)
+{
+    size_t alignedSize;
+    void *pointer;
+
+    if (prv_arena.depth == 0)
+    {
+        return iowa_system_malloc(size);
+    }
+
+    alignedSize = PRV_POOL_ALIGN(size);
+    prv_arena.requiredSize += alignedSize;
+
+    if (prv_arena.used + alignedSize <= prv_arena.size)
+    {
+        pointer = prv_arena.memory + prv_arena.used;
+        prv_arena.used += alignedSize;
+
+        return pointer;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "%u bytes do not fit in the request arena.", size);
+    prv_arena.failureCount++;
+
+    return iowa_system_malloc(size);
+}
+
+void coreArenaFree(void *pointer)
+{
+    // Memory allocated in the arena is released by coreArenaEnd()
+    if (prv_isInArena(pointer) == false)
+    {
+        iowa_system_free(pointer);
+    }
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_memory_pool_get_stats(iowa_memory_pool_t pool,
+                                         iowa_memory_pool_stats_t *statsP)
+{
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (statsP == NULL
+        || pool >= IOWA_MEMORY_POOL_COUNT)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Invalid arguments.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    if (pool == IOWA_MEMORY_POOL_REQUEST_ARENA)
+    {
+        statsP->objectSize = 1;
+        statsP->capacity = prv_arena.size;
+        statsP->used = prv_arena.used;
+        statsP->highWater = prv_arena.highWater;
+        statsP->failureCount = prv_arena.failureCount;
+    }
+    else
+    {
+        statsP->objectSize = prv_poolArray[pool].objectSize;
+        statsP->capacity = prv_poolArray[pool].capacity;
+        statsP->used = prv_poolArray[pool].used;
+        statsP->highWater = prv_poolArray[pool].highWater;
+        statsP->failureCount = prv_poolArray[pool].failureCount;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // IOWA_MEMORY_POOL_SUPPORT
@@ -0,0 +1,199 @@
+/**********************************************
+*
+*  _________ _________ ___________ _________
+* |         |         |   |   |   |         |
+* |_________|         |   |   |   |    _    |
+* |         |    |    |   |   |   |         |
+* |         |    |    |           |         |
+* |         |    |    |           |    |    |
+* |         |         |           |    |    |
+* |_________|_________|___________|____|____|
+*
+* Copyright (c) 2019-2020 IoTerop.
+* All rights reserved.
+*
+* This program and the accompanying materials
+* are made available under the terms of
+* IoTerop’s IOWA License (LICENSE.TXT) which
+* accompany this distribution.
+*
+*
+**********************************************/
+
+#include "iowa_prv_core_internals.h"
+
+#ifdef IOWA_METRICS_SUPPORT
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Find the LwM2M Server using a CoAP peer.
+// Returned value: the Short ID of the LwM2M Server or IOWA_LWM2M_ID_ALL if none uses the peer.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - peerP: the CoAP peer.
+static uint16_t prv_getPeerShortId(iowa_context_t contextP,
+                                   iowa_coap_peer_t *peerP)
+{
+#ifdef LWM2M_CLIENT_MODE
+    lwm2m_server_t *serverP;
+
+    for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+    {
+        if (serverP->runtime.peerP == peerP)
+        {
+            return serverP->shortId;
+        }
+    }
+#else
+    (void)contextP;
+    (void)peerP;
+#endif
+
+    return IOWA_LWM2M_ID_ALL;
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+uint32_t coreMetricsRecord(iowa_metrics_histogram_t *histogramP,
+                           uint32_t startTime)
+{
+    uint32_t currentTime;
+    uint32_t duration;
+    size_t bucket;
+
+    currentTime = iowa_system_gettime_us();
+
+    // Unsigned arithmetic handles the wrap around of the clock
+    duration = currentTime - startTime;
+
+    bucket = 0;
+    while (bucket < IOWA_METRICS_HISTOGRAM_BUCKET_COUNT - 1
+           && (duration >> bucket) != 0)
+    {
+        bucket++;
+    }
+
+    histogramP->count++;
+    histogramP->sum += duration;
+    if (duration > histogramP->max)
+    {
+        histogramP->max = duration;
+    }
+    histogramP->bucketArray[bucket]++;
+
+    return currentTime;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t iowa_metrics_get(iowa_context_t contextP,
+                               iowa_metrics_t *metricsP)
+{
+    iowa_coap_peer_t *peerP;
+    size_t index;
+#ifdef LWM2M_CLIENT_MODE
+    lwm2m_server_t *serverP;
+#endif
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (contextP == NULL
+        || metricsP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_BASE, "Invalid arguments.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    memset(metricsP, 0, sizeof(iowa_metrics_t));
+
+    CRIT_SECTION_ENTER(contextP);
+
+    memcpy(metricsP->phaseArray, contextP->metricsPhaseArray, sizeof(metricsP->phaseArray));
+    metricsP->dataCallback = contextP->metricsDataCallback;
+
+    for (peerP = coapGetPeerList(contextP); peerP != NULL; peerP = peerP->base.next)
+    {
+        metricsP->peerCount++;
+    }
+#ifdef LWM2M_CLIENT_MODE
+    for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+    {
+        metricsP->serverCount++;
+    }
+#endif
+
+    if (metricsP->peerCount != 0)
+    {
+        metricsP->peerArray = (iowa_metrics_peer_t *)iowa_system_malloc(metricsP->peerCount * sizeof(iowa_metrics_peer_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (metricsP->peerArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(metricsP->peerCount * sizeof(iowa_metrics_peer_t));
+            CRIT_SECTION_LEAVE(contextP);
+            memset(metricsP, 0, sizeof(iowa_metrics_t));
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+
+        index = 0;
+        for (peerP = coapGetPeerList(contextP); peerP != NULL; peerP = peerP->base.next)
+        {
+            metricsP->peerArray[index].shortId = prv_getPeerShortId(contextP, peerP);
+            metricsP->peerArray[index].type = peerP->base.type;
+            metricsP->peerArray[index].counters = peerP->base.metrics;
+            index++;
+        }
+    }
+
+#ifdef LWM2M_CLIENT_MODE
+    if (metricsP->serverCount != 0)
+    {
+        metricsP->serverArray = (iowa_metrics_server_t *)iowa_system_malloc(metricsP->serverCount * sizeof(iowa_metrics_server_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (metricsP->serverArray == NULL)
+        {
+            IOWA_LOG_ERROR_MALLOC(metricsP->serverCount * sizeof(iowa_metrics_server_t));
+            CRIT_SECTION_LEAVE(contextP);
+            iowa_system_free(metricsP->peerArray);
+            memset(metricsP, 0, sizeof(iowa_metrics_t));
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+
+        index = 0;
+        for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+        {
+            metricsP->serverArray[index].shortId = serverP->shortId;
+            metricsP->serverArray[index].counters = serverP->metrics;
+            index++;
+        }
+    }
+#endif
+
+    CRIT_SECTION_LEAVE(contextP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+void iowa_metrics_release(iowa_metrics_t *metricsP)
+{
+    if (metricsP == NULL)
+    {
+        return;
+    }
+
+    iowa_system_free(metricsP->peerArray);
+    iowa_system_free(metricsP->serverArray);
+    metricsP->peerArray = NULL;
+    metricsP->peerCount = 0;
+    metricsP->serverArray = NULL;
+    metricsP->serverCount = 0;
+}
+
+#endif // IOWA_METRICS_SUPPORT
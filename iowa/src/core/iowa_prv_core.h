@@ -70,6 +70,10 @@ extern "C" {
 
 #define MSISDN_MAX_LENGTH 15
 
+#if defined(IOWA_COMMAND_QUEUE_SUPPORT) && !defined(IOWA_COMMAND_QUEUE_SIZE)
+#define IOWA_COMMAND_QUEUE_SIZE 64
+#endif
+
 // Internal only data types
 #define INTERNAL_LWM2M_TYPE_BLOCK  (uint8_t)100    // used as a flag
 #define IOWA_LWM2M_TYPE_URI_ONLY   10
@@ -112,6 +116,58 @@ typedef struct _iowa_context_callback_t
     void                            *userData;
 } iowa_context_callback_t;
 
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+typedef enum
+{
+    CORE_COMMAND_IPSO_VALUE = 0,  // iowa_client_IPSO_post_value()
+    CORE_COMMAND_RESOURCE_CHANGED // iowa_client_post_resource_changed()
+} core_command_type_t;
+
+// An update posted by an application thread, applied by iowa_step().
+typedef struct
+{
+    core_command_type_t type;
+    union
+    {
+        struct
+        {
+            iowa_sensor_t id;
+            float         value;
+        } ipso;
+        struct
+        {
+            uint16_t objectId;
+            uint16_t instanceId;
+            uint16_t resourceId;
+        } resource;
+    } u;
+} core_command_t;
+
+// A slot of the command queue. The sequence tells the producers and the consumer whether the slot is free or holds a command.
+typedef struct
+{
+    uint32_t       sequence;
+    core_command_t command;
+} core_command_cell_t;
+
+// Bounded multiple producers single consumer queue.
+// The producer fields and the consumer fields are separated by the cell array to limit the false sharing.
+typedef struct
+{
+    uint32_t            enqueuePosition; // next slot to claim, shared by the producers
+    uint32_t            isWaiting;       // set while iowa_step() may wait in the select
+    uint32_t            postCount;
+    uint32_t            retryCount;
+    uint32_t            fullCount;
+    core_command_cell_t cellArray[IOWA_COMMAND_QUEUE_SIZE];
+    uint32_t            dequeuePosition; // only used by iowa_step()
+    uint32_t            appliedCount;
+    uint32_t            failedCount;
+    uint32_t            batchCount;
+    uint32_t            maxBatchSize;
+} core_command_queue_t;
+#endif
+
 struct _iowa_context_t
 {
     lwm2m_context_t               *lwm2mContextP;
@@ -120,12 +176,21 @@ struct _iowa_context_t
     iowa_security_context_t        securityContextP;
     int32_t                        currentTime;
     int32_t                        timeout;
-    iowa_timer_t                  *timerList;
+    iowa_timer_t                 **timerHeap;
+    size_t                         timerCount;
+    size_t                         timerHeapSize;
 #ifdef LWM2M_CLIENT_MODE
     iowa_event_callback_t          eventCb;
 #endif
     volatile uint16_t             action;
     void                          *userData;
+#ifdef IOWA_METRICS_SUPPORT
+    iowa_metrics_histogram_t       metricsPhaseArray[IOWA_METRICS_PHASE_COUNT];
+    iowa_metrics_histogram_t       metricsDataCallback;
+#endif
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+    core_command_queue_t           commandQueue;
+#endif
 };
 
 /************************************************
@@ -192,6 +257,145 @@ iowa_buffer_t coreBufferMerge(iowa_linked_buffer_t *bufferList);
 // - bufferP: iowa_buffer_t to clear.
 void coreBufferClear(iowa_buffer_t *bufferP);
 
+// Implemented in iowa_memory_pool.c
+
+#ifdef IOWA_MEMORY_POOL_SUPPORT
+
+// Allocate an object from a memory pool.
+// Returned value: the object or NULL in case of error. The object is not initialized.
+// Parameters:
+// - pool: the memory pool. Can not be IOWA_MEMORY_POOL_REQUEST_ARENA.
+// - size: the size of the object. It must be the same for all the objects of a pool.
+void * corePoolAlloc(iowa_memory_pool_t pool, size_t size);
+
+// Release an object to its memory pool.
+// Returned value: none.
+// Parameters:
+// - pool: the memory pool the object was allocated from.
+// - objectP: the object. This can be nil.
+void corePoolFree(iowa_memory_pool_t pool, void *objectP);
+
+// Free the slabs of the memory pools which have no object in use and the request arena.
+// Returned value: none.
+void corePoolRelease(void);
+
+// Start a request: until coreArenaEnd(), coreArenaAlloc() allocates in the request arena.
+// Returned value: none.
+void coreArenaBegin(void);
+
+// End a request: the memory allocated in the request arena is released.
+// Returned value: none.
+// Note: the arena is enlarged to the memory required by the request if it was not large enough.
+void coreArenaEnd(void);
+
+// Allocate memory in the request arena, or with iowa_system_malloc() outside of a request or if the arena is full.
+// Returned value: the allocated memory or NULL in case of error.
+// Parameters:
+// - size: the size to allocate.
+void * coreArenaAlloc(size_t size);
+
+// Free memory allocated by coreArenaAlloc().
+// Returned value: none.
+// Parameters:
+// - pointer: the memory to free. This can be nil.
+void coreArenaFree(void *pointer);
+
+#define CORE_POOL_ALLOC(P, S)   corePoolAlloc((P), (S))
+#define CORE_POOL_FREE(P, O)    corePoolFree((P), (O))
+#define CORE_POOL_RELEASE()     corePoolRelease()
+#define CORE_ARENA_BEGIN()      coreArenaBegin()
+#define CORE_ARENA_END()        coreArenaEnd()
+#define CORE_ARENA_ALLOC(S)     coreArenaAlloc(S)
+#define CORE_ARENA_FREE(O)      coreArenaFree(O)
+
+#else
+
+#define CORE_POOL_ALLOC(P, S)   iowa_system_malloc(S)
+#define CORE_POOL_FREE(P, O)    iowa_system_free(O)
+#define CORE_POOL_RELEASE()
+#define CORE_ARENA_BEGIN()
+#define CORE_ARENA_END()
+#define CORE_ARENA_ALLOC(S)     iowa_system_malloc(S)
+#define CORE_ARENA_FREE(O)      iowa_system_free(O)
+
+#endif // IOWA_MEMORY_POOL_SUPPORT
+
+// Implemented in iowa_metrics.c
+
+#ifdef IOWA_METRICS_SUPPORT
+
+// Record a duration in a latency histogram.
+// Returned value: the current time in microseconds, to be used as the start time of the next duration.
+// Parameters:
+// - histogramP: the histogram.
+// - startTime: the start time of the duration as returned by iowa_system_gettime_us().
+uint32_t coreMetricsRecord(iowa_metrics_histogram_t *histogramP, uint32_t startTime);
+
+#define CORE_METRICS_START(T)       (T) = iowa_system_gettime_us()
+#define CORE_METRICS_RECORD(H, T)   (T) = coreMetricsRecord(&(H), (T))
+#define CORE_METRICS_INCREMENT(C)   (C)++
+#define CORE_METRICS_ADD(C, V)      (C) += (V)
+
+#else
+
+#define CORE_METRICS_START(T)
+#define CORE_METRICS_RECORD(H, T)
+#define CORE_METRICS_INCREMENT(C)
+#define CORE_METRICS_ADD(C, V)
+
+#endif // IOWA_METRICS_SUPPORT
+
+// Implemented in iowa_command_queue.c
+
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+
+// Initialize the command queue of a context.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+void coreCommandQueueInit(iowa_context_t contextP);
+
+// Post a command in the queue without locking. Can be called from any thread.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or IOWA_COAP_503_SERVICE_UNAVAILABLE if the queue is full.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - commandP: the command to copy in the queue.
+iowa_status_t coreCommandQueuePost(iowa_context_t contextP,
+                                   const core_command_t *commandP);
+
+// Apply the commands present in the queue. Called once per iteration of iowa_step().
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+void coreCommandQueueStep(iowa_context_t contextP);
+
+#ifdef IOWA_THREAD_SUPPORT
+
+// Tell the producers that iowa_step() is about to wait in the select and must be interrupted by the next command posted.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+// Note: sets the timeout to zero if commands were posted since coreCommandQueueStep().
+void coreCommandQueueSelectStart(iowa_context_t contextP);
+
+// Tell the producers that iowa_step() does not wait in the select anymore.
+// Returned value: none.
+// Parameters:
+// - contextP: returned by iowa_init().
+void coreCommandQueueSelectStop(iowa_context_t contextP);
+
+#define CORE_COMMAND_QUEUE_SELECT_START(C)  coreCommandQueueSelectStart(C)
+#define CORE_COMMAND_QUEUE_SELECT_STOP(C)   coreCommandQueueSelectStop(C)
+
+#endif // IOWA_THREAD_SUPPORT
+
+#endif // IOWA_COMMAND_QUEUE_SUPPORT
+
+#ifndef CORE_COMMAND_QUEUE_SELECT_START
+#define CORE_COMMAND_QUEUE_SELECT_START(C)
+#define CORE_COMMAND_QUEUE_SELECT_STOP(C)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
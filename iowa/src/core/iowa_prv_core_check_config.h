@@ -81,6 +81,14 @@ extern "C" {
 #error "LWM2M_BOOTSTRAP must be only used when the LwM2M role is client."
 #endif
 
+#if defined(IOWA_COMMAND_QUEUE_SUPPORT) && !defined(LWM2M_CLIENT_MODE)
+#error "IOWA_COMMAND_QUEUE_SUPPORT must be only used when the LwM2M role is client."
+#endif
+
+#if defined(IOWA_COMMAND_QUEUE_SUPPORT) && (IOWA_COMMAND_QUEUE_SIZE < 2 || (IOWA_COMMAND_QUEUE_SIZE & (IOWA_COMMAND_QUEUE_SIZE - 1)) != 0)
+#error "IOWA_COMMAND_QUEUE_SIZE must be a power of two."
+#endif
+
 #if defined(LWM2M_BOOTSTRAP_PACK_SUPPORT) && !defined(LWM2M_BOOTSTRAP) && !defined(LWM2M_BOOTSTRAP_SERVER_MODE)
 #error "LWM2M_BOOTSTRAP_PACK_SUPPORT requires LWM2M_BOOTSTRAP or LWM2M_BOOTSTRAP_SERVER_MODE"
 #endif
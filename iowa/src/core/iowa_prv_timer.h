@@ -37,12 +37,14 @@ extern "C" {
 // userData: the data passed to coreTimerNew.
 typedef void (*timer_callback_t)(iowa_context_t contextP, void *userData);
 
+// Timers are stored in a binary min-heap ordered by execution time.
+// heapIndex is the position of the timer in the heap, used to cancel or reschedule it without searching.
 typedef struct _iowa_timer_t
 {
-    struct _iowa_timer_t *nextP;
-    int32_t               executionTime;
-    timer_callback_t      callback;
-    void                 *userData;
+    size_t           heapIndex;
+    int32_t          executionTime;
+    timer_callback_t callback;
+    void            *userData;
 } iowa_timer_t;
 
 /**************************************************************
@@ -73,7 +75,7 @@ void coreTimerDelete(iowa_context_t contextP, iowa_timer_t *timerP);
 // - delay: new timer's delay.
 iowa_status_t coreTimerReset(iowa_context_t contextP, iowa_timer_t *timerP, int32_t delay);
 
-// State Machine of iowa timers. Check all timers in the iowa context and call the corresponding callback when timer's delay has expired.
+// State Machine of iowa timers. Call the callback of the timers whose delay has expired and update the global timeout with the next deadline.
 // Parameters:
 // - contextP: as returned by iowa_init().
 void coreTimerStep(iowa_context_t contextP);
@@ -23,6 +23,87 @@
 #include "iowa_prv_core_internals.h"
 #include "iowa_prv_lwm2m_internals.h"
 
+#define PRV_TIMER_HEAP_INITIAL_SIZE 8
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+static void prv_heapSet(iowa_context_t contextP,
+                        size_t index,
+                        iowa_timer_t *timerP)
+{
+    contextP->timerHeap[index] = timerP;
+    timerP->heapIndex = index;
+}
+
+static void prv_heapSiftUp(iowa_context_t contextP,
+                           size_t index)
+{
+    iowa_timer_t *timerP;
+
+    timerP = contextP->timerHeap[index];
+    while (index > 0)
+    {
+        size_t parentIndex;
+
+        parentIndex = (index - 1) / 2;
+        if (contextP->timerHeap[parentIndex]->executionTime <= timerP->executionTime)
+        {
+            break;
+        }
+        prv_heapSet(contextP, index, contextP->timerHeap[parentIndex]);
+        index = parentIndex;
+    }
+    prv_heapSet(contextP, index, timerP);
+}
+
+static void prv_heapSiftDown(iowa_context_t contextP,
+                             size_t index)
+{
+    iowa_timer_t *timerP;
+
+    timerP = contextP->timerHeap[index];
+    while (2 * index + 1 < contextP->timerCount)
+    {
+        size_t childIndex;
+
+        childIndex = 2 * index + 1;
+        if (childIndex + 1 < contextP->timerCount
+            && contextP->timerHeap[childIndex + 1]->executionTime < contextP->timerHeap[childIndex]->executionTime)
+        {
+            childIndex++;
+        }
+        if (timerP->executionTime <= contextP->timerHeap[childIndex]->executionTime)
+        {
+            break;
+        }
+        prv_heapSet(contextP, index, contextP->timerHeap[childIndex]);
+        index = childIndex;
+    }
+    prv_heapSet(contextP, index, timerP);
+}
+
+static void prv_heapRemove(iowa_context_t contextP,
+                           iowa_timer_t *timerP)
+{
+    size_t index;
+
+    index = timerP->heapIndex;
+    contextP->timerCount--;
+    if (index != contextP->timerCount)
+    {
+        iowa_timer_t *lastTimerP;
+
+        // Move the last timer in the hole and restore the heap property
+        lastTimerP = contextP->timerHeap[contextP->timerCount];
+        prv_heapSet(contextP, index, lastTimerP);
+        prv_heapSiftUp(contextP, index);
+        prv_heapSiftDown(contextP, lastTimerP->heapIndex);
+    }
+    contextP->timerHeap[contextP->timerCount] = NULL;
+}
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -51,7 +132,38 @@ iowa_timer_t *coreTimerNew(iowa_context_t contextP,
     }
 #endif
 
-    timerP = (iowa_timer_t *)iowa_system_malloc(sizeof(iowa_timer_t));
+    if (contextP->currentTime + delay < contextP->currentTime)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_BASE, "Integer overflow.");
+        return NULL;
+    }
+
+    if (contextP->timerCount == contextP->timerHeapSize)
+    {
+        iowa_timer_t **newHeap;
+        size_t newSize;
+
+        if (contextP->timerHeapSize == 0)
+        {
+            newSize = PRV_TIMER_HEAP_INITIAL_SIZE;
+        }
+        else
+        {
+            newSize = 2 * contextP->timerHeapSize;
+        }
+
+        newHeap = (iowa_timer_t **)utilsRealloc(contextP->timerHeap, contextP->timerHeapSize * sizeof(iowa_timer_t *), newSize * sizeof(iowa_timer_t *));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (newHeap == NULL)
+        {
+            return NULL;
+        }
+#endif
+        contextP->timerHeap = newHeap;
+        contextP->timerHeapSize = newSize;
+    }
+
+    timerP = (iowa_timer_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_TIMER, sizeof(iowa_timer_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (timerP == NULL)
     {
@@ -64,14 +176,10 @@ iowa_timer_t *coreTimerNew(iowa_context_t contextP,
     timerP->callback = callback;
     timerP->userData = userData;
     timerP->executionTime = contextP->currentTime + delay;
-    if (timerP->executionTime < contextP->currentTime)
-    {
-        IOWA_LOG_WARNING(IOWA_PART_BASE, "Integer overflow.");
-        iowa_system_free(timerP);
-        return NULL;
-    }
 
-    contextP->timerList = (iowa_timer_t *)IOWA_UTILS_LIST_ADD(contextP->timerList, timerP);
+    contextP->timerHeap[contextP->timerCount] = timerP;
+    contextP->timerCount++;
+    prv_heapSiftUp(contextP, contextP->timerCount - 1);
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with iowa_timer_t: %p, execution time: %ds.", timerP, timerP->executionTime);
 
@@ -85,9 +193,9 @@ void coreTimerDelete(iowa_context_t contextP,
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering with iowa_timer_t %p.", timerP);
 
-    contextP->timerList = (iowa_timer_t *)IOWA_UTILS_LIST_REMOVE(contextP->timerList, timerP);
+    prv_heapRemove(contextP, timerP);
 
-    iowa_system_free(timerP);
+    CORE_POOL_FREE(IOWA_MEMORY_POOL_TIMER, timerP);
 
     IOWA_LOG_TRACE(IOWA_PART_BASE, "Exiting.");
 }
@@ -118,6 +226,8 @@ iowa_status_t coreTimerReset(iowa_context_t contextP,
     }
 
     timerP->executionTime = targetTime;
+    prv_heapSiftUp(contextP, timerP->heapIndex);
+    prv_heapSiftDown(contextP, timerP->heapIndex);
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with execution time: %ds.", timerP->executionTime);
 
@@ -127,54 +237,38 @@ iowa_status_t coreTimerReset(iowa_context_t contextP,
 void coreTimerStep(iowa_context_t contextP)
 {
     // WARNING: This function is called in a critical section
-    iowa_timer_t *timerP;
-    iowa_timer_t *parentTimerP;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Entering currentTime: %ds, timeoutP: %ds.", contextP->currentTime, contextP->timeout);
 
-    timerP = contextP->timerList;
-    parentTimerP = NULL;
-    while (timerP != NULL)
+    while (contextP->timerCount != 0
+           && contextP->timerHeap[0]->executionTime <= contextP->currentTime)
     {
-        iowa_timer_t *nextTimerP;
+        iowa_timer_t *timerP;
 
-        nextTimerP = timerP->nextP;
+        timerP = contextP->timerHeap[0];
 
-        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Execution time: %ds.", timerP->executionTime);
+        // Remove the timer before calling the callback as the callback may add or delete other timers.
+        prv_heapRemove(contextP, timerP);
 
-        if (timerP->executionTime <= contextP->currentTime)
-        {
-            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Calling callback for iowa_timer_t %p.", timerP);
-            timerP->callback(contextP, timerP->userData);
-            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Callback for iowa_timer_t %p returned.", timerP);
-
-            if (parentTimerP == NULL)
-            {
-                contextP->timerList = timerP->nextP;
-            }
-            else
-            {
-                parentTimerP->nextP = timerP->nextP;
-            }
-
-            iowa_system_free(timerP);
-        }
-        else
-        {
-            int32_t delay;
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Calling callback for iowa_timer_t %p.", timerP);
+        timerP->callback(contextP, timerP->userData);
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Callback for iowa_timer_t %p returned.", timerP);
+
+        CORE_POOL_FREE(IOWA_MEMORY_POOL_TIMER, timerP);
+    }
 
-            delay = timerP->executionTime - contextP->currentTime;
-            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Execution delay for iowa_timer_t %p is %ds.", timerP, delay);
+    if (contextP->timerCount != 0)
+    {
+        int32_t delay;
 
-            if (delay < contextP->timeout)
-            {
-                IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Updating global timeout from %ds to %ds.", contextP->timeout, delay);
-                contextP->timeout = delay;
-            }
+        delay = contextP->timerHeap[0]->executionTime - contextP->currentTime;
+        IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Next execution delay is %ds for iowa_timer_t %p.", delay, contextP->timerHeap[0]);
 
-            parentTimerP = timerP;
+        if (delay < contextP->timeout)
+        {
+            IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Updating global timeout from %ds to %ds.", contextP->timeout, delay);
+            contextP->timeout = delay;
         }
-        timerP = nextTimerP;
     }
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_BASE, "Exiting with final timeoutP: %ds.", contextP->timeout);
@@ -183,7 +277,16 @@ void coreTimerStep(iowa_context_t contextP)
 void coreTimerClose(iowa_context_t contextP)
 {
     // WARNING: This function is called in a critical section
+    size_t index;
+
     IOWA_LOG_TRACE(IOWA_PART_BASE, "Entering.");
 
-    IOWA_UTILS_LIST_FREE(contextP->timerList, iowa_system_free);
+    for (index = 0; index < contextP->timerCount; index++)
+    {
+        CORE_POOL_FREE(IOWA_MEMORY_POOL_TIMER, contextP->timerHeap[index]);
+    }
+    iowa_system_free(contextP->timerHeap);
+    contextP->timerHeap = NULL;
+    contextP->timerCount = 0;
+    contextP->timerHeapSize = 0;
 }
@@ -27,3 +27,1002 @@
 #include "iowa_prv_data_internals.h"
 #include <float.h>
 
+#if defined(LWM2M_SUPPORT_CBOR) || defined(LWM2M_SUPPORT_SENML_CBOR) || defined(LWM2M_SUPPORT_LWM2M_CBOR)
+
+#define PRV_CBOR_SIMPLE_VALUE_FALSE     20
+#define PRV_CBOR_SIMPLE_VALUE_TRUE      21
+#define PRV_CBOR_SIMPLE_VALUE_NULL      22
+#define PRV_CBOR_SIMPLE_VALUE_UNDEFINED 23
+
+#define PRV_CBOR_TAG_EPOCH_TIME         1
+
+#define PRV_CBOR_HALF_FLOAT_SIZE        3
+#define PRV_CBOR_FLOAT_SIZE             5
+#define PRV_CBOR_DOUBLE_SIZE            9
+
+#define PRV_CBOR_BREAK_BYTE             0xFF
+
+// Maximum nesting of arrays, maps and tags accepted when skipping an item
+#define PRV_CBOR_MAX_NESTING            16
+
+#define PRV_OBJECT_LINK_TEXT_MAX_LEN    (size_t)11 // 65535:65535
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Write the head of a CBOR item.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - majorType: major type of the item.
+// - addInfo: additional information of the item.
+// - value, valueLength: argument of the item, written on valueLength bytes in network byte order.
+// - bufferP: buffer in which the head will be added. If nil, only bufferIndexP is updated.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: IN/OUT. current buffer index.
+static int8_t prv_addHead(major_type_t majorType,
+                          uint8_t addInfo,
+                          uint64_t value,
+                          size_t valueLength,
+                          uint8_t *bufferP,
+                          size_t bufferLength,
+                          size_t *bufferIndexP)
+{
+    size_t i;
+
+    if (bufferP != NULL)
+    {
+        if (*bufferIndexP + 1 + valueLength > bufferLength)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Buffer too small (%u bytes) to add %u bytes at index %u.", bufferLength, 1 + valueLength, *bufferIndexP);
+            return CBOR_ERROR;
+        }
+
+        bufferP[*bufferIndexP] = CBOR_GET_ITEM_INITIAL_BYTE(majorType, addInfo);
+        for (i = 0; i < valueLength; i++)
+        {
+            bufferP[*bufferIndexP + valueLength - i] = (uint8_t)(value >> (8 * i));
+        }
+    }
+
+    *bufferIndexP += 1 + valueLength;
+
+    return CBOR_NO_ERROR;
+}
+
+// Convert a single precision floating point number to a half precision one.
+// Returned value: true if the number can be represented as a half float without loss, false otherwise.
+// Parameters:
+// - value: the number to convert.
+// - halfFloatP: OUT. the 16 bits of the half float.
+static bool prv_floatToHalfFloat(float value,
+                                 uint16_t *halfFloatP)
+{
+    uint32_t bits;
+    uint16_t sign;
+    int32_t exponent;
+    uint32_t mantissa;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    sign = (uint16_t)((bits >> 16) & 0x8000U);
+    exponent = (int32_t)((bits >> 23) & 0xFFU);
+    mantissa = bits & 0x007FFFFFU;
+
+    if (exponent == 0xFF)
+    {
+        // Infinity or NaN
+        *halfFloatP = (uint16_t)(sign | 0x7C00U | (mantissa != 0 ? 0x0200U : 0));
+        return true;
+    }
+
+    if (exponent == 0 && mantissa == 0)
+    {
+        *halfFloatP = sign;
+        return true;
+    }
+
+    exponent -= 127;
+
+    if (exponent >= -14 && exponent <= 15)
+    {
+        if ((mantissa & 0x1FFFU) != 0)
+        {
+            return false;
+        }
+        *halfFloatP = (uint16_t)(sign | ((uint32_t)(exponent + 15) << 10) | (mantissa >> 13));
+        return true;
+    }
+
+    if (exponent >= -24 && exponent < -14)
+    {
+        uint32_t shift;
+
+        // Half float subnormal: value = significand * 2^-24
+        mantissa |= 0x00800000U;
+        shift = (uint32_t)(-1 - exponent);
+        if ((mantissa & ((1U << shift) - 1)) != 0)
+        {
+            return false;
+        }
+        *halfFloatP = (uint16_t)(sign | (mantissa >> shift));
+        return true;
+    }
+
+    return false;
+}
+
+// Read the argument of a CBOR item head.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - addInfo: additional information of the item.
+// - numberP: OUT. the argument.
+// - bufferP: the buffer.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: IN/OUT. current buffer index, pointing after the initial byte.
+static int8_t prv_getArgument(uint8_t addInfo,
+                              uint64_t *numberP,
+                              uint8_t *bufferP,
+                              size_t bufferLength,
+                              size_t *bufferIndexP)
+{
+    size_t length;
+    size_t i;
+
+    if (addInfo < CBOR_ADD_INFO_1_BYTE)
+    {
+        *numberP = addInfo;
+        return CBOR_NO_ERROR;
+    }
+
+    switch (addInfo)
+    {
+    case CBOR_ADD_INFO_1_BYTE:
+        length = CBOR_BYTE_1_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_2_BYTES:
+        length = CBOR_BYTE_2_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_4_BYTES:
+        length = CBOR_BYTE_4_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_8_BYTES:
+        length = CBOR_BYTE_8_SIZE;
+        break;
+
+    case CBOR_ADD_INFO_VALUE_BREAK:
+        *numberP = 0;
+        return CBOR_NO_ERROR;
+
+    default:
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Reserved additional information %u.", addInfo);
+        return CBOR_ERROR;
+    }
+
+    if (*bufferIndexP + length > bufferLength)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "Buffer is too short for the item argument.");
+        return CBOR_ERROR;
+    }
+
+    *numberP = 0;
+    for (i = 0; i < length; i++)
+    {
+        *numberP = (*numberP << 8) | bufferP[*bufferIndexP + i];
+    }
+    *bufferIndexP += length;
+
+    return CBOR_NO_ERROR;
+}
+
+// Skip an item whose head was already read.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - majorType, addInfo, number: the head of the item.
+// - bufferP: the buffer.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: IN/OUT. current buffer index, pointing after the head.
+// - nesting: current nesting level.
+static int8_t prv_skipItemContent(major_type_t majorType,
+                                  uint8_t addInfo,
+                                  uint64_t number,
+                                  uint8_t *bufferP,
+                                  size_t bufferLength,
+                                  size_t *bufferIndexP,
+                                  uint8_t nesting);
+
+static int8_t prv_skipItem(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP,
+                           uint8_t nesting)
+{
+    major_type_t majorType;
+    uint8_t addInfo;
+    uint64_t number;
+
+    majorType = cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, bufferIndexP);
+    if (majorType == CBOR_MAJOR_TYPE_NONE)
+    {
+        return CBOR_ERROR;
+    }
+
+    return prv_skipItemContent(majorType, addInfo, number, bufferP, bufferLength, bufferIndexP, nesting);
+}
+
+static int8_t prv_skipItemContent(major_type_t majorType,
+                                  uint8_t addInfo,
+                                  uint64_t number,
+                                  uint8_t *bufferP,
+                                  size_t bufferLength,
+                                  size_t *bufferIndexP,
+                                  uint8_t nesting)
+{
+    uint64_t i;
+
+    if (nesting >= PRV_CBOR_MAX_NESTING)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "CBOR items are nested too deeply.");
+        return CBOR_ERROR;
+    }
+
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+    case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA:
+        if (addInfo == CBOR_ADD_INFO_VALUE_BREAK)
+        {
+            IOWA_LOG_INFO(IOWA_PART_DATA, "Unexpected break.");
+            return CBOR_ERROR;
+        }
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_BYTE_STRING:
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+    {
+        size_t stringLength;
+
+        if (cborGetBufferToStringLength(majorType, addInfo, number, &stringLength, bufferP, bufferLength, *bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+        return cborPutBufferToString(majorType, addInfo, number, NULL, stringLength, bufferP, bufferLength, bufferIndexP);
+    }
+
+    case CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS:
+    case CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS:
+        if (addInfo == CBOR_ADD_INFO_VALUE_BREAK)
+        {
+            while (*bufferIndexP < bufferLength
+                   && bufferP[*bufferIndexP] != PRV_CBOR_BREAK_BYTE)
+            {
+                if (prv_skipItem(bufferP, bufferLength, bufferIndexP, (uint8_t)(nesting + 1)) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+            }
+            if (*bufferIndexP >= bufferLength)
+            {
+                IOWA_LOG_INFO(IOWA_PART_DATA, "Missing break.");
+                return CBOR_ERROR;
+            }
+            *bufferIndexP += 1;
+            return CBOR_NO_ERROR;
+        }
+
+        if (majorType == CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+        {
+            if (number > (bufferLength - *bufferIndexP) / 2)
+            {
+                IOWA_LOG_INFO(IOWA_PART_DATA, "Buffer is too short for the declared map size.");
+                return CBOR_ERROR;
+            }
+            number *= 2;
+        }
+        for (i = 0; i < number; i++)
+        {
+            if (prv_skipItem(bufferP, bufferLength, bufferIndexP, (uint8_t)(nesting + 1)) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+        return CBOR_NO_ERROR;
+
+    case CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC:
+        return prv_skipItem(bufferP, bufferLength, bufferIndexP, (uint8_t)(nesting + 1));
+
+    default:
+        return CBOR_ERROR;
+    }
+}
+
+/*************************************************************************************
+** Internal functions
+*************************************************************************************/
+
+size_t cborGetNumberToBufferLength(uint64_t number)
+{
+    size_t length;
+
+    length = 0;
+    (void)cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, number, NULL, 0, &length);
+
+    return length;
+}
+
+int8_t cborAddNumberToBuffer(major_type_t majorType,
+                             uint64_t number,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    if (number < CBOR_ADD_INFO_1_BYTE)
+    {
+        return prv_addHead(majorType, (uint8_t)number, 0, 0, bufferP, bufferLength, bufferIndexP);
+    }
+    if (number <= UINT8_MAX)
+    {
+        return prv_addHead(majorType, CBOR_ADD_INFO_1_BYTE, number, CBOR_BYTE_1_SIZE, bufferP, bufferLength, bufferIndexP);
+    }
+    if (number <= UINT16_MAX)
+    {
+        return prv_addHead(majorType, CBOR_ADD_INFO_2_BYTES, number, CBOR_BYTE_2_SIZE, bufferP, bufferLength, bufferIndexP);
+    }
+    if (number <= UINT32_MAX)
+    {
+        return prv_addHead(majorType, CBOR_ADD_INFO_4_BYTES, number, CBOR_BYTE_4_SIZE, bufferP, bufferLength, bufferIndexP);
+    }
+
+    return prv_addHead(majorType, CBOR_ADD_INFO_8_BYTES, number, CBOR_BYTE_8_SIZE, bufferP, bufferLength, bufferIndexP);
+}
+
+int8_t cborAddIntegerToBuffer(int64_t number,
+                              uint8_t *bufferP,
+                              size_t bufferLength,
+                              size_t *bufferIndexP)
+{
+    if (number >= 0)
+    {
+        return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, (uint64_t)number, bufferP, bufferLength, bufferIndexP);
+    }
+
+    // Negative integers are encoded as -1 - value
+    return cborAddNumberToBuffer(CBOR_MAJOR_TYPE_NEGATIVE_INTEGER, (uint64_t)(-(number + 1)), bufferP, bufferLength, bufferIndexP);
+}
+
+int8_t cborAddStringToBuffer(uint8_t *stringP,
+                             size_t stringSize,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP,
+                             bool isByteString)
+{
+    assert(stringP != NULL || stringSize == 0);
+
+    if (cborAddNumberToBuffer(isByteString ? CBOR_MAJOR_TYPE_BYTE_STRING : CBOR_MAJOR_TYPE_TEXT_STRING, stringSize, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    if (bufferP != NULL)
+    {
+        if (*bufferIndexP + stringSize > bufferLength)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Buffer too small (%u bytes) to add a string of %u bytes at index %u.", bufferLength, stringSize, *bufferIndexP);
+            return CBOR_ERROR;
+        }
+        if (stringSize != 0)
+        {
+            memcpy(bufferP + *bufferIndexP, stringP, stringSize);
+        }
+    }
+    *bufferIndexP += stringSize;
+
+    return CBOR_NO_ERROR;
+}
+
+size_t cborGetFloatToBufferLength(double number)
+{
+    size_t length;
+
+    length = 0;
+    (void)cborAddFloatToBuffer(number, NULL, 0, &length);
+
+    return length;
+}
+
+int8_t cborAddFloatToBuffer(double number,
+                            uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *bufferIndexP)
+{
+    float singleNumber;
+    uint16_t halfNumber;
+    bool isSingle;
+
+    // Use the shortest encoding which keeps the exact value
+    singleNumber = 0;
+    if (number - number != 0.0)
+    {
+        // Infinity or NaN
+        singleNumber = (float)number;
+        isSingle = true;
+    }
+    else if (number >= 0.0 - (double)FLT_MAX
+             && number <= (double)FLT_MAX)
+    {
+        singleNumber = (float)number;
+        isSingle = ((double)singleNumber == number);
+    }
+    else
+    {
+        isSingle = false;
+    }
+
+    if (isSingle == true)
+    {
+        uint32_t bits;
+
+        if (prv_floatToHalfFloat(singleNumber, &halfNumber) == true)
+        {
+            return prv_addHead(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_2_BYTES, halfNumber, CBOR_BYTE_2_SIZE, bufferP, bufferLength, bufferIndexP);
+        }
+
+        memcpy(&bits, &singleNumber, sizeof(bits));
+
+        return prv_addHead(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_4_BYTES, bits, CBOR_BYTE_4_SIZE, bufferP, bufferLength, bufferIndexP);
+    }
+    else
+    {
+        uint64_t bits;
+
+        memcpy(&bits, &number, sizeof(bits));
+
+        return prv_addHead(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_8_BYTES, bits, CBOR_BYTE_8_SIZE, bufferP, bufferLength, bufferIndexP);
+    }
+}
+
+size_t cborGetDataToBufferLength(iowa_lwm2m_data_t *dataP)
+{
+    size_t length;
+
+    length = 0;
+    if (cborAddDataToBuffer(dataP, NULL, 0, &length) != CBOR_NO_ERROR)
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+int8_t cborAddDataToBuffer(iowa_lwm2m_data_t *dataP,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    assert(dataP != NULL);
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+        return cborAddStringToBuffer(dataP->value.asBuffer.buffer, dataP->value.asBuffer.length, bufferP, bufferLength, bufferIndexP, false);
+
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        return cborAddStringToBuffer(dataP->value.asBuffer.buffer, dataP->value.asBuffer.length, bufferP, bufferLength, bufferIndexP, true);
+
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        if (dataP->value.asInteger < 0)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsigned integer value has a negative value: %d", dataP->value.asInteger);
+            return CBOR_ERROR;
+        }
+        // Fall through
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+        return cborAddIntegerToBuffer(dataP->value.asInteger, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        return cborAddFloatToBuffer(dataP->value.asFloat, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        return prv_addHead(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, dataP->value.asBoolean ? PRV_CBOR_SIMPLE_VALUE_TRUE : PRV_CBOR_SIMPLE_VALUE_FALSE, 0, 0, bufferP, bufferLength, bufferIndexP);
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+    {
+        uint8_t stringBuffer[PRV_OBJECT_LINK_TEXT_MAX_LEN];
+        size_t stringLength;
+
+        stringLength = dataUtilsObjectLinkToBuffer(dataP, stringBuffer, PRV_OBJECT_LINK_TEXT_MAX_LEN);
+        if (stringLength == 0)
+        {
+            return CBOR_ERROR;
+        }
+        return cborAddStringToBuffer(stringBuffer, stringLength, bufferP, bufferLength, bufferIndexP, false);
+    }
+
+    case IOWA_LWM2M_TYPE_NULL:
+        return prv_addHead(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, PRV_CBOR_SIMPLE_VALUE_NULL, 0, 0, bufferP, bufferLength, bufferIndexP);
+
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsupported data type: %s.", STR_LWM2M_TYPE(dataP->type));
+        return CBOR_ERROR;
+    }
+}
+
+major_type_t cborPutBufferToNumber(uint64_t *numberP,
+                                   uint8_t *addInfoP,
+                                   uint8_t *bufferP,
+                                   size_t bufferLength,
+                                   size_t *bufferIndexP)
+{
+    major_type_t majorType;
+    uint8_t addInfo;
+
+    assert(numberP != NULL);
+    assert(bufferIndexP != NULL);
+
+    if (*bufferIndexP >= bufferLength)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "Buffer is too short.");
+        return CBOR_MAJOR_TYPE_NONE;
+    }
+
+    majorType = (major_type_t)((bufferP[*bufferIndexP] & CBOR_MAJOR_TYPE_MASK) >> CBOR_MAJOR_TYPE_BIT_SHIFT);
+    addInfo = (uint8_t)(bufferP[*bufferIndexP] & CBOR_ADD_INFO_MASK);
+    *bufferIndexP += 1;
+
+    if (addInfo == CBOR_ADD_INFO_VALUE_BREAK)
+    {
+        switch (majorType)
+        {
+        case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+        case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+        case CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC:
+            IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Major type %d can not have an indefinite length.", majorType);
+            return CBOR_MAJOR_TYPE_NONE;
+
+        default:
+            break;
+        }
+    }
+
+    if (prv_getArgument(addInfo, numberP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_MAJOR_TYPE_NONE;
+    }
+
+    if (addInfoP != NULL)
+    {
+        *addInfoP = addInfo;
+    }
+
+    return majorType;
+}
+
+int8_t cborSkipItem(uint8_t *bufferP,
+                    size_t bufferLength,
+                    size_t *bufferIndexP)
+{
+    return prv_skipItem(bufferP, bufferLength, bufferIndexP, 0);
+}
+
+int8_t cborGetBufferToStringLength(major_type_t majorType,
+                                   uint8_t addInfo,
+                                   uint64_t number,
+                                   size_t *stringLengthP,
+                                   uint8_t *bufferP,
+                                   size_t bufferLength,
+                                   size_t bufferIndex)
+{
+    if (addInfo != CBOR_ADD_INFO_VALUE_BREAK)
+    {
+        if (number > bufferLength - bufferIndex)
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Buffer is too short for the declared string length (%u bytes).", number);
+            return CBOR_ERROR;
+        }
+        *stringLengthP = (size_t)number;
+
+        return CBOR_NO_ERROR;
+    }
+
+    // Indefinite length string: sum the length of the chunks
+    *stringLengthP = 0;
+    while (bufferIndex < bufferLength
+           && bufferP[bufferIndex] != PRV_CBOR_BREAK_BYTE)
+    {
+        uint8_t chunkAddInfo;
+
+        if (cborPutBufferToNumber(&number, &chunkAddInfo, bufferP, bufferLength, &bufferIndex) != majorType
+            || chunkAddInfo == CBOR_ADD_INFO_VALUE_BREAK
+            || number > bufferLength - bufferIndex)
+        {
+            IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid chunk in indefinite length string.");
+            return CBOR_ERROR;
+        }
+        *stringLengthP += (size_t)number;
+        bufferIndex += (size_t)number;
+    }
+
+    if (bufferIndex >= bufferLength)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "Missing break.");
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborPutBufferToString(major_type_t majorType,
+                             uint8_t addInfo,
+                             uint64_t number,
+                             uint8_t *stringP,
+                             size_t stringLength,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    size_t stringIndex;
+
+    (void)majorType;
+
+    if (addInfo != CBOR_ADD_INFO_VALUE_BREAK)
+    {
+        if (stringP != NULL
+            && stringLength != 0)
+        {
+            memcpy(stringP, bufferP + *bufferIndexP, stringLength);
+        }
+        *bufferIndexP += stringLength;
+
+        return CBOR_NO_ERROR;
+    }
+
+    // The chunks were already checked by cborGetBufferToStringLength()
+    stringIndex = 0;
+    while (bufferP[*bufferIndexP] != PRV_CBOR_BREAK_BYTE)
+    {
+        (void)cborPutBufferToNumber(&number, NULL, bufferP, bufferLength, bufferIndexP);
+        if (stringP != NULL
+            && number != 0)
+        {
+            memcpy(stringP + stringIndex, bufferP + *bufferIndexP, (size_t)number);
+        }
+        stringIndex += (size_t)number;
+        *bufferIndexP += (size_t)number;
+    }
+    *bufferIndexP += 1;
+
+    assert(stringIndex == stringLength);
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborGetValueFromFloatMajorType(uint8_t addInfo,
+                                      uint64_t number,
+                                      iowa_lwm2m_data_t *dataP)
+{
+    switch (addInfo)
+    {
+    case PRV_CBOR_SIMPLE_VALUE_FALSE:
+        dataP->type = IOWA_LWM2M_TYPE_BOOLEAN;
+        dataP->value.asBoolean = false;
+        break;
+
+    case PRV_CBOR_SIMPLE_VALUE_TRUE:
+        dataP->type = IOWA_LWM2M_TYPE_BOOLEAN;
+        dataP->value.asBoolean = true;
+        break;
+
+    case PRV_CBOR_SIMPLE_VALUE_NULL:
+    case PRV_CBOR_SIMPLE_VALUE_UNDEFINED:
+        dataP->type = IOWA_LWM2M_TYPE_NULL;
+        break;
+
+    case CBOR_ADD_INFO_2_BYTES:
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        dataP->value.asFloat = (double)dataUtilsConvertHalfFloatToFloat((uint16_t)number);
+        break;
+
+    case CBOR_ADD_INFO_4_BYTES:
+    {
+        uint32_t bits;
+        float value;
+
+        bits = (uint32_t)number;
+        memcpy(&value, &bits, sizeof(value));
+
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        dataP->value.asFloat = (double)value;
+        break;
+    }
+
+    case CBOR_ADD_INFO_8_BYTES:
+        dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+        memcpy(&dataP->value.asFloat, &number, sizeof(dataP->value.asFloat));
+        break;
+
+    default:
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Unsupported simple value (additional information: %u).", addInfo);
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborHandleDecimalFraction(iowa_lwm2m_data_t *dataP,
+                                 uint8_t *bufferP,
+                                 size_t bufferLength,
+                                 size_t *bufferIndexP)
+{
+    uint64_t number;
+    uint8_t addInfo;
+    int64_t exponent;
+    int64_t mantissa;
+    major_type_t majorType;
+    uint8_t i;
+
+    if (cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, bufferIndexP) != CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS
+        || number != CBOR_DECIMAL_FRAC_ARRAY_LENGTH
+        || addInfo == CBOR_ADD_INFO_VALUE_BREAK)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "Decimal fraction is not an array of two items.");
+        return CBOR_ERROR;
+    }
+
+    exponent = 0;
+    mantissa = 0;
+    for (i = 0; i < CBOR_DECIMAL_FRAC_ARRAY_LENGTH; i++)
+    {
+        int64_t value;
+
+        majorType = cborPutBufferToNumber(&number, NULL, bufferP, bufferLength, bufferIndexP);
+        if (majorType != CBOR_MAJOR_TYPE_NONE
+            && number > INT64_MAX)
+        {
+            return CBOR_ERROR;
+        }
+        switch (majorType)
+        {
+        case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+            value = (int64_t)number;
+            break;
+
+        case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+            value = -1 - (int64_t)number;
+            break;
+
+        default:
+            IOWA_LOG_INFO(IOWA_PART_DATA, "Decimal fraction items must be integers.");
+            return CBOR_ERROR;
+        }
+
+        if (i == 0)
+        {
+            exponent = value;
+        }
+        else
+        {
+            mantissa = value;
+        }
+    }
+
+    dataP->type = IOWA_LWM2M_TYPE_FLOAT;
+    if (exponent < 0)
+    {
+        dataP->value.asFloat = (double)mantissa / dataUtilsPower(10, -exponent);
+    }
+    else
+    {
+        dataP->value.asFloat = (double)mantissa * dataUtilsPower(10, exponent);
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+int8_t cborPutBufferToData(major_type_t majorType,
+                           uint8_t addInfo,
+                           uint64_t number,
+                           iowa_lwm2m_data_t *dataP,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP)
+{
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+        if (number > INT64_MAX)
+        {
+            IOWA_LOG_INFO(IOWA_PART_DATA, "Unsigned integer is too large.");
+            return CBOR_ERROR;
+        }
+        dataP->type = IOWA_LWM2M_TYPE_UNSIGNED_INTEGER;
+        dataP->value.asInteger = (int64_t)number;
+        break;
+
+    case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+        if (number > INT64_MAX)
+        {
+            IOWA_LOG_INFO(IOWA_PART_DATA, "Negative integer is too large.");
+            return CBOR_ERROR;
+        }
+        dataP->type = IOWA_LWM2M_TYPE_INTEGER;
+        dataP->value.asInteger = -1 - (int64_t)number;
+        break;
+
+    case CBOR_MAJOR_TYPE_BYTE_STRING:
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+    {
+        size_t stringLength;
+
+        if (cborGetBufferToStringLength(majorType, addInfo, number, &stringLength, bufferP, bufferLength, *bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+
+        dataP->type = (majorType == CBOR_MAJOR_TYPE_BYTE_STRING) ? IOWA_LWM2M_TYPE_OPAQUE : IOWA_LWM2M_TYPE_STRING;
+        dataP->value.asBuffer.length = stringLength;
+        dataP->value.asBuffer.buffer = NULL;
+        if (stringLength != 0)
+        {
+            dataP->value.asBuffer.buffer = (uint8_t *)iowa_system_malloc(stringLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+            if (dataP->value.asBuffer.buffer == NULL)
+            {
+                IOWA_LOG_ERROR_MALLOC(stringLength);
+                dataP->value.asBuffer.length = 0;
+                return CBOR_ERROR;
+            }
+#endif
+        }
+
+        return cborPutBufferToString(majorType, addInfo, number, dataP->value.asBuffer.buffer, stringLength, bufferP, bufferLength, bufferIndexP);
+    }
+
+    case CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC:
+        if (number == CBOR_ADD_INFO_DECIMAL_FRAC)
+        {
+            return cborHandleDecimalFraction(dataP, bufferP, bufferLength, bufferIndexP);
+        }
+        if (number == PRV_CBOR_TAG_EPOCH_TIME)
+        {
+            majorType = cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, bufferIndexP);
+            if (majorType != CBOR_MAJOR_TYPE_UNSIGNED_INTEGER
+                && majorType != CBOR_MAJOR_TYPE_NEGATIVE_INTEGER)
+            {
+                IOWA_LOG_INFO(IOWA_PART_DATA, "Only integer epoch-based times are supported.");
+                return CBOR_ERROR;
+            }
+            if (cborPutBufferToData(majorType, addInfo, number, dataP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            dataP->type = IOWA_LWM2M_TYPE_TIME;
+            break;
+        }
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Unsupported tag %u.", number);
+        return CBOR_ERROR;
+
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA:
+        return cborGetValueFromFloatMajorType(addInfo, number, dataP);
+
+    default:
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Major type %d can not be a value.", majorType);
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+#ifdef LWM2M_SUPPORT_CBOR
+iowa_status_t cborSerialize(iowa_lwm2m_data_t *dataP,
+                            size_t headroom,
+                            uint8_t **bufferP,
+                            size_t *bufferLengthP)
+{
+    size_t index;
+
+    assert(dataP != NULL);
+    assert(bufferP != NULL);
+    assert(bufferLengthP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "Entering with data type: %s.", STR_LWM2M_TYPE(dataP->type));
+
+    *bufferP = NULL;
+    *bufferLengthP = cborGetDataToBufferLength(dataP);
+    if (*bufferLengthP == 0)
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_DATA, "Cannot serialize in CBOR the data type: %s.", STR_LWM2M_TYPE(dataP->type));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(headroom + *bufferLengthP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(headroom + *bufferLengthP);
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    index = headroom;
+    if (cborAddDataToBuffer(dataP, *bufferP, headroom + *bufferLengthP, &index) != CBOR_NO_ERROR)
+    {
+        iowa_system_free(*bufferP);
+        *bufferP = NULL;
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t cborDeserialize(iowa_lwm2m_uri_t *baseUriP,
+                              uint8_t *bufferP,
+                              size_t bufferLength,
+                              iowa_lwm2m_data_t **dataP,
+                              size_t *dataCountP)
+{
+    major_type_t majorType;
+    uint8_t addInfo;
+    uint64_t number;
+    size_t index;
+
+    IOWA_LOG_BUFFER_TRACE(IOWA_PART_DATA, "Parsing CBOR buffer", bufferP, bufferLength);
+
+    *dataCountP = 0;
+    *dataP = NULL;
+
+    if (baseUriP == NULL)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "No base URI provided.");
+        return IOWA_COAP_406_NOT_ACCEPTABLE;
+    }
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (baseUriP->resourceId == IOWA_LWM2M_ID_ALL)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "This format does only support single resource.");
+        return IOWA_COAP_406_NOT_ACCEPTABLE;
+    }
+#endif
+
+    *dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataP, 0, sizeof(iowa_lwm2m_data_t));
+    dataUtilsSetUri(*dataP, baseUriP);
+
+    index = 0;
+    majorType = cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, &index);
+    if (majorType == CBOR_MAJOR_TYPE_NONE
+        || cborPutBufferToData(majorType, addInfo, number, *dataP, bufferP, bufferLength, &index) != CBOR_NO_ERROR
+        || index != bufferLength)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid CBOR payload.");
+        dataLwm2mFree(1, *dataP);
+        *dataP = NULL;
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *dataCountP = 1;
+
+    return IOWA_COAP_NO_ERROR;
+}
+#endif // LWM2M_SUPPORT_CBOR
+
+#endif // LWM2M_SUPPORT_CBOR || LWM2M_SUPPORT_SENML_CBOR || LWM2M_SUPPORT_LWM2M_CBOR
@@ -26,12 +26,21 @@
 ** Private functions
 *************************************************************************************/
 
+// Sort key of a data: the Object ID in the upper bits and the Object Instance ID in the lower bits
+#define PRV_DATA_SORT_KEY(D) (((uint32_t)(D).objectID << 16) | (uint32_t)(D).instanceID)
+
+typedef struct
+{
+    uint32_t key;
+    size_t   index;
+} prv_sort_entry_t;
+
 // Use Insertion Algorithm to sort iowa_lwm2m_data_t
 // Returned value: None.
 // Parameters:
 // - dataCount: data Array size.
 // - dataArrayP: data to sort.
-// - level: level to sort data.
+// Note: this is only used when the memory to sort the indexes can not be allocated.
 static void prv_dataInsertionSortSmallToLarge(size_t dataCount,
                                               iowa_lwm2m_data_t *dataArrayP)
 {
@@ -60,6 +69,124 @@ static void prv_dataInsertionSortSmallToLarge(size_t dataCount,
     }
 }
 
+// Sort iowa_lwm2m_data_t by Object ID and Object Instance ID, keeping the order of the data with the same IDs.
+// Returned value: None.
+// Parameters:
+// - dataCount: data Array size.
+// - dataArrayP: data to sort.
+// Note: already sorted data are detected in one pass. Otherwise, a merge sort is done on an array of keys and indexes
+// and the data are moved only once to their final place.
+static void prv_dataSort(size_t dataCount,
+                         iowa_lwm2m_data_t *dataArrayP)
+{
+    prv_sort_entry_t *entryArray;
+    prv_sort_entry_t *srcP;
+    prv_sort_entry_t *dstP;
+    size_t width;
+    size_t i;
+
+    assert((dataArrayP != NULL && dataCount != 0) || dataCount == 0);
+
+    // Data are usually already in order
+    for (i = 1; i < dataCount; i++)
+    {
+        if (PRV_DATA_SORT_KEY(dataArrayP[i]) < PRV_DATA_SORT_KEY(dataArrayP[i - 1]))
+        {
+            break;
+        }
+    }
+    if (i >= dataCount)
+    {
+        return;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "Data #%u is out of order, sorting %u data.", i, dataCount);
+
+    entryArray = (prv_sort_entry_t *)iowa_system_malloc(2 * dataCount * sizeof(prv_sort_entry_t));
+    if (entryArray == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(2 * dataCount * sizeof(prv_sort_entry_t));
+        prv_dataInsertionSortSmallToLarge(dataCount, dataArrayP);
+        return;
+    }
+
+    for (i = 0; i < dataCount; i++)
+    {
+        entryArray[i].key = PRV_DATA_SORT_KEY(dataArrayP[i]);
+        entryArray[i].index = i;
+    }
+
+    // Bottom-up merge sort, stable as equal keys are taken from the left run first
+    srcP = entryArray;
+    dstP = entryArray + dataCount;
+    for (width = 1; width < dataCount; width *= 2)
+    {
+        prv_sort_entry_t *tmpP;
+        size_t left;
+
+        for (left = 0; left < dataCount; left += 2 * width)
+        {
+            size_t middle;
+            size_t right;
+            size_t leftIndex;
+            size_t rightIndex;
+            size_t dstIndex;
+
+            middle = (left + width < dataCount) ? left + width : dataCount;
+            right = (left + 2 * width < dataCount) ? left + 2 * width : dataCount;
+
+            leftIndex = left;
+            rightIndex = middle;
+            for (dstIndex = left; dstIndex < right; dstIndex++)
+            {
+                if (rightIndex >= right
+                    || (leftIndex < middle && srcP[leftIndex].key <= srcP[rightIndex].key))
+                {
+                    dstP[dstIndex] = srcP[leftIndex];
+                    leftIndex++;
+                }
+                else
+                {
+                    dstP[dstIndex] = srcP[rightIndex];
+                    rightIndex++;
+                }
+            }
+        }
+
+        tmpP = srcP;
+        srcP = dstP;
+        dstP = tmpP;
+    }
+
+    // Apply the permutation in place by following its cycles: the data at srcP[i].index goes to i
+    for (i = 0; i < dataCount; i++)
+    {
+        iowa_lwm2m_data_t dataCurrent;
+        size_t hole;
+
+        if (srcP[i].index == i)
+        {
+            continue;
+        }
+
+        memcpy(&dataCurrent, dataArrayP + i, sizeof(iowa_lwm2m_data_t));
+        hole = i;
+        while (srcP[hole].index != i)
+        {
+            size_t next;
+
+            next = srcP[hole].index;
+            memcpy(dataArrayP + hole, dataArrayP + next, sizeof(iowa_lwm2m_data_t));
+            srcP[hole].index = hole;
+            hole = next;
+        }
+        memcpy(dataArrayP + hole, &dataCurrent, sizeof(iowa_lwm2m_data_t));
+        srcP[hole].index = hole;
+    }
+
+    iowa_system_free(entryArray);
+}
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -91,6 +218,7 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
                                  iowa_lwm2m_data_t *dataP,
                                  size_t dataCount,
                                  iowa_content_format_t *contentFormatP,
+                                 size_t headroom,
                                  uint8_t **bufferP,
                                  size_t *bufferLengthP)
 {
@@ -124,6 +252,9 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
     {
     case IOWA_CONTENT_FORMAT_TEXT:
     case IOWA_CONTENT_FORMAT_OPAQUE:
+#ifdef LWM2M_SUPPORT_CBOR
+    case IOWA_CONTENT_FORMAT_CBOR:
+#endif
         if (dataCount != 1)
         {
             *contentFormatP = LWM2M_DEFAULT_CONTENT_FORMAT;
@@ -144,6 +275,16 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
         break;
 #endif
 
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+        break;
+#endif
+
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    case IOWA_CONTENT_FORMAT_LWM2M_CBOR:
+        break;
+#endif
+
     default:
         *contentFormatP = LWM2M_DEFAULT_CONTENT_FORMAT;
         IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "New content format: %s.", STR_MEDIA_TYPE(*contentFormatP));
@@ -156,17 +297,35 @@ iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP,
     // Serialize the data
     if (IOWA_CONTENT_FORMAT_TEXT == *contentFormatP)
     {
-        result = textSerialize(sortedDataP, bufferP, bufferLengthP);
+        result = textSerialize(sortedDataP, headroom, bufferP, bufferLengthP);
     }
     else if (IOWA_CONTENT_FORMAT_OPAQUE == *contentFormatP)
     {
-        result = opaqueSerialize(sortedDataP, bufferP, bufferLengthP);
+        result = opaqueSerialize(sortedDataP, headroom, bufferP, bufferLengthP);
     }
 #ifdef LWM2M_SUPPORT_TLV
     else if (IOWA_CONTENT_FORMAT_TLV_OLD == *contentFormatP
              || IOWA_CONTENT_FORMAT_TLV == *contentFormatP)
     {
-        result = tlvSerialize(baseUriP, sortedDataP, sortedDataCount, bufferP, bufferLengthP);
+        result = tlvSerialize(baseUriP, sortedDataP, sortedDataCount, headroom, bufferP, bufferLengthP);
+    }
+#endif
+#ifdef LWM2M_SUPPORT_CBOR
+    else if (IOWA_CONTENT_FORMAT_CBOR == *contentFormatP)
+    {
+        result = cborSerialize(sortedDataP, headroom, bufferP, bufferLengthP);
+    }
+#endif
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    else if (IOWA_CONTENT_FORMAT_SENML_CBOR == *contentFormatP)
+    {
+        result = senmlCborSerialize(sortedDataP, sortedDataCount, headroom, bufferP, bufferLengthP);
+    }
+#endif
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    else if (IOWA_CONTENT_FORMAT_LWM2M_CBOR == *contentFormatP)
+    {
+        result = lwm2mCborSerialize(sortedDataP, sortedDataCount, headroom, bufferP, bufferLengthP);
     }
 #endif
     else
@@ -222,6 +381,24 @@ iowa_status_t dataLwm2mDeserialize(iowa_lwm2m_uri_t *baseUriP,
         break;
 #endif
 
+#ifdef LWM2M_SUPPORT_CBOR
+    case IOWA_CONTENT_FORMAT_CBOR:
+        result = cborDeserialize(baseUriP, bufferP, bufferLength, dataP, dataCountP);
+        break;
+#endif
+
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+        result = senmlCborDeserialize(baseUriP, bufferP, bufferLength, dataP, dataCountP);
+        break;
+#endif
+
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    case IOWA_CONTENT_FORMAT_LWM2M_CBOR:
+        result = lwm2mCborDeserialize(baseUriP, bufferP, bufferLength, dataP, dataCountP);
+        break;
+#endif
+
     default:
         IOWA_LOG_ARG_ERROR(IOWA_PART_DATA, "Content format %s is not supported.", STR_MEDIA_TYPE(contentFormat));
         result = IOWA_COAP_415_UNSUPPORTED_CONTENT_FORMAT;
@@ -232,7 +409,7 @@ iowa_status_t dataLwm2mDeserialize(iowa_lwm2m_uri_t *baseUriP,
         result = dataLwm2mConsolidate(*dataCountP, *dataP, contentFormat, resTypeCb, userDataP);
     }
 
-    prv_dataInsertionSortSmallToLarge(*dataCountP, *dataP);
+    prv_dataSort(*dataCountP, *dataP);
 
     IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Exiting with result: %u.%02u, dataP: %p, dataCountP: %zu.", (result & 0xFF) >> 5, (result & 0x1F), *dataP, *dataCountP);
 
@@ -677,7 +854,11 @@ iowa_status_t dataLwm2mConsolidate(size_t dataCount,
         }
         else if (IOWA_LWM2M_TYPE_UNDEFINED == type)
         {
-            if (contentFormat != IOWA_CONTENT_FORMAT_OPAQUE)
+            // Only values held in a buffer can be left undefined
+            if (contentFormat != IOWA_CONTENT_FORMAT_OPAQUE
+                && (IOWA_LWM2M_TYPE_STRING == dataArray[i].type
+                    || IOWA_LWM2M_TYPE_CORE_LINK == dataArray[i].type
+                    || IOWA_LWM2M_TYPE_UNDEFINED == dataArray[i].type))
             {
                 dataArray[i].type = IOWA_LWM2M_TYPE_UNDEFINED;
             }
@@ -702,3 +883,71 @@ exit_error:
 
     return IOWA_COAP_406_NOT_ACCEPTABLE;
 }
+
+/*************************************************************************************
+** APIs
+*************************************************************************************/
+
+iowa_status_t iowa_data_get_block_info(iowa_lwm2m_data_t *dataP,
+                                       uint32_t *numberP,
+                                       bool *moreP,
+                                       uint16_t *sizeP)
+{
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "dataP: %p.", dataP);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (dataP == NULL
+        || numberP == NULL
+        || moreP == NULL
+        || sizeP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_DATA, "Invalid arguments.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    if (!DATA_IS_BLOCK(dataP->type))
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Data type %s has no block information.", STR_LWM2M_TYPE(dataP->type));
+        return IOWA_COAP_404_NOT_FOUND;
+    }
+
+    return coapDecodeBlockInfo(DATA_BLOCK_DETAIL_TO_OPTION(dataP->value.asBlock.details), numberP, moreP, sizeP);
+}
+
+iowa_status_t iowa_data_set_block_info(iowa_lwm2m_data_t *dataP,
+                                       uint32_t number,
+                                       bool more,
+                                       uint16_t size)
+{
+    iowa_status_t result;
+    uint32_t value;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "dataP: %p, number: %u, more: %s, size: %u.", dataP, number, more ? "true" : "false", size);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    if (dataP == NULL)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_DATA, "Invalid arguments.");
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+#endif
+
+    if (!DATA_IS_BLOCK(dataP->type))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Data type %s can not hold block information.", STR_LWM2M_TYPE(dataP->type));
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    result = coapEncodeBlockInfo(number, more, size, &value);
+    if (result != IOWA_COAP_NO_ERROR
+        || value != DATA_BLOCK_DETAIL_TO_OPTION(value))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Invalid block number %u or size %u.", number, size);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    dataP->value.asBlock.details = value;
+
+    return IOWA_COAP_NO_ERROR;
+}
@@ -31,7 +31,6 @@
 #define PRV_PLUS_SIGN                   '+'
 
 #define PRV_EXPONENT_INT_MIN_CHAR_COUNT 3
-#define PRV_EXPONENT_DEC_MIN_CHAR_COUNT 4
 
 /*************************************************************************************
 ** Private functions
@@ -191,63 +190,6 @@ static int prv_isExponentPossibleForIntPart(int64_t *valueP)
 }
 
 
-// change value and indicate exponent if it is possible for decimal part of value
-// return exponent if possible or 0
-static int prv_isExponentPossibleForDecPart(double *valueP)
-{
-    int cpt;
-    double floatValue;
-    int sign;
-
-    assert(valueP != NULL);
-
-    if ((int64_t)(*valueP) != 0)
-    {
-        IOWA_LOG_TRACE(IOWA_PART_DATA, "No exponent possible.");
-        return 0;
-    }
-
-    if (*valueP < 0)
-    {
-        floatValue = 0 - (*valueP);
-        sign = -1;
-    }
-    else
-    {
-        floatValue = *valueP;
-        sign = 1;
-    }
-
-    cpt = 0;
-
-    if ((floatValue - (double)FLT_EPSILON) <= 0)
-    {
-        IOWA_LOG_TRACE(IOWA_PART_DATA, "No exponent possible.");
-        return 0;
-    }
-
-    while ((floatValue - (double)FLT_EPSILON) > 0
-           && floatValue < 1)
-    {
-        floatValue = floatValue * 10;
-        cpt++;
-    }
-    if (cpt >= PRV_EXPONENT_DEC_MIN_CHAR_COUNT)
-    {
-        while (((floatValue - (double)((int64_t)floatValue)) - (double)FLT_EPSILON) > 0)
-        {
-            floatValue = floatValue * 10;
-            cpt++;
-        }
-        IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "exponent found: %d.", cpt);
-        (*valueP) = sign * floatValue;
-        return cpt;
-    }
-
-    IOWA_LOG_TRACE(IOWA_PART_DATA, "No exponent possible.");
-    return 0;
-}
-
 // get the length of the conversion of an integer into a buffer
 // return the length of the conversion
 static size_t prv_intToBufferLength(int64_t data)
@@ -335,6 +277,521 @@ static size_t prv_intToBuffer(int64_t data,
 }
 
 
+/*************************************************************************************
+** Floating point number formatting
+**
+** The digits are generated with the Grisu2 algorithm by Florian Loitsch ("Printing
+** Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010). The
+** output always reads back to the same double and is the shortest one for nearly
+** all values. Only 64-bit integer arithmetic is used.
+*************************************************************************************/
+
+#define PRV_DOUBLE_SIGNIFICAND_SIZE  52
+#define PRV_DOUBLE_EXPONENT_BIAS     (0x3FF + PRV_DOUBLE_SIGNIFICAND_SIZE)
+#define PRV_DOUBLE_MIN_EXPONENT      (-PRV_DOUBLE_EXPONENT_BIAS)
+#define PRV_DOUBLE_EXPONENT_MASK     0x7FF0000000000000ULL
+#define PRV_DOUBLE_SIGNIFICAND_MASK  0x000FFFFFFFFFFFFFULL
+#define PRV_DOUBLE_HIDDEN_BIT        0x0010000000000000ULL
+#define PRV_DOUBLE_SIGN_MASK         0x8000000000000000ULL
+
+// Maximal number of significant digits of a double
+#define PRV_DOUBLE_MAX_DIGITS 17
+
+// Decimal point positions written without exponent when it is not requested,
+// i.e. from 1e-6 to 1e21 like in ECMAScript
+#define PRV_FIXED_NOTATION_MIN_POINT -5
+#define PRV_FIXED_NOTATION_MAX_POINT 21
+
+// Decimal exponent of the first cached power and step between two cached powers
+#define PRV_CACHED_POWER_MIN_DEC_EXPONENT -348
+#define PRV_CACHED_POWER_DEC_EXPONENT_STEP 8
+
+// A floating point number f * 2^e with a 64-bit significand
+typedef struct
+{
+    uint64_t f;
+    int      e;
+} prv_diy_fp_t;
+
+typedef struct
+{
+    uint64_t f;
+    int16_t  e;
+} prv_cached_power_t;
+
+// Normalized 64-bit approximations of 10^-348, 10^-340, ..., 10^340
+static const prv_cached_power_t prv_cachedPowers[] =
+{
+    { 0xFA8FD5A0081C0288, -1220 }, // 1e-348
+    { 0xBAAEE17FA23EBF76, -1193 }, // 1e-340
+    { 0x8B16FB203055AC76, -1166 }, // 1e-332
+    { 0xCF42894A5DCE35EA, -1140 }, // 1e-324
+    { 0x9A6BB0AA55653B2D, -1113 }, // 1e-316
+    { 0xE61ACF033D1A45DF, -1087 }, // 1e-308
+    { 0xAB70FE17C79AC6CA, -1060 }, // 1e-300
+    { 0xFF77B1FCBEBCDC4F, -1034 }, // 1e-292
+    { 0xBE5691EF416BD60C, -1007 }, // 1e-284
+    { 0x8DD01FAD907FFC3C,  -980 }, // 1e-276
+    { 0xD3515C2831559A83,  -954 }, // 1e-268
+    { 0x9D71AC8FADA6C9B5,  -927 }, // 1e-260
+    { 0xEA9C227723EE8BCB,  -901 }, // 1e-252
+    { 0xAECC49914078536D,  -874 }, // 1e-244
+    { 0x823C12795DB6CE57,  -847 }, // 1e-236
+    { 0xC21094364DFB5637,  -821 }, // 1e-228
+    { 0x9096EA6F3848984F,  -794 }, // 1e-220
+    { 0xD77485CB25823AC7,  -768 }, // 1e-212
+    { 0xA086CFCD97BF97F4,  -741 }, // 1e-204
+    { 0xEF340A98172AACE5,  -715 }, // 1e-196
+    { 0xB23867FB2A35B28E,  -688 }, // 1e-188
+    { 0x84C8D4DFD2C63F3B,  -661 }, // 1e-180
+    { 0xC5DD44271AD3CDBA,  -635 }, // 1e-172
+    { 0x936B9FCEBB25C996,  -608 }, // 1e-164
+    { 0xDBAC6C247D62A584,  -582 }, // 1e-156
+    { 0xA3AB66580D5FDAF6,  -555 }, // 1e-148
+    { 0xF3E2F893DEC3F126,  -529 }, // 1e-140
+    { 0xB5B5ADA8AAFF80B8,  -502 }, // 1e-132
+    { 0x87625F056C7C4A8B,  -475 }, // 1e-124
+    { 0xC9BCFF6034C13053,  -449 }, // 1e-116
+    { 0x964E858C91BA2655,  -422 }, // 1e-108
+    { 0xDFF9772470297EBD,  -396 }, // 1e-100
+    { 0xA6DFBD9FB8E5B88F,  -369 }, // 1e-92
+    { 0xF8A95FCF88747D94,  -343 }, // 1e-84
+    { 0xB94470938FA89BCF,  -316 }, // 1e-76
+    { 0x8A08F0F8BF0F156B,  -289 }, // 1e-68
+    { 0xCDB02555653131B6,  -263 }, // 1e-60
+    { 0x993FE2C6D07B7FAC,  -236 }, // 1e-52
+    { 0xE45C10C42A2B3B06,  -210 }, // 1e-44
+    { 0xAA242499697392D3,  -183 }, // 1e-36
+    { 0xFD87B5F28300CA0E,  -157 }, // 1e-28
+    { 0xBCE5086492111AEB,  -130 }, // 1e-20
+    { 0x8CBCCC096F5088CC,  -103 }, // 1e-12
+    { 0xD1B71758E219652C,   -77 }, // 1e-4
+    { 0x9C40000000000000,   -50 }, // 1e4
+    { 0xE8D4A51000000000,   -24 }, // 1e12
+    { 0xAD78EBC5AC620000,     3 }, // 1e20
+    { 0x813F3978F8940984,    30 }, // 1e28
+    { 0xC097CE7BC90715B3,    56 }, // 1e36
+    { 0x8F7E32CE7BEA5C70,    83 }, // 1e44
+    { 0xD5D238A4ABE98068,   109 }, // 1e52
+    { 0x9F4F2726179A2245,   136 }, // 1e60
+    { 0xED63A231D4C4FB27,   162 }, // 1e68
+    { 0xB0DE65388CC8ADA8,   189 }, // 1e76
+    { 0x83C7088E1AAB65DB,   216 }, // 1e84
+    { 0xC45D1DF942711D9A,   242 }, // 1e92
+    { 0x924D692CA61BE758,   269 }, // 1e100
+    { 0xDA01EE641A708DEA,   295 }, // 1e108
+    { 0xA26DA3999AEF774A,   322 }, // 1e116
+    { 0xF209787BB47D6B85,   348 }, // 1e124
+    { 0xB454E4A179DD1877,   375 }, // 1e132
+    { 0x865B86925B9BC5C2,   402 }, // 1e140
+    { 0xC83553C5C8965D3D,   428 }, // 1e148
+    { 0x952AB45CFA97A0B3,   455 }, // 1e156
+    { 0xDE469FBD99A05FE3,   481 }, // 1e164
+    { 0xA59BC234DB398C25,   508 }, // 1e172
+    { 0xF6C69A72A3989F5C,   534 }, // 1e180
+    { 0xB7DCBF5354E9BECE,   561 }, // 1e188
+    { 0x88FCF317F22241E2,   588 }, // 1e196
+    { 0xCC20CE9BD35C78A5,   614 }, // 1e204
+    { 0x98165AF37B2153DF,   641 }, // 1e212
+    { 0xE2A0B5DC971F303A,   667 }, // 1e220
+    { 0xA8D9D1535CE3B396,   694 }, // 1e228
+    { 0xFB9B7CD9A4A7443C,   720 }, // 1e236
+    { 0xBB764C4CA7A44410,   747 }, // 1e244
+    { 0x8BAB8EEFB6409C1A,   774 }, // 1e252
+    { 0xD01FEF10A657842C,   800 }, // 1e260
+    { 0x9B10A4E5E9913129,   827 }, // 1e268
+    { 0xE7109BFBA19C0C9D,   853 }, // 1e276
+    { 0xAC2820D9623BF429,   880 }, // 1e284
+    { 0x80444B5E7AA7CF85,   907 }, // 1e292
+    { 0xBF21E44003ACDD2D,   933 }, // 1e300
+    { 0x8E679C2F5E44FF8F,   960 }, // 1e308
+    { 0xD433179D9C8CB841,   986 }, // 1e316
+    { 0x9E19DB92B4E31BA9,  1013 }, // 1e324
+    { 0xEB96BF6EBADF77D9,  1039 }, // 1e332
+    { 0xAF87023B9BF0EE6B,  1066 }, // 1e340
+};
+
+static const uint64_t prv_pow10[] =
+{
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL
+};
+
+// Multiply two numbers, keeping the 64 upper bits of the rounded product.
+static prv_diy_fp_t prv_diyFpMultiply(prv_diy_fp_t x,
+                                      prv_diy_fp_t y)
+{
+    prv_diy_fp_t result;
+    uint64_t a;
+    uint64_t b;
+    uint64_t c;
+    uint64_t d;
+    uint64_t bd;
+    uint64_t tmp;
+
+    a = x.f >> 32;
+    b = x.f & 0xFFFFFFFFU;
+    c = y.f >> 32;
+    d = y.f & 0xFFFFFFFFU;
+
+    bd = b * d;
+    tmp = (bd >> 32) + ((a * d) & 0xFFFFFFFFU) + ((b * c) & 0xFFFFFFFFU);
+    tmp += 1U << 31;
+
+    result.f = a * c + ((a * d) >> 32) + ((b * c) >> 32) + (tmp >> 32);
+    result.e = x.e + y.e + 64;
+
+    return result;
+}
+
+// Shift a number until the most significant bit of its significand is set.
+static prv_diy_fp_t prv_diyFpNormalize(prv_diy_fp_t x)
+{
+    while ((x.f & 0xFF00000000000000ULL) == 0)
+    {
+        x.f <<= 8;
+        x.e -= 8;
+    }
+    while ((x.f & PRV_DOUBLE_SIGN_MASK) == 0)
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+
+    return x;
+}
+
+// Remove the last generated digit while the result stays closer to the value.
+static void prv_grisuRound(uint8_t *digits,
+                           size_t length,
+                           uint64_t delta,
+                           uint64_t rest,
+                           uint64_t tenKappa,
+                           uint64_t distance)
+{
+    while (rest < distance
+           && delta - rest >= tenKappa
+           && (rest + tenKappa < distance
+               || distance - rest > rest + tenKappa - distance))
+    {
+        digits[length - 1]--;
+        rest += tenKappa;
+    }
+}
+
+// Generate the digits of a positive, finite and non-zero double.
+// Returned value: the number of digits.
+// Parameters:
+// - value: the number.
+// - digits: OUT. the digits. Its size is PRV_DOUBLE_MAX_DIGITS.
+// - exponentP: OUT. the decimal exponent such that value = digits * 10^exponent.
+static size_t prv_doubleToDigits(double value,
+                                 uint8_t *digits,
+                                 int *exponentP)
+{
+    uint64_t bits;
+    prv_diy_fp_t v;
+    prv_diy_fp_t plus;
+    prv_diy_fp_t minus;
+    prv_diy_fp_t cachedPower;
+    prv_diy_fp_t w;
+    prv_diy_fp_t one;
+    uint64_t delta;
+    uint64_t distance;
+    uint32_t p1;
+    uint64_t p2;
+    int kappa;
+    int k;
+    double dk;
+    size_t index;
+    size_t length;
+
+    memcpy(&bits, &value, sizeof(double));
+
+    v.f = bits & PRV_DOUBLE_SIGNIFICAND_MASK;
+    if ((bits & PRV_DOUBLE_EXPONENT_MASK) != 0)
+    {
+        v.f += PRV_DOUBLE_HIDDEN_BIT;
+        v.e = (int)((bits & PRV_DOUBLE_EXPONENT_MASK) >> PRV_DOUBLE_SIGNIFICAND_SIZE) - PRV_DOUBLE_EXPONENT_BIAS;
+    }
+    else
+    {
+        v.e = PRV_DOUBLE_MIN_EXPONENT + 1;
+    }
+
+    // Boundaries of the interval of numbers rounding to value
+    plus.f = (v.f << 1) + 1;
+    plus.e = v.e - 1;
+    if (v.f >= PRV_DOUBLE_HIDDEN_BIT)
+    {
+        // Shortcut for normal numbers whose most significant bit is known
+        plus.f <<= 10;
+        plus.e -= 10;
+        w.f = v.f << 11;
+        w.e = v.e - 11;
+    }
+    else
+    {
+        plus = prv_diyFpNormalize(plus);
+        w = prv_diyFpNormalize(v);
+    }
+    if (v.f == PRV_DOUBLE_HIDDEN_BIT)
+    {
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    }
+    else
+    {
+        minus.f = (v.f << 1) - 1;
+        minus.e = v.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    // Scale by a cached power of ten so that the exponent falls in [-60, -32]
+    dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    k = (int)dk;
+    if (dk - k > 0.0)
+    {
+        k++;
+    }
+    index = (size_t)((k >> 3) + 1);
+    *exponentP = -(PRV_CACHED_POWER_MIN_DEC_EXPONENT + (int)index * PRV_CACHED_POWER_DEC_EXPONENT_STEP);
+    cachedPower.f = prv_cachedPowers[index].f;
+    cachedPower.e = prv_cachedPowers[index].e;
+
+    w = prv_diyFpMultiply(w, cachedPower);
+    plus = prv_diyFpMultiply(plus, cachedPower);
+    minus = prv_diyFpMultiply(minus, cachedPower);
+    minus.f++;
+    plus.f--;
+
+    // Generate the digits of the upper boundary until they identify the value
+    delta = plus.f - minus.f;
+    distance = plus.f - w.f;
+    one.e = plus.e;
+    one.f = 1ULL << -one.e;
+    p1 = (uint32_t)(plus.f >> -one.e);
+    p2 = plus.f & (one.f - 1);
+
+    kappa = 0;
+    while (kappa < 10 && p1 >= prv_pow10[kappa])
+    {
+        kappa++;
+    }
+
+    length = 0;
+    while (kappa > 0)
+    {
+        uint32_t digit;
+        uint64_t rest;
+
+        // p1 is at most 32-bit long
+        digit = p1 / (uint32_t)prv_pow10[kappa - 1];
+        p1 = p1 % (uint32_t)prv_pow10[kappa - 1];
+        if (digit != 0
+            || length != 0)
+        {
+            digits[length] = (uint8_t)('0' + digit);
+            length++;
+        }
+        kappa--;
+
+        rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta)
+        {
+            *exponentP += kappa;
+            prv_grisuRound(digits, length, delta, rest, prv_pow10[kappa] << -one.e, distance);
+            return length;
+        }
+    }
+
+    while (true)
+    {
+        uint8_t digit;
+
+        p2 *= 10;
+        delta *= 10;
+        digit = (uint8_t)(p2 >> -one.e);
+        if (digit != 0
+            || length != 0)
+        {
+            digits[length] = (uint8_t)('0' + digit);
+            length++;
+        }
+        p2 &= one.f - 1;
+        kappa--;
+
+        if (p2 < delta)
+        {
+            *exponentP += kappa;
+            prv_grisuRound(digits, length, delta, p2, one.f, -kappa < 20 ? distance * prv_pow10[-kappa] : 0);
+            return length;
+        }
+    }
+}
+
+// Write a double as text.
+// Returned value: the length of the text, 0 in case of error.
+// Parameters:
+// - data: the number.
+// - withExponent: if true, the exponent form is used when it is shorter.
+// - buffer: the buffer. If nil, only the length is computed.
+// - length: the length of the buffer.
+static size_t prv_floatToBuffer(double data,
+                                bool withExponent,
+                                uint8_t *buffer,
+                                size_t length)
+{
+    uint8_t digits[PRV_DOUBLE_MAX_DIGITS];
+    size_t digitCount;
+    size_t signLength;
+    size_t fixedLength;
+    size_t exponentLength;
+    int exponent;
+    int point;
+    size_t result;
+    size_t i;
+
+    if (data - data != 0.0)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Infinite or NaN number can not be converted.");
+        return 0;
+    }
+
+    if (data == 0.0)
+    {
+        if (buffer != NULL)
+        {
+            if (length < 1)
+            {
+                return 0;
+            }
+            buffer[0] = '0';
+        }
+        return 1;
+    }
+
+    if (data < 0)
+    {
+        signLength = 1;
+        data = -data;
+    }
+    else
+    {
+        signLength = 0;
+    }
+
+    digitCount = prv_doubleToDigits(data, digits, &exponent);
+
+    // Position of the decimal point relatively to the first digit
+    point = (int)digitCount + exponent;
+
+    if (point >= (int)digitCount)
+    {
+        fixedLength = (size_t)point;
+    }
+    else if (point > 0)
+    {
+        fixedLength = digitCount + 1;
+    }
+    else
+    {
+        fixedLength = 2 + (size_t)(-point) + digitCount;
+    }
+
+    // Digits followed by the exponent, e.g. "15e-5"
+    if (exponent != 0
+        && (withExponent == true || point < PRV_FIXED_NOTATION_MIN_POINT || point > PRV_FIXED_NOTATION_MAX_POINT))
+    {
+        exponentLength = digitCount + 1 + prv_intToBufferLength(exponent);
+    }
+    else
+    {
+        exponentLength = 0;
+    }
+
+    if (exponentLength != 0
+        && (withExponent == false || exponentLength < fixedLength))
+    {
+        result = signLength + exponentLength;
+        if (buffer != NULL)
+        {
+            if (length < result)
+            {
+                IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
+                return 0;
+            }
+            memcpy(buffer + signLength, digits, digitCount);
+            buffer[signLength + digitCount] = PRV_EXPONENT_MIN;
+            (void)prv_intToBuffer(exponent, buffer + signLength + digitCount + 1, exponentLength - digitCount - 1);
+        }
+    }
+    else
+    {
+        result = signLength + fixedLength;
+        if (buffer != NULL)
+        {
+            if (length < result)
+            {
+                IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
+                return 0;
+            }
+            if (point >= (int)digitCount)
+            {
+                memcpy(buffer + signLength, digits, digitCount);
+                for (i = digitCount; i < (size_t)point; i++)
+                {
+                    buffer[signLength + i] = '0';
+                }
+            }
+            else if (point > 0)
+            {
+                memcpy(buffer + signLength, digits, (size_t)point);
+                buffer[signLength + (size_t)point] = PRV_DECIMAL_POINT;
+                memcpy(buffer + signLength + (size_t)point + 1, digits + point, digitCount - (size_t)point);
+            }
+            else
+            {
+                buffer[signLength] = '0';
+                buffer[signLength + 1] = PRV_DECIMAL_POINT;
+                for (i = 0; i < (size_t)(-point); i++)
+                {
+                    buffer[signLength + 2 + i] = '0';
+                }
+                memcpy(buffer + signLength + 2 + (size_t)(-point), digits, digitCount);
+            }
+        }
+    }
+
+    if (buffer != NULL
+        && signLength != 0)
+    {
+        buffer[0] = PRV_MINUS_SIGN;
+    }
+
+    return result;
+}
+
+
 /*************************************************************************************
 ** Public functions
 *************************************************************************************/
@@ -581,95 +1038,7 @@ size_t dataUtilsBufferToFloat(uint8_t *buffer,
 size_t dataUtilsFloatToBufferLength(double data,
                                     bool withExponent)
 {
-    if (data > (double)INT64_MAX
-        || data < (double)INT64_MIN)
-    {
-        IOWA_LOG_WARNING(IOWA_PART_DATA, "Number is too large, set IOWA_USE_SNPRINTF to serialize it without error.");
-        return 0;
-    }
-    else
-    {
-        size_t intLength;
-        size_t decLength;
-        int64_t intPart;
-        double decPart;
-        int exponent;
-
-        if (withExponent == true)
-        {
-            exponent = prv_isExponentPossibleForDecPart(&data);
-        }
-        else
-        {
-            exponent = 0;
-        }
-
-        intPart = (int64_t)data;
-        decPart = data - (double)intPart;
-        if (decPart < 0)
-        {
-            decPart = 1 - decPart;
-        }
-        else
-        {
-            decPart = 1 + decPart;
-        }
-
-        if (decPart <= 1 + (double)FLT_EPSILON)
-        {
-            decPart = 0;
-        }
-
-        if (intPart == 0 && data < 0)
-        {
-            // deal with numbers between -1 and 0
-            intLength = 2;
-        }
-        else
-        {
-            bool setExponent;
-
-            if (withExponent == false
-                || decPart >= (double)FLT_EPSILON)
-            {
-                setExponent = false;
-            }
-            else
-            {
-                setExponent = true;
-            }
-            // Call the utils function to take exponent in account
-            intLength = dataUtilsIntToBufferLength(intPart, setExponent);
-        }
-
-        decLength = 0;
-        if (decPart >= (double)FLT_EPSILON)
-        {
-            double noiseFloor;
-
-            noiseFloor = (double)FLT_EPSILON;
-            do
-            {
-                decPart *= 10;
-                noiseFloor *= 10;
-            } while (decPart - (double)((int64_t)decPart) > noiseFloor);  // Compare the integer part of decPart with possible noise
-
-            decLength = prv_intToBufferLength((int64_t)decPart);
-        }
-
-        if (exponent != 0)
-        {
-            if (decLength != 0)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "exponent can not be present if decimal part is.");
-                return 0;
-            }
-            intLength += 2;
-            decLength = prv_intToBufferLength(exponent);
-        }
-
-        return intLength + decLength;
-    }
+    return prv_floatToBuffer(data, withExponent, NULL, 0);
 }
 
 size_t dataUtilsFloatToBuffer(double data,
@@ -679,128 +1048,7 @@ size_t dataUtilsFloatToBuffer(double data,
 {
     assert(buffer != NULL && length != 0);
 
-    if (data > (double)INT64_MAX
-        || data < (double)INT64_MIN)
-    {
-        return 0;
-    }
-    else
-    {
-        size_t intLength;
-        size_t decLength;
-        int64_t intPart;
-        double decPart;
-        int exponent;
-
-        if (withExponent == true)
-        {
-            exponent = prv_isExponentPossibleForDecPart(&data);
-        }
-        else
-        {
-            exponent = 0;
-        }
-
-        intPart = (int64_t)data;
-        decPart = data - (double)intPart;
-        if (decPart < 0)
-        {
-            decPart = 1 - decPart;
-        }
-        else
-        {
-            decPart = 1 + decPart;
-        }
-
-        if (decPart <= 1 + (double)FLT_EPSILON)
-        {
-            decPart = 0;
-        }
-
-        if (intPart == 0 && data < 0)
-        {
-            // deal with numbers between -1 and 0
-            if (length < 4)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
-                return 0;   // "-0.n"
-            }
-            buffer[0] = '-';
-            buffer[1] = '0';
-            intLength = 2;
-        }
-        else
-        {
-            bool setExponent;
-
-            if (withExponent == false
-                || decPart >= (double)FLT_EPSILON)
-            {
-                setExponent = false;
-            }
-            else
-            {
-                setExponent = true;
-            }
-            // Call the utils function to take exponent in account
-            intLength = dataUtilsIntToBuffer(intPart, buffer, length, setExponent);
-
-            if (intLength == 0)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "failed to recover integer part.");
-                return 0;
-            }
-        }
-        decLength = 0;
-        if (decPart >= (double)FLT_EPSILON)
-        {
-            double noiseFloor;
-
-            if (intLength >= length - 1)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
-                return 0;
-            }
-
-            noiseFloor = (double)FLT_EPSILON;
-            do
-            {
-                decPart *= 10;
-                noiseFloor *= 10;
-            } while (decPart - (double)((int64_t)decPart) > noiseFloor); // Compare the integer part of decPart with possible noise
-
-            decLength = prv_intToBuffer((int64_t)decPart, buffer + intLength, length - intLength);
-            if (decLength <= 1)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "failed to recover decimal part.");
-                return 0;
-            }
-
-            // replace the leading 1 with a dot
-            buffer[intLength] = '.';
-        }
-
-        if (exponent != 0)
-        {
-            if (length < intLength + decLength + 2)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "buffer length too short.");
-                return 0;
-            }
-            buffer[intLength] = PRV_EXPONENT_MIN;
-            intLength++;
-            buffer[intLength] = PRV_MINUS_SIGN;
-            intLength++;
-            decLength = prv_intToBuffer(exponent, buffer + intLength, length - intLength);
-            if (decLength == 0)
-            {
-                IOWA_LOG_TRACE(IOWA_PART_DATA, "Adding exponent not possible.");
-                return 0;
-            }
-        }
-
-        return intLength + decLength;
-    }
+    return prv_floatToBuffer(data, withExponent, buffer, length);
 }
 
 size_t dataUtilsBufferToObjectLink(uint8_t *buffer,
@@ -1502,6 +1750,17 @@ void dataUtilsGetUri(iowa_lwm2m_data_t *dataP, iowa_lwm2m_uri_t *uriP)
     uriP->resInstanceId = dataP->resInstanceID;
 }
 
+void dataUtilsSetUri(iowa_lwm2m_data_t *dataP, iowa_lwm2m_uri_t *uriP)
+{
+    assert(dataP != NULL);
+    assert(uriP != NULL);
+
+    dataP->objectID = uriP->objectId;
+    dataP->instanceID = uriP->instanceId;
+    dataP->resourceID = uriP->resourceId;
+    dataP->resInstanceID = uriP->resInstanceId;
+}
+
 bool dataUtilsCompareFloatingPointNumbers(double num1,
                                           double num2)
 {
@@ -1519,3 +1778,40 @@ bool dataUtilsCompareFloatingPointNumbers(double num1,
 /**************************************************************
  * Half float conversion
  **************************************************************/
+
+float dataUtilsConvertHalfFloatToFloat(uint16_t halfFloat)
+{
+    uint32_t bits;
+    uint32_t exponent;
+    uint32_t mantissa;
+    float result;
+
+    bits = (uint32_t)(halfFloat & 0x8000U) << 16;
+    exponent = (halfFloat >> 10) & 0x1FU;
+    mantissa = halfFloat & 0x03FFU;
+
+    if (exponent == 0x1FU)
+    {
+        // Infinity or NaN
+        bits |= 0x7F800000U | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits |= ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    else if (mantissa != 0)
+    {
+        // Subnormal half float: normalize it as single precision floats have a wider exponent range
+        exponent = 127 - 15 + 1;
+        while ((mantissa & 0x0400U) == 0)
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits |= (exponent << 23) | ((mantissa & 0x03FFU) << 13);
+    }
+
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
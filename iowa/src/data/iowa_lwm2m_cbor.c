@@ -26,5 +26,491 @@
 *************************************************************************************/
 
 #include "iowa_prv_data_internals.h"
-#include <float.h>
 
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+
+#define PRV_PATH_MAX_DEPTH LWM2M_URI_DEPTH_RESOURCE_INSTANCE
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Get a segment of the path of a data.
+// Returned value: the segment.
+// Parameters:
+// - dataP: the data.
+// - depth: index of the segment, from 0 (Object ID) to 3 (Resource Instance ID).
+static uint16_t prv_getSegment(iowa_lwm2m_data_t *dataP,
+                               uint8_t depth)
+{
+    switch (depth)
+    {
+    case 0:
+        return dataP->objectID;
+
+    case 1:
+        return dataP->instanceID;
+
+    case 2:
+        return dataP->resourceID;
+
+    default:
+        return dataP->resInstanceID;
+    }
+}
+
+// Set a segment of an URI.
+// Returned value: None.
+// Parameters:
+// - uriP: the URI.
+// - depth: index of the segment, from 0 (Object ID) to 3 (Resource Instance ID).
+// - segment: the value of the segment.
+static void prv_setSegment(iowa_lwm2m_uri_t *uriP,
+                           uint8_t depth,
+                           uint16_t segment)
+{
+    switch (depth)
+    {
+    case 0:
+        uriP->objectId = segment;
+        break;
+
+    case 1:
+        uriP->instanceId = segment;
+        break;
+
+    case 2:
+        uriP->resourceId = segment;
+        break;
+
+    default:
+        uriP->resInstanceId = segment;
+        break;
+    }
+}
+
+// Get the number of segments of the path of a data.
+// Returned value: LWM2M_URI_DEPTH_RESOURCE or LWM2M_URI_DEPTH_RESOURCE_INSTANCE.
+// Parameters:
+// - dataP: the data.
+static uint8_t prv_getDepth(iowa_lwm2m_data_t *dataP)
+{
+    if (dataP->resInstanceID != IOWA_LWM2M_ID_ALL)
+    {
+        return LWM2M_URI_DEPTH_RESOURCE_INSTANCE;
+    }
+
+    return LWM2M_URI_DEPTH_RESOURCE;
+}
+
+// Encode data sharing the same first path segments as a map.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - dataP, size: data to encode.
+// - depth: number of path segments shared by all the data and already encoded in the parent keys.
+// - bufferP: buffer in which the map will be added. If nil, only bufferIndexP is updated.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: IN/OUT. current buffer index.
+static int8_t prv_encodeMap(iowa_lwm2m_data_t *dataP,
+                            size_t size,
+                            uint8_t depth,
+                            uint8_t *bufferP,
+                            size_t bufferLength,
+                            size_t *bufferIndexP)
+{
+    size_t groupCount;
+    size_t i;
+    size_t j;
+    size_t k;
+
+    // Each distinct segment at this depth is a key of the map
+    groupCount = 0;
+    for (i = 0; i < size; i++)
+    {
+        if (i == 0
+            || prv_getSegment(dataP + i, depth) != prv_getSegment(dataP + i - 1, depth))
+        {
+            groupCount++;
+        }
+    }
+
+    if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS, groupCount, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    for (i = 0; i < size; i = j)
+    {
+        uint8_t keyEnd;
+        uint8_t segment;
+        bool isShared;
+
+        for (j = i + 1; j < size && prv_getSegment(dataP + j, depth) == prv_getSegment(dataP + i, depth); j++)
+        {
+            // Find the end of the group
+        }
+
+        // Merge in the key the following segments shared by the whole group
+        keyEnd = (uint8_t)(depth + 1);
+        do
+        {
+            isShared = true;
+            for (k = i; k < j && isShared == true; k++)
+            {
+                if (prv_getDepth(dataP + k) <= keyEnd
+                    || prv_getSegment(dataP + k, keyEnd) != prv_getSegment(dataP + i, keyEnd))
+                {
+                    isShared = false;
+                }
+            }
+            if (isShared == true)
+            {
+                keyEnd++;
+            }
+        } while (isShared == true);
+
+        for (k = i; k < j; k++)
+        {
+            if (prv_getDepth(dataP + k) == keyEnd
+                && j - i > 1)
+            {
+                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Data /%u/%u/%u/%u is duplicated or has a value and children.", dataP[k].objectID, dataP[k].instanceID, dataP[k].resourceID, dataP[k].resInstanceID);
+                return CBOR_ERROR;
+            }
+        }
+
+        // Add the key
+        if (keyEnd - depth > 1)
+        {
+            if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, (uint64_t)(keyEnd - depth), bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+        for (segment = depth; segment < keyEnd; segment++)
+        {
+            if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_UNSIGNED_INTEGER, prv_getSegment(dataP + i, segment), bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+
+        // Add the value
+        if (j - i == 1
+            && prv_getDepth(dataP + i) == keyEnd)
+        {
+            if (cborAddDataToBuffer(dataP + i, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+        else
+        {
+            if (prv_encodeMap(dataP + i, j - i, keyEnd, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+// Parse a map of the LwM2M CBOR payload.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - addInfo, number: the head of the map, already read.
+// - bufferP: the buffer.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: IN/OUT. current buffer index, after the head of the map.
+// - uriP: the path of the map. It is modified during the parsing.
+// - depth: number of segments of uriP.
+// - baseUriP, baseUriDepth: the URI the data must be under.
+// - dataP: OUT. array receiving the data. If nil, the data are only counted.
+// - dataCountP: IN/OUT. number of data found so far.
+static int8_t prv_parseMap(uint8_t addInfo,
+                           uint64_t number,
+                           uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP,
+                           iowa_lwm2m_uri_t *uriP,
+                           uint8_t depth,
+                           iowa_lwm2m_uri_t *baseUriP,
+                           lwm2m_uri_depth_t baseUriDepth,
+                           iowa_lwm2m_data_t *dataP,
+                           size_t *dataCountP)
+{
+    uint64_t pairIndex;
+
+    for (pairIndex = 0; addInfo == CBOR_ADD_INFO_VALUE_BREAK || pairIndex < number; pairIndex++)
+    {
+        major_type_t majorType;
+        uint8_t keyAddInfo;
+        uint64_t keyNumber;
+        uint8_t valueAddInfo;
+        uint64_t valueNumber;
+        uint8_t newDepth;
+        size_t valueIndex;
+        iowa_lwm2m_uri_t uri;
+
+        if (addInfo == CBOR_ADD_INFO_VALUE_BREAK
+            && *bufferIndexP < bufferLength
+            && bufferP[*bufferIndexP] == CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK))
+        {
+            *bufferIndexP += 1;
+            break;
+        }
+
+        // Read the key: a path segment or an array of path segments
+        uri = *uriP;
+        newDepth = depth;
+        majorType = cborPutBufferToNumber(&keyNumber, &keyAddInfo, bufferP, bufferLength, bufferIndexP);
+        switch (majorType)
+        {
+        case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+            if (newDepth >= PRV_PATH_MAX_DEPTH
+                || keyNumber >= IOWA_LWM2M_ID_ALL)
+            {
+                IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid path segment.");
+                return CBOR_ERROR;
+            }
+            prv_setSegment(&uri, newDepth, (uint16_t)keyNumber);
+            newDepth++;
+            break;
+
+        case CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS:
+        {
+            uint64_t segmentIndex;
+
+            if (keyAddInfo == CBOR_ADD_INFO_VALUE_BREAK
+                || keyNumber == 0
+                || keyNumber > (uint64_t)(PRV_PATH_MAX_DEPTH - newDepth))
+            {
+                IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid path array.");
+                return CBOR_ERROR;
+            }
+            for (segmentIndex = 0; segmentIndex < keyNumber; segmentIndex++)
+            {
+                uint64_t segment;
+
+                if (cborPutBufferToNumber(&segment, NULL, bufferP, bufferLength, bufferIndexP) != CBOR_MAJOR_TYPE_UNSIGNED_INTEGER
+                    || segment >= IOWA_LWM2M_ID_ALL)
+                {
+                    IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid path segment.");
+                    return CBOR_ERROR;
+                }
+                prv_setSegment(&uri, newDepth, (uint16_t)segment);
+                newDepth++;
+            }
+            break;
+        }
+
+        default:
+            IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Invalid key major type %d.", majorType);
+            return CBOR_ERROR;
+        }
+
+        // Read the value: a nested map or a resource value
+        valueIndex = *bufferIndexP;
+        majorType = cborPutBufferToNumber(&valueNumber, &valueAddInfo, bufferP, bufferLength, bufferIndexP);
+        if (majorType == CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+        {
+            if (prv_parseMap(valueAddInfo, valueNumber, bufferP, bufferLength, bufferIndexP, &uri, newDepth, baseUriP, baseUriDepth, dataP, dataCountP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+            continue;
+        }
+        if (majorType == CBOR_MAJOR_TYPE_NONE)
+        {
+            return CBOR_ERROR;
+        }
+
+        if (newDepth < LWM2M_URI_DEPTH_RESOURCE)
+        {
+            IOWA_LOG_INFO(IOWA_PART_DATA, "Values must be at the resource or resource instance level.");
+            return CBOR_ERROR;
+        }
+
+        if (dataP == NULL)
+        {
+            iowa_lwm2m_data_t data;
+
+            dataUtilsSetUri(&data, &uri);
+            if (baseUriP != NULL
+                && dataUtilsIsInBaseUri(&data, baseUriP, baseUriDepth) == false)
+            {
+                IOWA_LOG_INFO(IOWA_PART_DATA, "Data is not under the base URI.");
+                return CBOR_ERROR;
+            }
+
+            *bufferIndexP = valueIndex;
+            if (cborSkipItem(bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+        else
+        {
+            dataUtilsSetUri(dataP + *dataCountP, &uri);
+            if (cborPutBufferToData(majorType, valueAddInfo, valueNumber, dataP + *dataCountP, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+        *dataCountP += 1;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+// Parse the LwM2M CBOR payload.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP, bufferLength: the payload.
+// - baseUriP: the URI the data must be under. This can be nil.
+// - dataP: OUT. array receiving the data. If nil, the data are only counted.
+// - dataCountP: OUT. number of data found.
+static int8_t prv_parsePayload(uint8_t *bufferP,
+                               size_t bufferLength,
+                               iowa_lwm2m_uri_t *baseUriP,
+                               iowa_lwm2m_data_t *dataP,
+                               size_t *dataCountP)
+{
+    size_t index;
+    uint8_t addInfo;
+    uint64_t number;
+    iowa_lwm2m_uri_t uri;
+    lwm2m_uri_depth_t baseUriDepth;
+
+    *dataCountP = 0;
+    index = 0;
+    LWM2M_URI_RESET(&uri);
+    baseUriDepth = (baseUriP == NULL) ? LWM2M_URI_DEPTH_ROOT : dataUtilsGetUriDepth(baseUriP);
+
+    if (cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, &index) != CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "LwM2M CBOR payload is not a map.");
+        return CBOR_ERROR;
+    }
+
+    if (prv_parseMap(addInfo, number, bufferP, bufferLength, &index, &uri, 0, baseUriP, baseUriDepth, dataP, dataCountP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    if (index != bufferLength)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "%u bytes remaining after the LwM2M CBOR map.", bufferLength - index);
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t lwm2mCborSerialize(iowa_lwm2m_data_t *dataP,
+                                 size_t size,
+                                 size_t headroom,
+                                 uint8_t **bufferP,
+                                 size_t *bufferLengthP)
+{
+    size_t index;
+
+    assert(dataP != NULL);
+    assert(size != 0);
+    assert(bufferP != NULL);
+    assert(bufferLengthP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "size: %u", size);
+
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
+    for (index = 0; index < size; index++)
+    {
+        if (dataP[index].resourceID == IOWA_LWM2M_ID_ALL)
+        {
+            IOWA_LOG_WARNING(IOWA_PART_DATA, "Data must be at the resource or resource instance level.");
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+    }
+
+    // First pass to get the exact length, second pass to write the payload
+    if (prv_encodeMap(dataP, size, 0, NULL, 0, bufferLengthP) != CBOR_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Failed to retrieve the length");
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(headroom + *bufferLengthP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(headroom + *bufferLengthP);
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    index = headroom;
+    if (prv_encodeMap(dataP, size, 0, *bufferP, headroom + *bufferLengthP, &index) != CBOR_NO_ERROR)
+    {
+        iowa_system_free(*bufferP);
+        *bufferP = NULL;
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "Returning %u bytes", *bufferLengthP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t lwm2mCborDeserialize(iowa_lwm2m_uri_t *baseUriP,
+                                   uint8_t *bufferP,
+                                   size_t bufferLength,
+                                   iowa_lwm2m_data_t **dataP,
+                                   size_t *dataCountP)
+{
+    size_t dataCount;
+
+    IOWA_LOG_BUFFER_TRACE(IOWA_PART_DATA, "Parsing LwM2M CBOR buffer", bufferP, bufferLength);
+
+    *dataP = NULL;
+    *dataCountP = 0;
+
+    // First pass to validate the payload and count the data
+    if (prv_parsePayload(bufferP, bufferLength, baseUriP, NULL, &dataCount) != CBOR_NO_ERROR
+        || dataCount == 0)
+    {
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(dataCount * sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(dataCount * sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataP, 0, dataCount * sizeof(iowa_lwm2m_data_t));
+
+    if (prv_parsePayload(bufferP, bufferLength, baseUriP, *dataP, dataCountP) != CBOR_NO_ERROR)
+    {
+        // Only a memory allocation can fail after the first pass
+        dataLwm2mFree(dataCount, *dataP);
+        *dataP = NULL;
+        *dataCountP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // LWM2M_SUPPORT_LWM2M_CBOR
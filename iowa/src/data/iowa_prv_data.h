@@ -78,12 +78,14 @@ typedef iowa_lwm2m_data_type_t(*data_resource_type_callback_t) (uint16_t objectI
 // - baseUriP: IN. the base URI of the serialized data. This can be nil.
 // - dataP, dataCount: IN. data to serialize.
 // - contentFormatP: IN/OUT. required content format to serialize to. It can be changed to a default content format if using the required one is not possible.
-// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+// - headroom: number of bytes to reserve before the payload in the allocated buffer, e.g. to later write a CoAP header in place.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload. The payload starts at bufferP + headroom and bufferLengthP does not include the headroom.
 // Notes:
 // - TEXT, OPAQUE and CBOR formats can not serialize several data nor data at instance or object level
 // - OPAQUE format can only serialize data with Opaque type
 // - baseUriP is only used for the TLV and JSON formats
-iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP, iowa_lwm2m_data_t *dataP, size_t dataCount, iowa_content_format_t *contentFormatP, uint8_t **bufferP, size_t *bufferLengthP);
+// - when there is no payload, bufferP is nil and no headroom is allocated
+iowa_status_t dataLwm2mSerialize(iowa_lwm2m_uri_t *baseUriP, iowa_lwm2m_data_t *dataP, size_t dataCount, iowa_content_format_t *contentFormatP, size_t headroom, uint8_t **bufferP, size_t *bufferLengthP);
 
 // Deserialize LwM2M data.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
@@ -172,19 +174,21 @@ size_t dataUtilsIntToBuffer(int64_t data, uint8_t *buffer, size_t length, bool w
 size_t dataUtilsBufferToFloat(uint8_t *buffer, size_t length, double *dataP);
 
 // Get the buffer length of a float number
-// Returned value: the length of the buffer
+// Returned value: the length of the buffer, 0 for an infinite or NaN number
 // Parameters:
 // - data: the float to convert.
-// - withExponent: boolean to use the exponent form.
+// - withExponent: boolean to use the exponent form when it is shorter.
+// Note: the text is the shortest one reading back to the same double. The exponent form is always used below 1e-6 and from 1e21.
 size_t dataUtilsFloatToBufferLength(double data, bool withExponent);
 
 // Convert a float to a buffer
-// Returned value: the length of the buffer
+// Returned value: the length of the buffer, 0 in case of error
 // Parameters:
 // - data: the float to convert.
 // - buffer: the buffer.
 // - length: the length of the buffer.
-// - withExponent: boolean to use the exponent form
+// - withExponent: boolean to use the exponent form when it is shorter.
+// Note: see dataUtilsFloatToBufferLength().
 size_t dataUtilsFloatToBuffer(double data, uint8_t *buffer, size_t length, bool withExponent);
 
 // Convert a buffer to a LwM2M data with object link type
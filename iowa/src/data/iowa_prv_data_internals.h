@@ -90,16 +90,20 @@ typedef enum
 }
 
 /****************************
-* Used for CBOR and SenML CBOR serialization
+* Used for CBOR, SenML CBOR and LwM2M CBOR serialization
+*
+* When bufferP is nil, the functions only advance
+* bufferIndexP. This allows to compute the exact size
+* of a payload with the same code used to write it.
 */
 
 // Add Text string to a cbor buffer.
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
 // - stringP, stringSize: the string to add.
-// - bufferP: buffer in which the number will be added.
+// - bufferP: buffer in which the number will be added. This can be nil.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
+// - bufferIndexP: IN/OUT. current buffer index.
 // - isByteString: indicate if major type is Text string or Byte string
 int8_t cborAddStringToBuffer(uint8_t *stringP, size_t stringSize, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP, bool isByteString);
 
@@ -114,11 +118,20 @@ size_t cborGetNumberToBufferLength(uint64_t number);
 // Parameters:
 // - majorType: major type of the number.
 // - number: the number to add.
-// - bufferP: buffer in which the number will be added.
+// - bufferP: buffer in which the number will be added. This can be nil.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
+// - bufferIndexP: IN/OUT. current buffer index.
 int8_t cborAddNumberToBuffer(major_type_t majorType, uint64_t number, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
+// Add a signed integer to a cbor buffer.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - number: the number to add. It is encoded as an unsigned or a negative integer.
+// - bufferP: buffer in which the number will be added. This can be nil.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: IN/OUT. current buffer index.
+int8_t cborAddIntegerToBuffer(int64_t number, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
+
 // Get size that the float number could take on cbor buffer.
 // Returned value: size that the number could take on cbor buffer.
 // Parameters:
@@ -128,14 +141,14 @@ size_t cborGetFloatToBufferLength(double number);
 // Add float number to a cbor buffer.
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
-// - number: the number to add.
-// - bufferP: buffer in which the number will be added.
+// - number: the number to add. It is encoded as a half, single or double precision float, the shortest one keeping the value.
+// - bufferP: buffer in which the number will be added. This can be nil.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
+// - bufferIndexP: IN/OUT. current buffer index.
 int8_t cborAddFloatToBuffer(double number, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
 // Get size that the LwM2M data could take on cbor buffer.
-// Returned value: size that the number could take on cbor buffer.
+// Returned value: size that the number could take on cbor buffer, 0 if the data type is not supported.
 // Parameters:
 // - dataP: the data to put in a buffer.
 size_t cborGetDataToBufferLength(iowa_lwm2m_data_t *dataP);
@@ -144,66 +157,76 @@ size_t cborGetDataToBufferLength(iowa_lwm2m_data_t *dataP);
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
 // - dataP: the data to add.
-// - bufferP: buffer in which the data will be added.
+// - bufferP: buffer in which the data will be added. This can be nil.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
+// - bufferIndexP: IN/OUT. current buffer index.
 int8_t cborAddDataToBuffer(iowa_lwm2m_data_t *dataP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
 /****************************
-* Used for CBOR and SenML CBOR deserialization
+* Used for CBOR, SenML CBOR and LwM2M CBOR deserialization
+*
+* The payload is parsed in place. An item is read in two
+* steps: cborPutBufferToNumber() reads its head, then
+* its content is read according to the major type.
 */
 
-// Put cbor buffer to number.
-// Returned value: major type of the number in case of success else CBOR_MAJOR_TYPE_NONE if any error.
+// Read the head of a cbor item.
+// Returned value: major type of the item in case of success else CBOR_MAJOR_TYPE_NONE if any error.
 // Parameters:
-// - number: the number in which the buffer will be put.
+// - numberP: OUT. the argument of the item: integer value, string length, number of items, tag, simple value or float bits.
+// - addInfoP: OUT. the additional information of the item. CBOR_ADD_INFO_VALUE_BREAK for indefinite lengths and breaks. This can be nil.
 // - bufferNumberP: the buffer to get number.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
-major_type_t cborPutBufferToNumber(uint64_t *numberP, uint8_t *bufferNumberP, size_t bufferLength, size_t *bufferIndexP);
+// - bufferIndexP: IN/OUT. current buffer index.
+major_type_t cborPutBufferToNumber(uint64_t *numberP, uint8_t *addInfoP, uint8_t *bufferNumberP, size_t bufferLength, size_t *bufferIndexP);
+
+// Skip a cbor item and its content.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the buffer.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: IN/OUT. current buffer index.
+int8_t cborSkipItem(uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
-// Get size that the string could take on cbor buffer.
+// Get the length of a string whose head was read.
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
 // - majorType: major type of the string (CBOR_MAJOR_TYPE_BYTE_STRING or CBOR_MAJOR_TYPE_TEXT_STRING).
-// - convertResult: initial byte of cbor item.
-// - stringLengthP: the string length.
+// - addInfo, number: the head of the string.
+// - stringLengthP: OUT. the string length. For indefinite length strings, this is the sum of the chunk lengths.
 // - bufferP: the buffer to get string.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
-int8_t cborGetBufferToStringLength(major_type_t majorType, uint64_t convertResult, size_t *stringLengthP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
+// - bufferIndex: buffer index after the head of the string.
+int8_t cborGetBufferToStringLength(major_type_t majorType, uint8_t addInfo, uint64_t number, size_t *stringLengthP, uint8_t *bufferP, size_t bufferLength, size_t bufferIndex);
 
 // Put cbor buffer to a string.
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
 // - majorType: major type of the string (CBOR_MAJOR_TYPE_BYTE_STRING or CBOR_MAJOR_TYPE_TEXT_STRING).
-// - convertResult: initial byte of cbor item.
-// - stringP, stringLengthP: the string in which the buffer will be put.
+// - addInfo, number: the head of the string.
+// - stringP, stringLength: the string in which the buffer will be put. stringLength is returned by cborGetBufferToStringLength(). stringP can be nil to skip the string.
 // - bufferP: the buffer to get string.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
-int8_t cborPutBufferToString(major_type_t majorType, uint64_t convertResult, uint8_t **stringP, size_t *stringLengthP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
+// - bufferIndexP: IN/OUT. current buffer index, after the head of the string.
+int8_t cborPutBufferToString(major_type_t majorType, uint8_t addInfo, uint64_t number, uint8_t *stringP, size_t stringLength, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
-// Get value number from float major type cbor buffer.
+// Get value from float major type cbor item.
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
-// - convertResult: initial byte of cbor item.
-// - dataP: data in which the buffer will be put.
-// - bufferP: the buffer to get data.
-// - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
-int8_t cborGetValueFromFloatMajorType(uint64_t convertResult, iowa_lwm2m_data_t *dataP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
+// - addInfo, number: the head of the item.
+// - dataP: data in which the value will be put.
+int8_t cborGetValueFromFloatMajorType(uint8_t addInfo, uint64_t number, iowa_lwm2m_data_t *dataP);
 
 // Put cbor buffer to a LwM2M Data.
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
 // Parameters:
 // - majorType: major type of the value
-// - convertResult: initial byte of cbor item.
-// - dataP: data in which the buffer will be put.
+// - addInfo, number: the head of the value.
+// - dataP: data in which the buffer will be put. Strings are copied in a dynamically allocated buffer.
 // - bufferP: the buffer to get data.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
-int8_t cborPutBufferToData(major_type_t majorType, uint64_t convertResult, iowa_lwm2m_data_t *dataP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
+// - bufferIndexP: IN/OUT. current buffer index, after the head of the value.
+int8_t cborPutBufferToData(major_type_t majorType, uint8_t addInfo, uint64_t number, iowa_lwm2m_data_t *dataP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
 // Handle decimal fraction, put buffer decimal fraction into data.value.asFloat
 // Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
@@ -211,7 +234,7 @@ int8_t cborPutBufferToData(major_type_t majorType, uint64_t convertResult, iowa_
 // - dataP: data in which the buffer will be put.
 // - bufferP: the buffer to get data.
 // - bufferLength: maximal size of the buffer.
-// - bufferIndexP: current buffer index.
+// - bufferIndexP: IN/OUT. current buffer index, after the tag.
 // Note: only if majorType is CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC with tag CBOR_ADD_INFO_DECIMAL_FRAC
 int8_t cborHandleDecimalFraction(iowa_lwm2m_data_t *dataP, uint8_t *bufferP, size_t bufferLength, size_t *bufferIndexP);
 
@@ -239,9 +262,10 @@ iowa_status_t dataLwm2mConsolidate(size_t dataCount, iowa_lwm2m_data_t *dataArra
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - dataP: data to serialize.
-// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+// - headroom: number of bytes to reserve before the payload in the allocated buffer.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload. The payload starts at bufferP + headroom and bufferLengthP does not include the headroom.
 // Note: Support string, opaque, integer, float, boolean, core link, object link, time and unsigned integer type
-iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP, uint8_t **bufferP, size_t *bufferLengthP);
+iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP, size_t headroom, uint8_t **bufferP, size_t *bufferLengthP);
 
 // Convert TEXT buffer into LwM2M data.
 // The LwM2M data type is set to IOWA_LWM2M_TYPE_STRING.
@@ -262,9 +286,10 @@ iowa_status_t textDeserialize(iowa_lwm2m_uri_t *baseUriP, uint8_t *bufferP, size
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - dataP: data to serialize.
-// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+// - headroom: number of bytes to reserve before the payload in the allocated buffer.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload. The payload starts at bufferP + headroom and bufferLengthP does not include the headroom.
 // Note: Support opaque, undefined type
-iowa_status_t opaqueSerialize(iowa_lwm2m_data_t *dataP, uint8_t **bufferP, size_t *bufferLengthP);
+iowa_status_t opaqueSerialize(iowa_lwm2m_data_t *dataP, size_t headroom, uint8_t **bufferP, size_t *bufferLengthP);
 
 // Convert OPAQUE buffer into  data.
 // The LwM2M data type is set to IOWA_LWM2M_TYPE_OPAQUE.
@@ -285,9 +310,10 @@ iowa_status_t opaqueDeserialize(iowa_lwm2m_uri_t *baseUriP, uint8_t *bufferP, si
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - dataP: data to serialize.
-// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+// - headroom: number of bytes to reserve before the payload in the allocated buffer.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload. The payload starts at bufferP + headroom and bufferLengthP does not include the headroom.
 // Note: Support string, opaque, integer, float, boolean, core link, object link, time and unsigned integer type
-iowa_status_t cborSerialize(iowa_lwm2m_data_t *dataP, uint8_t **bufferP, size_t *bufferLengthP);
+iowa_status_t cborSerialize(iowa_lwm2m_data_t *dataP, size_t headroom, uint8_t **bufferP, size_t *bufferLengthP);
 
 // Convert CBOR buffer into LwM2M data.
 // The LwM2M data type is set to the CBOR data type.
@@ -338,24 +364,26 @@ iowa_status_t senmlJsonDeserialize(uint8_t *buffer, size_t bufferLength, iowa_lw
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
 // - dataP, size: data to serialize.
-// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+// - headroom: number of bytes to reserve before the payload in the allocated buffer.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload. The payload starts at bufferP + headroom and bufferLengthP does not include the headroom.
 // Note:
 // - Support string, opaque, integer, float, boolean, core link, object link, time, unsigned integer type
 // - Base name is only present when there are several data
 // - Support timestamp, URI only
-iowa_status_t senmlCborSerialize(iowa_lwm2m_data_t *dataP, size_t size, uint8_t **bufferP, size_t *bufferLengthP);
+iowa_status_t senmlCborSerialize(iowa_lwm2m_data_t *dataP, size_t size, size_t headroom, uint8_t **bufferP, size_t *bufferLengthP);
 
 // Convert SenML CBOR buffer into LwM2M data.
 // The LwM2M data type is set to the SenML data type.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
+// - baseUriP: the URI targeted by the operation. The data must be under it. This can be nil.
 // - bufferP, bufferLength: payload to deserialize.
 // - dataP, dataCount: OUT. data deserialized, dynamically allocated.
 // Note:
-// - Support floating timestamp, URI only
+// - Support integer timestamp, URI only
 // - Support Half float, decimal fraction, null and undefined value
 // - Support Indefinite size of array, map, text string and byte string
-iowa_status_t senmlCborDeserialize(uint8_t *buffer, size_t bufferLength, iowa_lwm2m_data_t **dataP, size_t *dataCountP);
+iowa_status_t senmlCborDeserialize(iowa_lwm2m_uri_t *baseUriP, uint8_t *bufferP, size_t bufferLength, iowa_lwm2m_data_t **dataP, size_t *dataCountP);
 
 /**************************************************************
  * Function to serialize / deserialize data in LwM2M CBOR
@@ -365,16 +393,19 @@ iowa_status_t senmlCborDeserialize(uint8_t *buffer, size_t bufferLength, iowa_lw
 // Convert LwM2M data into LwM2M CBOR buffer.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
-// - baseUriP: URI targeted by the operation
 // - dataP, size: data to serialize.
-// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
-iowa_status_t lwm2mCborSerialize(iowa_lwm2m_uri_t *baseUriP, iowa_lwm2m_data_t *dataP, size_t size, uint8_t **bufferP, size_t *bufferLengthP);
+// - headroom: number of bytes to reserve before the payload in the allocated buffer.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload. The payload starts at bufferP + headroom and bufferLengthP does not include the headroom.
+// Note:
+// - the data with the same Object ID, Object Instance ID or Resource ID must be contiguous
+// - a path segment shared by all the data below it is merged with the next ones in an array key
+iowa_status_t lwm2mCborSerialize(iowa_lwm2m_data_t *dataP, size_t size, size_t headroom, uint8_t **bufferP, size_t *bufferLengthP);
 
 // Convert LwM2M CBOR buffer into LwM2M data.
 // The LwM2M data type is set to the CBOR data type.
 // Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
 // Parameters:
-// - baseUriP: URI targeted by the operation
+// - baseUriP: URI targeted by the operation. The data must be under it. This can be nil.
 // - bufferP, bufferLength: payload to deserialize.
 // - dataP, dataCount: OUT. data deserialized, dynamically allocated.
 iowa_status_t lwm2mCborDeserialize(iowa_lwm2m_uri_t *baseUriP, uint8_t *bufferP, size_t bufferLength, iowa_lwm2m_data_t **dataP, size_t *dataCountP);
@@ -389,12 +420,13 @@ iowa_status_t lwm2mCborDeserialize(iowa_lwm2m_uri_t *baseUriP, uint8_t *bufferP,
 // Parameters:
 // - baseUriP: the base URI of the serialized data. Can not be the Root path.
 // - dataP, size: data to serialize.
-// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload.
+// - headroom: number of bytes to reserve before the payload in the allocated buffer.
+// - bufferP, bufferLengthP: OUT. serialized, dynamically allocated payload. The payload starts at bufferP + headroom and bufferLengthP does not include the headroom.
 // Note:
 // - Support string, opaque, integer, float, boolean, core link, object link, time, unsigned integer type
 // - If a data is not corresponding to the base uri, it is ignored
 // - data should be at resource or resource instance level
-iowa_status_t tlvSerialize(iowa_lwm2m_uri_t *baseUriP, iowa_lwm2m_data_t *dataP, size_t size, uint8_t **bufferP, size_t *bufferLengthP);
+iowa_status_t tlvSerialize(iowa_lwm2m_uri_t *baseUriP, iowa_lwm2m_data_t *dataP, size_t size, size_t headroom, uint8_t **bufferP, size_t *bufferLengthP);
 
 // Convert TLV buffer into LwM2M data.
 // The LwM2M data type is set to IOWA_LWM2M_TYPE_UNDEFINED.
@@ -27,3 +27,678 @@
 #include "iowa_prv_data_internals.h"
 #include <float.h>
 
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+
+// SenML labels as defined in RFC 8428
+#define PRV_SENML_CBOR_LABEL_BASE_NAME     -2
+#define PRV_SENML_CBOR_LABEL_BASE_TIME     -3
+#define PRV_SENML_CBOR_LABEL_NAME          0
+#define PRV_SENML_CBOR_LABEL_VALUE         2
+#define PRV_SENML_CBOR_LABEL_STRING_VALUE  3
+#define PRV_SENML_CBOR_LABEL_BOOLEAN_VALUE 4
+#define PRV_SENML_CBOR_LABEL_TIME          6
+#define PRV_SENML_CBOR_LABEL_DATA_VALUE    8
+
+// LwM2M extension for Object Link values
+#define PRV_SENML_CBOR_LABEL_OBJECT_LINK_VALUE     "vlo"
+#define PRV_SENML_CBOR_LABEL_OBJECT_LINK_VALUE_LEN 3
+
+// "/65535/65535/65535/65535"
+#define PRV_SENML_NAME_MAX_LENGTH 25
+
+/*************************************************************************************
+** Private functions
+*************************************************************************************/
+
+// Write the path segments of an URI deeper than a base depth as text.
+// Returned value: the length of the text, 0 in case of error.
+// Parameters:
+// - uriP: the URI.
+// - fromDepth: the number of segments to skip.
+// - withLeadingSlash: if true, the text starts with a '/'.
+// - withTrailingSlash: if true, the text ends with a '/'.
+// - nameP: OUT. the text. Its size is PRV_SENML_NAME_MAX_LENGTH.
+static size_t prv_uriToName(iowa_lwm2m_uri_t *uriP,
+                            lwm2m_uri_depth_t fromDepth,
+                            bool withLeadingSlash,
+                            bool withTrailingSlash,
+                            uint8_t *nameP)
+{
+    uint16_t segments[4];
+    lwm2m_uri_depth_t depth;
+    lwm2m_uri_depth_t i;
+    size_t length;
+
+    segments[0] = uriP->objectId;
+    segments[1] = uriP->instanceId;
+    segments[2] = uriP->resourceId;
+    segments[3] = uriP->resInstanceId;
+    depth = dataUtilsGetUriDepth(uriP);
+
+    length = 0;
+    for (i = fromDepth; i < depth; i++)
+    {
+        size_t res;
+
+        if (i != fromDepth
+            || withLeadingSlash == true)
+        {
+            nameP[length] = '/';
+            length++;
+        }
+        res = dataUtilsIntToBuffer(segments[i], nameP + length, PRV_SENML_NAME_MAX_LENGTH - length, false);
+        if (res == 0)
+        {
+            return 0;
+        }
+        length += res;
+    }
+
+    if (withTrailingSlash == true)
+    {
+        nameP[length] = '/';
+        length++;
+    }
+
+    return length;
+}
+
+// Encode data as a SenML Pack.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - dataP, size: data to encode.
+// - bufferP: buffer in which the pack will be added. If nil, only bufferIndexP is updated.
+// - bufferLength: maximal size of the buffer.
+// - bufferIndexP: IN/OUT. current buffer index.
+static int8_t prv_encodePack(iowa_lwm2m_data_t *dataP,
+                             size_t size,
+                             uint8_t *bufferP,
+                             size_t bufferLength,
+                             size_t *bufferIndexP)
+{
+    iowa_lwm2m_uri_t baseUri;
+    lwm2m_uri_depth_t baseUriDepth;
+    size_t i;
+
+    // The base name is only used when there are several records
+    if (size > 1)
+    {
+        (void)dataUtilsGetBaseUri(dataP, size, &baseUri, &baseUriDepth);
+    }
+    else
+    {
+        baseUriDepth = LWM2M_URI_DEPTH_ROOT;
+    }
+
+    if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS, size, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+    {
+        return CBOR_ERROR;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        iowa_lwm2m_uri_t uri;
+        uint8_t name[PRV_SENML_NAME_MAX_LENGTH];
+        size_t nameLength;
+        size_t pairCount;
+        bool hasValue;
+
+        dataUtilsGetUri(dataP + i, &uri);
+        nameLength = prv_uriToName(&uri, baseUriDepth, baseUriDepth == LWM2M_URI_DEPTH_ROOT, false, name);
+
+        hasValue = (dataP[i].type != IOWA_LWM2M_TYPE_URI_ONLY && dataP[i].type != IOWA_LWM2M_TYPE_NULL);
+
+        pairCount = 0;
+        if (i == 0
+            && baseUriDepth != LWM2M_URI_DEPTH_ROOT)
+        {
+            pairCount++;
+        }
+        if (nameLength != 0)
+        {
+            pairCount++;
+        }
+        if (dataP[i].timestamp != 0)
+        {
+            pairCount++;
+        }
+        if (hasValue == true)
+        {
+            pairCount++;
+        }
+
+        if (cborAddNumberToBuffer(CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS, pairCount, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+
+        if (i == 0
+            && baseUriDepth != LWM2M_URI_DEPTH_ROOT)
+        {
+            uint8_t baseName[PRV_SENML_NAME_MAX_LENGTH];
+            size_t baseNameLength;
+
+            baseNameLength = prv_uriToName(&baseUri, LWM2M_URI_DEPTH_ROOT, true, true, baseName);
+            if (cborAddIntegerToBuffer(PRV_SENML_CBOR_LABEL_BASE_NAME, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+                || cborAddStringToBuffer(baseName, baseNameLength, bufferP, bufferLength, bufferIndexP, false) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+
+        if (nameLength != 0)
+        {
+            if (cborAddIntegerToBuffer(PRV_SENML_CBOR_LABEL_NAME, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+                || cborAddStringToBuffer(name, nameLength, bufferP, bufferLength, bufferIndexP, false) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+
+        if (dataP[i].timestamp != 0)
+        {
+            if (cborAddIntegerToBuffer(PRV_SENML_CBOR_LABEL_TIME, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR
+                || cborAddIntegerToBuffer(dataP[i].timestamp, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+
+        if (hasValue == true)
+        {
+            int8_t result;
+
+            switch (dataP[i].type)
+            {
+            case IOWA_LWM2M_TYPE_STRING:
+            case IOWA_LWM2M_TYPE_CORE_LINK:
+                result = cborAddIntegerToBuffer(PRV_SENML_CBOR_LABEL_STRING_VALUE, bufferP, bufferLength, bufferIndexP);
+                break;
+
+            case IOWA_LWM2M_TYPE_OPAQUE:
+                result = cborAddIntegerToBuffer(PRV_SENML_CBOR_LABEL_DATA_VALUE, bufferP, bufferLength, bufferIndexP);
+                break;
+
+            case IOWA_LWM2M_TYPE_BOOLEAN:
+                result = cborAddIntegerToBuffer(PRV_SENML_CBOR_LABEL_BOOLEAN_VALUE, bufferP, bufferLength, bufferIndexP);
+                break;
+
+            case IOWA_LWM2M_TYPE_OBJECT_LINK:
+                result = cborAddStringToBuffer((uint8_t *)PRV_SENML_CBOR_LABEL_OBJECT_LINK_VALUE, PRV_SENML_CBOR_LABEL_OBJECT_LINK_VALUE_LEN, bufferP, bufferLength, bufferIndexP, false);
+                break;
+
+            default:
+                result = cborAddIntegerToBuffer(PRV_SENML_CBOR_LABEL_VALUE, bufferP, bufferLength, bufferIndexP);
+                break;
+            }
+
+            if (result != CBOR_NO_ERROR
+                || cborAddDataToBuffer(dataP + i, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+            {
+                return CBOR_ERROR;
+            }
+        }
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+// Free the buffer held by the value of a record being parsed.
+// Returned value: none.
+// Parameters:
+// - dataP: the record.
+static void prv_freeValue(iowa_lwm2m_data_t *dataP)
+{
+    if (dataP->type == IOWA_LWM2M_TYPE_STRING
+        || dataP->type == IOWA_LWM2M_TYPE_OPAQUE)
+    {
+        iowa_system_free(dataP->value.asBuffer.buffer);
+        dataP->value.asBuffer.buffer = NULL;
+    }
+}
+
+// Read a SenML name into a buffer.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the payload.
+// - bufferLength: the payload length.
+// - bufferIndexP: IN/OUT. current buffer index, pointing to the name.
+// - nameP, nameLengthP: OUT. the name. The size of nameP is PRV_SENML_NAME_MAX_LENGTH.
+static int8_t prv_readName(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP,
+                           uint8_t *nameP,
+                           size_t *nameLengthP)
+{
+    uint64_t number;
+    uint8_t addInfo;
+
+    if (cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, bufferIndexP) != CBOR_MAJOR_TYPE_TEXT_STRING
+        || cborGetBufferToStringLength(CBOR_MAJOR_TYPE_TEXT_STRING, addInfo, number, nameLengthP, bufferP, bufferLength, *bufferIndexP) != CBOR_NO_ERROR
+        || *nameLengthP > PRV_SENML_NAME_MAX_LENGTH)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid SenML name.");
+        return CBOR_ERROR;
+    }
+
+    return cborPutBufferToString(CBOR_MAJOR_TYPE_TEXT_STRING, addInfo, number, nameP, *nameLengthP, bufferP, bufferLength, bufferIndexP);
+}
+
+// Read an integer time.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP: the payload.
+// - bufferLength: the payload length.
+// - bufferIndexP: IN/OUT. current buffer index, pointing to the time.
+// - timeP: OUT. the time.
+static int8_t prv_readTime(uint8_t *bufferP,
+                           size_t bufferLength,
+                           size_t *bufferIndexP,
+                           int32_t *timeP)
+{
+    iowa_lwm2m_data_t data;
+    major_type_t majorType;
+    uint64_t number;
+    uint8_t addInfo;
+
+    memset(&data, 0, sizeof(iowa_lwm2m_data_t));
+    majorType = cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, bufferIndexP);
+    switch (majorType)
+    {
+    case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+    case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA:
+        if (cborPutBufferToData(majorType, addInfo, number, &data, bufferP, bufferLength, bufferIndexP) != CBOR_NO_ERROR)
+        {
+            return CBOR_ERROR;
+        }
+        break;
+
+    default:
+        IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid SenML time.");
+        return CBOR_ERROR;
+    }
+
+    switch (data.type)
+    {
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        *timeP = (int32_t)data.value.asInteger;
+        break;
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        *timeP = (int32_t)data.value.asFloat;
+        break;
+
+    default:
+        IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid SenML time.");
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+// Parse a SenML Pack.
+// Returned value: CBOR_NO_ERROR in case of success else CBOR_ERROR if any error.
+// Parameters:
+// - bufferP, bufferLength: the payload.
+// - baseUriP: the URI the data must be under. This can be nil.
+// - dataP: OUT. array receiving the data. If nil, the records are only validated.
+// - dataCountP: OUT. number of records.
+static int8_t prv_parsePack(uint8_t *bufferP,
+                            size_t bufferLength,
+                            iowa_lwm2m_uri_t *baseUriP,
+                            iowa_lwm2m_data_t *dataP,
+                            size_t *dataCountP)
+{
+    size_t index;
+    uint64_t recordCount;
+    uint8_t packAddInfo;
+    uint8_t baseName[PRV_SENML_NAME_MAX_LENGTH];
+    size_t baseNameLength;
+    int32_t baseTime;
+    lwm2m_uri_depth_t baseUriDepth;
+
+    *dataCountP = 0;
+    index = 0;
+    baseNameLength = 0;
+    baseTime = 0;
+    baseUriDepth = (baseUriP == NULL) ? LWM2M_URI_DEPTH_ROOT : dataUtilsGetUriDepth(baseUriP);
+
+    if (cborPutBufferToNumber(&recordCount, &packAddInfo, bufferP, bufferLength, &index) != CBOR_MAJOR_TYPE_ARRAY_OF_ITEMS)
+    {
+        IOWA_LOG_INFO(IOWA_PART_DATA, "SenML Pack is not an array.");
+        return CBOR_ERROR;
+    }
+
+    while (packAddInfo == CBOR_ADD_INFO_VALUE_BREAK || *dataCountP < recordCount)
+    {
+        iowa_lwm2m_data_t data;
+        uint64_t pairCount;
+        uint8_t recordAddInfo;
+        uint64_t pairIndex;
+        uint8_t name[2 * PRV_SENML_NAME_MAX_LENGTH];
+        size_t nameLength;
+        int32_t time;
+        bool hasValue;
+        iowa_lwm2m_uri_t uri;
+
+        if (packAddInfo == CBOR_ADD_INFO_VALUE_BREAK
+            && index < bufferLength
+            && bufferP[index] == CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK))
+        {
+            index++;
+            break;
+        }
+
+        if (cborPutBufferToNumber(&pairCount, &recordAddInfo, bufferP, bufferLength, &index) != CBOR_MAJOR_TYPE_MAP_OF_PAIRS_OF_ITEMS)
+        {
+            IOWA_LOG_INFO(IOWA_PART_DATA, "SenML Record is not a map.");
+            return CBOR_ERROR;
+        }
+
+        memset(&data, 0, sizeof(iowa_lwm2m_data_t));
+        nameLength = 0;
+        time = 0;
+        hasValue = false;
+
+        for (pairIndex = 0; recordAddInfo == CBOR_ADD_INFO_VALUE_BREAK || pairIndex < pairCount; pairIndex++)
+        {
+            major_type_t majorType;
+            uint64_t number;
+            uint8_t addInfo;
+            int64_t label;
+            bool isValue;
+
+            if (recordAddInfo == CBOR_ADD_INFO_VALUE_BREAK
+                && index < bufferLength
+                && bufferP[index] == CBOR_GET_ITEM_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA, CBOR_ADD_INFO_VALUE_BREAK))
+            {
+                index++;
+                break;
+            }
+
+            // Read the label
+            majorType = cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, &index);
+            switch (majorType)
+            {
+            case CBOR_MAJOR_TYPE_UNSIGNED_INTEGER:
+                label = (number > INT8_MAX) ? INT8_MAX : (int64_t)number;
+                break;
+
+            case CBOR_MAJOR_TYPE_NEGATIVE_INTEGER:
+                label = (number > INT8_MAX) ? INT8_MIN : -1 - (int64_t)number;
+                break;
+
+            case CBOR_MAJOR_TYPE_TEXT_STRING:
+            {
+                size_t labelLength;
+
+                if (cborGetBufferToStringLength(majorType, addInfo, number, &labelLength, bufferP, bufferLength, index) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                if (addInfo != CBOR_ADD_INFO_VALUE_BREAK
+                    && labelLength == PRV_SENML_CBOR_LABEL_OBJECT_LINK_VALUE_LEN
+                    && memcmp(bufferP + index, PRV_SENML_CBOR_LABEL_OBJECT_LINK_VALUE, PRV_SENML_CBOR_LABEL_OBJECT_LINK_VALUE_LEN) == 0)
+                {
+                    label = PRV_SENML_CBOR_LABEL_STRING_VALUE;
+                }
+                else
+                {
+                    // Unknown label, the value will be skipped
+                    label = INT8_MAX;
+                }
+                (void)cborPutBufferToString(majorType, addInfo, number, NULL, labelLength, bufferP, bufferLength, &index);
+                break;
+            }
+
+            default:
+                IOWA_LOG_INFO(IOWA_PART_DATA, "Invalid SenML label.");
+                return CBOR_ERROR;
+            }
+
+            // Read the value
+            isValue = false;
+            switch (label)
+            {
+            case PRV_SENML_CBOR_LABEL_BASE_NAME:
+                if (prv_readName(bufferP, bufferLength, &index, baseName, &baseNameLength) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                break;
+
+            case PRV_SENML_CBOR_LABEL_NAME:
+                if (prv_readName(bufferP, bufferLength, &index, name + PRV_SENML_NAME_MAX_LENGTH, &nameLength) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                break;
+
+            case PRV_SENML_CBOR_LABEL_BASE_TIME:
+                if (prv_readTime(bufferP, bufferLength, &index, &baseTime) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                break;
+
+            case PRV_SENML_CBOR_LABEL_TIME:
+                if (prv_readTime(bufferP, bufferLength, &index, &time) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                break;
+
+            case PRV_SENML_CBOR_LABEL_VALUE:
+            case PRV_SENML_CBOR_LABEL_STRING_VALUE:
+            case PRV_SENML_CBOR_LABEL_BOOLEAN_VALUE:
+            case PRV_SENML_CBOR_LABEL_DATA_VALUE:
+                isValue = true;
+                break;
+
+            default:
+                if (cborSkipItem(bufferP, bufferLength, &index) != CBOR_NO_ERROR)
+                {
+                    return CBOR_ERROR;
+                }
+                break;
+            }
+
+            if (isValue == true)
+            {
+                size_t valueIndex;
+
+                if (hasValue == true)
+                {
+                    IOWA_LOG_INFO(IOWA_PART_DATA, "SenML Record has several values.");
+                    prv_freeValue(&data);
+                    return CBOR_ERROR;
+                }
+                hasValue = true;
+
+                valueIndex = index;
+                majorType = cborPutBufferToNumber(&number, &addInfo, bufferP, bufferLength, &index);
+                switch (label)
+                {
+                case PRV_SENML_CBOR_LABEL_VALUE:
+                    isValue = (majorType == CBOR_MAJOR_TYPE_UNSIGNED_INTEGER || majorType == CBOR_MAJOR_TYPE_NEGATIVE_INTEGER
+                               || majorType == CBOR_MAJOR_TYPE_OPTIONAL_SEMANTIC
+                               || (majorType == CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA && addInfo >= CBOR_ADD_INFO_2_BYTES));
+                    break;
+
+                case PRV_SENML_CBOR_LABEL_STRING_VALUE:
+                    isValue = (majorType == CBOR_MAJOR_TYPE_TEXT_STRING);
+                    break;
+
+                case PRV_SENML_CBOR_LABEL_BOOLEAN_VALUE:
+                    isValue = (majorType == CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE_DATA && addInfo < CBOR_ADD_INFO_2_BYTES);
+                    break;
+
+                default:
+                    isValue = (majorType == CBOR_MAJOR_TYPE_BYTE_STRING);
+                    break;
+                }
+                if (isValue == false)
+                {
+                    IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Invalid value type for SenML label %d.", (int)label);
+                    return CBOR_ERROR;
+                }
+
+                if (dataP == NULL)
+                {
+                    index = valueIndex;
+                    if (cborSkipItem(bufferP, bufferLength, &index) != CBOR_NO_ERROR)
+                    {
+                        return CBOR_ERROR;
+                    }
+                }
+                else if (cborPutBufferToData(majorType, addInfo, number, &data, bufferP, bufferLength, &index) != CBOR_NO_ERROR)
+                {
+                    prv_freeValue(&data);
+                    return CBOR_ERROR;
+                }
+            }
+        }
+
+        // The name of the record is the concatenation of the base name and the name
+        memmove(name + PRV_SENML_NAME_MAX_LENGTH - baseNameLength, baseName, baseNameLength);
+        if (dataUtilsBufferToUri((const char *)name + PRV_SENML_NAME_MAX_LENGTH - baseNameLength, baseNameLength + nameLength, &uri
+#ifdef LWM2M_ALTPATH_SUPPORT
+                                 , NULL
+#endif
+                                 ) != baseNameLength + nameLength)
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "Invalid SenML Record name \"%.*s\".", (int)(baseNameLength + nameLength), name + PRV_SENML_NAME_MAX_LENGTH - baseNameLength);
+            prv_freeValue(&data);
+            return CBOR_ERROR;
+        }
+
+        dataUtilsSetUri(&data, &uri);
+        if ((baseUriP != NULL && dataUtilsIsInBaseUri(&data, baseUriP, baseUriDepth) == false)
+            || (hasValue == true && data.resourceID == IOWA_LWM2M_ID_ALL))
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "SenML Record /%u/%u/%u/%u is not valid for the base URI.", data.objectID, data.instanceID, data.resourceID, data.resInstanceID);
+            prv_freeValue(&data);
+            return CBOR_ERROR;
+        }
+
+        if (hasValue == false)
+        {
+            data.type = IOWA_LWM2M_TYPE_URI_ONLY;
+        }
+        data.timestamp = baseTime + time;
+
+        if (dataP != NULL)
+        {
+            dataP[*dataCountP] = data;
+        }
+        *dataCountP += 1;
+    }
+
+    if (index != bufferLength)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_DATA, "%u bytes remaining after the SenML Pack.", bufferLength - index);
+        return CBOR_ERROR;
+    }
+
+    return CBOR_NO_ERROR;
+}
+
+/*************************************************************************************
+** Public functions
+*************************************************************************************/
+
+iowa_status_t senmlCborSerialize(iowa_lwm2m_data_t *dataP,
+                                 size_t size,
+                                 size_t headroom,
+                                 uint8_t **bufferP,
+                                 size_t *bufferLengthP)
+{
+    size_t index;
+
+    assert(dataP != NULL);
+    assert(size != 0);
+    assert(bufferP != NULL);
+    assert(bufferLengthP != NULL);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "size: %u", size);
+
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
+    // First pass to get the exact length, second pass to write the payload
+    if (prv_encodePack(dataP, size, NULL, 0, bufferLengthP) != CBOR_NO_ERROR)
+    {
+        IOWA_LOG_WARNING(IOWA_PART_DATA, "Failed to retrieve the length");
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    *bufferP = (uint8_t *)iowa_system_malloc(headroom + *bufferLengthP);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*bufferP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(headroom + *bufferLengthP);
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    index = headroom;
+    if (prv_encodePack(dataP, size, *bufferP, headroom + *bufferLengthP, &index) != CBOR_NO_ERROR)
+    {
+        iowa_system_free(*bufferP);
+        *bufferP = NULL;
+        *bufferLengthP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "Returning %u bytes", *bufferLengthP);
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t senmlCborDeserialize(iowa_lwm2m_uri_t *baseUriP,
+                                   uint8_t *bufferP,
+                                   size_t bufferLength,
+                                   iowa_lwm2m_data_t **dataP,
+                                   size_t *dataCountP)
+{
+    size_t dataCount;
+
+    IOWA_LOG_BUFFER_TRACE(IOWA_PART_DATA, "Parsing SenML CBOR buffer", bufferP, bufferLength);
+
+    *dataP = NULL;
+    *dataCountP = 0;
+
+    // First pass to validate the payload and count the records
+    if (prv_parsePack(bufferP, bufferLength, baseUriP, NULL, &dataCount) != CBOR_NO_ERROR
+        || dataCount == 0)
+    {
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    *dataP = (iowa_lwm2m_data_t *)iowa_system_malloc(dataCount * sizeof(iowa_lwm2m_data_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*dataP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(dataCount * sizeof(iowa_lwm2m_data_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memset(*dataP, 0, dataCount * sizeof(iowa_lwm2m_data_t));
+
+    if (prv_parsePack(bufferP, bufferLength, baseUriP, *dataP, dataCountP) != CBOR_NO_ERROR)
+    {
+        // Only a memory allocation can fail after the first pass
+        dataLwm2mFree(dataCount, *dataP);
+        *dataP = NULL;
+        *dataCountP = 0;
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+#endif // LWM2M_SUPPORT_SENML_CBOR
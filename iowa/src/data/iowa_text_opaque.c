@@ -30,6 +30,7 @@
 *************************************************************************************/
 
 iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP,
+                            size_t headroom,
                             uint8_t **bufferP,
                             size_t *bufferLengthP)
 {
@@ -50,15 +51,15 @@ iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP,
         }
         else
         {
-            *bufferP = (uint8_t *)iowa_system_malloc(dataP->value.asBuffer.length);
+            *bufferP = (uint8_t *)iowa_system_malloc(headroom + dataP->value.asBuffer.length);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (*bufferP == NULL)
             {
-                IOWA_LOG_ERROR_MALLOC(dataP->value.asBuffer.length);
+                IOWA_LOG_ERROR_MALLOC(headroom + dataP->value.asBuffer.length);
                 return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
             }
 #endif
-            memcpy(*bufferP, dataP->value.asBuffer.buffer, dataP->value.asBuffer.length);
+            memcpy(*bufferP + headroom, dataP->value.asBuffer.buffer, dataP->value.asBuffer.length);
         }
 
         *bufferLengthP = dataP->value.asBuffer.length;
@@ -78,17 +79,17 @@ iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP,
             bufferLength = iowa_utils_base64_get_encoded_size(dataP->value.asBuffer.length);
 
             // 'bufferLength' cannot be equal to zero
-            *bufferP = (uint8_t *)iowa_system_malloc(bufferLength);
+            *bufferP = (uint8_t *)iowa_system_malloc(headroom + bufferLength);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (*bufferP == NULL)
             {
-                IOWA_LOG_ERROR_MALLOC(bufferLength);
+                IOWA_LOG_ERROR_MALLOC(headroom + bufferLength);
                 return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
             }
 #endif
 
             *bufferLengthP = bufferLength;
-            utils_b64Encode(dataP->value.asBuffer.buffer, dataP->value.asBuffer.length, *bufferP, bufferLengthP, BASE64_MODE_CLASSIC);
+            utils_b64Encode(dataP->value.asBuffer.buffer, dataP->value.asBuffer.length, *bufferP + headroom, bufferLengthP, BASE64_MODE_CLASSIC);
 
             if (*bufferLengthP == 0)
             {
@@ -117,15 +118,15 @@ iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP,
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 
-        *bufferP = (uint8_t *)iowa_system_malloc(*bufferLengthP);
+        *bufferP = (uint8_t *)iowa_system_malloc(headroom + *bufferLengthP);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (*bufferP == NULL)
         {
-            IOWA_LOG_ERROR_MALLOC(*bufferLengthP);
+            IOWA_LOG_ERROR_MALLOC(headroom + *bufferLengthP);
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
-        memcpy(*bufferP, intString, *bufferLengthP);
+        memcpy(*bufferP + headroom, intString, *bufferLengthP);
         break;
     }
 
@@ -140,35 +141,35 @@ iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP,
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 
-        *bufferP = (uint8_t *)iowa_system_malloc(*bufferLengthP);
+        *bufferP = (uint8_t *)iowa_system_malloc(headroom + *bufferLengthP);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (NULL == *bufferP)
         {
-            IOWA_LOG_ERROR_MALLOC(*bufferLengthP);
+            IOWA_LOG_ERROR_MALLOC(headroom + *bufferLengthP);
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
-        memcpy(*bufferP, floatString, *bufferLengthP);
+        memcpy(*bufferP + headroom, floatString, *bufferLengthP);
         break;
     }
 
     case IOWA_LWM2M_TYPE_BOOLEAN:
-        *bufferP = (uint8_t *)iowa_system_malloc(1);
+        *bufferP = (uint8_t *)iowa_system_malloc(headroom + 1);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (NULL == *bufferP)
         {
-            IOWA_LOG_ERROR_MALLOC(1);
+            IOWA_LOG_ERROR_MALLOC(headroom + 1);
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
 
         if (dataP->value.asBoolean == true)
         {
-            *bufferP[0] = '1';
+            (*bufferP)[headroom] = '1';
         }
         else
         {
-            *bufferP[0] = '0';
+            (*bufferP)[headroom] = '0';
         }
 
         *bufferLengthP = 1;
@@ -185,15 +186,15 @@ iowa_status_t textSerialize(iowa_lwm2m_data_t *dataP,
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 
-        *bufferP = (uint8_t *)iowa_system_malloc(*bufferLengthP);
+        *bufferP = (uint8_t *)iowa_system_malloc(headroom + *bufferLengthP);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (NULL == *bufferP)
         {
-            IOWA_LOG_ERROR_MALLOC(*bufferLengthP);
+            IOWA_LOG_ERROR_MALLOC(headroom + *bufferLengthP);
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
-        memcpy(*bufferP, stringBuffer, *bufferLengthP);
+        memcpy(*bufferP + headroom, stringBuffer, *bufferLengthP);
         break;
     }
 
@@ -282,6 +283,7 @@ iowa_status_t textDeserialize(iowa_lwm2m_uri_t *baseUriP,
 }
 
 iowa_status_t opaqueSerialize(iowa_lwm2m_data_t *dataP,
+                              size_t headroom,
                               uint8_t **bufferP,
                               size_t *bufferLengthP)
 {
@@ -309,15 +311,15 @@ iowa_status_t opaqueSerialize(iowa_lwm2m_data_t *dataP,
     else
     {
         // dataP array length is assumed to be 1.
-        *bufferP = (uint8_t *)iowa_system_malloc(dataP->value.asBuffer.length);
+        *bufferP = (uint8_t *)iowa_system_malloc(headroom + dataP->value.asBuffer.length);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (*bufferP == NULL)
         {
-            IOWA_LOG_ERROR_MALLOC(dataP->value.asBuffer.length);
+            IOWA_LOG_ERROR_MALLOC(headroom + dataP->value.asBuffer.length);
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
-        memcpy(*bufferP, dataP->value.asBuffer.buffer, dataP->value.asBuffer.length);
+        memcpy(*bufferP + headroom, dataP->value.asBuffer.buffer, dataP->value.asBuffer.length);
     }
 
     *bufferLengthP = dataP->value.asBuffer.length;
@@ -35,6 +35,13 @@
 
 #define PRV_64BIT_BUFFER_SIZE 8
 
+// Type, 16-bit identifier and 24-bit length
+#define PRV_TLV_HEADER_MAX_LENGTH 6
+
+// Initial guesses used to size the output buffer and the headers of the containers
+#define PRV_TLV_DATA_LENGTH_ESTIMATE      16
+#define PRV_TLV_CONTAINER_LENGTH_ESTIMATE 0xFF
+
 #define PRV_TLV_TYPE_LEVEL_STR(S) ((S) == PRV_TLV_TYPE_OBJECT_INSTANCE ? "Object Instance" :     \
                                   ((S) == PRV_TLV_TYPE_RESOURCE ? "Resource" :                   \
                                   ((S) == PRV_TLV_TYPE_MULTIPLE_RESOURCE ? "Multiple Resource" : \
@@ -287,143 +294,209 @@ static size_t prv_lwm2mDecodeTlv(uint8_t *buffer,
     return *oDataIndex + *oDataLength;
 }
 
-static iowa_status_t prv_getLength(iowa_lwm2m_uri_t *baseUriP,
-                                   lwm2m_uri_depth_t uriDepth,
-                                   iowa_lwm2m_data_t *dataP,
-                                   size_t size,
-                                   size_t *lengthP)
+// Output buffer of the serializer
+typedef struct
 {
-    size_t i;
-    size_t instanceDataLength;
-    size_t resourceDataLength;
-
-    *lengthP = 0;
+    uint8_t *buffer;
+    size_t   capacity;
+    size_t   index;
+} prv_tlv_writer_t;
+
+// Make room in the output buffer.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or IOWA_COAP_500_INTERNAL_SERVER_ERROR on memory allocation failure.
+// Parameters:
+// - writerP: the output buffer.
+// - length: the number of bytes to be written at the current index.
+static iowa_status_t prv_writerReserve(prv_tlv_writer_t *writerP,
+                                       size_t length)
+{
+    uint8_t *newBufferP;
+    size_t newCapacity;
 
-    if (size == 0)
+    if (writerP->index + length <= writerP->capacity)
     {
         return IOWA_COAP_NO_ERROR;
     }
 
-    instanceDataLength = 0;
-    resourceDataLength = 0;
+    newCapacity = 2 * writerP->capacity;
+    if (newCapacity < writerP->index + length)
+    {
+        newCapacity = writerP->index + length;
+    }
 
-    for (i = 0; i < size; i++)
+    newBufferP = (uint8_t *)iowa_system_malloc(newCapacity);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (newBufferP == NULL)
     {
-        uint16_t resId;
+        IOWA_LOG_ERROR_MALLOC(newCapacity);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memcpy(newBufferP, writerP->buffer, writerP->index);
+    iowa_system_free(writerP->buffer);
 
-        // Check if data has to be added
-        if (dataUtilsIsInBaseUri(dataP + i, baseUriP, uriDepth) == false)
-        {
-            // Loop on next element
-            continue;
-        }
+    writerP->buffer = newBufferP;
+    writerP->capacity = newCapacity;
 
-        // Check if this is a new instance
-        if (i > 0
-            && dataP[i].instanceID != dataP[i-1].instanceID)
-        {
-            *lengthP += prv_getHeaderLength(dataP[i-1].instanceID, instanceDataLength) + instanceDataLength;
-            instanceDataLength = 0;
-        }
+    return IOWA_COAP_NO_ERROR;
+}
 
-        // Check if this is a multiple resource
-        if (dataP[i].resInstanceID != IOWA_LWM2M_ID_ALL)
-        {
-            resId = dataP[i].resInstanceID;
-        }
-        else
-        {
-            resId = dataP[i].resourceID;
-        }
+// Start an Object Instance or a Multiple Resource.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - writerP: the output buffer.
+// - id: the ID of the container.
+// - expectedLength: the expected length of the content, used to reserve the header.
+// - startP: OUT. the index of the header.
+// - reservedP: OUT. the length reserved for the header.
+static iowa_status_t prv_openContainer(prv_tlv_writer_t *writerP,
+                                       uint16_t id,
+                                       size_t expectedLength,
+                                       size_t *startP,
+                                       size_t *reservedP)
+{
+    iowa_status_t result;
 
-        switch (dataP[i].type)
-        {
-        case IOWA_LWM2M_TYPE_STRING:
-        case IOWA_LWM2M_TYPE_CORE_LINK:
-        case IOWA_LWM2M_TYPE_OPAQUE:
-            resourceDataLength += prv_getHeaderLength(resId, dataP[i].value.asBuffer.length) + dataP[i].value.asBuffer.length;
-            break;
+    *reservedP = prv_getHeaderLength(id, expectedLength);
+    result = prv_writerReserve(writerP, *reservedP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
 
-        case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
-            if (dataP[i].value.asInteger < 0)
-            {
-                IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsigned integer value has a negative value: %d", dataP[i].value.asInteger);
-                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
-            }
-            // Fall through
-        case IOWA_LWM2M_TYPE_INTEGER:
-        case IOWA_LWM2M_TYPE_TIME:
-        {
-            size_t dataLength;
-            uint8_t unusedBuffer[PRV_64BIT_BUFFER_SIZE];
+    *startP = writerP->index;
+    writerP->index += *reservedP;
 
-            dataLength = prv_encodeInt(dataP[i].value.asInteger, unusedBuffer);
-            resourceDataLength += prv_getHeaderLength(resId, dataLength) + dataLength;
-            break;
-        }
+    return IOWA_COAP_NO_ERROR;
+}
 
-        case IOWA_LWM2M_TYPE_FLOAT:
+// Write the header of an Object Instance or a Multiple Resource once its content is written.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - writerP: the output buffer.
+// - type: the TLV type of the container.
+// - id: the ID of the container.
+// - start: the index of the header.
+// - reserved: the length reserved for the header.
+// - lengthP: OUT. the length of the content.
+// Note: the content is only moved when the reserved length does not match the header.
+static iowa_status_t prv_closeContainer(prv_tlv_writer_t *writerP,
+                                        uint8_t type,
+                                        uint16_t id,
+                                        size_t start,
+                                        size_t reserved,
+                                        size_t *lengthP)
+{
+    size_t headerLength;
+
+    *lengthP = writerP->index - start - reserved;
+    headerLength = prv_getHeaderLength(id, *lengthP);
+    if (headerLength != reserved)
+    {
+        if (headerLength > reserved)
         {
-            size_t dataLength;
+            iowa_status_t result;
 
-            if (dataP[i].value.asFloat < 0.0 - (double)FLT_MAX
-                || dataP[i].value.asFloat > (double)FLT_MAX)
-            {
-                dataLength = 8;
-            }
-            else
+            result = prv_writerReserve(writerP, headerLength - reserved);
+            if (result != IOWA_COAP_NO_ERROR)
             {
-                dataLength = 4;
+                return result;
             }
-
-            resourceDataLength += prv_getHeaderLength(resId, dataLength) + dataLength;
-            break;
         }
+        memmove(writerP->buffer + start + headerLength, writerP->buffer + start + reserved, *lengthP);
+        writerP->index = writerP->index + headerLength - reserved;
+    }
 
-        case IOWA_LWM2M_TYPE_BOOLEAN:
-            // Booleans are always encoded on one byte
-            resourceDataLength += prv_getHeaderLength(resId, 1) + 1;
-            break;
+    (void)prv_createHeader(writerP->buffer + start, type, id, *lengthP);
 
-        case IOWA_LWM2M_TYPE_OBJECT_LINK:
-            // Object Link are always encoded on four bytes
-            resourceDataLength += prv_getHeaderLength(resId, 4) + 4;
-            break;
+    return IOWA_COAP_NO_ERROR;
+}
 
-        case IOWA_LWM2M_TYPE_UNDEFINED:
-        default:
-            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unknown resource type: %d", dataP[i].type);
-            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
-        }
+// Write a Resource or a Resource Instance.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - writerP: the output buffer.
+// - dataP: the data.
+static iowa_status_t prv_writeResource(prv_tlv_writer_t *writerP,
+                                       iowa_lwm2m_data_t *dataP)
+{
+    iowa_status_t result;
+    uint16_t resId;
+    uint8_t resType;
+    uint8_t dataBuffer[PRV_64BIT_BUFFER_SIZE];
+    uint8_t *valueP;
+    size_t valueLength;
 
-        // Check if this is a multiple resource
-        if (dataP[i].resInstanceID != IOWA_LWM2M_ID_ALL
-                 && uriDepth != LWM2M_URI_DEPTH_RESOURCE_INSTANCE)
-        {
-            // Check if this is a new multiple resource
-            if (i + 1 == size
-                || dataP[i].resourceID != dataP[i+1].resourceID)
-            {
-                instanceDataLength += prv_getHeaderLength(dataP[i].resourceID, resourceDataLength) + resourceDataLength;
-                resourceDataLength = 0;
-            }
-        }
-        else
-        {
-            instanceDataLength += resourceDataLength;
-            resourceDataLength = 0;
-        }
+    // Check if this is a multiple resource
+    if (dataP->resInstanceID != IOWA_LWM2M_ID_ALL)
+    {
+        resId = dataP->resInstanceID;
+        resType = PRV_TLV_TYPE_RESOURCE_INSTANCE;
+    }
+    else
+    {
+        resId = dataP->resourceID;
+        resType = PRV_TLV_TYPE_RESOURCE;
     }
 
-    switch (uriDepth)
+    valueP = dataBuffer;
+    switch (dataP->type)
     {
-    case LWM2M_URI_DEPTH_OBJECT:
-        *lengthP += prv_getHeaderLength(dataP[i-1].instanceID, instanceDataLength) + instanceDataLength;
+    case IOWA_LWM2M_TYPE_STRING:
+    case IOWA_LWM2M_TYPE_CORE_LINK:
+    case IOWA_LWM2M_TYPE_OPAQUE:
+        valueP = dataP->value.asBuffer.buffer;
+        valueLength = dataP->value.asBuffer.length;
         break;
 
-    default:
-        *lengthP = instanceDataLength;
+    case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
+        if (dataP->value.asInteger < 0)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unsigned integer value has a negative value: %d", dataP->value.asInteger);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+        // Fall through
+    case IOWA_LWM2M_TYPE_INTEGER:
+    case IOWA_LWM2M_TYPE_TIME:
+        valueLength = prv_encodeInt(dataP->value.asInteger, dataBuffer);
+        break;
+
+    case IOWA_LWM2M_TYPE_FLOAT:
+        valueLength = prv_encodeFloat(dataP->value.asFloat, dataBuffer);
         break;
+
+    case IOWA_LWM2M_TYPE_BOOLEAN:
+        // Booleans are always encoded on one byte
+        dataBuffer[0] = dataP->value.asBoolean ? 1 : 0;
+        valueLength = 1;
+        break;
+
+    case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        // Object Link are always encoded on four bytes
+        dataBuffer[0] = (uint8_t)((uint16_t)(dataP->value.asObjLink.objectId & 0xFF00) >> 8);
+        dataBuffer[1] = (uint8_t)(dataP->value.asObjLink.objectId & 0x00FF);
+        dataBuffer[2] = (uint8_t)((uint16_t)(dataP->value.asObjLink.instanceId & 0xFF00) >> 8);
+        dataBuffer[3] = (uint8_t)(dataP->value.asObjLink.instanceId & 0x00FF);
+        valueLength = 4;
+        break;
+
+    case IOWA_LWM2M_TYPE_UNDEFINED:
+    default:
+        IOWA_LOG_ARG_WARNING(IOWA_PART_DATA, "Unknown resource type: %d", dataP->type);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+
+    result = prv_writerReserve(writerP, PRV_TLV_HEADER_MAX_LENGTH + valueLength);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    writerP->index += prv_createHeader(writerP->buffer + writerP->index, resType, resId, valueLength);
+    if (valueLength != 0)
+    {
+        memcpy(writerP->buffer + writerP->index, valueP, valueLength);
+        writerP->index += valueLength;
     }
 
     return IOWA_COAP_NO_ERROR;
@@ -648,6 +721,7 @@ static size_t prv_tlvToLwm2mData(iowa_lwm2m_uri_t *baseUriP,
 iowa_status_t tlvSerialize(iowa_lwm2m_uri_t *baseUriP,
                            iowa_lwm2m_data_t *dataP,
                            size_t size,
+                           size_t headroom,
                            uint8_t **bufferP,
                            size_t *bufferLengthP)
 {
@@ -655,10 +729,16 @@ iowa_status_t tlvSerialize(iowa_lwm2m_uri_t *baseUriP,
     iowa_status_t result;
     iowa_lwm2m_uri_t baseUri;
     lwm2m_uri_depth_t uriDepth;
-    size_t index;
+    prv_tlv_writer_t writer;
     size_t i;
-    size_t instanceDataLength;
-    size_t resourceDataLength;
+    iowa_lwm2m_data_t *instanceP;
+    size_t instanceStart;
+    size_t instanceReserved;
+    size_t instanceLength;
+    iowa_lwm2m_data_t *multipleResourceP;
+    size_t multipleResourceStart;
+    size_t multipleResourceReserved;
+    size_t multipleResourceLength;
 
     assert(dataP != NULL);
     assert(size != 0);
@@ -667,6 +747,9 @@ iowa_status_t tlvSerialize(iowa_lwm2m_uri_t *baseUriP,
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "size: %d", size);
 
+    *bufferP = NULL;
+    *bufferLengthP = 0;
+
     if (baseUriP == NULL)
     {
         dataUtilsGetBaseUri(dataP, size, &baseUri, &uriDepth);
@@ -683,38 +766,31 @@ iowa_status_t tlvSerialize(iowa_lwm2m_uri_t *baseUriP,
         return IOWA_COAP_400_BAD_REQUEST;
     }
 
-    *bufferP = NULL;
-    result = prv_getLength(&baseUri, uriDepth, dataP, size, bufferLengthP);
-    if (result != IOWA_COAP_NO_ERROR)
-    {
-        IOWA_LOG_WARNING(IOWA_PART_DATA, "Failed to retrieve the length");
-        return result;
-    }
-    if (*bufferLengthP == 0)
-    {
-        IOWA_LOG_INFO(IOWA_PART_DATA, "Buffer length is zero");
-        return result;
-    }
-
-    *bufferP = (uint8_t *)iowa_system_malloc(*bufferLengthP);
+    // The payload is written in one pass after the reserved headroom. The buffer grows if the estimation is too short.
+    writer.capacity = headroom + size * PRV_TLV_DATA_LENGTH_ESTIMATE;
+    writer.buffer = (uint8_t *)iowa_system_malloc(writer.capacity);
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-    if (*bufferP == NULL)
+    if (writer.buffer == NULL)
     {
-        IOWA_LOG_ERROR_MALLOC(*bufferLengthP);
+        IOWA_LOG_ERROR_MALLOC(writer.capacity);
         return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 #endif
+    writer.index = headroom;
 
-    index = 0;
-    instanceDataLength = 0;
-    resourceDataLength = 0;
+    result = IOWA_COAP_NO_ERROR;
+    instanceP = NULL;
+    instanceStart = 0;
+    instanceReserved = 0;
+    instanceLength = PRV_TLV_CONTAINER_LENGTH_ESTIMATE;
+    multipleResourceP = NULL;
+    multipleResourceStart = 0;
+    multipleResourceReserved = 0;
+    multipleResourceLength = PRV_TLV_CONTAINER_LENGTH_ESTIMATE;
 
-    for (i = 0; i < size; i++)
+    // The header of a container is reserved with the length of the previous container of the same kind, and fixed once its content is written
+    for (i = 0; i < size && result == IOWA_COAP_NO_ERROR; i++)
     {
-        size_t headerLen;
-        uint16_t resId;
-        uint8_t resType;
-
         // Check if data has to be added
         if (dataUtilsIsInBaseUri(dataP + i, &baseUri, uriDepth) == false)
         {
@@ -722,159 +798,78 @@ iowa_status_t tlvSerialize(iowa_lwm2m_uri_t *baseUriP,
             continue;
         }
 
-        // Check if this is a new instance
-        if (i > 0
-            && dataP[i].instanceID != dataP[i-1].instanceID)
-        {
-            headerLen = prv_getHeaderLength(dataP[i-1].instanceID, instanceDataLength);
-            memmove(*bufferP + index + headerLen - instanceDataLength, *bufferP + index - instanceDataLength, instanceDataLength);
-
-            (void)prv_createHeader(*bufferP + index - instanceDataLength, PRV_TLV_TYPE_OBJECT_INSTANCE, dataP[i-1].instanceID, instanceDataLength);
-            index += headerLen;
-
-            instanceDataLength = 0;
-        }
-
-        // Check if this is a multiple resource
-        if (dataP[i].resInstanceID != IOWA_LWM2M_ID_ALL)
-        {
-            resId = dataP[i].resInstanceID;
-            resType = PRV_TLV_TYPE_RESOURCE_INSTANCE;
-        }
-        else
-        {
-            resId = dataP[i].resourceID;
-            resType = PRV_TLV_TYPE_RESOURCE;
-        }
-
-        switch (dataP[i].type)
-        {
-        case IOWA_LWM2M_TYPE_STRING:
-        case IOWA_LWM2M_TYPE_CORE_LINK:
-        case IOWA_LWM2M_TYPE_OPAQUE:
-            headerLen = prv_createHeader(*bufferP + index, resType, resId, dataP[i].value.asBuffer.length);
-            index += headerLen;
-            memcpy(*bufferP + index, dataP[i].value.asBuffer.buffer, dataP[i].value.asBuffer.length);
-            index += dataP[i].value.asBuffer.length;
-
-            resourceDataLength += headerLen + dataP[i].value.asBuffer.length;
-            break;
-
-        case IOWA_LWM2M_TYPE_INTEGER:
-        case IOWA_LWM2M_TYPE_TIME:
-        case IOWA_LWM2M_TYPE_UNSIGNED_INTEGER:
-        {
-            size_t dataLength;
-            uint8_t dataBuffer[PRV_64BIT_BUFFER_SIZE];
-
-            dataLength = prv_encodeInt(dataP[i].value.asInteger, dataBuffer);
-            headerLen = prv_createHeader(*bufferP + index, resType, resId, dataLength);
-            index += headerLen;
-            memcpy(*bufferP + index, dataBuffer, dataLength);
-            index += dataLength;
-
-            resourceDataLength += headerLen + dataLength;
-            break;
-        }
-
-        case IOWA_LWM2M_TYPE_FLOAT:
+        // Check if this is the end of a multiple resource
+        if (multipleResourceP != NULL
+            && (dataP[i].resInstanceID == IOWA_LWM2M_ID_ALL
+                || dataP[i].resourceID != multipleResourceP->resourceID
+                || dataP[i].instanceID != multipleResourceP->instanceID))
         {
-            size_t dataLength;
-            uint8_t dataBuffer[PRV_64BIT_BUFFER_SIZE];
-
-            dataLength = prv_encodeFloat(dataP[i].value.asFloat, dataBuffer);
-            headerLen = prv_createHeader(*bufferP + index, resType, resId, dataLength);
-            index += headerLen;
-            memcpy(*bufferP + index, dataBuffer, dataLength);
-            index += dataLength;
-
-            resourceDataLength += headerLen + dataLength;
-            break;
+            result = prv_closeContainer(&writer, PRV_TLV_TYPE_MULTIPLE_RESOURCE, multipleResourceP->resourceID, multipleResourceStart, multipleResourceReserved, &multipleResourceLength);
+            multipleResourceP = NULL;
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                break;
+            }
         }
 
-        case IOWA_LWM2M_TYPE_BOOLEAN:
-            // Booleans are always encoded on one byte
-            headerLen = prv_createHeader(*bufferP + index, resType, resId, 1);
-            index += headerLen;
-            (*bufferP)[index] = dataP[i].value.asBoolean ? 1 : 0;
-            index += 1;
-
-            resourceDataLength += headerLen + 1;
-            break;
-
-        case IOWA_LWM2M_TYPE_OBJECT_LINK:
+        // Check if this is a new instance
+        if (uriDepth == LWM2M_URI_DEPTH_OBJECT
+            && (instanceP == NULL
+                || dataP[i].instanceID != instanceP->instanceID))
         {
-            // Object Link are always encoded on four bytes
-            uint8_t buf[4];
-
-            buf[0] = (uint8_t)((uint16_t)(dataP[i].value.asObjLink.objectId & 0xFF00) >> 8);
-            buf[1] = (uint8_t)(dataP[i].value.asObjLink.objectId & 0x00FF);
-            buf[2] = (uint8_t)((uint16_t)(dataP[i].value.asObjLink.instanceId & 0xFF00) >> 8);
-            buf[3] = (uint8_t)(dataP[i].value.asObjLink.instanceId & 0x00FF);
-
-            // Keep encoding as buffer
-            headerLen = prv_createHeader(*bufferP + index, resType, resId, 4);
-            index += headerLen;
-            memcpy(*bufferP + index, buf, 4);
-            index += 4;
-
-            resourceDataLength += headerLen + 4;
-            break;
-        }
+            if (instanceP != NULL)
+            {
+                result = prv_closeContainer(&writer, PRV_TLV_TYPE_OBJECT_INSTANCE, instanceP->instanceID, instanceStart, instanceReserved, &instanceLength);
+                if (result != IOWA_COAP_NO_ERROR)
+                {
+                    break;
+                }
+            }
 
-        default:
-            result = IOWA_COAP_400_BAD_REQUEST;
-            goto exit_function;
+            instanceP = dataP + i;
+            result = prv_openContainer(&writer, instanceP->instanceID, instanceLength, &instanceStart, &instanceReserved);
+            if (result != IOWA_COAP_NO_ERROR)
+            {
+                break;
+            }
         }
 
-        // Check if this is a multiple resource
-        if (dataP[i].resInstanceID != IOWA_LWM2M_ID_ALL
-                 && uriDepth != LWM2M_URI_DEPTH_RESOURCE_INSTANCE)
+        // Check if this is a new multiple resource
+        if (multipleResourceP == NULL
+            && dataP[i].resInstanceID != IOWA_LWM2M_ID_ALL
+            && uriDepth != LWM2M_URI_DEPTH_RESOURCE_INSTANCE)
         {
-            // Check if this is a new multiple resource
-            if (i + 1 == size
-                || dataP[i].resourceID != dataP[i+1].resourceID)
+            multipleResourceP = dataP + i;
+            result = prv_openContainer(&writer, multipleResourceP->resourceID, multipleResourceLength, &multipleResourceStart, &multipleResourceReserved);
+            if (result != IOWA_COAP_NO_ERROR)
             {
-                headerLen = prv_getHeaderLength(dataP[i].resourceID, resourceDataLength);
-                memmove(*bufferP + index + headerLen - resourceDataLength, *bufferP + index - resourceDataLength, resourceDataLength);
-
-                (void)prv_createHeader(*bufferP + index - resourceDataLength, PRV_TLV_TYPE_MULTIPLE_RESOURCE, dataP[i].resourceID, resourceDataLength);
-                index += headerLen;
-
-                instanceDataLength += resourceDataLength + headerLen;
-                resourceDataLength = 0;
+                break;
             }
         }
-        else
-        {
-            instanceDataLength += resourceDataLength;
-            resourceDataLength = 0;
-        }
 
+        result = prv_writeResource(&writer, dataP + i);
     }
 
-    switch (uriDepth)
+    if (result == IOWA_COAP_NO_ERROR
+        && multipleResourceP != NULL)
     {
-    case LWM2M_URI_DEPTH_OBJECT:
+        result = prv_closeContainer(&writer, PRV_TLV_TYPE_MULTIPLE_RESOURCE, multipleResourceP->resourceID, multipleResourceStart, multipleResourceReserved, &multipleResourceLength);
+    }
+    if (result == IOWA_COAP_NO_ERROR
+        && instanceP != NULL)
     {
-        size_t headerLen;
-
-        headerLen = prv_getHeaderLength(dataP[i-1].instanceID, instanceDataLength);
-        memmove(*bufferP + index + headerLen - instanceDataLength, *bufferP + index - instanceDataLength, instanceDataLength);
-
-        (void)prv_createHeader(*bufferP + index - instanceDataLength, PRV_TLV_TYPE_OBJECT_INSTANCE, dataP[i-1].instanceID, instanceDataLength);
-        break;
+        result = prv_closeContainer(&writer, PRV_TLV_TYPE_OBJECT_INSTANCE, instanceP->instanceID, instanceStart, instanceReserved, &instanceLength);
     }
 
-    default:
-        break;
+    if (result != IOWA_COAP_NO_ERROR
+        || writer.index == headroom)
+    {
+        iowa_system_free(writer.buffer);
     }
-
-exit_function:
-    if (result != IOWA_COAP_NO_ERROR)
+    else
     {
-        iowa_system_free(*bufferP);
-        *bufferP = NULL;
+        *bufferP = writer.buffer;
+        *bufferLengthP = writer.index - headroom;
     }
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_DATA, "Returning %u bytes", *bufferLengthP);
@@ -38,7 +38,10 @@ set(BASE_SOURCES
     ${BASE_DIR}/iowa_base.c
     ${BASE_DIR}/iowa_buffer.c
     ${BASE_DIR}/iowa_context.c
-    ${BASE_DIR}/iowa_timer.c)
+    ${BASE_DIR}/iowa_timer.c
+    ${BASE_DIR}/iowa_memory_pool.c
+    ${BASE_DIR}/iowa_metrics.c
+    ${BASE_DIR}/iowa_command_queue.c)
 
 set(BASE_CLIENT_SOURCES
     ${BASE_DIR}/iowa_client.c)
@@ -37,6 +37,127 @@
                         ((S) == IOWA_PART_OBJECT ? "object" :     \
                         "unknown"))))))))
 
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+
+#if (IOWA_LOG_RING_BUFFER_SIZE < 256) || ((IOWA_LOG_RING_BUFFER_SIZE & (IOWA_LOG_RING_BUFFER_SIZE - 1)) != 0)
+#error "IOWA_LOG_RING_BUFFER_SIZE must be a power of two of at least 256."
+#endif
+
+// The ring buffer is shared by all the threads logging and the one calling iowa_log_flush()
+#if defined(__GNUC__) || defined(__clang__)
+#define PRV_ATOMIC_LOAD(P)       __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define PRV_ATOMIC_STORE(P, V)   __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+#define PRV_ATOMIC_CAS(P, E, V)  __atomic_compare_exchange_n((P), (E), (V), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define PRV_ATOMIC_EXCHANGE(P, V) __atomic_exchange_n((P), (V), __ATOMIC_ACQ_REL)
+#define PRV_ATOMIC_INCREMENT(P)  (void)__atomic_add_fetch((P), 1, __ATOMIC_RELAXED)
+#elif defined(IOWA_THREAD_SUPPORT)
+#error "IOWA_LOG_RING_BUFFER_SIZE with IOWA_THREAD_SUPPORT requires the GCC atomic built-ins."
+#else
+#define PRV_ATOMIC_LOAD(P)       (*(P))
+#define PRV_ATOMIC_STORE(P, V)   (*(P) = (V))
+#define PRV_ATOMIC_CAS(P, E, V)  (*(P) == *(E) ? (*(P) = (V), true) : (*(E) = *(P), false))
+#define PRV_ATOMIC_EXCHANGE(P, V) prv_exchange((P), (V))
+#define PRV_ATOMIC_INCREMENT(P)  ((*(P))++)
+
+static uint32_t prv_exchange(uint32_t *valueP,
+                             uint32_t newValue)
+{
+    uint32_t oldValue;
+
+    oldValue = *valueP;
+    *valueP = newValue;
+
+    return oldValue;
+}
+#endif
+
+// Records start on multiples of this value
+#define PRV_RECORD_ALIGNMENT 8
+
+// Flag of the record state for the unused bytes at the end of the ring buffer
+#define PRV_RECORD_PADDING     0x80000000
+#define PRV_RECORD_LENGTH_MASK 0x7FFFFFFF
+
+// Content of the record after its header
+#define PRV_RECORD_FLAG_ARGS   0x01
+#define PRV_RECORD_FLAG_BUFFER 0x02
+
+// Longest string argument stored in a record, longer ones are truncated
+#define PRV_STRING_MAX_LENGTH 64
+
+// Largest record accepted in the ring buffer
+#define PRV_RECORD_MAX_LENGTH (IOWA_LOG_RING_BUFFER_SIZE / 2)
+
+#if defined(IOWA_LOG_BUFFER_LIMIT) && (IOWA_LOG_BUFFER_LIMIT < IOWA_LOG_RING_BUFFER_SIZE / 4)
+#define PRV_BUFFER_DUMP_MAX IOWA_LOG_BUFFER_LIMIT
+#else
+#define PRV_BUFFER_DUMP_MAX (IOWA_LOG_RING_BUFFER_SIZE / 4)
+#endif
+
+#elif defined(IOWA_LOG_BUFFER_LIMIT)
+#define PRV_BUFFER_DUMP_MAX IOWA_LOG_BUFFER_LIMIT
+#endif // IOWA_LOG_RING_BUFFER_SIZE
+
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+
+typedef enum
+{
+    PRV_LENGTH_DEFAULT = 0,
+    PRV_LENGTH_CHAR,
+    PRV_LENGTH_SHORT,
+    PRV_LENGTH_LONG,
+    PRV_LENGTH_LONG_LONG,
+    PRV_LENGTH_INTMAX,
+    PRV_LENGTH_SIZE,
+    PRV_LENGTH_PTRDIFF,
+    PRV_LENGTH_LONG_DOUBLE
+} prv_length_modifier_t;
+
+// A conversion specification of a format string
+typedef struct
+{
+    const char           *startP;          // the '%' character
+    const char           *endP;            // after the conversion character
+    const char           *flagsP;
+    size_t                flagsLength;
+    const char           *widthP;          // digits of the width, nil if given by an argument
+    size_t                widthLength;
+    bool                  widthArgument;
+    bool                  hasPrecision;
+    const char           *precisionP;      // digits of the precision, nil if given by an argument
+    size_t                precisionLength;
+    bool                  precisionArgument;
+    prv_length_modifier_t lengthModifier;
+    char                  conversion;      // 0 at the end of the format string
+} prv_spec_t;
+
+typedef struct
+{
+    uint32_t    state;        // record length with PRV_RECORD_PADDING, 0 until the record is written
+    uint8_t     part;
+    uint8_t     level;
+    uint8_t     flags;        // PRV_RECORD_FLAG_xxx
+    uint8_t     reserved;
+    uint32_t    line;
+    int32_t     time;
+    const char *functionName;
+    const char *message;      // format string when PRV_RECORD_FLAG_ARGS is set
+    size_t      bufferLength; // original length of the logged buffer
+} prv_record_header_t;
+
+static union
+{
+    uint8_t  bytes[IOWA_LOG_RING_BUFFER_SIZE];
+    uint64_t alignment;
+} prv_ringBuffer;
+static uint32_t prv_ringHead;           // position of the next record to reserve
+static uint32_t prv_ringTail;           // position of the next record to output
+static uint32_t prv_ringDroppedCount;   // records dropped because the ring buffer was full
+static uint32_t prv_ringReportedCount;  // dropped records already reported by iowa_log_flush()
+static uint32_t prv_ringConsumer;       // 1 while iowa_log_flush() runs
+
+#endif // IOWA_LOG_RING_BUFFER_SIZE
+
 /*************************************************************************************
 ** Private functions
 *************************************************************************************/
@@ -59,25 +180,35 @@ static void prv_printf(const char *format, ...)
 
 #define PRV_HEX(n) ((n) < 10 ? ('0' + (n)) : ('A' + ((n)-10)))
 
+static size_t prv_getDumpLength(size_t bufferLength)
+{
+#ifdef PRV_BUFFER_DUMP_MAX
+    if (PRV_BUFFER_DUMP_MAX < bufferLength)
+    {
+        return PRV_BUFFER_DUMP_MAX;
+    }
+#endif
+
+    return bufferLength;
+}
+
+// Output the first dumpLength bytes of a buffer of bufferLength bytes.
 static void prv_logBuffer(const uint8_t *buffer,
-                          size_t bufferLength)
+                          size_t bufferLength,
+                          size_t dumpLength)
 {
     size_t i;
 
-#ifdef IOWA_LOG_BUFFER_LIMIT
-    if (IOWA_LOG_BUFFER_LIMIT < bufferLength)
+    if (dumpLength < bufferLength)
     {
-        prv_printf("%d bytes (truncated)\r\n", bufferLength);
-        bufferLength = IOWA_LOG_BUFFER_LIMIT;
+        prv_printf("%u bytes (truncated)\r\n", (unsigned int)bufferLength);
     }
     else
-#else
     {
-        prv_printf("%d bytes\r\n", bufferLength);
+        prv_printf("%u bytes\r\n", (unsigned int)bufferLength);
     }
-#endif
 
-    for (i = 0; i < bufferLength; i += 16)
+    for (i = 0; i < dumpLength; i += 16)
     {
         size_t j;
         char lineBuf[PRV_MAX_LINE_LEN];
@@ -89,7 +220,7 @@ static void prv_logBuffer(const uint8_t *buffer,
         *outC++ = ' ';
 
         // Print the buffer by byte
-        for (j = 0; j < 16 && i + j < bufferLength; j++)
+        for (j = 0; j < 16 && i + j < dumpLength; j++)
         {
             byte = buffer[i + j];
 
@@ -122,7 +253,7 @@ static void prv_logBuffer(const uint8_t *buffer,
         *outC++ = '|';
 
         // Print the buffer with writable characters if possible
-        for (j = 0; j < 16 && i + j < bufferLength; j++)
+        for (j = 0; j < 16 && i + j < dumpLength; j++)
         {
             byte = buffer[i + j];
 
@@ -142,6 +273,748 @@ static void prv_logBuffer(const uint8_t *buffer,
     }
 }
 
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+
+static const char *prv_skipDigits(const char *formatP)
+{
+    while (*formatP >= '0' && *formatP <= '9')
+    {
+        formatP++;
+    }
+
+    return formatP;
+}
+
+// Find the next conversion specification of a format string.
+// Returned value: the first character after the literal text preceding the conversion specification.
+// Parameters:
+// - formatP: where to start the search in the format string.
+// - specP: OUT. the conversion specification. specP->conversion is 0 when the end of the format string is reached.
+static const char *prv_getNextSpec(const char *formatP,
+                                   prv_spec_t *specP)
+{
+    const char *textEndP;
+
+    textEndP = strchr(formatP, '%');
+    if (textEndP == NULL)
+    {
+        textEndP = formatP + strlen(formatP);
+        specP->startP = textEndP;
+        specP->endP = textEndP;
+        specP->conversion = 0;
+        return textEndP;
+    }
+
+    specP->startP = textEndP;
+    specP->widthP = NULL;
+    specP->widthLength = 0;
+    specP->widthArgument = false;
+    specP->hasPrecision = false;
+    specP->precisionP = NULL;
+    specP->precisionLength = 0;
+    specP->precisionArgument = false;
+    specP->lengthModifier = PRV_LENGTH_DEFAULT;
+    formatP = textEndP + 1;
+
+    specP->flagsP = formatP;
+    while (*formatP == '-' || *formatP == '+' || *formatP == ' ' || *formatP == '#' || *formatP == '0')
+    {
+        formatP++;
+    }
+    specP->flagsLength = (size_t)(formatP - specP->flagsP);
+
+    if (*formatP == '*')
+    {
+        specP->widthArgument = true;
+        formatP++;
+    }
+    else
+    {
+        specP->widthP = formatP;
+        formatP = prv_skipDigits(formatP);
+        specP->widthLength = (size_t)(formatP - specP->widthP);
+    }
+
+    if (*formatP == '.')
+    {
+        specP->hasPrecision = true;
+        formatP++;
+        if (*formatP == '*')
+        {
+            specP->precisionArgument = true;
+            formatP++;
+        }
+        else
+        {
+            specP->precisionP = formatP;
+            formatP = prv_skipDigits(formatP);
+            specP->precisionLength = (size_t)(formatP - specP->precisionP);
+        }
+    }
+
+    switch (*formatP)
+    {
+    case 'h':
+        formatP++;
+        if (*formatP == 'h')
+        {
+            specP->lengthModifier = PRV_LENGTH_CHAR;
+            formatP++;
+        }
+        else
+        {
+            specP->lengthModifier = PRV_LENGTH_SHORT;
+        }
+        break;
+
+    case 'l':
+        formatP++;
+        if (*formatP == 'l')
+        {
+            specP->lengthModifier = PRV_LENGTH_LONG_LONG;
+            formatP++;
+        }
+        else
+        {
+            specP->lengthModifier = PRV_LENGTH_LONG;
+        }
+        break;
+
+    case 'j':
+        specP->lengthModifier = PRV_LENGTH_INTMAX;
+        formatP++;
+        break;
+
+    case 'z':
+        specP->lengthModifier = PRV_LENGTH_SIZE;
+        formatP++;
+        break;
+
+    case 't':
+        specP->lengthModifier = PRV_LENGTH_PTRDIFF;
+        formatP++;
+        break;
+
+    case 'L':
+        specP->lengthModifier = PRV_LENGTH_LONG_DOUBLE;
+        formatP++;
+        break;
+
+    default:
+        break;
+    }
+
+    specP->conversion = *formatP;
+    if (*formatP != '\0')
+    {
+        formatP++;
+    }
+    else
+    {
+        // Truncated conversion specification, output it as text
+        specP->conversion = '?';
+    }
+    specP->endP = formatP;
+
+    return textEndP;
+}
+
+static size_t prv_stringLength(const char *stringP,
+                               size_t maxLength)
+{
+    size_t length;
+
+    length = 0;
+    while (length < maxLength && stringP[length] != '\0')
+    {
+        length++;
+    }
+
+    return length;
+}
+
+// Store the arguments of a format string or compute their size.
+// Returned value: the size of the stored arguments.
+// Parameters:
+// - format: printf-like format string.
+// - argsP: the arguments matching the format string.
+// - buffer: where to store the arguments. If nil, only the size is computed.
+static size_t prv_storeArgs(const char *format,
+                            va_list *argsP,
+                            uint8_t *buffer)
+{
+    prv_spec_t spec;
+    size_t length;
+
+    length = 0;
+    (void)prv_getNextSpec(format, &spec);
+    while (spec.conversion != 0)
+    {
+        int precision;
+
+        precision = -1;
+        if (spec.widthArgument == true)
+        {
+            int width;
+
+            width = va_arg(*argsP, int);
+            if (buffer != NULL)
+            {
+                memcpy(buffer + length, &width, sizeof(int));
+            }
+            length += sizeof(int);
+        }
+        if (spec.precisionArgument == true)
+        {
+            precision = va_arg(*argsP, int);
+            if (buffer != NULL)
+            {
+                memcpy(buffer + length, &precision, sizeof(int));
+            }
+            length += sizeof(int);
+        }
+        else if (spec.hasPrecision == true)
+        {
+            precision = atoi(spec.precisionP);
+        }
+
+        switch (spec.conversion)
+        {
+        case 'd':
+        case 'i':
+        case 'c':
+        {
+            int64_t value;
+
+            switch (spec.lengthModifier)
+            {
+            case PRV_LENGTH_LONG:
+                value = (int64_t)va_arg(*argsP, long);
+                break;
+
+            case PRV_LENGTH_LONG_LONG:
+                value = (int64_t)va_arg(*argsP, long long);
+                break;
+
+            case PRV_LENGTH_INTMAX:
+                value = (int64_t)va_arg(*argsP, intmax_t);
+                break;
+
+            case PRV_LENGTH_SIZE:
+                value = (int64_t)va_arg(*argsP, size_t);
+                break;
+
+            case PRV_LENGTH_PTRDIFF:
+                value = (int64_t)va_arg(*argsP, ptrdiff_t);
+                break;
+
+            case PRV_LENGTH_CHAR:
+                value = (int64_t)(signed char)va_arg(*argsP, int);
+                break;
+
+            case PRV_LENGTH_SHORT:
+                value = (int64_t)(short)va_arg(*argsP, int);
+                break;
+
+            default:
+                value = (int64_t)va_arg(*argsP, int);
+            }
+            if (buffer != NULL)
+            {
+                memcpy(buffer + length, &value, sizeof(int64_t));
+            }
+            length += sizeof(int64_t);
+            break;
+        }
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        {
+            uint64_t value;
+
+            switch (spec.lengthModifier)
+            {
+            case PRV_LENGTH_LONG:
+                value = (uint64_t)va_arg(*argsP, unsigned long);
+                break;
+
+            case PRV_LENGTH_LONG_LONG:
+                value = (uint64_t)va_arg(*argsP, unsigned long long);
+                break;
+
+            case PRV_LENGTH_INTMAX:
+                value = (uint64_t)va_arg(*argsP, uintmax_t);
+                break;
+
+            case PRV_LENGTH_SIZE:
+                value = (uint64_t)va_arg(*argsP, size_t);
+                break;
+
+            case PRV_LENGTH_PTRDIFF:
+                value = (uint64_t)va_arg(*argsP, ptrdiff_t);
+                break;
+
+            case PRV_LENGTH_CHAR:
+                value = (uint64_t)(unsigned char)va_arg(*argsP, unsigned int);
+                break;
+
+            case PRV_LENGTH_SHORT:
+                value = (uint64_t)(unsigned short)va_arg(*argsP, unsigned int);
+                break;
+
+            default:
+                value = (uint64_t)va_arg(*argsP, unsigned int);
+            }
+            if (buffer != NULL)
+            {
+                memcpy(buffer + length, &value, sizeof(uint64_t));
+            }
+            length += sizeof(uint64_t);
+            break;
+        }
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            double value;
+
+            if (spec.lengthModifier == PRV_LENGTH_LONG_DOUBLE)
+            {
+                value = (double)va_arg(*argsP, long double);
+            }
+            else
+            {
+                value = va_arg(*argsP, double);
+            }
+            if (buffer != NULL)
+            {
+                memcpy(buffer + length, &value, sizeof(double));
+            }
+            length += sizeof(double);
+            break;
+        }
+
+        case 'p':
+        {
+            void *value;
+
+            value = va_arg(*argsP, void *);
+            if (buffer != NULL)
+            {
+                memcpy(buffer + length, &value, sizeof(void *));
+            }
+            length += sizeof(void *);
+            break;
+        }
+
+        case 's':
+        {
+            const char *stringP;
+            uint8_t stringLength;
+
+            stringP = va_arg(*argsP, const char *);
+            if (stringP == NULL)
+            {
+                stringP = "(null)";
+            }
+            if (precision >= 0 && precision < PRV_STRING_MAX_LENGTH)
+            {
+                stringLength = (uint8_t)prv_stringLength(stringP, (size_t)precision);
+            }
+            else
+            {
+                stringLength = (uint8_t)prv_stringLength(stringP, PRV_STRING_MAX_LENGTH);
+            }
+            if (buffer != NULL)
+            {
+                buffer[length] = stringLength;
+                memcpy(buffer + length + 1, stringP, stringLength);
+            }
+            length += 1 + stringLength;
+            break;
+        }
+
+        case 'n':
+            // Nothing is written back
+            (void)va_arg(*argsP, void *);
+            break;
+
+        default:
+            // '%' or unknown conversion: no argument
+            break;
+        }
+
+        (void)prv_getNextSpec(spec.endP, &spec);
+    }
+
+    return length;
+}
+
+static size_t prv_intToString(int value,
+                              char *buffer)
+{
+    char digits[12];
+    size_t digitCount;
+    size_t length;
+    unsigned int absValue;
+
+    length = 0;
+    if (value < 0)
+    {
+        buffer[length++] = '-';
+        absValue = 0U - (unsigned int)value;
+    }
+    else
+    {
+        absValue = (unsigned int)value;
+    }
+
+    digitCount = 0;
+    do
+    {
+        digits[digitCount++] = (char)('0' + absValue % 10);
+        absValue /= 10;
+    } while (absValue != 0);
+
+    while (digitCount != 0)
+    {
+        buffer[length++] = digits[--digitCount];
+    }
+
+    return length;
+}
+
+// Output a format string with the arguments stored by prv_storeArgs().
+// Returned value: the size of the read arguments.
+// Parameters:
+// - format: printf-like format string.
+// - buffer: the stored arguments.
+static size_t prv_printArgs(const char *format,
+                            const uint8_t *buffer)
+{
+    // '%', flags, width, '.', precision, "ll", conversion and NUL
+    char specBuffer[1 + 8 + 12 + 1 + 12 + 2 + 1 + 1];
+    prv_spec_t spec;
+    const char *textP;
+    const char *textEndP;
+    size_t length;
+
+    length = 0;
+    textP = format;
+    textEndP = prv_getNextSpec(textP, &spec);
+    while (true)
+    {
+        size_t specLength;
+        int precision;
+
+        if (textEndP != textP)
+        {
+            prv_printf("%.*s", (int)(textEndP - textP), textP);
+        }
+        if (spec.conversion == 0)
+        {
+            break;
+        }
+
+        // Rebuild the conversion specification with the width and precision arguments and a length modifier matching the stored values
+        specBuffer[0] = '%';
+        specLength = 1;
+        if (spec.flagsLength <= 8)
+        {
+            memcpy(specBuffer + specLength, spec.flagsP, spec.flagsLength);
+            specLength += spec.flagsLength;
+        }
+        if (spec.widthArgument == true)
+        {
+            int width;
+
+            memcpy(&width, buffer + length, sizeof(int));
+            length += sizeof(int);
+            specLength += prv_intToString(width, specBuffer + specLength);
+        }
+        else if (spec.widthLength <= 10)
+        {
+            memcpy(specBuffer + specLength, spec.widthP, spec.widthLength);
+            specLength += spec.widthLength;
+        }
+        precision = -1;
+        if (spec.precisionArgument == true)
+        {
+            memcpy(&precision, buffer + length, sizeof(int));
+            length += sizeof(int);
+        }
+        else if (spec.hasPrecision == true)
+        {
+            precision = atoi(spec.precisionP);
+        }
+        if (precision >= 0)
+        {
+            specBuffer[specLength++] = '.';
+            specLength += prv_intToString(precision, specBuffer + specLength);
+        }
+
+        switch (spec.conversion)
+        {
+        case 'd':
+        case 'i':
+        case 'c':
+        {
+            int64_t value;
+
+            memcpy(&value, buffer + length, sizeof(int64_t));
+            length += sizeof(int64_t);
+            if (spec.conversion == 'c')
+            {
+                specBuffer[specLength++] = 'c';
+                specBuffer[specLength] = '\0';
+                prv_printf(specBuffer, (int)value);
+            }
+            else
+            {
+                specBuffer[specLength++] = 'l';
+                specBuffer[specLength++] = 'l';
+                specBuffer[specLength++] = spec.conversion;
+                specBuffer[specLength] = '\0';
+                prv_printf(specBuffer, (long long)value);
+            }
+            break;
+        }
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        {
+            uint64_t value;
+
+            memcpy(&value, buffer + length, sizeof(uint64_t));
+            length += sizeof(uint64_t);
+            specBuffer[specLength++] = 'l';
+            specBuffer[specLength++] = 'l';
+            specBuffer[specLength++] = spec.conversion;
+            specBuffer[specLength] = '\0';
+            prv_printf(specBuffer, (unsigned long long)value);
+            break;
+        }
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            double value;
+
+            memcpy(&value, buffer + length, sizeof(double));
+            length += sizeof(double);
+            specBuffer[specLength++] = spec.conversion;
+            specBuffer[specLength] = '\0';
+            prv_printf(specBuffer, value);
+            break;
+        }
+
+        case 'p':
+        {
+            void *value;
+
+            memcpy(&value, buffer + length, sizeof(void *));
+            length += sizeof(void *);
+            specBuffer[specLength++] = 'p';
+            specBuffer[specLength] = '\0';
+            prv_printf(specBuffer, value);
+            break;
+        }
+
+        case 's':
+        {
+            char string[PRV_STRING_MAX_LENGTH + 1];
+            uint8_t stringLength;
+
+            stringLength = buffer[length];
+            memcpy(string, buffer + length + 1, stringLength);
+            string[stringLength] = '\0';
+            length += 1 + stringLength;
+            specBuffer[specLength++] = 's';
+            specBuffer[specLength] = '\0';
+            prv_printf(specBuffer, string);
+            break;
+        }
+
+        case 'n':
+            break;
+
+        case '%':
+            prv_printf("%%");
+            break;
+
+        default:
+            prv_printf("%.*s", (int)(spec.endP - spec.startP), spec.startP);
+            break;
+        }
+
+        textP = spec.endP;
+        textEndP = prv_getNextSpec(textP, &spec);
+    }
+
+    return length;
+}
+
+static void prv_printRecord(const prv_record_header_t *headerP)
+{
+    const uint8_t *dataP;
+    size_t dataLength;
+
+    dataP = (const uint8_t *)headerP + sizeof(prv_record_header_t);
+
+    prv_printf("%ld [%s:%s:%s:%u] ", (long)headerP->time, PRV_STR_LEVEL(headerP->level), PRV_STR_PART(headerP->part), headerP->functionName, (unsigned int)headerP->line);
+    if ((headerP->flags & PRV_RECORD_FLAG_ARGS) != 0)
+    {
+        dataLength = prv_printArgs(headerP->message, dataP);
+    }
+    else
+    {
+        prv_printf("%s", headerP->message);
+        dataLength = 0;
+    }
+
+    if ((headerP->flags & PRV_RECORD_FLAG_BUFFER) != 0)
+    {
+        prv_printf(" ");
+        prv_logBuffer(dataP + dataLength, headerP->bufferLength, prv_getDumpLength(headerP->bufferLength));
+    }
+    else
+    {
+        prv_printf("\r\n");
+    }
+}
+
+// Reserve a record in the ring buffer.
+// Returned value: the record or nil if the ring buffer is full.
+// Parameters:
+// - length: size of the record, a multiple of PRV_RECORD_ALIGNMENT.
+static prv_record_header_t *prv_ringReserve(uint32_t length)
+{
+    uint32_t head;
+    uint32_t offset;
+    uint32_t padding;
+
+    head = PRV_ATOMIC_LOAD(&prv_ringHead);
+    do
+    {
+        uint32_t tail;
+
+        offset = head & (IOWA_LOG_RING_BUFFER_SIZE - 1);
+        // A record does not wrap around the end of the ring buffer
+        if (offset + length > IOWA_LOG_RING_BUFFER_SIZE)
+        {
+            padding = IOWA_LOG_RING_BUFFER_SIZE - offset;
+        }
+        else
+        {
+            padding = 0;
+        }
+
+        tail = PRV_ATOMIC_LOAD(&prv_ringTail);
+        if ((uint32_t)(head - tail) + padding + length > IOWA_LOG_RING_BUFFER_SIZE)
+        {
+            PRV_ATOMIC_INCREMENT(&prv_ringDroppedCount);
+            return NULL;
+        }
+    } while (PRV_ATOMIC_CAS(&prv_ringHead, &head, head + padding + length) == false);
+
+    if (padding != 0)
+    {
+        PRV_ATOMIC_STORE((uint32_t *)(prv_ringBuffer.bytes + offset), PRV_RECORD_PADDING | padding);
+        offset = 0;
+    }
+
+    return (prv_record_header_t *)(prv_ringBuffer.bytes + offset);
+}
+
+// Store a log as a record in the ring buffer.
+// Parameters:
+// - part, level, functionName, line, message: as given to iowa_log().
+// - buffer, bufferLength: the buffer to dump. buffer can be nil.
+// - argsP: the arguments of message. If nil, message is not a format string.
+static void prv_ringLog(uint8_t part,
+                        uint8_t level,
+                        const char *functionName,
+                        unsigned int line,
+                        const char *message,
+                        const uint8_t *buffer,
+                        size_t bufferLength,
+                        va_list *argsP)
+{
+    prv_record_header_t *headerP;
+    size_t argsLength;
+    size_t dumpLength;
+    size_t length;
+
+    argsLength = 0;
+    if (argsP != NULL)
+    {
+        va_list args;
+
+        va_copy(args, *argsP);
+        argsLength = prv_storeArgs(message, &args, NULL);
+        va_end(args);
+    }
+    dumpLength = 0;
+    if (buffer != NULL)
+    {
+        dumpLength = prv_getDumpLength(bufferLength);
+    }
+
+    length = sizeof(prv_record_header_t) + argsLength + dumpLength;
+    length = (length + PRV_RECORD_ALIGNMENT - 1) & ~((size_t)PRV_RECORD_ALIGNMENT - 1);
+    if (length > PRV_RECORD_MAX_LENGTH)
+    {
+        PRV_ATOMIC_INCREMENT(&prv_ringDroppedCount);
+        return;
+    }
+
+    headerP = prv_ringReserve((uint32_t)length);
+    if (headerP == NULL)
+    {
+        return;
+    }
+
+    headerP->part = part;
+    headerP->level = level;
+    headerP->flags = 0;
+    headerP->line = (uint32_t)line;
+    headerP->time = iowa_system_gettime();
+    headerP->functionName = functionName;
+    headerP->message = message;
+    headerP->bufferLength = bufferLength;
+    if (argsP != NULL)
+    {
+        headerP->flags |= PRV_RECORD_FLAG_ARGS;
+        (void)prv_storeArgs(message, argsP, (uint8_t *)headerP + sizeof(prv_record_header_t));
+    }
+    if (buffer != NULL)
+    {
+        headerP->flags |= PRV_RECORD_FLAG_BUFFER;
+        memcpy((uint8_t *)headerP + sizeof(prv_record_header_t) + argsLength, buffer, dumpLength);
+    }
+
+    // Publish the record
+    PRV_ATOMIC_STORE(&(headerP->state), (uint32_t)length);
+}
+
+#endif // IOWA_LOG_RING_BUFFER_SIZE
+
 /*************************************************************************************
 ** Internal functions
 *************************************************************************************/
@@ -154,7 +1027,11 @@ void iowa_log(uint8_t part,
 {
     if ((IOWA_LOG_PART) & part)
     {
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+        prv_ringLog(part, level, functionName, line, message, NULL, 0, NULL);
+#else
         prv_printf("[%s:%s:%s:%d] %s\r\n", PRV_STR_LEVEL(level), PRV_STR_PART(part), functionName, line, message);
+#endif
     }
 }
 
@@ -169,6 +1046,11 @@ void iowa_log_arg(uint8_t part,
     {
         va_list args;
 
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+        va_start(args, message);
+        prv_ringLog(part, level, functionName, line, message, NULL, 0, &args);
+        va_end(args);
+#else
         prv_printf("[%s:%s:%s:%d] ", PRV_STR_LEVEL(level), PRV_STR_PART(part), functionName, line);
 
         va_start(args, message);
@@ -176,6 +1058,7 @@ void iowa_log_arg(uint8_t part,
         va_end(args);
 
         prv_printf("\r\n");
+#endif
     }
 }
 
@@ -189,8 +1072,12 @@ void iowa_log_buffer(uint8_t part,
 {
     if ((IOWA_LOG_PART) & part)
     {
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+        prv_ringLog(part, level, functionName, line, message, buffer, bufferLength, NULL);
+#else
         prv_printf("[%s:%s:%s:%d] %s ", PRV_STR_LEVEL(level), PRV_STR_PART(part), functionName, line, message);
-        prv_logBuffer(buffer, bufferLength);
+        prv_logBuffer(buffer, bufferLength, prv_getDumpLength(bufferLength));
+#endif
     }
 }
 
@@ -207,6 +1094,11 @@ void iowa_log_arg_buffer(uint8_t part,
     {
         va_list args;
 
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+        va_start(args, bufferLength);
+        prv_ringLog(part, level, functionName, line, message, buffer, bufferLength, &args);
+        va_end(args);
+#else
         prv_printf("[%s:%s:%s:%d] ", PRV_STR_LEVEL(level), PRV_STR_PART(part), functionName, line);
 
         va_start(args, bufferLength);
@@ -214,7 +1106,65 @@ void iowa_log_arg_buffer(uint8_t part,
         va_end(args);
 
         prv_printf(" ");
-        prv_logBuffer(buffer, bufferLength);
+        prv_logBuffer(buffer, bufferLength, prv_getDumpLength(bufferLength));
+#endif
     }
 }
 
+#ifdef IOWA_LOG_RING_BUFFER_SIZE
+size_t iowa_log_flush(void)
+{
+    size_t recordCount;
+    uint32_t tail;
+    uint32_t droppedCount;
+
+    if (PRV_ATOMIC_EXCHANGE(&prv_ringConsumer, 1) != 0)
+    {
+        // Another thread is already outputting the records
+        return 0;
+    }
+
+    recordCount = 0;
+    tail = PRV_ATOMIC_LOAD(&prv_ringTail);
+    while (tail != PRV_ATOMIC_LOAD(&prv_ringHead))
+    {
+        uint8_t *recordP;
+        uint32_t state;
+
+        recordP = prv_ringBuffer.bytes + (tail & (IOWA_LOG_RING_BUFFER_SIZE - 1));
+        state = PRV_ATOMIC_LOAD((uint32_t *)recordP);
+        if (state == 0)
+        {
+            // The record is still being written
+            break;
+        }
+
+        if ((state & PRV_RECORD_PADDING) == 0)
+        {
+            prv_printRecord((prv_record_header_t *)recordP);
+            recordCount++;
+        }
+
+        // A new record can start anywhere in the released space, its state must read as 0 until written
+        memset(recordP, 0, state & PRV_RECORD_LENGTH_MASK);
+        tail += state & PRV_RECORD_LENGTH_MASK;
+        PRV_ATOMIC_STORE(&prv_ringTail, tail);
+    }
+
+    droppedCount = PRV_ATOMIC_LOAD(&prv_ringDroppedCount);
+    if (droppedCount != prv_ringReportedCount)
+    {
+        prv_printf("[warning:base:%s:%d] %u log records dropped.\r\n", __func__, __LINE__, (unsigned int)(droppedCount - prv_ringReportedCount));
+        prv_ringReportedCount = droppedCount;
+    }
+
+    PRV_ATOMIC_STORE(&prv_ringConsumer, 0);
+
+    return recordCount;
+}
+
+uint32_t iowa_log_get_dropped_count(void)
+{
+    return PRV_ATOMIC_LOAD(&prv_ringDroppedCount);
+}
+#endif // IOWA_LOG_RING_BUFFER_SIZE
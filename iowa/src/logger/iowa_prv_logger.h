@@ -31,6 +31,9 @@ extern "C" {
 #include "iowa_platform.h"
 
 #include <ctype.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 /**************************************************************
  * Defines
@@ -120,6 +120,10 @@ void lwm2m_close(iowa_context_t contextP)
 
         customObjectDelete(objectP);
     }
+    iowa_system_free(contextP->lwm2mContextP->objectArray);
+    contextP->lwm2mContextP->objectArray = NULL;
+    contextP->lwm2mContextP->objectCount = 0;
+    lwm2mResetRegistrationPayload(contextP);
 
     iowa_system_free(contextP->lwm2mContextP->endpointName);
 #ifdef LWM2M_ALTPATH_SUPPORT
@@ -220,7 +224,7 @@ void lwm2m_server_close(iowa_context_t contextP,
 
     utilsDisconnectServer(contextP, serverP);
     attributesRemoveFromServer(serverP);
-    observeRemoveFromServer(serverP);
+    observeRemoveFromServer(contextP, serverP);
 }
 #endif // LWM2M_CLIENT_MODE
 
@@ -178,6 +178,15 @@ iowa_content_format_t utils_getMediaType(iowa_coap_message_t *messageP,
 #ifdef LWM2M_SUPPORT_TLV
     case IOWA_CONTENT_FORMAT_TLV_OLD:
     case IOWA_CONTENT_FORMAT_TLV:
+#endif
+#ifdef LWM2M_SUPPORT_CBOR
+    case IOWA_CONTENT_FORMAT_CBOR:
+#endif
+#ifdef LWM2M_SUPPORT_SENML_CBOR
+    case IOWA_CONTENT_FORMAT_SENML_CBOR:
+#endif
+#ifdef LWM2M_SUPPORT_LWM2M_CBOR
+    case IOWA_CONTENT_FORMAT_LWM2M_CBOR:
 #endif
         break;
 
@@ -73,6 +73,290 @@
 
 #ifdef LWM2M_CLIENT_MODE
 
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+
+// Hand a Block1 block of a write request to the streamable resource it targets.
+// Returned value: IOWA_COAP_NO_ERROR if the request is not a block-wise transfer, otherwise the code of the response.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - uriP: the URI targeted by the request.
+// - serverP: the LwM2M Server which sent the request.
+// - messageP: the request.
+// - responseP: the response. The Block1 option is added to it.
+static iowa_status_t prv_handleBlock1(iowa_context_t contextP,
+                                      iowa_lwm2m_uri_t *uriP,
+                                      lwm2m_server_t *serverP,
+                                      iowa_coap_message_t *messageP,
+                                      iowa_coap_message_t *responseP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_lwm2m_data_t data;
+    uint32_t number;
+    bool more;
+    uint16_t size;
+    size_t offset;
+
+    result = coapBlockGetInfo(serverP->runtime.peerP, messageP, IOWA_COAP_OPTION_BLOCK_1, &number, &more, &size);
+    if (result == IOWA_COAP_404_NOT_FOUND)
+    {
+        return IOWA_COAP_NO_ERROR;
+    }
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        serverP->runtime.blockOffset = 0;
+        return result;
+    }
+
+    if (number == 0
+        && more == false)
+    {
+        // The whole payload is in this block
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Received block %u (%u bytes, more: %s) for /%u/%u/%u/%u.", number, messageP->payload.length, more ? "true" : "false", uriP->objectId, uriP->instanceId, uriP->resourceId, uriP->resInstanceId);
+
+    if ((messageP->code != IOWA_COAP_CODE_PUT
+         && messageP->code != IOWA_COAP_CODE_POST)
+        || !LWM2M_URI_IS_SET_RESOURCE(uriP)
+        || false == object_checkResourceFlag(contextP, uriP, IOWA_RESOURCE_FLAG_STREAMABLE))
+    {
+        // Only streamable resources receive the payload block by block
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Block-wise transfer is only supported for writing streamable resources.");
+        result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+        goto exit;
+    }
+
+    switch (utils_getMediaType(messageP, IOWA_COAP_OPTION_CONTENT_FORMAT))
+    {
+    case IOWA_CONTENT_FORMAT_TEXT:
+    case IOWA_CONTENT_FORMAT_OPAQUE:
+        break;
+
+    default:
+        IOWA_LOG_WARNING(IOWA_PART_LWM2M, "Blocks of a streamable resource must be in text or opaque format.");
+        result = IOWA_COAP_415_UNSUPPORTED_CONTENT_FORMAT;
+        goto exit;
+    }
+
+    offset = (size_t)number * size;
+    if (offset != 0
+        && (offset != serverP->runtime.blockOffset
+            || !LWM2M_URI_ARE_EQUAL(uriP, &(serverP->runtime.blockUri))))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Block %u received out of sequence.", number);
+        result = IOWA_COAP_408_REQUEST_ENTITY_INCOMPLETE;
+        goto exit;
+    }
+
+    if (more == true
+        && messageP->payload.length != size)
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Block %u has %u bytes instead of %u.", number, messageP->payload.length, size);
+        result = IOWA_COAP_400_BAD_REQUEST;
+        goto exit;
+    }
+
+    memset(&data, 0, sizeof(iowa_lwm2m_data_t));
+    data.objectID = uriP->objectId;
+    data.instanceID = uriP->instanceId;
+    data.resourceID = uriP->resourceId;
+    data.resInstanceID = uriP->resInstanceId;
+    data.type = (iowa_lwm2m_data_type_t)(object_getResourceType(uriP->objectId, uriP->resourceId, contextP) + INTERNAL_LWM2M_TYPE_BLOCK);
+    data.value.asBlock.buffer = messageP->payload.data;
+    data.value.asBlock.totalSize = messageP->payload.length;
+
+    result = iowa_data_set_block_info(&data, number, more, size);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        result = IOWA_COAP_413_REQUEST_ENTITY_TOO_LARGE;
+        goto exit;
+    }
+
+    result = object_checkWritePayload(contextP, 1, &data);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        // Only the first block of a replace operation can reset the resource instances
+        result = object_write(contextP, serverP->shortId, 1, &data, messageP->code == IOWA_COAP_CODE_POST || number != 0);
+    }
+    if (result != IOWA_COAP_204_CHANGED)
+    {
+        goto exit;
+    }
+
+    if (coapBlockAddOption(responseP, IOWA_COAP_OPTION_BLOCK_1, number, more, size) != IOWA_COAP_NO_ERROR)
+    {
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit;
+    }
+
+    serverP->runtime.flags |= LWM2M_SERVER_FLAG_AVAILABLE;
+
+    if (more == true)
+    {
+        LWM2M_URI_COPY(&(serverP->runtime.blockUri), uriP);
+        serverP->runtime.blockOffset = offset + size;
+
+        return IOWA_COAP_231_CONTINUE;
+    }
+
+exit:
+    serverP->runtime.blockOffset = 0;
+
+    return result;
+}
+
+// Check if a Read operation can be answered by reading only the requested block.
+// Returned value: true if the URI targets a single streamable value readable in the requested format.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - uriP: the URI targeted by the request.
+// - messageP: the request.
+static bool prv_isBlockReadable(iowa_context_t contextP,
+                                iowa_lwm2m_uri_t *uriP,
+                                iowa_coap_message_t *messageP)
+{
+    if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_ACCEPT) != NULL)
+    {
+        switch (utils_getMediaType(messageP, IOWA_COAP_OPTION_ACCEPT))
+        {
+        case IOWA_CONTENT_FORMAT_TEXT:
+        case IOWA_CONTENT_FORMAT_OPAQUE:
+            break;
+
+        default:
+            return false;
+        }
+    }
+
+    return (LWM2M_URI_IS_SET_RESOURCE(uriP)
+            && object_checkResourceFlag(contextP, uriP, IOWA_RESOURCE_FLAG_STREAMABLE)
+            && (LWM2M_URI_IS_SET_RESOURCE_INSTANCE(uriP)
+                || !object_checkResourceFlag(contextP, uriP, IOWA_RESOURCE_FLAG_MULTIPLE)));
+}
+
+// Read the block of a streamable resource requested by the Block2 option.
+// Returned value: IOWA_COAP_205_CONTENT in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - uriP: the URI targeted by the request.
+// - serverP: the LwM2M Server which sent the request.
+// - messageP: the request.
+// - responseP: the response. The block is set as its payload and the Block2 option is added to it.
+// - responseFormatP: OUT. the format of the response.
+static iowa_status_t prv_readBlock(iowa_context_t contextP,
+                                   iowa_lwm2m_uri_t *uriP,
+                                   lwm2m_server_t *serverP,
+                                   iowa_coap_message_t *messageP,
+                                   iowa_coap_message_t *responseP,
+                                   iowa_content_format_t *responseFormatP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    iowa_content_format_t blockFormat;
+    uint32_t blockInfo;
+    uint32_t number;
+    uint32_t dataNumber;
+    bool more;
+    uint16_t size;
+    uint16_t dataSize;
+
+    result = coapBlockGetInfo(serverP->runtime.peerP, messageP, IOWA_COAP_OPTION_BLOCK_2, &number, &more, &size);
+    if (result == IOWA_COAP_404_NOT_FOUND)
+    {
+        number = 0;
+        size = coapBlockGetPeerSize(serverP->runtime.peerP);
+        if (size == 0)
+        {
+            size = IOWA_DATA_BLOCK_SIZE_1024;
+        }
+    }
+    else if (result != IOWA_COAP_NO_ERROR)
+    {
+        return result;
+    }
+
+    if (coapEncodeBlockInfo(number, false, size, &blockInfo) != IOWA_COAP_NO_ERROR
+        || blockInfo != DATA_BLOCK_DETAIL_TO_OPTION(blockInfo))
+    {
+        IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Block number %u is out of range.", number);
+        return IOWA_COAP_402_BAD_OPTION;
+    }
+
+    result = object_readBlock(contextP, uriP, blockInfo, &dataCount, &dataP);
+    if (result != IOWA_COAP_205_CONTENT)
+    {
+        return result;
+    }
+
+    switch (dataP->type)
+    {
+    case IOWA_LWM2M_TYPE_STRING_BLOCK:
+        blockFormat = IOWA_CONTENT_FORMAT_TEXT;
+        break;
+
+    case IOWA_LWM2M_TYPE_OPAQUE_BLOCK:
+        blockFormat = IOWA_CONTENT_FORMAT_OPAQUE;
+        break;
+
+    default:
+        IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Data type %s is not a block.", STR_LWM2M_TYPE(dataP->type));
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit;
+    }
+
+    if (iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_ACCEPT) != NULL
+        && utils_getMediaType(messageP, IOWA_COAP_OPTION_ACCEPT) != blockFormat)
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Requested format %s is not acceptable.", STR_MEDIA_TYPE(utils_getMediaType(messageP, IOWA_COAP_OPTION_ACCEPT)));
+        result = IOWA_COAP_406_NOT_ACCEPTABLE;
+        goto exit;
+    }
+
+    // The callback tells if more blocks follow
+    if (iowa_data_get_block_info(dataP, &dataNumber, &more, &dataSize) != IOWA_COAP_NO_ERROR
+        || dataNumber != number
+        || dataP->value.asBlock.totalSize > size
+        || (more == true && dataP->value.asBlock.totalSize != size))
+    {
+        IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Invalid block of %u bytes returned by the callback.", dataP->value.asBlock.totalSize);
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit;
+    }
+
+    if (dataP->value.asBlock.totalSize != 0)
+    {
+        responseP->payload = coreBufferNew(dataP->value.asBlock.buffer, dataP->value.asBlock.totalSize);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (responseP->payload.data == NULL)
+        {
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            goto exit;
+        }
+#endif
+    }
+
+    if (coapBlockAddOption(responseP, IOWA_COAP_OPTION_BLOCK_2, number, more, size) != IOWA_COAP_NO_ERROR)
+    {
+        coreBufferClear(&(responseP->payload));
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        goto exit;
+    }
+
+    *responseFormatP = blockFormat;
+
+exit:
+    object_free(contextP, dataCount, dataP);
+    CORE_ARENA_FREE(dataP);
+
+    return result;
+}
+
+#endif // IOWA_COAP_BLOCK_SUPPORT
+
 void dm_handleRequest(iowa_context_t contextP,
                       iowa_lwm2m_uri_t *uriP,
                       lwm2m_server_t *serverP,
@@ -119,6 +403,9 @@ void dm_handleRequest(iowa_context_t contextP,
         return;
     }
 
+    // The data arrays read during the request are allocated in the request arena
+    CORE_ARENA_BEGIN();
+
     dataP = NULL;
     dataCount = 0;
     optionObserveP = iowa_coap_message_find_option(messageP, IOWA_COAP_OPTION_OBSERVE);
@@ -137,6 +424,15 @@ void dm_handleRequest(iowa_context_t contextP,
         }
     }
 
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+    // A block of a write to a streamable resource is handed over without parsing the payload
+    result = prv_handleBlock1(contextP, uriP, serverP, messageP, responseP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        goto error;
+    }
+#endif
+
     // Get the request message format
     requestFormat = utils_getMediaType(messageP, IOWA_COAP_OPTION_CONTENT_FORMAT);
     switch (requestFormat)
@@ -211,6 +507,24 @@ void dm_handleRequest(iowa_context_t contextP,
                 }
             }
         }
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+        else if (optionObserveP == NULL
+                 && prv_isBlockReadable(contextP, uriP, messageP))
+        {
+            // Only the requested block of a streamable resource is read
+            result = prv_readBlock(contextP, uriP, serverP, messageP, responseP, &responseFormat);
+        }
+        else if (optionObserveP == NULL
+                 && coapBlockHasStoredContent(serverP->runtime.peerP, messageP) == true)
+        {
+            // Next block of a content sliced by a previous request: it is not read again
+            result = coapBlockGetStoredResponse(serverP->runtime.peerP, messageP, responseP, &responseFormat);
+            if (result == IOWA_COAP_NO_ERROR)
+            {
+                result = IOWA_COAP_205_CONTENT;
+            }
+        }
+#endif
         else
         {
             {
@@ -223,7 +537,7 @@ void dm_handleRequest(iowa_context_t contextP,
                         uint8_t *bufferP;
                         size_t bufferLengthP;
 
-                        result = dataLwm2mSerialize(uriP, dataP, dataCount, &responseFormat, &bufferP, &bufferLengthP);
+                        result = dataLwm2mSerialize(uriP, dataP, dataCount, &responseFormat, 0, &bufferP, &bufferLengthP);
                         if (result == IOWA_COAP_NO_ERROR)
                         {
                             coreBufferSet(&(responseP->payload), bufferP, bufferLengthP);
@@ -247,13 +561,30 @@ void dm_handleRequest(iowa_context_t contextP,
                     if (dataP != NULL)
                     {
                         object_free(contextP, dataCount, dataP);
-                        iowa_system_free(dataP);
+                        CORE_ARENA_FREE(dataP);
                         dataP = NULL; // Set pointer to NULL to prevent calling dataLwm2mFree at the end of the function
                     }
                 }
             }
         }
 
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+        if (result == IOWA_COAP_205_CONTENT
+            && iowa_coap_message_find_option(responseP, IOWA_COAP_OPTION_BLOCK_2) == NULL)
+        {
+            // The whole content is kept for the next blocks and its ETag identifies it
+            result = coapBlockSliceResponse(serverP->runtime.peerP, messageP, responseP, responseFormat);
+            if (result == IOWA_COAP_NO_ERROR)
+            {
+                result = IOWA_COAP_205_CONTENT;
+            }
+            else
+            {
+                coreBufferClear(&(responseP->payload));
+            }
+        }
+#endif
+
         if (result == IOWA_COAP_205_CONTENT
             && responseP->payload.length != 0)
         {
@@ -459,7 +790,7 @@ error:
                     // Memorize previous observe
                     observedP = serverP->runtime.observedList->next;
                     // Delete last observe
-                    observe_delete(serverP->runtime.observedList);
+                    observe_delete(contextP, serverP->runtime.observedList);
                     serverP->runtime.observedList = observedP;
                 }
             }
@@ -467,6 +798,8 @@ error:
         coreBufferClear(&(responseP->payload));
         iowa_coap_message_free(responseP);
     }
+
+    CORE_ARENA_END();
 }
 #endif
 
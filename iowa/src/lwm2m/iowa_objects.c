@@ -95,10 +95,15 @@ static iowa_status_t prv_callDataCb(iowa_context_t contextP,
                                     iowa_lwm2m_data_t *dataP)
 {
     iowa_status_t result;
+#ifdef IOWA_METRICS_SUPPORT
+    uint32_t metricsTime;
+#endif
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Calling dataCb() for %s on %u resources.", STR_DM_OPERATION(op), dataCount);
     CRIT_SECTION_LEAVE(contextP);
+    CORE_METRICS_START(metricsTime);
     result = objectP->dataCb(op, dataP, dataCount, objectP->userData, contextP);
     CRIT_SECTION_ENTER(contextP);
+    CORE_METRICS_RECORD(contextP->metricsDataCallback, metricsTime);
     return result;
 }
 
@@ -136,16 +141,211 @@ static iowa_status_t prv_getResourceDimension(iowa_context_t contextP,
     return result;
 }
 
+// Sort an array of IDs in ascending order.
+// Parameters:
+// - idArray: the array to sort.
+// - idCount: number of elements in idArray.
+static void prv_sortIdArray(uint16_t *idArray,
+                            uint16_t idCount)
+{
+    uint16_t i;
+
+    // Insertion sort: these arrays are small and usually already sorted.
+    for (i = 1; i < idCount; i++)
+    {
+        uint16_t id;
+        uint16_t j;
+
+        id = idArray[i];
+        j = i;
+        while (j > 0
+               && idArray[j - 1] > id)
+        {
+            idArray[j] = idArray[j - 1];
+            j--;
+        }
+        idArray[j] = id;
+    }
+}
+
+// Check if an ID is present in a sorted array.
+// Returned value: true if the ID was found, false otherwise.
+// Parameters:
+// - idArray: the array sorted by prv_sortIdArray().
+// - idCount: number of elements in idArray.
+// - id: the ID to look for.
+static bool prv_isIdInArray(const uint16_t *idArray,
+                            uint16_t idCount,
+                            uint16_t id)
+{
+    uint16_t low;
+    uint16_t high;
+
+    low = 0;
+    high = idCount;
+    while (low < high)
+    {
+        uint16_t middle;
+
+        middle = (uint16_t)(low + (high - low) / 2);
+        if (idArray[middle] == id)
+        {
+            return true;
+        }
+        if (idArray[middle] < id)
+        {
+            low = (uint16_t)(middle + 1);
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return false;
+}
+
+// Find the position of an instance in the sorted instance array of an Object.
+// Returned value: the index of the first instance with an ID greater or equal to id.
+// Parameters:
+// - objectP: the Object.
+// - id: the instance ID.
+static uint16_t prv_getInstancePosition(lwm2m_object_t *objectP,
+                                        uint16_t id)
+{
+    uint16_t low;
+    uint16_t high;
+
+    low = 0;
+    high = objectP->instanceCount;
+    while (low < high)
+    {
+        uint16_t middle;
+
+        middle = (uint16_t)(low + (high - low) / 2);
+        if (objectP->instanceArray[middle].id < id)
+        {
+            low = (uint16_t)(middle + 1);
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+// Find the position of an Object in the sorted Object array of the context.
+// Returned value: the index of the first Object with an ID greater or equal to id.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - id: the Object ID.
+static size_t prv_getObjectPosition(lwm2m_context_t *lwm2mContextP,
+                                    uint16_t id)
+{
+    size_t low;
+    size_t high;
+
+    low = 0;
+    high = lwm2mContextP->objectCount;
+    while (low < high)
+    {
+        size_t middle;
+
+        middle = low + (high - low) / 2;
+        if (lwm2mContextP->objectArray[middle]->objID < id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+// Build the table of the resource indexes sorted by resource ID.
+// Returned value: IOWA_COAP_NO_ERROR or IOWA_COAP_500_INTERNAL_SERVER_ERROR in case of memory allocation failure.
+// Parameters:
+// - objectP: the Object. Its resourceArray must be set.
+static iowa_status_t prv_buildResourceIndex(lwm2m_object_t *objectP)
+{
+    uint16_t i;
+
+    if (objectP->resourceCount == 0)
+    {
+        objectP->resourceIndexArray = NULL;
+        return IOWA_COAP_NO_ERROR;
+    }
+
+    objectP->resourceIndexArray = (uint16_t *)iowa_system_malloc(objectP->resourceCount * sizeof(uint16_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (objectP->resourceIndexArray == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(objectP->resourceCount * sizeof(uint16_t));
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    for (i = 0; i < objectP->resourceCount; i++)
+    {
+        uint16_t j;
+
+        j = i;
+        while (j > 0
+               && objectP->resourceArray[objectP->resourceIndexArray[j - 1]].id > objectP->resourceArray[i].id)
+        {
+            objectP->resourceIndexArray[j] = objectP->resourceIndexArray[j - 1];
+            j--;
+        }
+        objectP->resourceIndexArray[j] = i;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Sort the instance array of an Object by instance ID.
+// Parameters:
+// - objectP: the Object.
+static void prv_sortInstanceArray(lwm2m_object_t *objectP)
+{
+    uint16_t i;
+
+    for (i = 0; i < objectP->instanceCount; i++)
+    {
+        lwm2m_instance_details_t instance;
+        uint16_t j;
+
+        prv_sortIdArray(objectP->instanceArray[i].resArray, objectP->instanceArray[i].resCount);
+
+        instance = objectP->instanceArray[i];
+        j = i;
+        while (j > 0
+               && objectP->instanceArray[j - 1].id > instance.id)
+        {
+            objectP->instanceArray[j] = objectP->instanceArray[j - 1];
+            j--;
+        }
+        objectP->instanceArray[j] = instance;
+    }
+}
+
 static iowa_status_t prv_addInstance(lwm2m_object_t *objectP,
                                      uint16_t id,
                                      uint16_t resourceCount,
                                      uint16_t *resourceArray)
 {
     lwm2m_instance_details_t *newArray;
+    uint16_t position;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Adding instance %u with %u resources to Object %u.", id, resourceCount, objectP->objID);
 
-    if (IOWA_COAP_404_NOT_FOUND != object_getInstanceIndex(objectP, id, NULL))
+    position = prv_getInstancePosition(objectP, id);
+    if (position < objectP->instanceCount
+        && objectP->instanceArray[position].id == id)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Instance %u already exists in Object %u.", id, objectP->objID);
         return IOWA_COAP_406_NOT_ACCEPTABLE;
@@ -158,28 +358,33 @@ static iowa_status_t prv_addInstance(lwm2m_object_t *objectP,
         return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 #endif
-    if (objectP->instanceCount != 0)
+    if (position != 0)
+    {
+        memcpy(newArray, objectP->instanceArray, position * sizeof(lwm2m_instance_details_t));
+    }
+    if (position != objectP->instanceCount)
     {
-        memcpy(newArray, objectP->instanceArray, objectP->instanceCount * sizeof(lwm2m_instance_details_t));
+        memcpy(newArray + position + 1, objectP->instanceArray + position, (size_t)(objectP->instanceCount - position) * sizeof(lwm2m_instance_details_t));
     }
-    newArray[objectP->instanceCount].id = id;
-    newArray[objectP->instanceCount].resCount = resourceCount;
+    newArray[position].id = id;
+    newArray[position].resCount = resourceCount;
     if (resourceCount != 0)
     {
-        newArray[objectP->instanceCount].resArray = (uint16_t *)iowa_system_malloc(resourceCount * sizeof(uint16_t));
+        newArray[position].resArray = (uint16_t *)iowa_system_malloc(resourceCount * sizeof(uint16_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-        if (newArray[objectP->instanceCount].resArray == NULL)
+        if (newArray[position].resArray == NULL)
         {
             iowa_system_free(newArray);
             IOWA_LOG_ERROR_MALLOC(resourceCount * sizeof(uint16_t));
             return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
 #endif
-        memcpy(newArray[objectP->instanceCount].resArray, resourceArray, resourceCount * sizeof(uint16_t));
+        memcpy(newArray[position].resArray, resourceArray, resourceCount * sizeof(uint16_t));
+        prv_sortIdArray(newArray[position].resArray, resourceCount);
     }
     else
     {
-        newArray[objectP->instanceCount].resArray = NULL;
+        newArray[position].resArray = NULL;
     }
 
     iowa_system_free(objectP->instanceArray);
@@ -194,18 +399,15 @@ static uint16_t prv_getNewInstanceId(lwm2m_object_t *objectP)
     uint16_t instanceId;
     size_t i;
 
+    // The instance array is sorted: the first gap in the IDs is the lowest free one.
     instanceId = 0;
-    i = 0;
-    while (i < objectP->instanceCount)
+    for (i = 0; i < objectP->instanceCount; i++)
     {
-        for (i = 0; i < objectP->instanceCount; i++)
+        if (objectP->instanceArray[i].id != instanceId)
         {
-            if (objectP->instanceArray[i].id == instanceId)
-            {
-                instanceId++;
-                break;
-            }
+            break;
         }
+        instanceId++;
     }
 
     return instanceId;
@@ -276,17 +478,36 @@ static uint16_t prv_getResourceIndex(lwm2m_object_t *objectP,
                                      uint16_t instIndex,
                                      uint16_t id)
 {
+    uint16_t low;
+    uint16_t high;
     uint16_t index;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Looking for resource %u in Object %u, instance index: %u.", id, objectP->objID, instIndex);
 
-    for (index = 0; index < objectP->resourceCount; index++)
+    index = objectP->resourceCount;
+    low = 0;
+    high = objectP->resourceCount;
+    while (low < high)
     {
-        if (objectP->resourceArray[index].id == id)
+        uint16_t middle;
+        uint16_t middleId;
+
+        middle = (uint16_t)(low + (high - low) / 2);
+        middleId = objectP->resourceArray[objectP->resourceIndexArray[middle]].id;
+        if (middleId == id)
         {
+            index = objectP->resourceIndexArray[middle];
             IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u found at index %u in Object %u.", id, index, objectP->objID);
             break;
         }
+        if (middleId < id)
+        {
+            low = (uint16_t)(middle + 1);
+        }
+        else
+        {
+            high = middle;
+        }
     }
     if (index == objectP->resourceCount)
     {
@@ -297,25 +518,14 @@ static uint16_t prv_getResourceIndex(lwm2m_object_t *objectP,
     if (instIndex < objectP->instanceCount
         && objectP->instanceArray[instIndex].resArray != NULL)
     {
-        uint16_t i;
-
         // check if resource exists in this instance
-        for (i = 0; i < objectP->instanceArray[instIndex].resCount; i++)
-        {
-            if (objectP->instanceArray[instIndex].resArray[i] == id)
-            {
-                break;
-            }
-        }
-        if (i == objectP->instanceArray[instIndex].resCount)
+        if (!prv_isIdInArray(objectP->instanceArray[instIndex].resArray, objectP->instanceArray[instIndex].resCount, id))
         {
             IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u not found in Object %u, instance index: %u.", id, objectP->objID, instIndex);
             index = objectP->resourceCount;
         }
     }
 
-    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u not found in Object %u.", id, objectP->objID);
-
     return index;
 }
 
@@ -328,7 +538,7 @@ static iowa_status_t prv_extendDataArray(size_t *arraySizeP,
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Array size: %u, array: %p, index: %u, new size: %u.", *arraySizeP, *arrayP, index, newSize);
 
-    newArray = (iowa_lwm2m_data_t *)iowa_system_malloc(newSize * sizeof(iowa_lwm2m_data_t));
+    newArray = (iowa_lwm2m_data_t *)CORE_ARENA_ALLOC(newSize * sizeof(iowa_lwm2m_data_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
     if (newArray == NULL)
     {
@@ -345,7 +555,7 @@ static iowa_status_t prv_extendDataArray(size_t *arraySizeP,
             memcpy(newArray, *arrayP, index * sizeof(iowa_lwm2m_data_t));
         }
 
-        iowa_system_free(*arrayP);
+        CORE_ARENA_FREE(*arrayP);
     }
 
     *arrayP = newArray;
@@ -369,16 +579,7 @@ static iowa_status_t prv_addResourceToDataArray(iowa_context_t contextP,
 
     if (objectP->instanceArray[instIndex].resArray != NULL)
     {
-        uint16_t i;
-
-        for (i = 0; i < objectP->instanceArray[instIndex].resCount; i++)
-        {
-            if (objectP->instanceArray[instIndex].resArray[i] == objectP->resourceArray[resIndex].id)
-            {
-                break;
-            }
-        }
-        if (i == objectP->instanceArray[instIndex].resCount)
+        if (!prv_isIdInArray(objectP->instanceArray[instIndex].resArray, objectP->instanceArray[instIndex].resCount, objectP->resourceArray[resIndex].id))
         {
             IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Resource %u not found in Object %u, instance %u.", objectP->resourceArray[resIndex].id, objectP->objID, objectP->instanceArray[instIndex].id);
             return IOWA_COAP_404_NOT_FOUND;
@@ -549,7 +750,7 @@ static iowa_status_t prv_getResourceReadableArray(iowa_context_t contextP,
             if (result != IOWA_COAP_NO_ERROR)
             {
                 IOWA_LOG_TRACE(IOWA_PART_LWM2M, "prv_addResourceToDataArray() failed.");
-                iowa_system_free(iowaDataArray);
+                CORE_ARENA_FREE(iowaDataArray);
                 return result;
             }
         }
@@ -558,7 +759,7 @@ static iowa_status_t prv_getResourceReadableArray(iowa_context_t contextP,
             // multiple resource read
 
             iowaDataArraySize = objectP->resourceCount;
-            iowaDataArray = (iowa_lwm2m_data_t *)iowa_system_malloc(iowaDataArraySize * sizeof(iowa_lwm2m_data_t));
+            iowaDataArray = (iowa_lwm2m_data_t *)CORE_ARENA_ALLOC(iowaDataArraySize * sizeof(iowa_lwm2m_data_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
             if (iowaDataArray == NULL)
             {
@@ -584,7 +785,7 @@ static iowa_status_t prv_getResourceReadableArray(iowa_context_t contextP,
                 if (result != IOWA_COAP_NO_ERROR)
                 {
                     IOWA_LOG_ERROR(IOWA_PART_LWM2M, "prv_addResourceToDataArray() failed.");
-                    iowa_system_free(iowaDataArray);
+                    CORE_ARENA_FREE(iowaDataArray);
                     return result;
                 }
             }
@@ -594,7 +795,7 @@ static iowa_status_t prv_getResourceReadableArray(iowa_context_t contextP,
     {
         // multiple object instances read
         iowaDataArraySize = (size_t)(objectP->instanceCount * objectP->resourceCount);
-        iowaDataArray = (iowa_lwm2m_data_t *)iowa_system_malloc(iowaDataArraySize * sizeof(iowa_lwm2m_data_t));
+        iowaDataArray = (iowa_lwm2m_data_t *)CORE_ARENA_ALLOC(iowaDataArraySize * sizeof(iowa_lwm2m_data_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (iowaDataArray == NULL)
         {
@@ -623,7 +824,7 @@ static iowa_status_t prv_getResourceReadableArray(iowa_context_t contextP,
                 if (result != IOWA_COAP_NO_ERROR)
                 {
                     IOWA_LOG_ERROR(IOWA_PART_LWM2M, "prv_addResourceToDataArray() failed.");
-                    iowa_system_free(iowaDataArray);
+                    CORE_ARENA_FREE(iowaDataArray);
                     return result;
                 }
             }
@@ -635,7 +836,7 @@ static iowa_status_t prv_getResourceReadableArray(iowa_context_t contextP,
 
     if (*dataCountP == 0)
     {
-        iowa_system_free(iowaDataArray);
+        CORE_ARENA_FREE(iowaDataArray);
         *dataArrayP = NULL;
     }
     else
@@ -758,6 +959,17 @@ static iowa_status_t prv_checkDataConsistency(iowa_lwm2m_data_t *dataP,
     iowa_lwm2m_data_type_t type;
 
     type = dataP->type;
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+    if (DATA_IS_BLOCK(type))
+    {
+        if (!IS_RSC_STREAMABLE(objectP->resourceArray[resourceIndex]))
+        {
+            IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Resource %u in Object %u is not streamable.", dataP->resourceID, objectP->objID);
+            return IOWA_COAP_406_NOT_ACCEPTABLE;
+        }
+        type = (iowa_lwm2m_data_type_t)(type - INTERNAL_LWM2M_TYPE_BLOCK);
+    }
+#endif
 
     if (type != objectP->resourceArray[resourceIndex].type)
     {
@@ -1006,6 +1218,7 @@ static iowa_status_t prv_create(iowa_context_t contextP,
         {
             result = prv_addInstance(objectP, dataP[0].instanceID, 0, NULL);
         }
+        lwm2mResetRegistrationPayload(contextP);
     }
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Exiting with code %u.%02u", (result & 0xFF) >> 5, (result & 0x1F));
@@ -1086,6 +1299,7 @@ static iowa_status_t prv_deleteObjectInstance(iowa_context_t contextP,
     }
 
     (void)prv_removeInstance(objectP, uriP->instanceId);
+    lwm2mResetRegistrationPayload(contextP);
     observe_clear(contextP, uriP);
 
     return IOWA_COAP_202_DELETED;
@@ -1161,13 +1375,15 @@ iowa_status_t object_getInstanceIndex(lwm2m_object_t *objectP,
     }
     else
     {
-        for (index = 0; index < objectP->instanceCount; index++)
+        index = prv_getInstancePosition(objectP, id);
+        if (index < objectP->instanceCount
+            && objectP->instanceArray[index].id == id)
         {
-            if (objectP->instanceArray[index].id == id)
-            {
-                IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Instance %u found at index %u in Object %u.", id, index, objectP->objID);
-                break;
-            }
+            IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Instance %u found at index %u in Object %u.", id, index, objectP->objID);
+        }
+        else
+        {
+            index = objectP->instanceCount;
         }
     }
 
@@ -1198,7 +1414,7 @@ iowa_status_t object_find(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Looking for /%u/%u/%u.", objectID, instanceID, resourceID);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID);
+    objectP = object_get(contextP, objectID);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", objectID);
@@ -1249,6 +1465,24 @@ iowa_status_t object_find(iowa_context_t contextP,
     return IOWA_COAP_NO_ERROR;
 }
 
+lwm2m_object_t * object_get(iowa_context_t contextP,
+                            uint16_t objectID)
+{
+    lwm2m_context_t *lwm2mContextP;
+    size_t position;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    position = prv_getObjectPosition(lwm2mContextP, objectID);
+    if (position < lwm2mContextP->objectCount
+        && lwm2mContextP->objectArray[position]->objID == objectID)
+    {
+        return lwm2mContextP->objectArray[position];
+    }
+
+    return NULL;
+}
+
 static iowa_status_t prv_addObjectVersion(lwm2m_object_t *objectP,
                                           link_t *linkP,
                                           size_t *linkIndex)
@@ -1306,7 +1540,7 @@ iowa_status_t object_getTargets(iowa_context_t contextP,
     }
     else
     {
-        *startPP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectId);
+        *startPP = object_get(contextP, objectId);
         if (*startPP == NULL)
         {
             IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object with ID %u not found.", objectId);
@@ -1442,7 +1676,80 @@ iowa_status_t object_read(iowa_context_t contextP,
         && (*dataArrayP) != NULL)
     {
         object_free(contextP, *dataCountP, *dataArrayP);
-        iowa_system_free(*dataArrayP);
+        CORE_ARENA_FREE(*dataArrayP);
+        *dataArrayP = NULL;
+        *dataCountP = 0;
+    }
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+    return result;
+}
+
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+iowa_status_t object_readBlock(iowa_context_t contextP,
+                               iowa_lwm2m_uri_t *uriP,
+                               uint32_t blockInfo,
+                               size_t *dataCountP,
+                               iowa_lwm2m_data_t **dataArrayP)
+{
+    // WARNING: This function is called in a critical section
+    iowa_status_t result;
+    lwm2m_object_t *objectP;
+    uint16_t instIndex;
+    uint16_t resIndex;
+    size_t arraySize;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "URI: /%u/%u/%u/%u, block info: 0x%06X", uriP->objectId, uriP->instanceId, uriP->resourceId, uriP->resInstanceId, blockInfo);
+
+    *dataCountP = 0;
+    *dataArrayP = NULL;
+
+    result = object_find(contextP, uriP->objectId, uriP->instanceId, uriP->resourceId, &objectP, &instIndex, &resIndex);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_INFO(IOWA_PART_LWM2M, "URI not found.");
+        return result;
+    }
+
+    if (!IS_RSC_READABLE(objectP->resourceArray[resIndex]))
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "/%u/%u/%u is not readable.", uriP->objectId, uriP->instanceId, uriP->resourceId);
+        return IOWA_COAP_405_METHOD_NOT_ALLOWED;
+    }
+
+    if (!IS_RSC_STREAMABLE(objectP->resourceArray[resIndex])
+        || (IS_RSC_MULTIPLE(objectP->resourceArray[resIndex]) && !LWM2M_URI_IS_SET_RESOURCE_INSTANCE(uriP)))
+    {
+        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "/%u/%u/%u/%u is not a single streamable value.", uriP->objectId, uriP->instanceId, uriP->resourceId, uriP->resInstanceId);
+        return IOWA_COAP_400_BAD_REQUEST;
+    }
+
+    arraySize = 0;
+    result = prv_addResourceToDataArray(contextP, objectP, instIndex, resIndex, uriP->resInstanceId, &arraySize, dataArrayP, dataCountP);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        if (*dataArrayP != NULL)
+        {
+            CORE_ARENA_FREE(*dataArrayP);
+            *dataArrayP = NULL;
+        }
+        *dataCountP = 0;
+        return result;
+    }
+
+    // The callback fills in at most the requested block and updates the block information
+    (*dataArrayP)->type = (iowa_lwm2m_data_type_t)((*dataArrayP)->type + INTERNAL_LWM2M_TYPE_BLOCK);
+    (*dataArrayP)->value.asBlock.details = blockInfo;
+
+    result = prv_callDataCb(contextP, IOWA_DM_READ, objectP, *dataCountP, *dataArrayP);
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        result = IOWA_COAP_205_CONTENT;
+    }
+    else
+    {
+        object_free(contextP, *dataCountP, *dataArrayP);
+        CORE_ARENA_FREE(*dataArrayP);
         *dataArrayP = NULL;
         *dataCountP = 0;
     }
@@ -1450,6 +1757,7 @@ iowa_status_t object_read(iowa_context_t contextP,
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Exiting with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
     return result;
 }
+#endif
 
 void object_free(iowa_context_t contextP,
                  size_t dataCount,
@@ -1469,7 +1777,7 @@ void object_free(iowa_context_t contextP,
     }
 
     objectId = dataP[0].objectID;
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectId);
+    objectP = object_get(contextP, objectId);
     if (objectP == NULL)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", objectId);
@@ -1484,7 +1792,7 @@ void object_free(iowa_context_t contextP,
             startInd = ind;
 
             objectId = dataP[ind].objectID;
-            objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectId);
+            objectP = object_get(contextP, objectId);
             if (objectP == NULL)
             {
                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", objectId);
@@ -1522,7 +1830,7 @@ iowa_status_t object_checkWritePayload(iowa_context_t contextP,
         uint16_t resourceIndex;  // index of a Resource inside a lwm2m_object_t
         size_t instIndex;        // index of the first data_t matching the beginning of an Object Instance in dataArray
 
-        objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &dataArray[dataIndex].objectID);
+        objectP = object_get(contextP, dataArray[dataIndex].objectID);
         if (NULL == objectP)
         {
             IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", dataArray[dataIndex].objectID);
@@ -1627,7 +1935,7 @@ iowa_status_t object_write(iowa_context_t contextP,
         if (objectP == NULL
             || objectP->objID != dataP[i].objectID)
         {
-            objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &dataP[i].objectID);
+            objectP = object_get(contextP, dataP[i].objectID);
             if (NULL == objectP)
             {
                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", dataP[i].objectID);
@@ -1747,7 +2055,7 @@ iowa_status_t object_create(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object ID: %u.", dataP[0].objectID);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &dataP[0].objectID);
+    objectP = object_get(contextP, dataP[0].objectID);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", dataP[0].objectID);
@@ -1786,7 +2094,7 @@ iowa_status_t object_delete(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "URI: /%u/%u/%u", uriP->objectId, uriP->instanceId, uriP->resourceId);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &uriP->objectId);
+    objectP = object_get(contextP, uriP->objectId);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", uriP->objectId);
@@ -1972,7 +2280,7 @@ iowa_status_t object_getTree(iowa_context_t contextP,
 #endif
 
     // Count the number of link.
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &uriP->objectId);
+    objectP = object_get(contextP, uriP->objectId);
     if (objectP == NULL)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", uriP->objectId);
@@ -2238,11 +2546,14 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
                               void *userData)
 {
     // WARNING: This function is called in a critical section
+    lwm2m_context_t *lwm2mContextP;
     lwm2m_object_t *objectP;
+    lwm2m_object_t **newArray;
+    size_t position;
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Adding new custom object with ID: %u, instanceCount: %u and resourceCount: %u", objectID, instanceCount, resourceCount);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID);
+    objectP = object_get(contextP, objectID);
     if (objectP != NULL)
     {
         IOWA_LOG_ARG_ERROR(IOWA_PART_LWM2M, "Object %u already exists.", objectID);
@@ -2336,6 +2647,7 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
                 }
             }
             objectP->instanceCount = instanceCount;
+            prv_sortInstanceArray(objectP);
         }
     }
 
@@ -2348,6 +2660,11 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
     objectP->userData = userData;
 
     memcpy(objectP->resourceArray, resourceArray, resourceCount * sizeof(iowa_lwm2m_resource_desc_t));
+    if (prv_buildResourceIndex(objectP) != IOWA_COAP_NO_ERROR)
+    {
+        customObjectDelete(objectP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
 
     switch (objectID)
     {
@@ -2357,7 +2674,24 @@ iowa_status_t customObjectAdd(iowa_context_t contextP,
         objectP->version.minor = PRV_DEFAULT_MINOR_OBJECT_VERSION;
         break;
     }
-    contextP->lwm2mContextP->objectList = (lwm2m_object_t *)IOWA_UTILS_LIST_ADD(contextP->lwm2mContextP->objectList, objectP);
+
+    lwm2mContextP = contextP->lwm2mContextP;
+    newArray = (lwm2m_object_t **)utilsRealloc(lwm2mContextP->objectArray, lwm2mContextP->objectCount * sizeof(lwm2m_object_t *), (lwm2mContextP->objectCount + 1) * sizeof(lwm2m_object_t *));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (newArray == NULL)
+    {
+        customObjectDelete(objectP);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    lwm2mContextP->objectArray = newArray;
+    position = prv_getObjectPosition(lwm2mContextP, objectID);
+    memmove(lwm2mContextP->objectArray + position + 1, lwm2mContextP->objectArray + position, (lwm2mContextP->objectCount - position) * sizeof(lwm2m_object_t *));
+    lwm2mContextP->objectArray[position] = objectP;
+    lwm2mContextP->objectCount++;
+
+    lwm2mContextP->objectList = (lwm2m_object_t *)IOWA_UTILS_LIST_ADD(lwm2mContextP->objectList, objectP);
+    lwm2mResetRegistrationPayload(contextP);
 
     if (contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
     {
@@ -2379,6 +2713,7 @@ void customObjectDelete(lwm2m_object_t *objectP)
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Deleting custom object with ID: %u.", objectP->objID);
 
     iowa_system_free(objectP->resourceArray);
+    iowa_system_free(objectP->resourceIndexArray);
 
     for (i = 0; i < objectP->instanceCount; i++)
     {
@@ -2395,18 +2730,34 @@ iowa_status_t customObjectRemove(iowa_context_t contextP,
                                  uint16_t objectID)
 {
     // WARNING: This function is called in a critical section
+    lwm2m_context_t *lwm2mContextP;
     lwm2m_object_t *objectP;
+    size_t position;
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Removing custom object with ID: %u", objectID);
 
-    contextP->lwm2mContextP->objectList = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND_AND_REMOVE(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID, &objectP);
-    if (objectP == NULL)
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    position = prv_getObjectPosition(lwm2mContextP, objectID);
+    if (position == lwm2mContextP->objectCount
+        || lwm2mContextP->objectArray[position]->objID != objectID)
     {
         IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Object ID %u not found.", objectID);
         return IOWA_COAP_404_NOT_FOUND;
     }
 
+    objectP = lwm2mContextP->objectArray[position];
+    lwm2mContextP->objectList = (lwm2m_object_t *)IOWA_UTILS_LIST_REMOVE(lwm2mContextP->objectList, objectP);
+    lwm2mContextP->objectCount--;
+    memmove(lwm2mContextP->objectArray + position, lwm2mContextP->objectArray + position + 1, (lwm2mContextP->objectCount - position) * sizeof(lwm2m_object_t *));
+    if (lwm2mContextP->objectCount == 0)
+    {
+        iowa_system_free(lwm2mContextP->objectArray);
+        lwm2mContextP->objectArray = NULL;
+    }
+
     customObjectDelete(objectP);
+    lwm2mResetRegistrationPayload(contextP);
 
     if (contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
     {
@@ -2457,7 +2808,7 @@ iowa_status_t objectAddInstance(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Adding instance %u to Object %u. ", instanceID, objectID);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID);
+    objectP = object_get(contextP, objectID);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Object %u not found.", objectID);
@@ -2490,6 +2841,11 @@ iowa_status_t objectAddInstance(iowa_context_t contextP,
         result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        lwm2mResetRegistrationPayload(contextP);
+    }
+
     if (result == IOWA_COAP_NO_ERROR
         && contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
     {
@@ -2514,7 +2870,7 @@ iowa_status_t objectRemoveInstance(iowa_context_t contextP,
 
     IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Removing instance %u of Object %u. ", instanceID, objectID);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectID);
+    objectP = object_get(contextP, objectID);
     if (NULL == objectP)
     {
         IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Object %u not found.", objectID);
@@ -2523,6 +2879,11 @@ iowa_status_t objectRemoveInstance(iowa_context_t contextP,
 
     result = prv_removeInstance(objectP, instanceID);
 
+    if (result == IOWA_COAP_NO_ERROR)
+    {
+        lwm2mResetRegistrationPayload(contextP);
+    }
+
     if (result == IOWA_COAP_NO_ERROR
         && contextP->lwm2mContextP->state == STATE_DEVICE_MANAGEMENT)
     {
@@ -89,6 +89,8 @@ static void prv_notificationCallback(iowa_coap_peer_t *fromPeer,
                                      iowa_coap_message_t * requestP,
                                      void * userData,
                                      iowa_context_t contextP);
+static void prv_maxPeriodTimerCallback(iowa_context_t contextP,
+                                       void *userData);
 
 
 static void prv_addMID(lwm2m_observed_t * observedP,
@@ -126,6 +128,357 @@ static bool prv_notificationMatch(lwm2m_observed_t * observedP,
     return false;
 }
 
+// Add an observation to the dirty list if not already there.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - observedP: the observation.
+static void prv_dirtyAdd(lwm2m_context_t *lwm2mContextP,
+                         lwm2m_observed_t *observedP)
+{
+    if ((observedP->flags & LWM2M_OBSERVE_FLAG_DIRTY) == 0)
+    {
+        observedP->flags |= LWM2M_OBSERVE_FLAG_DIRTY;
+        observedP->nextDirtyP = lwm2mContextP->dirtyObservedList;
+        lwm2mContextP->dirtyObservedList = observedP;
+    }
+}
+
+// Remove an observation from the dirty list.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - observedP: the observation.
+static void prv_dirtyRemove(lwm2m_context_t *lwm2mContextP,
+                            lwm2m_observed_t *observedP)
+{
+    lwm2m_observed_t **nodePP;
+
+    if ((observedP->flags & LWM2M_OBSERVE_FLAG_DIRTY) == 0)
+    {
+        return;
+    }
+
+    nodePP = &(lwm2mContextP->dirtyObservedList);
+    while (*nodePP != NULL)
+    {
+        if (*nodePP == observedP)
+        {
+            *nodePP = observedP->nextDirtyP;
+            break;
+        }
+        nodePP = &((*nodePP)->nextDirtyP);
+    }
+    observedP->nextDirtyP = NULL;
+    observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_DIRTY);
+}
+
+// Compute the delay before the end of a maximum period.
+// Returned value: the delay in seconds, at least 1 and such that the timer does not expire after INT32_MAX.
+// Parameters:
+// - contextP: the IOWA context.
+// - startTime: the start of the period.
+// - maxPeriod: the pmax attribute. It can be greater than INT32_MAX.
+static int32_t prv_getMaxPeriodDelay(iowa_context_t contextP,
+                                     int32_t startTime,
+                                     uint32_t maxPeriod)
+{
+    int64_t deadline;
+
+    deadline = (int64_t)startTime + (int64_t)maxPeriod;
+    if (deadline > INT32_MAX)
+    {
+        deadline = INT32_MAX;
+    }
+
+    if (deadline <= (int64_t)contextP->currentTime)
+    {
+        // The period already elapsed: expire as soon as possible
+        return 1;
+    }
+
+    return (int32_t)(deadline - (int64_t)contextP->currentTime);
+}
+
+// Schedule the timer of the maximum period of an observation from its last notification.
+// Parameters:
+// - contextP: the IOWA context.
+// - observedP: the observation.
+static void prv_scheduleMaxPeriod(iowa_context_t contextP,
+                                  lwm2m_observed_t *observedP)
+{
+    int32_t delay;
+
+    if (observedP->timeAttrP == NULL
+        || (observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MAX_PERIOD) == 0
+        || ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0
+            && observedP->timeAttrP->maxPeriod < observedP->timeAttrP->minPeriod))
+    {
+        // No maximum period or pmax is lesser than pmin and is ignored
+        if (observedP->maxPeriodTimerP != NULL)
+        {
+            coreTimerDelete(contextP, observedP->maxPeriodTimerP);
+            observedP->maxPeriodTimerP = NULL;
+        }
+        return;
+    }
+
+    delay = prv_getMaxPeriodDelay(contextP, observedP->lastTime, observedP->timeAttrP->maxPeriod);
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Maximum period of the observation expires in %ds.", delay);
+
+    if (observedP->maxPeriodTimerP == NULL)
+    {
+        observedP->maxPeriodTimerP = coreTimerNew(contextP, delay, prv_maxPeriodTimerCallback, observedP);
+        if (observedP->maxPeriodTimerP == NULL)
+        {
+            IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create the maximum period timer.");
+        }
+    }
+    else
+    {
+        (void)coreTimerReset(contextP, observedP->maxPeriodTimerP, delay);
+    }
+}
+
+// Find the position of an Object in the observation index.
+// Returned value: the index of the first entry of observeIndexArray with an Object ID greater or equal to objectId.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - objectId: the Object ID.
+static size_t prv_indexGetObjectPosition(lwm2m_context_t *lwm2mContextP,
+                                         uint16_t objectId)
+{
+    size_t low;
+    size_t high;
+
+    low = 0;
+    high = lwm2mContextP->observeIndexCount;
+    while (low < high)
+    {
+        size_t middle;
+
+        middle = low + (high - low) / 2;
+        if (lwm2mContextP->observeIndexArray[middle].objectId < objectId)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+// Find the position of an Instance/Resource pair in an Object's observation index.
+// Returned value: the index of the first entry greater or equal to (instanceId, resourceId).
+// Parameters:
+// - indexP: the Object's observation index.
+// - start: the position to start from.
+// - instanceId, resourceId: the IDs to look for. IOWA_LWM2M_ID_ALL is sorted last.
+static size_t prv_indexGetEntryPosition(lwm2m_observe_index_t *indexP,
+                                        size_t start,
+                                        uint16_t instanceId,
+                                        uint16_t resourceId)
+{
+    size_t low;
+    size_t high;
+
+    low = start;
+    high = indexP->entryCount;
+    while (low < high)
+    {
+        size_t middle;
+
+        middle = low + (high - low) / 2;
+        if (indexP->entryArray[middle].instanceId < instanceId
+            || (indexP->entryArray[middle].instanceId == instanceId
+                && indexP->entryArray[middle].resourceId < resourceId))
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+// Remove the URIs of an observation from the observation index.
+// Parameters:
+// - contextP: the IOWA context.
+// - observedP: the observation.
+static void prv_indexRemove(iowa_context_t contextP,
+                            lwm2m_observed_t *observedP)
+{
+    lwm2m_context_t *lwm2mContextP;
+    size_t uriIndex;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    for (uriIndex = 0; uriIndex < observedP->uriCount; uriIndex++)
+    {
+        size_t position;
+        lwm2m_observe_index_t *indexP;
+        size_t i;
+        size_t j;
+
+        position = prv_indexGetObjectPosition(lwm2mContextP, observedP->uriInfoP[uriIndex].uri.objectId);
+        if (position == lwm2mContextP->observeIndexCount
+            || lwm2mContextP->observeIndexArray[position].objectId != observedP->uriInfoP[uriIndex].uri.objectId)
+        {
+            // Already removed with a previous URI of the same Object
+            continue;
+        }
+        indexP = lwm2mContextP->observeIndexArray + position;
+
+        j = 0;
+        for (i = 0; i < indexP->entryCount; i++)
+        {
+            if (indexP->entryArray[i].observedP != observedP)
+            {
+                indexP->entryArray[j] = indexP->entryArray[i];
+                j++;
+            }
+        }
+        indexP->entryCount = j;
+
+        if (indexP->entryCount == 0)
+        {
+            iowa_system_free(indexP->entryArray);
+            lwm2mContextP->observeIndexCount--;
+            memmove(lwm2mContextP->observeIndexArray + position, lwm2mContextP->observeIndexArray + position + 1, (lwm2mContextP->observeIndexCount - position) * sizeof(lwm2m_observe_index_t));
+            if (lwm2mContextP->observeIndexCount == 0)
+            {
+                iowa_system_free(lwm2mContextP->observeIndexArray);
+                lwm2mContextP->observeIndexArray = NULL;
+            }
+        }
+    }
+}
+
+// Add the URIs of an observation to the observation index.
+// Returned value: IOWA_COAP_NO_ERROR or IOWA_COAP_500_INTERNAL_SERVER_ERROR in case of memory allocation failure.
+// Parameters:
+// - contextP: the IOWA context.
+// - observedP: the observation.
+static iowa_status_t prv_indexAdd(iowa_context_t contextP,
+                                  lwm2m_observed_t *observedP)
+{
+    lwm2m_context_t *lwm2mContextP;
+    size_t uriIndex;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    for (uriIndex = 0; uriIndex < observedP->uriCount; uriIndex++)
+    {
+        iowa_lwm2m_uri_t *uriP;
+        lwm2m_observe_index_t *indexP;
+        lwm2m_observe_index_entry_t *newArray;
+        size_t position;
+
+        uriP = &(observedP->uriInfoP[uriIndex].uri);
+
+        position = prv_indexGetObjectPosition(lwm2mContextP, uriP->objectId);
+        if (position == lwm2mContextP->observeIndexCount
+            || lwm2mContextP->observeIndexArray[position].objectId != uriP->objectId)
+        {
+            lwm2m_observe_index_t *newIndexArray;
+
+            newIndexArray = (lwm2m_observe_index_t *)utilsRealloc(lwm2mContextP->observeIndexArray, lwm2mContextP->observeIndexCount * sizeof(lwm2m_observe_index_t), (lwm2mContextP->observeIndexCount + 1) * sizeof(lwm2m_observe_index_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+            if (newIndexArray == NULL)
+            {
+                prv_indexRemove(contextP, observedP);
+                return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            }
+#endif
+            lwm2mContextP->observeIndexArray = newIndexArray;
+            memmove(lwm2mContextP->observeIndexArray + position + 1, lwm2mContextP->observeIndexArray + position, (lwm2mContextP->observeIndexCount - position) * sizeof(lwm2m_observe_index_t));
+            lwm2mContextP->observeIndexCount++;
+
+            lwm2mContextP->observeIndexArray[position].objectId = uriP->objectId;
+            lwm2mContextP->observeIndexArray[position].entryCount = 0;
+            lwm2mContextP->observeIndexArray[position].entryArray = NULL;
+        }
+        indexP = lwm2mContextP->observeIndexArray + position;
+
+        newArray = (lwm2m_observe_index_entry_t *)utilsRealloc(indexP->entryArray, indexP->entryCount * sizeof(lwm2m_observe_index_entry_t), (indexP->entryCount + 1) * sizeof(lwm2m_observe_index_entry_t));
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+        if (newArray == NULL)
+        {
+            prv_indexRemove(contextP, observedP);
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+#endif
+        indexP->entryArray = newArray;
+
+        position = prv_indexGetEntryPosition(indexP, 0, uriP->instanceId, uriP->resourceId);
+        memmove(indexP->entryArray + position + 1, indexP->entryArray + position, (indexP->entryCount - position) * sizeof(lwm2m_observe_index_entry_t));
+        indexP->entryCount++;
+
+        indexP->entryArray[position].instanceId = uriP->instanceId;
+        indexP->entryArray[position].resourceId = uriP->resourceId;
+        indexP->entryArray[position].observedP = observedP;
+        indexP->entryArray[position].uriIndex = uriIndex;
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+// Tag the observation of an entry of the observation index.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - entryP: the entry.
+static void prv_indexTagEntry(lwm2m_context_t *lwm2mContextP,
+                              lwm2m_observe_index_entry_t *entryP)
+{
+    entryP->observedP->uriInfoP[entryP->uriIndex].flags |= LWM2M_OBSERVE_FLAG_UPDATE;
+    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Tagging the observation.");
+    entryP->observedP->flags |= LWM2M_OBSERVE_FLAG_UPDATE;
+    prv_dirtyAdd(lwm2mContextP, entryP->observedP);
+}
+
+// Tag the observations of an instance matching a resource.
+// Parameters:
+// - lwm2mContextP: the LwM2M context.
+// - indexP: the Object's observation index.
+// - instanceId: the instance ID as stored in the index.
+// - resourceId: the resource which changed. May be IOWA_LWM2M_ID_ALL.
+static void prv_indexTagInstance(lwm2m_context_t *lwm2mContextP,
+                                 lwm2m_observe_index_t *indexP,
+                                 uint16_t instanceId,
+                                 uint16_t resourceId)
+{
+    size_t i;
+
+    if (resourceId == IOWA_LWM2M_ID_ALL)
+    {
+        for (i = prv_indexGetEntryPosition(indexP, 0, instanceId, 0); i < indexP->entryCount && indexP->entryArray[i].instanceId == instanceId; i++)
+        {
+            prv_indexTagEntry(lwm2mContextP, indexP->entryArray + i);
+        }
+    }
+    else
+    {
+        // Observations of this resource, then of the whole instance which are sorted last
+        for (i = prv_indexGetEntryPosition(indexP, 0, instanceId, resourceId);
+             i < indexP->entryCount && indexP->entryArray[i].instanceId == instanceId && indexP->entryArray[i].resourceId == resourceId;
+             i++)
+        {
+            prv_indexTagEntry(lwm2mContextP, indexP->entryArray + i);
+        }
+        for (i = prv_indexGetEntryPosition(indexP, i, instanceId, IOWA_LWM2M_ID_ALL);
+             i < indexP->entryCount && indexP->entryArray[i].instanceId == instanceId;
+             i++)
+        {
+            prv_indexTagEntry(lwm2mContextP, indexP->entryArray + i);
+        }
+    }
+}
+
 static void prv_callObservationEventCallback(iowa_context_t contextP,
                                              lwm2m_observed_t *targetP,
                                              iowa_event_type_t eventType,
@@ -253,12 +606,20 @@ static void prv_callObservationEventCallback(iowa_context_t contextP,
     }
 }
 
-void observe_delete(lwm2m_observed_t *observedP)
+void observe_delete(iowa_context_t contextP,
+                    lwm2m_observed_t *observedP)
 {
     size_t ind;
 
     IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Delete observe.");
 
+    prv_indexRemove(contextP, observedP);
+    prv_dirtyRemove(contextP->lwm2mContextP, observedP);
+    if (observedP->maxPeriodTimerP != NULL)
+    {
+        coreTimerDelete(contextP, observedP->maxPeriodTimerP);
+    }
+
     for (ind = 0; ind < observedP->uriCount; ind++)
     {
         iowa_system_free(observedP->uriInfoP[ind].uriAttrP);
@@ -268,7 +629,8 @@ void observe_delete(lwm2m_observed_t *observedP)
     iowa_system_free(observedP);
 }
 
-void observeRemoveFromServer(lwm2m_server_t *serverP)
+void observeRemoveFromServer(iowa_context_t contextP,
+                             lwm2m_server_t *serverP)
 {
     IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Clearing observe list.");
 
@@ -277,7 +639,7 @@ void observeRemoveFromServer(lwm2m_server_t *serverP)
         lwm2m_observed_t *observedP;
 
         observedP = serverP->runtime.observedList->next;
-        observe_delete(serverP->runtime.observedList);
+        observe_delete(contextP, serverP->runtime.observedList);
         serverP->runtime.observedList = observedP;
     }
 }
@@ -421,6 +783,8 @@ iowa_status_t observe_updateObserve(iowa_context_t contextP,
         }
     }
 
+    prv_scheduleMaxPeriod(contextP, observedP);
+
     return IOWA_COAP_NO_ERROR;
 }
 
@@ -434,7 +798,7 @@ static void prv_observeRemove(iowa_context_t contextP,
 
     prv_callObservationEventCallback(contextP, observedP, IOWA_EVENT_OBSERVATION_CANCELED, NULL);
 
-    observe_delete(observedP);
+    observe_delete(contextP, observedP);
 }
 
 iowa_status_t observe_handleRequest(iowa_context_t contextP,
@@ -512,11 +876,15 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
             observedP->tokenLen = requestP->tokenLength;
             memcpy(observedP->token, requestP->token, requestP->tokenLength);
             observedP->uriCount = uriCount;
+            observedP->serverP = serverP;
         }
         else
         {
             newObserved = false;
 
+            // The URIs may change, they are indexed again below
+            prv_indexRemove(contextP, observedP);
+
             // Check if the targets are the same
             if (observedP->uriCount == uriCount)
             {
@@ -551,6 +919,7 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
                     iowa_system_free(observedP->uriInfoP[ind].uriAttrP);
                 }
                 iowa_system_free(observedP->uriInfoP);
+                observedP->uriCount = 0;
 
                 observedP->uriInfoP = (lwm2m_observed_uri_info_t *)iowa_system_malloc(uriCount * sizeof(lwm2m_observed_uri_info_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
@@ -618,7 +987,7 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
         {
             if (newObserved == true)
             {
-                observe_delete(observedP);
+                observe_delete(contextP, observedP);
             }
             else
             {
@@ -634,7 +1003,7 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
         {
             if (newObserved == true)
             {
-                observe_delete(observedP);
+                observe_delete(contextP, observedP);
             }
             else
             {
@@ -645,6 +1014,21 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP,
         }
 #endif
 
+        if (prv_indexAdd(contextP, observedP) != IOWA_COAP_NO_ERROR)
+        {
+            iowa_coap_option_free(optionP);
+            if (newObserved == true)
+            {
+                observe_delete(contextP, observedP);
+            }
+            else
+            {
+                prv_observeRemove(contextP, serverP, observedP);
+            }
+            IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to index the observation.");
+            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        }
+
         optionP->value.asInteger = IOWA_COAP_OBSERVE_REQUEST_NEW;
         observedP->counter++;
         iowa_coap_message_add_option(responseP, optionP);
@@ -725,7 +1109,7 @@ void observe_clear(iowa_context_t contextP,
                 nextP = observedP->next;
 
                 IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Delete observation: %p.", observedP);
-                observe_delete(observedP);
+                observe_delete(contextP, observedP);
                 if (parentP == NULL)
                 {
                     serverP->runtime.observedList = nextP;
@@ -875,39 +1259,42 @@ static void prv_notificationCallback(iowa_coap_peer_t *fromPeer,
 void lwm2m_resource_value_changed(iowa_context_t contextP,
                                   iowa_lwm2m_uri_t *uriP)
 {
-    lwm2m_server_t *serverP;
+    lwm2m_context_t *lwm2mContextP;
+    lwm2m_observe_index_t *indexP;
+    size_t position;
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "URI: /%u/%u/%u", uriP->objectId, uriP->instanceId, uriP->resourceId);
 
-    for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    position = prv_indexGetObjectPosition(lwm2mContextP, uriP->objectId);
+    if (position == lwm2mContextP->observeIndexCount
+        || lwm2mContextP->observeIndexArray[position].objectId != uriP->objectId)
     {
-        lwm2m_observed_t *observedP;
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "No observation on this Object.");
+        return;
+    }
+    indexP = lwm2mContextP->observeIndexArray + position;
 
-        for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
-        {
-            size_t ind;
+    if (uriP->instanceId == IOWA_LWM2M_ID_ALL)
+    {
+        size_t i;
 
-            for (ind = 0; ind < observedP->uriCount; ind++)
+        for (i = 0; i < indexP->entryCount; i++)
+        {
+            if (uriP->resourceId == IOWA_LWM2M_ID_ALL
+                || indexP->entryArray[i].resourceId == IOWA_LWM2M_ID_ALL
+                || indexP->entryArray[i].resourceId == uriP->resourceId)
             {
-                if (observedP->uriInfoP[ind].uri.objectId == uriP->objectId)
-                {
-                    if (uriP->instanceId == IOWA_LWM2M_ID_ALL
-                        || observedP->uriInfoP[ind].uri.instanceId == IOWA_LWM2M_ID_ALL
-                        || uriP->instanceId == observedP->uriInfoP[ind].uri.instanceId)
-                    {
-                        if (uriP->resourceId == IOWA_LWM2M_ID_ALL
-                            || observedP->uriInfoP[ind].uri.resourceId == IOWA_LWM2M_ID_ALL
-                            || uriP->resourceId == observedP->uriInfoP[ind].uri.resourceId)
-                        {
-                            observedP->uriInfoP[ind].flags |= LWM2M_OBSERVE_FLAG_UPDATE;
-                            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Tagging the observation.");
-                            observedP->flags |= LWM2M_OBSERVE_FLAG_UPDATE;
-                        }
-                    }
-                }
+                prv_indexTagEntry(lwm2mContextP, indexP->entryArray + i);
             }
         }
-
+    }
+    else
+    {
+        // Observations of this instance, then of the whole Object
+        prv_indexTagInstance(lwm2mContextP, indexP, uriP->instanceId, uriP->resourceId);
+        prv_indexTagInstance(lwm2mContextP, indexP, IOWA_LWM2M_ID_ALL, uriP->resourceId);
     }
 }
 
@@ -929,7 +1316,12 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
     size_t ind;
     uint8_t *bufferP;
     size_t bufferLength;
+    size_t headroom;
     lwm2m_value_t *valueP;
+    iowa_coap_message_t message;
+    iowa_coap_option_t formatOption;
+    iowa_coap_option_t observeOption;
+    iowa_coap_option_t *optionP;
 
     IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
 
@@ -969,23 +1361,62 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
         }
     }
 
-    result = dataLwm2mSerialize(&observedP->uriInfoP[0].uri, dataP, dataCount, &(observedP->format), &bufferP, &bufferLength);
+    // The notification only lives during this function: build it on the stack.
+    memset(&message, 0, sizeof(iowa_coap_message_t));
+    memset(&formatOption, 0, sizeof(iowa_coap_option_t));
+    memset(&observeOption, 0, sizeof(iowa_coap_option_t));
+
+    message.code = IOWA_COAP_205_CONTENT;
+    message.tokenLength = observedP->tokenLen;
+    memcpy(message.token, observedP->token, observedP->tokenLen);
+
+    formatOption.number = IOWA_COAP_OPTION_CONTENT_FORMAT;
+    formatOption.value.asInteger = observedP->format;
+    iowa_coap_message_add_option(&message, &formatOption);
+
+    observeOption.number = IOWA_COAP_OPTION_OBSERVE;
+    observeOption.value.asInteger = observedP->counter;
+    iowa_coap_message_add_option(&message, &observeOption);
+
+    // On datagram transports, reserve room for the CoAP header in the payload buffer so that the datagram is built in place.
+    if (coapPeerGetConnectionType(serverP->runtime.peerP) == IOWA_CONN_DATAGRAM)
+    {
+        headroom = coapMessageGetDatagramHeadroom(&message);
+    }
+    else
+    {
+        headroom = 0;
+    }
+
+    result = dataLwm2mSerialize(&observedP->uriInfoP[0].uri, dataP, dataCount, &(observedP->format), headroom, &bufferP, &bufferLength);
     if (result != IOWA_COAP_NO_ERROR)
     {
         IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "dataLwm2mSerialize() failed with code %d.", result);
+        CORE_METRICS_INCREMENT(serverP->metrics.notificationDropCount);
         return;
     }
 
+    // The content format may have been changed by the serializer. In this case, the header is not built in place.
+    formatOption.value.asInteger = observedP->format;
+    message.payload.memory = bufferP;
+    if (bufferP != NULL)
+    {
+        message.payload.data = bufferP + headroom;
+        message.payload.length = bufferLength;
+    }
+
     observedP->lastTime = contextP->currentTime;
+    prv_scheduleMaxPeriod(contextP, observedP);
 
     if (serverP->notifStoring == true)
     {
-        valueP = (lwm2m_value_t *)iowa_system_malloc(sizeof(lwm2m_value_t));
+        valueP = (lwm2m_value_t *)CORE_POOL_ALLOC(IOWA_MEMORY_POOL_LWM2M_VALUE, sizeof(lwm2m_value_t));
 #ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
         if (valueP == NULL)
         {
             IOWA_LOG_ERROR_MALLOC(sizeof(lwm2m_value_t));
             iowa_system_free(bufferP);
+            CORE_METRICS_INCREMENT(serverP->metrics.notificationDropCount);
             return;
         }
 #endif
@@ -1005,282 +1436,298 @@ static void prv_checkAndSendNotification(iowa_context_t contextP,
         if (serverP->runtime.status == STATE_REG_REGISTERED
             || serverP->runtime.status == STATE_REG_UPDATE_PENDING)
         {
-            iowa_coap_message_t *messageP;
-            iowa_coap_option_t *optionP;
-            uint8_t messageType;
             coap_message_callback_t callbackP;
 
             if (serverP->notifStoring == true)
             {
-                messageType = IOWA_COAP_TYPE_CONFIRMABLE;
+                message.type = IOWA_COAP_TYPE_CONFIRMABLE;
                 callbackP = prv_notificationCallback;
             }
             else
             {
-                messageType = IOWA_COAP_TYPE_NON_CONFIRMABLE;
+                message.type = IOWA_COAP_TYPE_NON_CONFIRMABLE;
                 callbackP = NULL;
             }
 
-            messageP = iowa_coap_message_new(messageType, IOWA_COAP_205_CONTENT, observedP->tokenLen, observedP->token);
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-            if (messageP == NULL)
-            {
-                iowa_system_free(bufferP);
-                IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP message.");
-                return;
-            }
-#endif
-
-            optionP = iowa_coap_option_new(IOWA_COAP_OPTION_CONTENT_FORMAT);
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-            if (optionP == NULL)
+            IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Send notification number %d.", observedP->counter);
+            result = coapSend(contextP, serverP->runtime.peerP, &message, callbackP, valueP);
+            if (result == IOWA_COAP_NO_ERROR)
             {
-                iowa_coap_message_free(messageP);
-                iowa_system_free(bufferP);
-                IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP option.");
-                return;
+                CORE_METRICS_INCREMENT(serverP->metrics.notificationCount);
             }
-#endif
-            optionP->value.asInteger = observedP->format;
-            iowa_coap_message_add_option(messageP, optionP);
-
-            optionP = iowa_coap_option_new(IOWA_COAP_OPTION_OBSERVE);
-#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
-            if (optionP == NULL)
+            else
             {
-                iowa_coap_message_free(messageP);
-                iowa_system_free(bufferP);
-                IOWA_LOG_ERROR(IOWA_PART_LWM2M, "Failed to create new CoAP option.");
-                return;
+                CORE_METRICS_INCREMENT(serverP->metrics.notificationDropCount);
             }
-#endif
-            optionP->value.asInteger = observedP->counter;
-            iowa_coap_message_add_option(messageP, optionP);
-
-            coreBufferSet(&(messageP->payload),bufferP, bufferLength);
 
-            IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Send notification number %d.", observedP->counter);
-            (void)coapSend(contextP, serverP->runtime.peerP, messageP, callbackP, valueP);
+            prv_addMID(observedP, message.id);
+        }
+        else
+        {
+            CORE_METRICS_INCREMENT(serverP->metrics.notificationDropCount);
+        }
+    }
 
-            prv_addMID(observedP, messageP->id);
+    // Slicing a large notification in blocks added allocated options to the ones on the stack
+    optionP = message.optionList;
+    while (optionP != NULL)
+    {
+        iowa_coap_option_t *nextP;
 
-            iowa_coap_message_free(messageP);
-            iowa_system_free(bufferP);
+        nextP = optionP->next;
+        if (optionP != &formatOption
+            && optionP != &observeOption)
+        {
+            optionP->next = NULL;
+            iowa_coap_option_free(optionP);
         }
+        optionP = nextP;
     }
 
+    // If the payload buffer was handed over to a CoAP transaction, the message payload is empty.
+    coreBufferClear(&(message.payload));
+
     observedP->counter++;
     observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
 }
 
-void observe_step(iowa_context_t contextP)
+// Process a tagged observation: check its minimum period and its numeric attributes and send a notification if required.
+// Returned value: IOWA_COAP_NO_ERROR or the error returned by object_read().
+// Parameters:
+// - contextP: iowa context.
+// - serverP: server's information.
+// - observedP: observe's information.
+static iowa_status_t prv_processUpdate(iowa_context_t contextP,
+                                       lwm2m_server_t *serverP,
+                                       lwm2m_observed_t *observedP)
 {
     // WARNING: This function is called in a critical section
-    lwm2m_server_t *serverP;
+    iowa_status_t result;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    size_t ind;
+    bool sendNotif;
+    bool nextObs;
 
-    IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
+    dataP = NULL;
+    dataCount = 0;
+    sendNotif = false;
+    nextObs = false;
 
-    for (serverP = contextP->lwm2mContextP->serverList; serverP != NULL; serverP = serverP->next)
+    //Check if there is timeAttribute
+    if (observedP->timeAttrP != NULL)
     {
-        lwm2m_observed_t *observedP;
-
-        for (observedP = serverP->runtime.observedList; observedP != NULL; observedP = observedP->next)
+        if ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
         {
-            iowa_status_t result;
-            iowa_lwm2m_data_t *dataP;
-            size_t dataCount;
-            size_t ind;
-            bool sendNotif;
-            bool nextObs;
-            dataP = NULL;
-            dataCount = 0;
-            sendNotif = false;
-            nextObs = false;
-
-            // if tag true
-            if ((observedP->flags & LWM2M_OBSERVE_FLAG_UPDATE) != 0
-                && (contextP->lwm2mContextP->internalFlag & CONTEXT_FLAG_INSIDE_CALLBACK) == 0)
+            IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Checking minimum period (%d s).", observedP->timeAttrP->minPeriod);
+            if (observedP->lastTime + observedP->timeAttrP->minPeriod > contextP->currentTime)
             {
-                //Check if there is timeAttribute
-                if (observedP->timeAttrP != NULL)
+                // pmin is set and did not elapsed. Ignore this notification.
+                observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
+                CORE_METRICS_INCREMENT(serverP->metrics.pminSuppressionCount);
+                nextObs = true;
+            }
+        }
+    }
+    if (nextObs == false)
+    {
+        for (ind = 0; ind < observedP->uriCount; ind++)
+        {
+            //Get value to send
+            result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
+            {
+                if (result != IOWA_COAP_205_CONTENT)
                 {
-                    if ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0)
-                    {
-                        IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Checking minimum period (%d s).", observedP->timeAttrP->minPeriod);
-                        if (observedP->lastTime + observedP->timeAttrP->minPeriod > contextP->currentTime)
-                        {
-                            // pmin is set and did not elapsed. Ignore this notification.
-                            observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
-                            nextObs = true;
-                        }
-                    }
+                    IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+                    return result;
                 }
-                if (nextObs == false)
+            }
+            //Check if it's a resource with no multiple instance && a numeric resource && if there is a ST, LT, GT set
+            if (LWM2M_URI_IS_SET_RESOURCE(&observedP->uriInfoP[ind].uri)
+                && !LWM2M_URI_IS_SET_RESOURCE_INSTANCE(&observedP->uriInfoP[ind].uri)
+                && observedP->uriInfoP[ind].uriAttrP != NULL
+                && (observedP->uriInfoP[ind].uriAttrP->flags & ATTR_FLAG_NUMERIC) != 0
+                && LWM2M_OBSERVE_IS_NUMERIC(&observedP->uriInfoP[ind]))
+            {
+                if ((observedP->uriInfoP[ind].flags & LWM2M_OBSERVE_FLAG_INTEGER) != 0)
                 {
-                    for (ind = 0; ind < observedP->uriCount; ind++)
+                    int64_t integerValue;
+                    integerValue = dataP->value.asInteger;
+
+                    if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0
+                        && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->lessThan, integerValue, observedP->uriInfoP[ind].lastValue.asInteger))
                     {
-                        //Get value to send
-                        result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
-                        {
-                            if (result != IOWA_COAP_205_CONTENT)
-                            {
-                                IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
-                                return;
-                            }
-                        }
-                        //Check if it's a resource with no multiple instance && a numeric resource && if there is a ST, LT, GT set
-                        if (LWM2M_URI_IS_SET_RESOURCE(&observedP->uriInfoP[ind].uri)
-                            && !LWM2M_URI_IS_SET_RESOURCE_INSTANCE(&observedP->uriInfoP[ind].uri)
-                            && observedP->uriInfoP[ind].uriAttrP != NULL
-                            && (observedP->uriInfoP[ind].uriAttrP->flags & ATTR_FLAG_NUMERIC) != 0
-                            && LWM2M_OBSERVE_IS_NUMERIC(&observedP->uriInfoP[ind]))
+                        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower threshold crossing.");
+                        sendNotif = true;
+                    }
+
+                    if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0
+                        && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->greaterThan, integerValue, observedP->uriInfoP[ind].lastValue.asInteger))
+                    {
+                        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower upper crossing.");
+                        sendNotif = true;
+                    }
+
+                    if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
+                    {
+                        int64_t diff;
+
+                        diff = integerValue - observedP->uriInfoP[ind].lastValue.asInteger;
+                        if (diff < 0 )
                         {
-                            if ((observedP->uriInfoP[ind].flags & LWM2M_OBSERVE_FLAG_INTEGER) != 0)
-                            {
-                                int64_t integerValue;
-                                integerValue = dataP->value.asInteger;
-
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0
-                                    && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->lessThan, integerValue, observedP->uriInfoP[ind].lastValue.asInteger))
-                                {
-                                    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower threshold crossing.");
-                                    sendNotif = true;
-                                }
-
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0
-                                    && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->greaterThan, integerValue, observedP->uriInfoP[ind].lastValue.asInteger))
-                                {
-                                    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower upper crossing.");
-                                    sendNotif = true;
-                                }
-
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
-                                {
-                                    int64_t diff;
-
-                                    diff = integerValue - observedP->uriInfoP[ind].lastValue.asInteger;
-                                    if (diff < 0 )
-                                    {
-                                        diff = 0 - diff;
-                                    }
-                                    if (diff >= observedP->uriInfoP[ind].uriAttrP->step)
-                                    {
-                                        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on step condition.");
-                                        sendNotif = true;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                double floatValue;
-                                floatValue = dataP->value.asFloat;
-
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0
-                                    && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->lessThan, floatValue, observedP->uriInfoP[ind].lastValue.asFloat))
-                                {
-                                    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower threshold crossing.");
-                                    sendNotif = true;
-                                }
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0
-                                    && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->greaterThan, floatValue, observedP->uriInfoP[ind].lastValue.asFloat))
-                                {
-                                    IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower upper crossing.");
-                                    sendNotif = true;
-                                }
-                                if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
-                                {
-                                    double diff;
-
-                                    diff = floatValue - observedP->uriInfoP[ind].lastValue.asFloat;
-                                    if (diff < 0 )
-                                    {
-                                        diff = 0 - diff;
-                                    }
-                                    if (diff >= observedP->uriInfoP[ind].uriAttrP->step) //Todo : check FLT_EPSILON
-                                    {
-                                        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on step condition.");
-                                        sendNotif = true;
-                                    }
-                                }
-                            }
+                            diff = 0 - diff;
                         }
-                        else
+                        if (diff >= observedP->uriInfoP[ind].uriAttrP->step)
                         {
-                            if ((observedP->uriInfoP[ind].flags & LWM2M_OBSERVE_FLAG_UPDATE) != 0)
-                            {
-                                sendNotif = true;
-                            }
+                            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on step condition.");
+                            sendNotif = true;
                         }
                     }
-                    if (sendNotif == true)
+                }
+                else
+                {
+                    double floatValue;
+                    floatValue = dataP->value.asFloat;
+
+                    if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_LESS_THAN) != 0
+                        && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->lessThan, floatValue, observedP->uriInfoP[ind].lastValue.asFloat))
                     {
-                        prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
+                        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower threshold crossing.");
+                        sendNotif = true;
                     }
+                    if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_GREATER_THAN) != 0
+                        && TEST_THRESHOLD(observedP->uriInfoP[ind].uriAttrP->greaterThan, floatValue, observedP->uriInfoP[ind].lastValue.asFloat))
                     {
-                        object_free(contextP, dataCount, dataP);
-                        iowa_system_free(dataP);
+                        IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on lower upper crossing.");
+                        sendNotif = true;
                     }
-                    observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
-                }
-            }
-            else // Check pmax
-            {
-                //Check if there is timeAttribute
-                if (observedP->timeAttrP != NULL)
-                {
-                    if ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+                    if ((observedP->uriInfoP[ind].uriAttrP->flags & LWM2M_ATTR_FLAG_STEP) != 0)
                     {
-                        // Ignore pmax if lesser than pmin
-                        if (((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0
-                            && observedP->timeAttrP->maxPeriod >= observedP->timeAttrP->minPeriod)
-                            || ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) == 0))
+                        double diff;
+
+                        diff = floatValue - observedP->uriInfoP[ind].lastValue.asFloat;
+                        if (diff < 0 )
                         {
-                            IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Checking maximum period (%d s).", observedP->timeAttrP->maxPeriod);
-                            if (observedP->lastTime + observedP->timeAttrP->maxPeriod <= contextP->currentTime)
-                            {
-                                IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Notify on elapsed maximal period (%d s).", observedP->timeAttrP->maxPeriod);
-
-                                for (ind = 0; ind < observedP->uriCount; ind++)
-                                {
-                                    //Get value to send
-                                    result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
-                                    {
-                                        if (result != IOWA_COAP_205_CONTENT)
-                                        {
-                                            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
-                                            return;
-                                        }
-                                    }
-                                }
-                                prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
-                                object_free(contextP, dataCount, dataP);
-                                iowa_system_free(dataP);
-                            }
+                            diff = 0 - diff;
+                        }
+                        if (diff >= observedP->uriInfoP[ind].uriAttrP->step) //Todo : check FLT_EPSILON
+                        {
+                            IOWA_LOG_INFO(IOWA_PART_LWM2M, "Notify on step condition.");
+                            sendNotif = true;
                         }
                     }
                 }
             }
-            if (observedP->timeAttrP != NULL
-                && (observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MAX_PERIOD) != 0)
+            else
             {
-                // Ignore pmax if lesser than pmin
-                if (((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) != 0
-                    && observedP->timeAttrP->maxPeriod >= observedP->timeAttrP->minPeriod)
-                    || ((observedP->timeAttrP->flags & LWM2M_ATTR_FLAG_MIN_PERIOD) == 0))
+                if ((observedP->uriInfoP[ind].flags & LWM2M_OBSERVE_FLAG_UPDATE) != 0)
                 {
-                    int32_t interval;
-
-                    interval = observedP->lastTime + observedP->timeAttrP->maxPeriod - contextP->currentTime;
-                    if (contextP->timeout > interval)
-                    {
-                        contextP->timeout = interval;
-                    }
+                    sendNotif = true;
                 }
             }
         }
+        if (sendNotif == true)
+        {
+            prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
+        }
+        {
+            object_free(contextP, dataCount, dataP);
+            CORE_ARENA_FREE(dataP);
+        }
+        observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_UPDATE);
+    }
+
+    return IOWA_COAP_NO_ERROR;
+}
+
+static void prv_maxPeriodTimerCallback(iowa_context_t contextP,
+                                       void *userData)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_observed_t *observedP;
+    lwm2m_server_t *serverP;
+    iowa_lwm2m_data_t *dataP;
+    size_t dataCount;
+    size_t ind;
+
+    observedP = (lwm2m_observed_t *)userData;
+    serverP = observedP->serverP;
 
+    observedP->maxPeriodTimerP = NULL;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_LWM2M, "Notify on elapsed maximal period (%d s).", observedP->timeAttrP->maxPeriod);
+
+    dataP = NULL;
+    dataCount = 0;
+
+    for (ind = 0; ind < observedP->uriCount; ind++)
+    {
+        iowa_status_t result;
+
+        //Get value to send
+        result = object_read(contextP, &observedP->uriInfoP[ind].uri, serverP->shortId, &dataCount, &dataP);
+        if (result != IOWA_COAP_205_CONTENT)
+        {
+            IOWA_LOG_ARG_WARNING(IOWA_PART_LWM2M, "Getting value to send failed with code %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
+
+            // Try again at the next maximum period
+            observedP->maxPeriodTimerP = coreTimerNew(contextP, prv_getMaxPeriodDelay(contextP, contextP->currentTime, observedP->timeAttrP->maxPeriod), prv_maxPeriodTimerCallback, observedP);
+            return;
+        }
     }
+    prv_checkAndSendNotification(contextP, serverP, observedP, dataP, dataCount);
+    object_free(contextP, dataCount, dataP);
+    CORE_ARENA_FREE(dataP);
+}
+
+void observe_step(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    lwm2m_context_t *lwm2mContextP;
+
+    IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Entering.");
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    // The maximum periods are handled by timers: only the tagged observations are processed here.
+    if ((lwm2mContextP->internalFlag & CONTEXT_FLAG_INSIDE_CALLBACK) != 0)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Inside a callback, the tagged observations are kept for later.");
+        return;
+    }
+
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    // The notifications are sent together
+    coapSendBatchStart(contextP);
+#endif
+
+    while (lwm2mContextP->dirtyObservedList != NULL)
+    {
+        lwm2m_observed_t *observedP;
+
+        // The observation keeps its dirty flag while processed so that the callbacks do not add it to the list again.
+        observedP = lwm2mContextP->dirtyObservedList;
+        lwm2mContextP->dirtyObservedList = observedP->nextDirtyP;
+        observedP->nextDirtyP = NULL;
+
+        if ((observedP->flags & LWM2M_OBSERVE_FLAG_UPDATE) != 0)
+        {
+            if (prv_processUpdate(contextP, observedP->serverP, observedP) != IOWA_COAP_NO_ERROR)
+            {
+                // Keep the observation tagged to try again at the next step
+                observedP->nextDirtyP = lwm2mContextP->dirtyObservedList;
+                lwm2mContextP->dirtyObservedList = observedP;
+                break;
+            }
+        }
+
+        observedP->flags &= (uint8_t)~(LWM2M_OBSERVE_FLAG_DIRTY);
+    }
+
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+    coapSendBatchStop(contextP);
+#endif
+
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Exiting with timeoutP: %ds.", contextP->timeout);
 }
 #endif // LWM2M_CLIENT_MODE
-
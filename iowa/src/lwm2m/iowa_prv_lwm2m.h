@@ -327,7 +327,10 @@ typedef struct _lwm2m_observed_
 {
     struct _lwm2m_observed_ *next;
 
-    uint8_t                     flags; // possibilities: LWM2M_OBSERVE_FLAG_UPDATE
+    struct _lwm2m_server_      *serverP;         // the Server which requested the observation
+    struct _lwm2m_observed_    *nextDirtyP;      // next observation in lwm2m_context_t::dirtyObservedList
+    iowa_timer_t               *maxPeriodTimerP; // fires when the maximum period elapses
+    uint8_t                     flags; // possibilities: LWM2M_OBSERVE_FLAG_UPDATE; LWM2M_OBSERVE_FLAG_DIRTY
     size_t                      uriCount;
     lwm2m_observed_uri_info_t  *uriInfoP;
     lwm2m_time_attributes_t    *timeAttrP;
@@ -339,6 +342,23 @@ typedef struct _lwm2m_observed_
     uint16_t                    lastMid[LWM2M_OBSERVATION_MID_ARRAY_SIZE];
 } lwm2m_observed_t;
 
+// Entry of the index from the observed URIs to the observations.
+typedef struct
+{
+    uint16_t          instanceId;
+    uint16_t          resourceId;
+    lwm2m_observed_t *observedP;
+    size_t            uriIndex;   // index of the URI in observedP->uriInfoP
+} lwm2m_observe_index_entry_t;
+
+// Observed URIs of an Object.
+typedef struct
+{
+    uint16_t                     objectId;
+    size_t                       entryCount;
+    lwm2m_observe_index_entry_t *entryArray; // sorted by instance ID then by resource ID
+} lwm2m_observe_index_t;
+
 typedef struct _lwm2m_async_operation_
 {
     struct _lwm2m_async_operation_ *next;
@@ -404,6 +424,10 @@ typedef struct
     attributes_t            *attributesList;
     iowa_timer_t            *updateTimerP;
     iowa_timer_t            *lifetimeTimerP;
+#ifdef IOWA_COAP_BLOCK_SUPPORT
+    iowa_lwm2m_uri_t         blockUri;     // target of the ongoing Block1 transfer
+    size_t                   blockOffset;  // offset of the next expected Block1 block, 0 if no transfer is ongoing
+#endif
 } lwm2m_server_runtime_t;
 
 typedef struct _lwm2m_server_
@@ -426,6 +450,9 @@ typedef struct _lwm2m_server_
     lwm2m_server_runtime_t        runtime;
     uint8_t                       coapAckTimeout;
     uint8_t                       coapMaxRetransmit;
+#ifdef IOWA_METRICS_SUPPORT
+    iowa_metrics_server_counters_t metrics;
+#endif
 } lwm2m_server_t;
 
 /*
@@ -500,12 +527,13 @@ typedef struct _lwm2m_object_t
     iowa_object_version_t       version;
     uint16_t                    resourceCount;
     iowa_lwm2m_resource_desc_t *resourceArray;
+    uint16_t                   *resourceIndexArray; // indexes in resourceArray sorted by resource ID
     iowa_RWE_callback_t         dataCb;
     iowa_CD_callback_t          instanceCb;
     iowa_RI_callback_t          resInstanceCb;
     void                       *userData;
     uint16_t                    instanceCount;
-    lwm2m_instance_details_t   *instanceArray;
+    lwm2m_instance_details_t   *instanceArray;  // sorted by instance ID. Each resArray is sorted too.
 } lwm2m_object_t;
 
 typedef struct _lwm2m_context_t lwm2m_context_t;
@@ -513,16 +541,23 @@ typedef struct _lwm2m_context_t lwm2m_context_t;
 struct _lwm2m_context_t
 {
 #ifdef LWM2M_CLIENT_MODE
-    lwm2m_client_state_t  state;
-    char                 *endpointName;
+    lwm2m_client_state_t   state;
+    char                  *endpointName;
 #ifdef LWM2M_ALTPATH_SUPPORT
-    char                 *altPath;
+    char                  *altPath;
 #endif
-    lwm2m_server_t       *serverList;
-    lwm2m_object_t       *objectList;
-    uint8_t               internalFlag;
+    lwm2m_server_t        *serverList;
+    lwm2m_object_t        *objectList;
+    lwm2m_object_t       **objectArray;       // same objects as objectList, sorted by ID
+    size_t                 objectCount;
+    lwm2m_observe_index_t *observeIndexArray; // observed URIs of all the servers, sorted by Object ID
+    size_t                 observeIndexCount;
+    lwm2m_observed_t      *dirtyObservedList; // observations tagged since the last observe_step()
+    uint8_t               *registrationPayload; // CoRE Link payload of the last registration, nil when the Object tree changed
+    size_t                 registrationPayloadLength;
+    uint8_t                internalFlag;
 #endif // LWM2M_CLIENT_MODE
-    void                 *userData;
+    void                  *userData;
 };
 
 #define LWM2M_CLIENT_FLAG_CLOSED      0x01
@@ -571,6 +606,10 @@ iowa_status_t lwm2m_configure(iowa_context_t contextP, const char * endpointName
 // - serverP : pointer of the server.
 // - update : an unsigned integer as the update flag.
 void lwm2mUpdateRegistration(iowa_context_t contextP, lwm2m_server_t *serverP, uint8_t update);
+// Discard the cached registration payload. To be called when the Object tree changes.
+// Parameters:
+// - contextP: as returned by iowa_init().
+void lwm2mResetRegistrationPayload(iowa_context_t contextP);
 // Update the observe flag of the matched uris.
 // Parameters:
 // - contextP: as returned by iowa_init().
@@ -678,6 +717,13 @@ bool object_hasResource(lwm2m_object_t *objectP, uint16_t instIndex, uint16_t re
 // - resourceIndexP: OUT. The index of the resource in case of success. May be nil.
 iowa_status_t object_find(iowa_context_t contextP, uint16_t objectID, uint16_t instanceID, uint16_t resourceID, lwm2m_object_t **objectPP, uint16_t *instanceIndexP, uint16_t *resourceIndexP);
 
+// Retrieve an Object by its ID.
+// Returned value: a pointer to the Object or nil if not found.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - objectID: ID of the Object to retrieve.
+lwm2m_object_t * object_get(iowa_context_t contextP, uint16_t objectID);
+
 // CoRE Link APIs
 typedef enum
 {
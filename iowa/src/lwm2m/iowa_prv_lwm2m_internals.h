@@ -239,6 +239,7 @@ typedef enum
 #define LWM2M_OBSERVE_FLAG_INTEGER    (uint8_t)0x02 // indicates if observe's value is an integer, used in lwm2m_observed_uri_info_t
 #define LWM2M_OBSERVE_FLAG_FLOAT      (uint8_t)0x04 // indicates if observe's value is a float, used in lwm2m_observed_uri_info_t
 #define LWM2M_OBSERVE_FLAG_URI_UNSET  (uint8_t)0x08 // indicates if observe's uri is unset due to instance deletion, used in lwm2m_observed_uri_info_t
+#define LWM2M_OBSERVE_FLAG_DIRTY      (uint8_t)0x10 // indicates if the observation is in the dirty list, used in lwm2m_observed_t
 
 // Macro to check if observe's value is numeric
 // Returned value: true if observe's value is numeric, else false.
@@ -555,8 +556,8 @@ iowa_status_t observe_handleRequest(iowa_context_t contextP, size_t uriCount, io
 
 void observe_cancel(iowa_context_t contextP, lwm2m_server_t *serverP, iowa_coap_message_t *messageP);
 iowa_status_t observe_setParameters(iowa_context_t contextP, iowa_lwm2m_uri_t *uriP, lwm2m_server_t *serverP);
-void observe_delete(lwm2m_observed_t *observedP);
-void observeRemoveFromServer(lwm2m_server_t *serverP);
+void observe_delete(iowa_context_t contextP, lwm2m_observed_t *observedP);
+void observeRemoveFromServer(iowa_context_t contextP, lwm2m_server_t *serverP);
 void observe_remove(lwm2m_observation_t * observationP);
 void observe_step(iowa_context_t contextP);
 void observe_clear(iowa_context_t contextP, iowa_lwm2m_uri_t * uriP);
@@ -99,6 +99,7 @@
 
 #ifdef LWM2M_CLIENT_MODE
 static iowa_status_t prv_getRegistrationQuery(iowa_context_t contextP, lwm2m_server_t *serverP, size_t *lengthP, char **bufferP);
+static iowa_status_t prv_buildRegistrationPayload(iowa_context_t contextP, uint8_t **payloadP, size_t *payloadLengthP);
 static iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP, uint8_t **payloadP, size_t *payloadLengthP);
 static int32_t prv_getUpdateDelay(lwm2m_server_t *serverP);
 static void prv_serverRegistrationFailing(iowa_context_t contextP, lwm2m_server_t *serverP, bool isInternal, uint8_t code);
@@ -255,9 +256,9 @@ exit_on_error:
     return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
 }
 
-iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP,
-                                         uint8_t **payloadP,
-                                         size_t *payloadLengthP)
+iowa_status_t prv_buildRegistrationPayload(iowa_context_t contextP,
+                                           uint8_t **payloadP,
+                                           size_t *payloadLengthP)
 {
     iowa_status_t result;
     link_t *linkP;
@@ -317,6 +318,44 @@ iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP,
     return result;
 }
 
+iowa_status_t prv_getRegistrationPayload(iowa_context_t contextP,
+                                         uint8_t **payloadP,
+                                         size_t *payloadLengthP)
+{
+    lwm2m_context_t *lwm2mContextP;
+
+    lwm2mContextP = contextP->lwm2mContextP;
+
+    if (lwm2mContextP->registrationPayload == NULL)
+    {
+        iowa_status_t result;
+
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Building the registration payload.");
+
+        result = prv_buildRegistrationPayload(contextP, &(lwm2mContextP->registrationPayload), &(lwm2mContextP->registrationPayloadLength));
+        if (result != IOWA_COAP_NO_ERROR)
+        {
+            lwm2mContextP->registrationPayload = NULL;
+            lwm2mContextP->registrationPayloadLength = 0;
+            return result;
+        }
+    }
+
+    // The message takes ownership of its payload: give it a copy of the cached one
+    *payloadP = (uint8_t *)iowa_system_malloc(lwm2mContextP->registrationPayloadLength);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (*payloadP == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(lwm2mContextP->registrationPayloadLength);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+    memcpy(*payloadP, lwm2mContextP->registrationPayload, lwm2mContextP->registrationPayloadLength);
+    *payloadLengthP = lwm2mContextP->registrationPayloadLength;
+
+    return IOWA_COAP_NO_ERROR;
+}
+
 int32_t prv_getUpdateDelay(lwm2m_server_t *serverP)
 {
     int32_t coapMaxTransmitWait;
@@ -683,6 +722,7 @@ void prv_updateRegistration(iowa_context_t contextP,
     {
         serverP->runtime.status = STATE_REG_UPDATE_PENDING;
         serverP->runtime.update = LWM2M_UPDATE_FLAG_NONE; // Reset the registration update flags since the message has been sent
+        CORE_METRICS_INCREMENT(serverP->metrics.updateCount);
 
         // After the server event callback, don't try to access 'serverP' pointer since the application callback could have removed it
         coreServerEventCallback(contextP, serverP, IOWA_EVENT_REG_UPDATING, false, IOWA_COAP_NO_ERROR);
@@ -1053,6 +1093,12 @@ premature_exit:
         coapPeerDelete(contextP, serverP->runtime.peerP);
         serverP->runtime.peerP = NULL;
     }
+#ifdef IOWA_METRICS_SUPPORT
+    else
+    {
+        serverP->metrics.registrationCount++;
+    }
+#endif
 
     IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "Exiting with status: %u.%02u.", (result & 0xFF) >> 5, (result & 0x1F));
 
@@ -1211,6 +1257,19 @@ void lwm2mUpdateRegistration(iowa_context_t contextP,
     }
 }
 
+void lwm2mResetRegistrationPayload(iowa_context_t contextP)
+{
+    // WARNING: This function is called in a critical section
+    if (contextP->lwm2mContextP->registrationPayload != NULL)
+    {
+        IOWA_LOG_TRACE(IOWA_PART_LWM2M, "Discarding the cached registration payload.");
+
+        iowa_system_free(contextP->lwm2mContextP->registrationPayload);
+        contextP->lwm2mContextP->registrationPayload = NULL;
+        contextP->lwm2mContextP->registrationPayloadLength = 0;
+    }
+}
+
 void registration_deregister(iowa_context_t contextP,
                              lwm2m_server_t *serverP)
 {
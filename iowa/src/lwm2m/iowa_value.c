@@ -27,6 +27,6 @@ void valueFree(lwm2m_value_t *valueP)
     {
         IOWA_LOG_ARG_TRACE(IOWA_PART_LWM2M, "counter: %u.", valueP->counter);
         iowa_system_free(valueP->buffer);
-        iowa_system_free(valueP);
+        CORE_POOL_FREE(IOWA_MEMORY_POOL_LWM2M_VALUE, valueP);
     }
 }
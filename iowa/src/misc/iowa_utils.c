@@ -361,6 +361,30 @@ char * utilsStrdup(const char *str)
     return dest;
 }
 
+void * utilsRealloc(void *src,
+                    size_t sizeSrc,
+                    size_t sizeDst)
+{
+    void *dest;
+
+    dest = iowa_system_malloc(sizeDst);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (dest == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(sizeDst);
+        return NULL;
+    }
+#endif
+
+    if (src != NULL)
+    {
+        memcpy(dest, src, (sizeSrc < sizeDst) ? sizeSrc : sizeDst);
+        iowa_system_free(src);
+    }
+
+    return dest;
+}
+
 void * utilsCalloc(size_t number, size_t size)
 {
     size_t totalSize;
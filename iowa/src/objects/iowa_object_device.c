@@ -1418,7 +1418,7 @@ iowa_status_t iowa_client_update_device_information(iowa_context_t contextP,
 
     CRIT_SECTION_ENTER(contextP);
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &id);
+    objectP = object_get(contextP, id);
     if (objectP == NULL)
     {
         CRIT_SECTION_LEAVE(contextP);
@@ -32,7 +32,7 @@ void * objectGetData(iowa_context_t contextP,
 {
     lwm2m_object_t *objectP;
 
-    objectP = (lwm2m_object_t *)IOWA_UTILS_LIST_FIND(contextP->lwm2mContextP->objectList, listFindCallbackBy16bitsId, &objectId);
+    objectP = object_get(contextP, objectId);
     if (objectP == NULL)
     {
         return NULL;
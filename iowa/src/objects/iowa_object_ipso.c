@@ -1019,38 +1019,22 @@ iowa_status_t iowa_client_IPSO_remove_sensor(iowa_context_t contextP,
     return result;
 }
 
-iowa_status_t iowa_client_IPSO_update_value(iowa_context_t contextP,
-                                            iowa_sensor_t id,
-                                            float value)
+iowa_status_t objectIpsoUpdateValue(iowa_context_t contextP,
+                                    iowa_sensor_t id,
+                                    float value)
 {
+    // WARNING: This function is called in a critical section
     ipso_instance_t *instanceP;
     lwm2m_object_t *objectP;
     iowa_ipso_timed_value_t valueToUpdate;
     uint16_t objectId;
     uint16_t instIndex;
 
-    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Updating IPSO object /%d/%d. New value: %f.", (uint16_t)(id >> 16), id & 0xFFFF, (double)value);
-
     objectId = GET_OBJECT_ID_FROM_SENSOR(id);
 
-#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
-    // Check if the value is valid
-    iowa_status_t result;
-
-    result = prv_checkResourceValue((iowa_IPSO_ID_t)objectId, value);
-    if (result != IOWA_COAP_NO_ERROR)
-    {
-        IOWA_LOG_ERROR(IOWA_PART_OBJECT, "Resources value check failed.");
-        return result;
-    }
-#endif
-
-    CRIT_SECTION_ENTER(contextP);
-
     if (object_find(contextP, objectId, GET_INSTANCE_ID_FROM_SENSOR(id), IOWA_LWM2M_ID_ALL, &objectP, &instIndex, NULL) != IOWA_COAP_NO_ERROR)
     {
         IOWA_LOG_ERROR(IOWA_PART_OBJECT, "The structure 'lwm2m_object_t' associated with the IPSO sensor has not been found.");
-        CRIT_SECTION_LEAVE(contextP);
         return IOWA_COAP_404_NOT_FOUND;
     }
 
@@ -1058,7 +1042,6 @@ iowa_status_t iowa_client_IPSO_update_value(iowa_context_t contextP,
     if (instanceP == NULL)
     {
         IOWA_LOG_ARG_ERROR(IOWA_PART_OBJECT, "IPSO sensor with Object ID %d and Object Instance ID %d has not been found.", &objectId, GET_INSTANCE_ID_FROM_SENSOR(id));
-        CRIT_SECTION_LEAVE(contextP);
         return IOWA_COAP_404_NOT_FOUND;
     }
 
@@ -1073,9 +1056,59 @@ iowa_status_t iowa_client_IPSO_update_value(iowa_context_t contextP,
 
     clientNotificationLock(contextP, false);
 
+    return IOWA_COAP_NO_ERROR;
+}
+
+iowa_status_t iowa_client_IPSO_update_value(iowa_context_t contextP,
+                                            iowa_sensor_t id,
+                                            float value)
+{
+    iowa_status_t result;
+
+    IOWA_LOG_ARG_INFO(IOWA_PART_OBJECT, "Updating IPSO object /%d/%d. New value: %f.", (uint16_t)(id >> 16), id & 0xFFFF, (double)value);
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    // Check if the value is valid
+    result = prv_checkResourceValue((iowa_IPSO_ID_t)GET_OBJECT_ID_FROM_SENSOR(id), value);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_OBJECT, "Resources value check failed.");
+        return result;
+    }
+#endif
+
+    CRIT_SECTION_ENTER(contextP);
+    result = objectIpsoUpdateValue(contextP, id, value);
     CRIT_SECTION_LEAVE(contextP);
 
-    return IOWA_COAP_NO_ERROR;
+    return result;
 }
 
+#ifdef IOWA_COMMAND_QUEUE_SUPPORT
+iowa_status_t iowa_client_IPSO_post_value(iowa_context_t contextP,
+                                          iowa_sensor_t id,
+                                          float value)
+{
+    core_command_t command;
+
+#ifndef IOWA_CONFIG_SKIP_ARGS_CHECK
+    iowa_status_t result;
+
+    // Check the value now as the caller does not get the result of the update
+    result = prv_checkResourceValue((iowa_IPSO_ID_t)GET_OBJECT_ID_FROM_SENSOR(id), value);
+    if (result != IOWA_COAP_NO_ERROR)
+    {
+        IOWA_LOG_ERROR(IOWA_PART_OBJECT, "Resources value check failed.");
+        return result;
+    }
+#endif
+
+    command.type = CORE_COMMAND_IPSO_VALUE;
+    command.u.ipso.id = id;
+    command.u.ipso.value = value;
+
+    return coreCommandQueuePost(contextP, &command);
+}
+#endif
+
 #endif
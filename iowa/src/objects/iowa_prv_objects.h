@@ -170,6 +170,21 @@ void objectSoftwareManagementInstall(iowa_context_t contextP);
 // - contextP: the IOWA context on which iowa_client_enable_software_management() was called.
 void objectSoftwareManagementActivate(iowa_context_t contextP);
 
+/*******************************
+ * IPSO objects
+ */
+
+// Update the value of an IPSO Object sensor. The value must have been checked by the caller.
+// Returned value: IOWA_COAP_NO_ERROR in case of success or an error status.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - id: ID of the sensor.
+// - value: the new value of the sensor.
+// Note: must be called in a critical section.
+iowa_status_t objectIpsoUpdateValue(iowa_context_t contextP,
+                                    iowa_sensor_t id,
+                                    float value);
+
 #ifdef __cplusplus
 }
 #endif
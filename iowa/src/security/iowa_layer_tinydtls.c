@@ -495,27 +495,42 @@ iowa_status_t tinydtlsStep(iowa_security_session_t securityS)
 
 iowa_status_t tinydtlsHandleHandshakePacket(iowa_security_session_t securityS)
 {
-    uint8_t buffer[IOWA_BUFFER_SIZE];
+    uint8_t *buffer;
     int bufferLength;
+    iowa_status_t result;
 
     IOWA_LOG_TRACE(IOWA_PART_SECURITY, "Entering.");
 
+    // Handshake packets are rare: do not keep a buffer for them
+    buffer = (uint8_t *)iowa_system_malloc(IOWA_BUFFER_SIZE);
+#ifndef IOWA_CONFIG_SKIP_SYSTEM_FUNCTION_CHECK
+    if (buffer == NULL)
+    {
+        IOWA_LOG_ERROR_MALLOC(IOWA_BUFFER_SIZE);
+        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+    }
+#endif
+
+    result = IOWA_COAP_NO_ERROR;
+
     bufferLength = commRecv(securityS->contextP, securityS->channelP, buffer, IOWA_BUFFER_SIZE);
     if (bufferLength > 0)
     {
         if (dtls_handle_message(securityS->sslContext, securityS->sslSession, buffer, bufferLength) != PRV_SUCCESSFUL)
         {
             prv_connectionFailing(securityS);
-            return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+            result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
         }
     }
     else
     {
         prv_connectionFailing(securityS);
-        return IOWA_COAP_500_INTERNAL_SERVER_ERROR;
+        result = IOWA_COAP_500_INTERNAL_SERVER_ERROR;
     }
 
-    return IOWA_COAP_NO_ERROR;
+    iowa_system_free(buffer);
+
+    return result;
 }
 
 void tinydtlsDisconnect(iowa_security_session_t securityS)
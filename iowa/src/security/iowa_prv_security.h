@@ -191,6 +191,25 @@ int securityRecv(iowa_context_t contextP,
                  uint8_t *buffer,
                  size_t length);
 
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+// Receive several datagrams on a connection.
+// Returned value: the number of datagrams received or a negative number in case of error.
+// Parameters:
+// - contextP: returned by iowa_init().
+// - securityS: the session to use, returned by securityConnect().
+// - buffer: to store the read datagrams. The datagram i is stored at buffer + i * length.
+// - length: the maximum size of a datagram.
+// - lengthArray: OUT. The size of each read datagram.
+// - count: the maximum number of datagrams to read.
+// Note: on a secure session, only one datagram is read.
+int securityRecvBatch(iowa_context_t contextP,
+                      iowa_security_session_t securityS,
+                      uint8_t *buffer,
+                      size_t length,
+                      size_t *lengthArray,
+                      size_t count);
+#endif
+
 // Return if a security session is encrypted.
 // Returned value: 'true' if encrypted, 'false' otherwise.
 // Parameters:
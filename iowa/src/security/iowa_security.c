@@ -473,6 +473,36 @@ int securityRecv(iowa_context_t contextP,
     return bufferReceived;
 }
 
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+int securityRecvBatch(iowa_context_t contextP,
+                      iowa_security_session_t securityS,
+                      uint8_t *buffer,
+                      size_t length,
+                      size_t *lengthArray,
+                      size_t count)
+{
+    // WARNING: This function is called in a critical section
+    int bufferReceived;
+
+    IOWA_LOG_ARG_TRACE(IOWA_PART_SECURITY, "Receiving up to %u datagrams on session %p.", count, securityS);
+
+    if (securityS->isSecure == false)
+    {
+        return commRecvBatch(contextP, securityS->channelP, buffer, length, lengthArray, count);
+    }
+
+    // The security layer decrypts the records one by one
+    bufferReceived = securityRecv(contextP, securityS, buffer, length);
+    if (bufferReceived < 0)
+    {
+        return bufferReceived;
+    }
+    lengthArray[0] = (size_t)bufferReceived;
+
+    return 1;
+}
+#endif // IOWA_CONNECTION_RECV_BATCH_SUPPORT
+
 #ifdef IOWA_SECURITY_SERVER_MODE
 iowa_security_session_t securityServerNewSession(iowa_context_t contextP,
                                                  iowa_connection_type_t type,
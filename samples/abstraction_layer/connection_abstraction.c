@@ -19,6 +19,12 @@
 
 // IOWA header
 #include "iowa_config.h"
+
+#if (defined(IOWA_CONNECTION_RECV_BATCH_SUPPORT) || defined(IOWA_CONNECTION_SEND_BATCH_SUPPORT)) && defined(__linux__) && !defined(_GNU_SOURCE)
+// Required for recvmmsg() and sendmmsg()
+#define _GNU_SOURCE
+#endif
+
 #include "iowa_platform.h"
 
 // Platform specific headers
@@ -275,6 +281,64 @@ int iowa_system_connection_select(void **connArray,
 // A socket used only to interrupt the select()
 int g_interruptSocket = -1;
 
+// We create a loopback UDP socket connected to itself.
+static int prv_createInterruptSocket(void)
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        return -1;
+    }
+#endif
+
+    // we create the socket used to interrupt the select()
+    g_interruptSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (g_interruptSocket != -1)
+    {
+        int res;
+        struct sockaddr_in sysAddr;
+
+        memset((char *)&sysAddr, 0, sizeof(sysAddr));
+
+        sysAddr.sin_family = AF_INET;
+        sysAddr.sin_port = 0;
+        sysAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        // bind socket to port
+        res = bind(g_interruptSocket, (struct sockaddr *) &sysAddr, sizeof(sysAddr));
+        if (res != -1)
+        {
+            struct sockaddr_in realAddr;
+            int addrLen;
+
+            addrLen = sizeof(realAddr);
+            res = getsockname(g_interruptSocket, (struct sockaddr *)&realAddr, (socklen_t *)&addrLen);
+            if (res != -1)
+            {
+                res = connect(g_interruptSocket, (struct sockaddr *)&realAddr, addrLen);
+            }
+        }
+        if (res == -1)
+        {
+#ifdef _WIN32
+            closesocket(g_interruptSocket);
+#else
+            close(g_interruptSocket);
+#endif
+            g_interruptSocket = -1;
+            return -1;
+        }
+    }
+    else
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
 // In this function, we use select on the sockets provided by IOWA
 // and on our socket to be able to interrupt the select() if required.
 int iowa_system_connection_select(void **connArray,
@@ -295,59 +359,10 @@ int iowa_system_connection_select(void **connArray,
     FD_ZERO(&readfds);
     maxFd = 0;
 
-    if (g_interruptSocket == -1)
+    if (g_interruptSocket == -1
+        && prv_createInterruptSocket() == -1)
     {
-#ifdef _WIN32
-    {
-        WSADATA wsaData;
-
-        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
-        {
-            return -1;
-        }
-    }
-#endif
-        // we create the socket used to interrupt the select()
-        g_interruptSocket = socket(AF_INET, SOCK_DGRAM, 0);
-        if (g_interruptSocket != -1)
-        {
-            int res;
-            struct sockaddr_in sysAddr;
-
-            memset((char *)&sysAddr, 0, sizeof(sysAddr));
-
-            sysAddr.sin_family = AF_INET;
-            sysAddr.sin_port = 0;
-            sysAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-
-            // bind socket to port
-            res = bind(g_interruptSocket, (struct sockaddr *) &sysAddr, sizeof(sysAddr));
-            if (res != -1)
-            {
-                struct sockaddr_in realAddr;
-                int addrLen;
-
-                addrLen = sizeof(realAddr);
-                res = getsockname(g_interruptSocket, (struct sockaddr *)&realAddr, (socklen_t *)&addrLen);
-                if (res != -1)
-                {
-                    res = connect(g_interruptSocket, (struct sockaddr *)&realAddr, addrLen);
-                }
-            }
-            if (res == -1)
-            {
-#ifdef _WIN32
-                closesocket(g_interruptSocket);
-#else
-                close(g_interruptSocket);
-#endif
-                return -1;
-            }
-        }
-        else
-        {
-            return -1;
-        }
+        return -1;
     }
 
     // we add our socket to be able to interrupt the select()
@@ -420,3 +435,247 @@ void iowa_system_connection_interrupt_select(void *userData)
 }
 
 #endif // IOWA_THREAD_SUPPORT
+
+#ifdef IOWA_CONNECTION_MONITOR_SUPPORT
+
+#ifndef __linux__
+#error "This sample implements IOWA_CONNECTION_MONITOR_SUPPORT only for Linux."
+#endif
+
+#include <limits.h>
+#include <sys/epoll.h>
+
+#define SAMPLE_EPOLL_MAX_EVENTS 64
+
+// The epoll instance containing the sockets provided by IOWA
+static int g_epollFd = -1;
+
+static int prv_getEpollFd(void)
+{
+    if (g_epollFd == -1)
+    {
+        g_epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+#ifdef IOWA_THREAD_SUPPORT
+        // we add our socket to be able to interrupt the wait if required
+        if (g_epollFd != -1
+            && (g_interruptSocket != -1 || prv_createInterruptSocket() != -1))
+        {
+            struct epoll_event event;
+
+            memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN;
+            event.data.ptr = NULL;
+            (void)epoll_ctl(g_epollFd, EPOLL_CTL_ADD, g_interruptSocket, &event);
+        }
+#endif
+    }
+
+    return g_epollFd;
+}
+
+// The socket is registered once. IOWA's data is stored in the epoll event
+// so that it is returned as is when the socket is readable.
+int iowa_system_connection_monitor_add(void *connP,
+                                       void *eventData,
+                                       void *userData)
+{
+    sample_connection_t *connectionP;
+    struct epoll_event event;
+    int epollFd;
+
+    (void)userData;
+
+    connectionP = (sample_connection_t *)connP;
+
+    epollFd = prv_getEpollFd();
+    if (epollFd == -1)
+    {
+        return -1;
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = eventData;
+
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, connectionP->sock, &event);
+}
+
+void iowa_system_connection_monitor_remove(void *connP,
+                                           void *userData)
+{
+    sample_connection_t *connectionP;
+
+    (void)userData;
+
+    connectionP = (sample_connection_t *)connP;
+
+    if (g_epollFd != -1)
+    {
+        (void)epoll_ctl(g_epollFd, EPOLL_CTL_DEL, connectionP->sock, NULL);
+    }
+}
+
+// In this function, we wait on the epoll instance and report
+// only the sockets with available data.
+int iowa_system_connection_wait(void **eventDataArray,
+                                size_t eventDataCount,
+                                int32_t timeout,
+                                void *userData)
+{
+    struct epoll_event events[SAMPLE_EPOLL_MAX_EVENTS];
+    int maxEvents;
+    int timeoutMs;
+    int result;
+    int i;
+    int readyCount;
+
+    (void)userData;
+
+    if (prv_getEpollFd() == -1)
+    {
+        return -1;
+    }
+
+    maxEvents = (eventDataCount < SAMPLE_EPOLL_MAX_EVENTS) ? (int)eventDataCount : SAMPLE_EPOLL_MAX_EVENTS;
+    if (timeout > INT_MAX / 1000)
+    {
+        timeoutMs = -1;
+    }
+    else
+    {
+        timeoutMs = (int)timeout * 1000;
+    }
+
+    result = epoll_wait(g_epollFd, events, maxEvents, timeoutMs);
+    if (result < 0)
+    {
+        return (errno == EINTR) ? 0 : -1;
+    }
+
+    readyCount = 0;
+    for (i = 0; i < result; i++)
+    {
+        if (events[i].data.ptr == NULL)
+        {
+#ifdef IOWA_THREAD_SUPPORT
+            uint8_t buffer[1];
+
+            // flush the dummy data
+            (void)recv(g_interruptSocket, buffer, 1, 0);
+#endif
+            continue;
+        }
+        eventDataArray[readyCount] = events[i].data.ptr;
+        readyCount++;
+    }
+
+    return readyCount;
+}
+
+#endif // IOWA_CONNECTION_MONITOR_SUPPORT
+
+#ifdef IOWA_CONNECTION_RECV_BATCH_SUPPORT
+
+#ifndef __linux__
+#error "This sample implements IOWA_CONNECTION_RECV_BATCH_SUPPORT only for Linux."
+#endif
+
+#include <sys/socket.h>
+
+#define SAMPLE_RECV_BATCH_MAX_COUNT 64
+
+// In this function, we read all the pending datagrams with a single recvmmsg().
+int iowa_system_connection_recv_batch(void *connP,
+                                      uint8_t *buffer,
+                                      size_t length,
+                                      size_t *lengthArray,
+                                      size_t count,
+                                      void *userData)
+{
+    struct mmsghdr msgArray[SAMPLE_RECV_BATCH_MAX_COUNT];
+    struct iovec iovArray[SAMPLE_RECV_BATCH_MAX_COUNT];
+    sample_connection_t *connectionP;
+    size_t i;
+    int result;
+
+    (void)userData;
+
+    connectionP = (sample_connection_t *)connP;
+
+    if (count > SAMPLE_RECV_BATCH_MAX_COUNT)
+    {
+        count = SAMPLE_RECV_BATCH_MAX_COUNT;
+    }
+
+    memset(msgArray, 0, count * sizeof(struct mmsghdr));
+    for (i = 0; i < count; i++)
+    {
+        iovArray[i].iov_base = buffer + i * length;
+        iovArray[i].iov_len = length;
+        msgArray[i].msg_hdr.msg_iov = iovArray + i;
+        msgArray[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // The socket is known to be readable: do not wait for the other datagrams
+    result = recvmmsg(connectionP->sock, msgArray, (unsigned int)count, MSG_DONTWAIT, NULL);
+    if (result < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    for (i = 0; i < (size_t)result; i++)
+    {
+        lengthArray[i] = msgArray[i].msg_len;
+    }
+
+    return result;
+}
+
+#endif // IOWA_CONNECTION_RECV_BATCH_SUPPORT
+
+#ifdef IOWA_CONNECTION_SEND_BATCH_SUPPORT
+
+#ifndef __linux__
+#error "This sample implements IOWA_CONNECTION_SEND_BATCH_SUPPORT only for Linux."
+#endif
+
+#include <sys/socket.h>
+
+#define SAMPLE_SEND_BATCH_MAX_COUNT 64
+
+// In this function, we send the datagrams with a single sendmmsg().
+// Since the socket is connected, no destination address is needed.
+int iowa_system_connection_send_batch(void *connP,
+                                      uint8_t **bufferArray,
+                                      size_t *lengthArray,
+                                      size_t count,
+                                      void *userData)
+{
+    struct mmsghdr msgArray[SAMPLE_SEND_BATCH_MAX_COUNT];
+    struct iovec iovArray[SAMPLE_SEND_BATCH_MAX_COUNT];
+    sample_connection_t *connectionP;
+    size_t i;
+
+    (void)userData;
+
+    connectionP = (sample_connection_t *)connP;
+
+    if (count > SAMPLE_SEND_BATCH_MAX_COUNT)
+    {
+        count = SAMPLE_SEND_BATCH_MAX_COUNT;
+    }
+
+    memset(msgArray, 0, count * sizeof(struct mmsghdr));
+    for (i = 0; i < count; i++)
+    {
+        iovArray[i].iov_base = bufferArray[i];
+        iovArray[i].iov_len = lengthArray[i];
+        msgArray[i].msg_hdr.msg_iov = iovArray + i;
+        msgArray[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    return sendmmsg(connectionP->sock, msgArray, (unsigned int)count, 0);
+}
+
+#endif // IOWA_CONNECTION_SEND_BATCH_SUPPORT
@@ -51,6 +51,26 @@ int32_t iowa_system_gettime(void)
 #endif
 }
 
+// We return the monotonic clock truncated to 32 bits.
+uint32_t iowa_system_gettime_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (uint32_t)(counter.QuadPart * 1000000 / frequency.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000);
+#endif
+}
+
 // We fake a reboot by exiting the application.
 void iowa_system_reboot(void *userData)
 {